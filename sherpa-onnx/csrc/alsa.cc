@@ -10,21 +10,15 @@
 #include <time.h>  // 用于nanosleep
 
 #include "alsa/asoundlib.h"
+#include "sherpa-onnx/csrc/pcm-convert.h"
 
 namespace sherpa_onnx {
 
-void ToFloat(const std::vector<int16_t> &in, int32_t num_channels,
-             std::vector<float> *out) {
-  out->resize(in.size() / num_channels);
-
-  int32_t n = in.size();
-  for (int32_t i = 0, k = 0; i < n; i += num_channels, ++k) {
-    (*out)[k] = in[i] / 32768.;
-  }
-}
-
-Alsa::Alsa(const char *device_name, int32_t period_size, int32_t buffer_size) 
-    : period_size_(period_size), buffer_size_(buffer_size) {
+Alsa::Alsa(const char *device_name, int32_t period_size, int32_t buffer_size,
+           int32_t num_channels)
+    : num_channels_(num_channels),
+      period_size_(period_size),
+      buffer_size_(buffer_size) {
   const char *kDeviceHelp = R"(
 Please use the command:
 
@@ -74,9 +68,19 @@ and if you want to select card 3 and device 0 on that card, please use:
     exit(-1);
   }
 
-  // mono
-  err = snd_pcm_hw_params_set_channels(capture_handle_, hw_params, 1);
-  if (err) {
+  if (num_channels_ > 1) {
+    err = snd_pcm_hw_params_set_channels(capture_handle_, hw_params,
+                                         num_channels_);
+    if (err) {
+      fprintf(stderr, "Failed to set number of channels to %d. %s\n",
+              num_channels_, snd_strerror(err));
+      exit(-1);
+    }
+    actual_channel_count_ = num_channels_;
+    fprintf(stderr, "Channel count is set to %d\n", num_channels_);
+  } else if ((err = snd_pcm_hw_params_set_channels(capture_handle_, hw_params,
+                                                   1))) {
+    // mono is not supported
     fprintf(stderr, "Failed to set number of channels to 1. %s\n",
             snd_strerror(err));
 
@@ -117,9 +121,11 @@ and if you want to select card 3 and device 0 on that card, please use:
     float lowpass_cutoff = 0.99 * 0.5 * min_freq;
 
     int32_t lowpass_filter_width = 6;
-    resampler_ = std::make_unique<LinearResample>(
-        actual_sample_rate_, expected_sample_rate_, lowpass_cutoff,
-        lowpass_filter_width);
+    for (int32_t c = 0; c != num_channels_; ++c) {
+      channel_resamplers_.push_back(std::make_unique<PolyphaseResample>(
+          actual_sample_rate_, expected_sample_rate_, lowpass_cutoff,
+          lowpass_filter_width));
+    }
   } else {
     fprintf(stderr, "Current sample rate: %d\n", actual_sample_rate_);
   }
@@ -153,15 +159,23 @@ and if you want to select card 3 and device 0 on that card, please use:
     exit(-1);
   }
 
+  converter_ = std::make_unique<PcmConverter>(
+      actual_channel_count_, 0, actual_sample_rate_, expected_sample_rate_);
+
   fprintf(stderr, "Recording started!\n");
 }
 
 Alsa::~Alsa() { snd_pcm_close(capture_handle_); }
 
-const std::vector<float> &Alsa::Read(int32_t num_samples) {
+int32_t Alsa::ReadInterleaved(int32_t num_samples) {
   samples_.resize(num_samples * actual_channel_count_);
 
+  auto start = std::chrono::steady_clock::now();
   int32_t count = snd_pcm_readi(capture_handle_, samples_.data(), num_samples);
+  last_read_time_ = std::chrono::steady_clock::now();
+  last_wait_ms_ = std::chrono::duration<double, std::milli>(
+                      last_read_time_ - start)
+                      .count();
   if (count == -EPIPE) {
     static int32_t total_overruns = 0;
     total_overruns++;
@@ -179,9 +193,8 @@ const std::vector<float> &Alsa::Read(int32_t num_samples) {
 
     snd_pcm_drop(capture_handle_);
     snd_pcm_prepare(capture_handle_);
-    
-    static std::vector<float> tmp;
-    return tmp;
+
+    return 0;
   } else if (count < 0) {
     fprintf(stderr, "Can't read PCM device: %s\n", snd_strerror(count));
     exit(-1);
@@ -189,14 +202,63 @@ const std::vector<float> &Alsa::Read(int32_t num_samples) {
 
   samples_.resize(count * actual_channel_count_);
 
-  ToFloat(samples_, actual_channel_count_, &samples1_);
+  return count;
+}
 
-  if (!resampler_) {
-    return samples1_;
+const std::vector<float> &Alsa::Read(int32_t num_samples) {
+  samples1_.resize(MaxReadSize(num_samples));
+  samples1_.resize(Read(num_samples, samples1_.data()));
+  return samples1_;
+}
+
+int32_t Alsa::Read(int32_t num_samples, float *out) {
+  int32_t count = ReadInterleaved(num_samples);
+  if (count == 0) {
+    return 0;
+  }
+
+  int32_t n = converter_->Convert(samples_.data(), count, out);
+  num_samples_read_ += n;
+  return n;
+}
+
+const std::vector<std::vector<float>> &Alsa::ReadChannels(
+    int32_t num_samples) {
+  channel_samples1_.resize(num_channels_);
+  channel_samples2_.resize(num_channels_);
+  channel_ptrs_.resize(num_channels_);
+
+  int32_t count = ReadInterleaved(num_samples);
+
+  for (int32_t c = 0; c != num_channels_; ++c) {
+    channel_samples1_[c].resize(count);
+    channel_ptrs_[c] = channel_samples1_[c].data();
   }
 
-  resampler_->Resample(samples1_.data(), samples_.size(), false, &samples2_);
-  return samples2_;
+  if (count == 0) {
+    return channel_samples1_;
+  }
+
+  // With a single channel, it is the first channel of a stereo device
+  if (num_channels_ == 1 && actual_channel_count_ != 1) {
+    ChannelInt16ToFloat(samples_.data(), count, actual_channel_count_, 0,
+                        channel_samples1_[0].data());
+  } else {
+    DeinterleaveInt16ToFloat(samples_.data(), count, num_channels_,
+                             channel_ptrs_.data());
+  }
+
+  if (channel_resamplers_.empty()) {
+    num_samples_read_ += count;
+    return channel_samples1_;
+  }
+
+  for (int32_t c = 0; c != num_channels_; ++c) {
+    channel_resamplers_[c]->Resample(channel_samples1_[c].data(), count, false,
+                                     &channel_samples2_[c]);
+  }
+  num_samples_read_ += channel_samples2_[0].size();
+  return channel_samples2_;
 }
 
 }  // namespace sherpa_onnx
@@ -5,20 +5,28 @@
 #ifndef SHERPA_ONNX_CSRC_ALSA_H_
 #define SHERPA_ONNX_CSRC_ALSA_H_
 
+#include <chrono>  // NOLINT
+#include <cstdint>
 #include <memory>
 #include <vector>
 
 #include "alsa/asoundlib.h"
-#include "sherpa-onnx/csrc/resample.h"
+#include "sherpa-onnx/csrc/pcm-convert.h"
+#include "sherpa-onnx/csrc/polyphase-resample.h"
 
 namespace sherpa_onnx {
 
 class Alsa {
  public:
+  // @param num_channels Number of channels to capture. If it is 1 and the
+  //                     device does not support mono, 2 channels are
+  //                     captured and only the first one is used. Otherwise,
+  //                     the device must support exactly num_channels.
   explicit Alsa(
     const char *device_name, 
     int32_t period_size = 170, 
-    int32_t buffer_size = 1365
+    int32_t buffer_size = 1365,
+    int32_t num_channels = 1
   );
   
   ~Alsa();
@@ -30,22 +38,74 @@ class Alsa {
   // The returned value is valid until the next call to Read().
   const std::vector<float> &Read(int32_t num_samples);
 
+  // Same as the above, but it writes to a caller-supplied buffer, which must
+  // have room for at least MaxReadSize(num_samples) samples. Samples are
+  // converted to float and resampled in one step, without copies in
+  // between.
+  //
+  // @return Return the number of samples written to out.
+  int32_t Read(int32_t num_samples, float *out);
+
+  // Return the maximum number of samples written by Read(num_samples, out)
+  int32_t MaxReadSize(int32_t num_samples) const {
+    return converter_->MaxOutputSize(num_samples);
+  }
+
+  // This is a blocking read of all channels.
+  //
+  // @param num_samples  Number of samples per channel to read.
+  //
+  // The returned value contains NumChannels() vectors, one per channel.
+  // It is valid until the next call to ReadChannels().
+  const std::vector<std::vector<float>> &ReadChannels(int32_t num_samples);
+
+  // Number of channels returned by ReadChannels()
+  int32_t NumChannels() const { return num_channels_; }
+
   int32_t GetExpectedSampleRate() const { return expected_sample_rate_; }
   int32_t GetActualSampleRate() const { return actual_sample_rate_; }
 
+  // Total number of samples returned by Read() so far, at the expected
+  // sample rate. With LastReadTime(), it stamps the captured audio.
+  int64_t NumSamplesRead() const { return num_samples_read_; }
+
+  // Time when the last Read() got its samples from the device
+  std::chrono::steady_clock::time_point LastReadTime() const {
+    return last_read_time_;
+  }
+
+  // Time in milliseconds the last Read() was blocked waiting for the device
+  double LastWaitMs() const { return last_wait_ms_; }
+
  private:
+  // Read num_samples frames into samples_.
+  // @return Return the number of frames read. 0 on overrun.
+  int32_t ReadInterleaved(int32_t num_samples);
+
   snd_pcm_t *capture_handle_;
   int32_t expected_sample_rate_ = 16000;
   int32_t actual_sample_rate_;
 
   int32_t actual_channel_count_ = 1;
+  int32_t num_channels_ = 1;  // Number of channels used
   int32_t period_size_;  // 默认170
   int32_t buffer_size_;  // 默认1365
 
-  std::unique_ptr<LinearResample> resampler_;
+  // Converts the first channel of samples_ for Read()
+  std::unique_ptr<PcmConverter> converter_;
   std::vector<int16_t> samples_;  // directly from the microphone
-  std::vector<float> samples1_;   // normalized version of samples_
-  std::vector<float> samples2_;   // possibly resampled from samples1_
+  std::vector<float> samples1_;   // normalized and possibly resampled
+
+  // For ReadChannels(). One resampler per channel, since each keeps the
+  // history of its channel.
+  std::vector<std::unique_ptr<PolyphaseResample>> channel_resamplers_;
+  std::vector<std::vector<float>> channel_samples1_;
+  std::vector<std::vector<float>> channel_samples2_;
+  std::vector<float *> channel_ptrs_;
+
+  int64_t num_samples_read_ = 0;
+  std::chrono::steady_clock::time_point last_read_time_;
+  double last_wait_ms_ = 0;
 };
 
 }  // namespace sherpa_onnx
@@ -7,8 +7,13 @@
 #include <chrono>  // NOLINT
 #include <cmath>
 #include <map>
+#include <memory>
+#include <queue>
 #include <random>
 #include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -16,6 +21,204 @@
 
 namespace sherpa_onnx {
 
+// The pointer-based ContextGraph that the flat one replaced. It is kept
+// here to check that both give the same scores, states and matches.
+class ReferenceContextGraph {
+ public:
+  struct State {
+    int32_t token;
+    float token_score;
+    float node_score;
+    float output_score;
+    int32_t level;
+    float ac_threshold;
+    bool is_end;
+    std::string phrase;
+    std::unordered_map<int32_t, std::unique_ptr<State>> next;
+    const State *fail = nullptr;
+    const State *output = nullptr;
+
+    State(int32_t token, float token_score, float node_score,
+          float output_score, int32_t level = 0, float ac_threshold = 0.0f,
+          bool is_end = false, const std::string &phrase = {})
+        : token(token),
+          token_score(token_score),
+          node_score(node_score),
+          output_score(output_score),
+          level(level),
+          ac_threshold(ac_threshold),
+          is_end(is_end),
+          phrase(phrase) {}
+  };
+
+  ReferenceContextGraph(const std::vector<std::vector<int32_t>> &token_ids,
+                        float context_score, float ac_threshold,
+                        const std::vector<float> &scores,
+                        const std::vector<std::string> &phrases,
+                        const std::vector<float> &ac_thresholds)
+      : context_score_(context_score), ac_threshold_(ac_threshold) {
+    root_ = std::make_unique<State>(-1, 0, 0, 0);
+    root_->fail = root_.get();
+    Build(token_ids, scores, phrases, ac_thresholds);
+  }
+
+  const State *Root() const { return root_.get(); }
+
+  std::tuple<float, const State *, const State *> ForwardOneStep(
+      const State *state, int32_t token, bool strict_mode) const {
+    const State *node = nullptr;
+    float score = 0;
+    if (1 == state->next.count(token)) {
+      node = state->next.at(token).get();
+      score = node->token_score;
+    } else {
+      node = state->fail;
+      while (0 == node->next.count(token)) {
+        node = node->fail;
+        if (-1 == node->token) break;  // root
+      }
+      if (1 == node->next.count(token)) {
+        node = node->next.at(token).get();
+      }
+      score = node->node_score - state->node_score;
+    }
+
+    const State *matched_node =
+        node->is_end ? node
+                     : (node->output != nullptr ? node->output : nullptr);
+
+    if (!strict_mode && node->output_score != 0) {
+      float output_score =
+          node->is_end ? node->node_score
+                       : (node->output != nullptr ? node->output->node_score
+                                                  : node->node_score);
+      return std::make_tuple(score + output_score - node->node_score,
+                             root_.get(), matched_node);
+    }
+    return std::make_tuple(score + node->output_score, node, matched_node);
+  }
+
+  std::pair<bool, const State *> IsMatched(const State *state) const {
+    if (state->is_end) {
+      return {true, state};
+    }
+    if (state->output != nullptr) {
+      return {true, state->output};
+    }
+    return {false, nullptr};
+  }
+
+  std::pair<float, const State *> Finalize(const State *state) const {
+    return {-state->node_score, root_.get()};
+  }
+
+ private:
+  void Build(const std::vector<std::vector<int32_t>> &token_ids,
+             const std::vector<float> &scores,
+             const std::vector<std::string> &phrases,
+             const std::vector<float> &ac_thresholds) {
+    for (int32_t i = 0; i < static_cast<int32_t>(token_ids.size()); ++i) {
+      auto node = root_.get();
+      float score = scores.empty() ? 0.0f : scores[i];
+      score = score == 0.0f ? context_score_ : score;
+      float ac_threshold = ac_thresholds.empty() ? 0.0f : ac_thresholds[i];
+      ac_threshold = ac_threshold == 0.0f ? ac_threshold_ : ac_threshold;
+      std::string phrase = phrases.empty() ? std::string() : phrases[i];
+
+      int32_t n = static_cast<int32_t>(token_ids[i].size());
+      for (int32_t j = 0; j < n; ++j) {
+        int32_t token = token_ids[i][j];
+        bool last = j == n - 1;
+        if (0 == node->next.count(token)) {
+          node->next[token] = std::make_unique<State>(
+              token, score, node->node_score + score,
+              last ? node->node_score + score : 0, j + 1,
+              last ? ac_threshold : 0.0f, last,
+              last ? phrase : std::string());
+        } else {
+          auto &next = node->next[token];
+          next->token_score = std::max(score, next->token_score);
+          float node_score = node->node_score + next->token_score;
+          next->node_score = node_score;
+          bool is_end = last || next->is_end;
+          next->output_score = is_end ? node_score : 0.0f;
+          next->is_end = is_end;
+          if (last) {
+            next->phrase = phrase;
+            next->ac_threshold = ac_threshold;
+          }
+        }
+        node = node->next[token].get();
+      }
+    }
+    FillFailOutput();
+  }
+
+  void FillFailOutput() {
+    std::queue<State *> node_queue;
+    for (auto &kv : root_->next) {
+      kv.second->fail = root_.get();
+      node_queue.push(kv.second.get());
+    }
+    while (!node_queue.empty()) {
+      auto current_node = node_queue.front();
+      node_queue.pop();
+      for (auto &kv : current_node->next) {
+        auto fail = current_node->fail;
+        if (1 == fail->next.count(kv.first)) {
+          fail = fail->next.at(kv.first).get();
+        } else {
+          fail = fail->fail;
+          while (0 == fail->next.count(kv.first)) {
+            fail = fail->fail;
+            if (-1 == fail->token) break;
+          }
+          if (1 == fail->next.count(kv.first)) {
+            fail = fail->next.at(kv.first).get();
+          }
+        }
+        kv.second->fail = fail;
+
+        auto output = fail;
+        while (!output->is_end) {
+          output = output->fail;
+          if (-1 == output->token) {
+            output = nullptr;
+            break;
+          }
+        }
+        kv.second->output = output;
+        kv.second->output_score +=
+            output == nullptr ? 0 : output->output_score;
+        node_queue.push(kv.second.get());
+      }
+    }
+  }
+
+ private:
+  float context_score_;
+  float ac_threshold_;
+  std::unique_ptr<State> root_;
+};
+
+static void ExpectSameState(const ContextGraph &graph,
+                            const ContextState *state,
+                            const ReferenceContextGraph::State *expected) {
+  ASSERT_EQ(state == nullptr, expected == nullptr);
+  if (state == nullptr) {
+    return;
+  }
+
+  EXPECT_EQ(state->token, expected->token);
+  EXPECT_EQ(state->level, expected->level);
+  EXPECT_EQ(state->is_end, expected->is_end);
+  EXPECT_FLOAT_EQ(state->token_score, expected->token_score);
+  EXPECT_FLOAT_EQ(state->node_score, expected->node_score);
+  EXPECT_FLOAT_EQ(state->output_score, expected->output_score);
+  EXPECT_FLOAT_EQ(state->ac_threshold, expected->ac_threshold);
+  EXPECT_EQ(graph.Phrase(state), expected->phrase);
+}
+
 static void TestHelper(const std::map<std::string, float> &queries, float score,
                        bool strict_mode) {
   std::vector<std::string> contexts_str(
@@ -74,6 +277,105 @@ TEST(ContextGraph, TestCustomizeNonStrict) {
   TestHelper(queries, 5, false);
 }
 
+TEST(ContextGraph, Phrase) {
+  std::vector<std::string> keywords({"HE", "SHE", "HERS"});
+  std::vector<std::vector<int32_t>> contexts;
+  for (const auto &k : keywords) {
+    contexts.emplace_back(k.begin(), k.end());
+  }
+  auto context_graph = ContextGraph(contexts, 1, 0.1, {}, keywords);
+
+  // "USHERS" contains "SHE", "HE" and "HERS"
+  std::string text = "USHERS";
+  std::vector<std::string> matched;
+  auto state = context_graph.Root();
+  for (auto c : text) {
+    state = std::get<1>(context_graph.ForwardOneStep(state, c));
+    auto res = context_graph.IsMatched(state);
+    if (res.first) {
+      EXPECT_EQ(res.second->level,
+                context_graph.Phrase(res.second).size());
+      matched.push_back(context_graph.Phrase(res.second));
+    }
+  }
+
+  EXPECT_EQ(matched, std::vector<std::string>({"SHE", "HERS"}));
+  EXPECT_EQ(context_graph.Phrase(context_graph.Root()), "");
+
+  // root, H, HE, HER, HERS, S, SH, SHE
+  EXPECT_EQ(context_graph.NumStates(), 8);
+}
+
+// Compare with the reference implementation on random keyword sets over a
+// small alphabet, so that keywords share prefixes and suffixes
+TEST(ContextGraph, SameAsReference) {
+  std::mt19937 mt(20250101);
+  std::uniform_int_distribution<int32_t> token_dist(0, 5);
+  std::uniform_int_distribution<int32_t> len_dist(1, 6);
+  std::uniform_int_distribution<int32_t> score_dist(0, 4);
+  std::uniform_int_distribution<int32_t> threshold_dist(0, 3);
+
+  for (int32_t iter = 0; iter != 50; ++iter) {
+    int32_t num_keywords = 1 + iter % 20;
+
+    std::vector<std::vector<int32_t>> contexts;
+    std::vector<float> scores;
+    std::vector<std::string> phrases;
+    std::vector<float> ac_thresholds;
+    for (int32_t i = 0; i != num_keywords; ++i) {
+      std::vector<int32_t> tokens(len_dist(mt));
+      std::string phrase;
+      for (auto &t : tokens) {
+        t = token_dist(mt);
+        phrase += static_cast<char>('a' + t);
+      }
+      contexts.push_back(std::move(tokens));
+      phrases.push_back(phrase);
+
+      // 0 means to use the default
+      scores.push_back(score_dist(mt) * 0.5f);
+      ac_thresholds.push_back(threshold_dist(mt) * 0.1f);
+    }
+
+    ContextGraph graph(contexts, 1.5, 0.2, scores, phrases, ac_thresholds);
+    ReferenceContextGraph expected(contexts, 1.5, 0.2, scores, phrases,
+                                   ac_thresholds);
+
+    for (bool strict_mode : {true, false}) {
+      auto state = graph.Root();
+      auto expected_state = expected.Root();
+      for (int32_t i = 0; i != 200; ++i) {
+        // Also feed tokens that no keyword contains
+        int32_t token = token_dist(mt) + (i % 17 == 0 ? 10 : 0);
+
+        auto res = graph.ForwardOneStep(state, token, strict_mode);
+        auto expected_res =
+            expected.ForwardOneStep(expected_state, token, strict_mode);
+
+        EXPECT_FLOAT_EQ(std::get<0>(res), std::get<0>(expected_res));
+        ExpectSameState(graph, std::get<1>(res), std::get<1>(expected_res));
+        ExpectSameState(graph, std::get<2>(res), std::get<2>(expected_res));
+
+        state = std::get<1>(res);
+        expected_state = std::get<1>(expected_res);
+
+        auto matched = graph.IsMatched(state);
+        auto expected_matched = expected.IsMatched(expected_state);
+        EXPECT_EQ(matched.first, expected_matched.first);
+        ExpectSameState(graph, matched.second, expected_matched.second);
+
+        if (i % 50 == 49) {
+          auto final_res = graph.Finalize(state);
+          auto expected_final = expected.Finalize(expected_state);
+          EXPECT_FLOAT_EQ(final_res.first, expected_final.first);
+          state = final_res.second;
+          expected_state = expected_final.second;
+        }
+      }
+    }
+  }
+}
+
 TEST(ContextGraph, Benchmark) {
   std::random_device rd;
   std::mt19937 mt(rd());
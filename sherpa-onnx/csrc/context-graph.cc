@@ -5,8 +5,7 @@
 #include "sherpa-onnx/csrc/context-graph.h"
 
 #include <algorithm>
-#include <cassert>
-#include <queue>
+#include <map>
 #include <string>
 #include <tuple>
 #include <utility>
@@ -14,10 +13,27 @@
 #include "sherpa-onnx/csrc/macros.h"
 
 namespace sherpa_onnx {
+
+namespace {
+
+// A node of the trie while building the graph. It is converted to the
+// flat representation in ContextGraph::Build().
+struct TrieNode {
+  ContextState state;
+  std::map<int32_t, int32_t> next;  // token -> index of the child
+  std::string phrase;
+};
+
+// Search linearly in arc lists up to this size, and use binary search for
+// longer ones.
+constexpr int32_t kLinearSearchThreshold = 8;
+
+}  // namespace
+
 void ContextGraph::Build(const std::vector<std::vector<int32_t>> &token_ids,
                          const std::vector<float> &scores,
                          const std::vector<std::string> &phrases,
-                         const std::vector<float> &ac_thresholds) const {
+                         const std::vector<float> &ac_thresholds) {
   if (!scores.empty()) {
     SHERPA_ONNX_CHECK_EQ(token_ids.size(), scores.size());
   }
@@ -27,8 +43,12 @@ void ContextGraph::Build(const std::vector<std::vector<int32_t>> &token_ids,
   if (!ac_thresholds.empty()) {
     SHERPA_ONNX_CHECK_EQ(token_ids.size(), ac_thresholds.size());
   }
+
+  std::vector<TrieNode> trie(1);
+  trie[0].state = ContextState(-1, 0, 0, 0);
+
   for (int32_t i = 0; i < static_cast<int32_t>(token_ids.size()); ++i) {
-    auto node = root_.get();
+    int32_t node = 0;
     float score = scores.empty() ? 0.0f : scores[i];
     score = score == 0.0f ? context_score_ : score;
     float ac_threshold = ac_thresholds.empty() ? 0.0f : ac_thresholds[i];
@@ -37,68 +57,159 @@ void ContextGraph::Build(const std::vector<std::vector<int32_t>> &token_ids,
 
     for (int32_t j = 0; j < static_cast<int32_t>(token_ids[i].size()); ++j) {
       int32_t token = token_ids[i][j];
-      if (0 == node->next.count(token)) {
-        bool is_end = j == (static_cast<int32_t>(token_ids[i].size()) - 1);
-        node->next[token] = std::make_unique<ContextState>(
-            token, score, node->node_score + score,
-            is_end ? node->node_score + score : 0, j + 1,
-            is_end ? ac_threshold : 0.0f, is_end,
-            is_end ? phrase : std::string());
+      bool is_last = j == (static_cast<int32_t>(token_ids[i].size()) - 1);
+      float parent_score = trie[node].state.node_score;
+
+      auto it = trie[node].next.find(token);
+      if (it == trie[node].next.end()) {
+        int32_t child = static_cast<int32_t>(trie.size());
+        trie[node].next.emplace(token, child);
+
+        trie.emplace_back();
+        trie.back().state = ContextState(
+            token, score, parent_score + score,
+            is_last ? parent_score + score : 0, j + 1,
+            is_last ? ac_threshold : 0.0f, is_last);
+        if (is_last) {
+          trie.back().phrase = phrase;
+        }
+        node = child;
       } else {
-        float token_score = std::max(score, node->next[token]->token_score);
-        node->next[token]->token_score = token_score;
-        float node_score = node->node_score + token_score;
-        node->next[token]->node_score = node_score;
-        bool is_end = (j == static_cast<int32_t>(token_ids[i].size()) - 1) ||
-                      node->next[token]->is_end;
-        node->next[token]->output_score = is_end ? node_score : 0.0f;
-        node->next[token]->is_end = is_end;
-        if (j == static_cast<int32_t>(token_ids[i].size()) - 1) {
-          node->next[token]->phrase = phrase;
-          node->next[token]->ac_threshold = ac_threshold;
+        node = it->second;
+        ContextState &state = trie[node].state;
+        state.token_score = std::max(score, state.token_score);
+        state.node_score = parent_score + state.token_score;
+        bool is_end = is_last || state.is_end;
+        state.output_score = is_end ? state.node_score : 0.0f;
+        state.is_end = is_end;
+        if (is_last) {
+          trie[node].phrase = phrase;
+          state.ac_threshold = ac_threshold;
         }
       }
-      node = node->next[token].get();
     }
   }
+
+  // Lay out the nodes in breadth-first order, so that the arcs of a node
+  // are contiguous and FillFailOutput() can visit nodes by index.
+  std::vector<int32_t> order;
+  order.reserve(trie.size());
+  order.push_back(0);
+
+  std::vector<int32_t> new_index(trie.size());
+  for (int32_t i = 0; i < static_cast<int32_t>(order.size()); ++i) {
+    for (const auto &kv : trie[order[i]].next) {
+      new_index[kv.second] = static_cast<int32_t>(order.size());
+      order.push_back(kv.second);
+    }
+  }
+
+  nodes_.clear();
+  arcs_.clear();
+  phrases_.clear();
+  nodes_.reserve(trie.size());
+  arcs_.reserve(trie.size() - 1);
+
+  for (auto i : order) {
+    TrieNode &t = trie[i];
+    ContextState state = t.state;
+
+    state.arc_begin = static_cast<int32_t>(arcs_.size());
+    for (const auto &kv : t.next) {
+      arcs_.push_back({kv.first, new_index[kv.second]});
+    }
+    state.arc_end = static_cast<int32_t>(arcs_.size());
+
+    if (!t.phrase.empty()) {
+      state.phrase = static_cast<int32_t>(phrases_.size());
+      phrases_.push_back(std::move(t.phrase));
+    }
+
+    nodes_.push_back(state);
+  }
+
+  root_next_.clear();
+  const ContextState &root = nodes_[0];
+  if (root.arc_begin != root.arc_end) {
+    // Arcs are sorted by token, so the last one has the largest token
+    int32_t max_token = arcs_[root.arc_end - 1].token;
+    if (max_token >= 0) {
+      root_next_.resize(max_token + 1, -1);
+    }
+    for (int32_t a = root.arc_begin; a != root.arc_end; ++a) {
+      if (arcs_[a].token >= 0) {
+        root_next_[arcs_[a].token] = arcs_[a].next;
+      }
+    }
+  }
+
   FillFailOutput();
 }
 
+int32_t ContextGraph::Next(int32_t node, int32_t token) const {
+  if (node == 0 && token >= 0 &&
+      token < static_cast<int32_t>(root_next_.size())) {
+    return root_next_[token];
+  }
+
+  const ContextState &state = nodes_[node];
+  const Arc *begin = arcs_.data() + state.arc_begin;
+  const Arc *end = arcs_.data() + state.arc_end;
+
+  if (end - begin <= kLinearSearchThreshold) {
+    for (const Arc *p = begin; p != end; ++p) {
+      if (p->token == token) {
+        return p->next;
+      }
+    }
+    return -1;
+  }
+
+  auto it = std::lower_bound(
+      begin, end, token, [](const Arc &a, int32_t t) { return a.token < t; });
+  if (it != end && it->token == token) {
+    return it->next;
+  }
+  return -1;
+}
+
+int32_t ContextGraph::FailTransition(int32_t node, int32_t token) const {
+  int32_t n = nodes_[node].fail;
+  int32_t next = Next(n, token);
+  while (next == -1 && n != 0) {
+    n = nodes_[n].fail;
+    next = Next(n, token);
+  }
+  return next == -1 ? n : next;
+}
+
 std::tuple<float, const ContextState *, const ContextState *>
 ContextGraph::ForwardOneStep(const ContextState *state, int32_t token,
                              bool strict_mode /*= true*/) const {
+  int32_t index = static_cast<int32_t>(state - nodes_.data());
+
   const ContextState *node = nullptr;
   float score = 0;
-  if (1 == state->next.count(token)) {
-    node = state->next.at(token).get();
+  int32_t next = Next(index, token);
+  if (next != -1) {
+    node = &nodes_[next];
     score = node->token_score;
   } else {
-    node = state->fail;
-    while (0 == node->next.count(token)) {
-      node = node->fail;
-      if (-1 == node->token) break;  // root
-    }
-    if (1 == node->next.count(token)) {
-      node = node->next.at(token).get();
-    }
+    node = &nodes_[FailTransition(index, token)];
     score = node->node_score - state->node_score;
   }
 
-  if (!node) {
-    SHERPA_ONNX_LOGE("Some bad things happened.");
-    exit(-1);
-  }
-
-  const ContextState *matched_node =
-      node->is_end ? node : (node->output != nullptr ? node->output : nullptr);
+  const ContextState *output =
+      node->output != -1 ? &nodes_[node->output] : nullptr;
+  const ContextState *matched_node = node->is_end ? node : output;
 
   if (!strict_mode && node->output_score != 0) {
     SHERPA_ONNX_CHECK(nullptr != matched_node);
     float output_score =
         node->is_end ? node->node_score
-                     : (node->output != nullptr ? node->output->node_score
-                                                : node->node_score);
-    return std::make_tuple(score + output_score - node->node_score, root_.get(),
+                     : (output != nullptr ? output->node_score
+                                          : node->node_score);
+    return std::make_tuple(score + output_score - node->node_score, Root(),
                            matched_node);
   }
   return std::make_tuple(score + node->output_score, node, matched_node);
@@ -107,7 +218,7 @@ ContextGraph::ForwardOneStep(const ContextState *state, int32_t token,
 std::pair<float, const ContextState *> ContextGraph::Finalize(
     const ContextState *state) const {
   float score = -state->node_score;
-  return std::make_pair(score, root_.get());
+  return std::make_pair(score, Root());
 }
 
 std::pair<bool, const ContextState *> ContextGraph::IsMatched(
@@ -118,50 +229,43 @@ std::pair<bool, const ContextState *> ContextGraph::IsMatched(
     status = true;
     node = state;
   } else {
-    if (state->output != nullptr) {
+    if (state->output != -1) {
       status = true;
-      node = state->output;
+      node = &nodes_[state->output];
     }
   }
   return std::make_pair(status, node);
 }
 
-void ContextGraph::FillFailOutput() const {
-  std::queue<const ContextState *> node_queue;
-  for (auto &kv : root_->next) {
-    kv.second->fail = root_.get();
-    node_queue.push(kv.second.get());
-  }
-  while (!node_queue.empty()) {
-    auto current_node = node_queue.front();
-    node_queue.pop();
-    for (auto &kv : current_node->next) {
-      auto fail = current_node->fail;
-      if (1 == fail->next.count(kv.first)) {
-        fail = fail->next.at(kv.first).get();
-      } else {
-        fail = fail->fail;
-        while (0 == fail->next.count(kv.first)) {
-          fail = fail->fail;
-          if (-1 == fail->token) break;
-        }
-        if (1 == fail->next.count(kv.first))
-          fail = fail->next.at(kv.first).get();
-      }
-      kv.second->fail = fail;
+const std::string &ContextGraph::Phrase(const ContextState *state) const {
+  static const std::string kEmpty;
+  return state->phrase == -1 ? kEmpty : phrases_[state->phrase];
+}
+
+void ContextGraph::FillFailOutput() {
+  // Nodes are in breadth-first order, so the fail arc of a node is
+  // always filled before the node is visited. The root and its children
+  // keep the default fail arc to the root.
+  for (int32_t i = 1; i < static_cast<int32_t>(nodes_.size()); ++i) {
+    for (int32_t a = nodes_[i].arc_begin; a != nodes_[i].arc_end; ++a) {
+      int32_t fail = FailTransition(i, arcs_[a].token);
+
+      ContextState &child = nodes_[arcs_[a].next];
+      child.fail = fail;
+
       // fill the output arc
-      auto output = fail;
-      while (!output->is_end) {
-        output = output->fail;
-        if (-1 == output->token) {
-          output = nullptr;
+      int32_t output = fail;
+      while (!nodes_[output].is_end) {
+        output = nodes_[output].fail;
+        if (0 == output) {
+          output = -1;
           break;
         }
       }
-      kv.second->output = output;
-      kv.second->output_score += output == nullptr ? 0 : output->output_score;
-      node_queue.push(kv.second.get());
+      child.output = output;
+      child.output_score += output == -1 ? 0 : nodes_[output].output_score;
     }
   }
 }
+
 }  // namespace sherpa_onnx
@@ -8,7 +8,6 @@
 #include <memory>
 #include <string>
 #include <tuple>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -19,6 +18,8 @@ namespace sherpa_onnx {
 class ContextGraph;
 using ContextGraphPtr = std::shared_ptr<ContextGraph>;
 
+// A node of the Aho-Corasick graph. Nodes are stored contiguously in
+// ContextGraph and refer to each other by their index in that array.
 struct ContextState {
   int32_t token;
   float token_score;
@@ -27,23 +28,27 @@ struct ContextState {
   int32_t level;
   float ac_threshold;
   bool is_end;
-  std::string phrase;
-  std::unordered_map<int32_t, std::unique_ptr<ContextState>> next;
-  const ContextState *fail = nullptr;
-  const ContextState *output = nullptr;
+  // Index into ContextGraph's phrase table; -1 if there is no phrase.
+  // Use ContextGraph::Phrase() to get the phrase.
+  int32_t phrase = -1;
+  // Outgoing arcs are [arc_begin, arc_end) in ContextGraph's arc table,
+  // sorted by token.
+  int32_t arc_begin = 0;
+  int32_t arc_end = 0;
+  int32_t fail = 0;
+  int32_t output = -1;
 
   ContextState() = default;
   ContextState(int32_t token, float token_score, float node_score,
                float output_score, int32_t level = 0, float ac_threshold = 0.0f,
-               bool is_end = false, const std::string &phrase = {})
+               bool is_end = false)
       : token(token),
         token_score(token_score),
         node_score(node_score),
         output_score(output_score),
         level(level),
         ac_threshold(ac_threshold),
-        is_end(is_end),
-        phrase(phrase) {}
+        is_end(is_end) {}
 };
 
 class ContextGraph {
@@ -55,8 +60,6 @@ class ContextGraph {
                const std::vector<std::string> &phrases = {},
                const std::vector<float> &ac_thresholds = {})
       : context_score_(context_score), ac_threshold_(ac_threshold) {
-    root_ = std::make_unique<ContextState>(-1, 0, 0, 0);
-    root_->fail = root_.get();
     Build(token_ids, scores, phrases, ac_thresholds);
   }
 
@@ -75,17 +78,51 @@ class ContextGraph {
   std::pair<float, const ContextState *> Finalize(
       const ContextState *state) const;
 
-  const ContextState *Root() const { return root_.get(); }
+  const ContextState *Root() const {
+    return nodes_.empty() ? nullptr : nodes_.data();
+  }
+
+  // Return the phrase of a state. It is empty if no phrase was given
+  // for the keyword ending at this state.
+  const std::string &Phrase(const ContextState *state) const;
+
+  int32_t NumStates() const { return static_cast<int32_t>(nodes_.size()); }
 
  private:
-  float context_score_;
-  float ac_threshold_;
-  std::unique_ptr<ContextState> root_;
+  struct Arc {
+    int32_t token;
+    int32_t next;  // index of the destination node
+  };
+
+  // Return the index of the node reached from node by token, or -1 if
+  // there is no such arc.
+  int32_t Next(int32_t node, int32_t token) const;
+
+  // Follow the fail arcs of node until reaching a node with an arc for
+  // token, and take that arc. Return the root if there is no such node.
+  int32_t FailTransition(int32_t node, int32_t token) const;
+
   void Build(const std::vector<std::vector<int32_t>> &token_ids,
              const std::vector<float> &scores,
              const std::vector<std::string> &phrases,
-             const std::vector<float> &ac_thresholds) const;
-  void FillFailOutput() const;
+             const std::vector<float> &ac_thresholds);
+  void FillFailOutput();
+
+ private:
+  float context_score_ = 0;
+  float ac_threshold_ = 0;
+
+  // Nodes in breadth-first order. nodes_[0] is the root.
+  std::vector<ContextState> nodes_;
+
+  // Outgoing arcs of all nodes. See ContextState::arc_begin.
+  std::vector<Arc> arcs_;
+
+  // Arcs of the root indexed by token, since most fail arcs end at the root.
+  // root_next_[token] is -1 if the root has no arc for token.
+  std::vector<int32_t> root_next_;
+
+  std::vector<std::string> phrases_;
 };
 
 }  // namespace sherpa_onnx
@@ -0,0 +1,91 @@
+// sherpa-onnx/csrc/decoder-out-cache-test.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/decoder-out-cache.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace sherpa_onnx {
+
+TEST(DecoderOutCache, FindOrAdd) {
+  DecoderOutCache cache(4);
+  cache.SetDim(3);
+
+  std::vector<int64_t> a = {-1, 0};
+  std::vector<int64_t> b = {0, 5};
+
+  bool found = true;
+  int32_t ia = cache.FindOrAdd(a.data(), a.size(), &found);
+  EXPECT_FALSE(found);
+  EXPECT_EQ(ia, 0);
+
+  float *p = cache.Data(ia);
+  p[0] = 1;
+  p[1] = 2;
+  p[2] = 3;
+
+  int32_t ib = cache.FindOrAdd(b.data(), b.size(), &found);
+  EXPECT_FALSE(found);
+  EXPECT_EQ(ib, 1);
+  cache.Data(ib)[0] = 10;
+
+  EXPECT_EQ(cache.FindOrAdd(a.data(), a.size(), &found), ia);
+  EXPECT_TRUE(found);
+  EXPECT_EQ(cache.Data(ia)[0], 1);
+  EXPECT_EQ(cache.Data(ia)[2], 3);
+
+  EXPECT_EQ(cache.FindOrAdd(b.data(), b.size(), &found), ib);
+  EXPECT_TRUE(found);
+  EXPECT_EQ(cache.Data(ib)[0], 10);
+
+  EXPECT_EQ(cache.Size(), 2);
+  EXPECT_EQ(cache.NumHits(), 2);
+  EXPECT_EQ(cache.NumMisses(), 2);
+  EXPECT_FLOAT_EQ(cache.HitRate(), 0.5);
+}
+
+TEST(DecoderOutCache, SetDimAfterAdd) {
+  // The decoder output dim is known only after the first decoder run,
+  // i.e., after the first entries are added.
+  DecoderOutCache cache(2);
+  EXPECT_EQ(cache.HitRate(), 0);
+
+  std::vector<int64_t> a = {1, 2};
+  bool found = true;
+  int32_t i = cache.FindOrAdd(a.data(), a.size(), &found);
+  EXPECT_FALSE(found);
+
+  cache.SetDim(4);
+  cache.Data(i)[3] = 7;
+
+  EXPECT_EQ(cache.FindOrAdd(a.data(), a.size(), &found), i);
+  EXPECT_TRUE(found);
+  EXPECT_EQ(cache.Data(i)[3], 7);
+}
+
+TEST(DecoderOutCache, MakeRoom) {
+  DecoderOutCache cache(2);
+  cache.SetDim(1);
+
+  std::vector<int64_t> a = {1};
+  std::vector<int64_t> b = {2};
+  bool found = false;
+
+  cache.FindOrAdd(a.data(), a.size(), &found);
+  cache.FindOrAdd(b.data(), b.size(), &found);
+  EXPECT_EQ(cache.Size(), 2);
+
+  cache.MakeRoom(0);
+  EXPECT_EQ(cache.Size(), 2);
+
+  cache.MakeRoom(1);
+  EXPECT_EQ(cache.Size(), 0);
+
+  cache.FindOrAdd(a.data(), a.size(), &found);
+  EXPECT_FALSE(found);
+}
+
+}  // namespace sherpa_onnx
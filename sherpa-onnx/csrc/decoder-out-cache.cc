@@ -0,0 +1,86 @@
+// sherpa-onnx/csrc/decoder-out-cache.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/decoder-out-cache.h"
+
+#include <algorithm>
+#include <functional>
+
+#include "sherpa-onnx/csrc/macros.h"
+
+namespace sherpa_onnx {
+
+std::size_t DecoderOutCache::KeyHash::operator()(
+    const std::vector<int64_t> &key) const {
+  std::size_t seed = key.size();
+  std::hash<int64_t> hasher;
+  for (auto i : key) {
+    seed ^= hasher(i) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+  }
+  return seed;
+}
+
+DecoderOutCache::DecoderOutCache(int32_t capacity) : capacity_(capacity) {
+  if (capacity <= 0) {
+    SHERPA_ONNX_LOGE("Please specify a positive capacity. Given: %d\n",
+                     capacity);
+    exit(-1);
+  }
+  index_.reserve(capacity);
+}
+
+void DecoderOutCache::MakeRoom(int32_t n) {
+  if (Size() + n > capacity_) {
+    Clear();
+  }
+}
+
+int32_t DecoderOutCache::FindOrAdd(const int64_t *context,
+                                   int32_t context_size, bool *found) {
+  key_.assign(context, context + context_size);
+
+  auto it = index_.find(key_);
+  if (it != index_.end()) {
+    *found = true;
+    ++num_hits_;
+    return it->second;
+  }
+
+  *found = false;
+  ++num_misses_;
+
+  int32_t index = Size();
+  index_.emplace(key_, index);
+
+  if (dim_ > 0 && static_cast<int32_t>(storage_.size()) < Size() * dim_) {
+    storage_.resize(Size() * dim_);
+  }
+
+  return index;
+}
+
+void DecoderOutCache::SetDim(int32_t dim) {
+  if (dim_ == dim) {
+    return;
+  }
+
+  if (dim_ != 0) {
+    SHERPA_ONNX_LOGE("Decoder output dim changed from %d to %d", dim_, dim);
+    Clear();
+  }
+
+  dim_ = dim;
+  storage_.resize(std::max(Size(), capacity_) * dim_);
+}
+
+float DecoderOutCache::HitRate() const {
+  int64_t total = num_hits_ + num_misses_;
+  if (total == 0) {
+    return 0;
+  }
+
+  return static_cast<float>(num_hits_) / total;
+}
+
+}  // namespace sherpa_onnx
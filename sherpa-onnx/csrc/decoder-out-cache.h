@@ -0,0 +1,77 @@
+// sherpa-onnx/csrc/decoder-out-cache.h
+//
+// Copyright (c)  2025  Xiaomi Corporation
+#ifndef SHERPA_ONNX_CSRC_DECODER_OUT_CACHE_H_
+#define SHERPA_ONNX_CSRC_DECODER_OUT_CACHE_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace sherpa_onnx {
+
+// Cache the output of a stateless transducer decoder.
+//
+// The decoder output depends only on the last context_size tokens of a
+// hypothesis, so it is keyed by that token tuple. Each entry is identified
+// by a dense index in [0, Size()) that stays valid until Clear() is called.
+class DecoderOutCache {
+ public:
+  // @param capacity Maximum number of entries. See MakeRoom().
+  explicit DecoderOutCache(int32_t capacity = 256);
+
+  // Clear the cache if adding n more entries would exceed its capacity.
+  // Call it before a round of FindOrAdd() so that indexes returned in
+  // that round are not invalidated.
+  void MakeRoom(int32_t n);
+
+  // @param context Pointer to an array of context_size tokens.
+  // @param context_size Number of tokens in context.
+  // @param found On return, it is true if the entry existed before;
+  //              false if it was just added. The caller should fill
+  //              Data(index) for a newly added entry.
+  // @return Return the index of the entry.
+  int32_t FindOrAdd(const int64_t *context, int32_t context_size,
+                    bool *found);
+
+  // Dimension of each entry. It must be set before calling Data().
+  void SetDim(int32_t dim);
+  int32_t Dim() const { return dim_; }
+
+  // @return Return a pointer to an array of Dim() floats.
+  float *Data(int32_t index) { return storage_.data() + index * dim_; }
+  const float *Data(int32_t index) const {
+    return storage_.data() + index * dim_;
+  }
+
+  int32_t Size() const { return static_cast<int32_t>(index_.size()); }
+
+  void Clear() { index_.clear(); }
+
+  int64_t NumHits() const { return num_hits_; }
+  int64_t NumMisses() const { return num_misses_; }
+
+  // Fraction of lookups served from the cache. 0 if there is no lookup yet.
+  float HitRate() const;
+
+ private:
+  struct KeyHash {
+    std::size_t operator()(const std::vector<int64_t> &key) const;
+  };
+
+  int32_t capacity_;
+  int32_t dim_ = 0;
+
+  std::unordered_map<std::vector<int64_t>, int32_t, KeyHash> index_;
+  std::vector<float> storage_;
+
+  // Reused for lookups to avoid allocating a key for each of them
+  std::vector<int64_t> key_;
+
+  int64_t num_hits_ = 0;
+  int64_t num_misses_ = 0;
+};
+
+}  // namespace sherpa_onnx
+
+#endif  // SHERPA_ONNX_CSRC_DECODER_OUT_CACHE_H_
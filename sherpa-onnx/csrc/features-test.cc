@@ -0,0 +1,95 @@
+// sherpa-onnx/csrc/features-test.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/features.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace sherpa_onnx {
+
+// Append all frames that are ready to *features. *num_frames is the number
+// of frames read so far.
+static void ReadFrames(const FeatureExtractor &extractor, int32_t *num_frames,
+                       std::vector<float> *features) {
+  int32_t n = extractor.NumFramesReady() - *num_frames;
+  if (n <= 0) {
+    return;
+  }
+
+  auto f = extractor.GetFrames(*num_frames, n);
+  features->insert(features->end(), f.begin(), f.end());
+  *num_frames += n;
+}
+
+static void CheckRestartFrameIndex(const FeatureExtractorConfig &config) {
+  FeatureExtractor expected_extractor(config);
+  FeatureExtractor extractor(config);
+
+  std::mt19937 gen(config.snip_edges);
+  std::uniform_real_distribution<float> dist(-0.5, 0.5);
+  std::uniform_int_distribution<int32_t> chunk_dist(1, 900);
+
+  std::vector<float> samples(3 * 16000);
+  for (auto &x : samples) {
+    x = dist(gen);
+  }
+
+  std::vector<float> expected;
+  std::vector<float> features;
+  int32_t expected_num_frames = 0;
+  int32_t num_frames = 0;
+
+  size_t start = 0;
+  for (int32_t k = 0; start < samples.size(); ++k) {
+    int32_t n = std::min<int32_t>(chunk_dist(gen), samples.size() - start);
+    expected_extractor.AcceptWaveform(16000, samples.data() + start, n);
+    extractor.AcceptWaveform(16000, samples.data() + start, n);
+    start += n;
+
+    ReadFrames(expected_extractor, &expected_num_frames, &expected);
+    ReadFrames(extractor, &num_frames, &features);
+
+    if (k % 3 == 2) {
+      extractor.RestartFrameIndex();
+      num_frames = 0;
+      ASSERT_EQ(extractor.NumFramesReady(), 0);
+    }
+  }
+
+  expected_extractor.InputFinished();
+  extractor.InputFinished();
+
+  ReadFrames(expected_extractor, &expected_num_frames, &expected);
+  ReadFrames(extractor, &num_frames, &features);
+  EXPECT_TRUE(extractor.IsLastFrame(num_frames - 1));
+
+  // Without dither, the frames are exactly the same as without restarting
+  EXPECT_EQ(features, expected);
+}
+
+TEST(FeatureExtractor, RestartFrameIndex) {
+  FeatureExtractorConfig config;
+  CheckRestartFrameIndex(config);
+
+  config.snip_edges = true;
+  CheckRestartFrameIndex(config);
+}
+
+TEST(FeatureExtractor, RestartFrameIndexSimdFbank) {
+  FeatureExtractorConfig config;
+  config.fbank_backend = "simd";
+  CheckRestartFrameIndex(config);
+}
+
+TEST(FeatureExtractor, RestartFrameIndexMfcc) {
+  FeatureExtractorConfig config;
+  config.is_mfcc = true;
+  CheckRestartFrameIndex(config);
+}
+
+}  // namespace sherpa_onnx
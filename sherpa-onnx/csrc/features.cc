@@ -12,7 +12,9 @@
 
 #include "kaldi-native-fbank/csrc/online-feature.h"
 #include "sherpa-onnx/csrc/macros.h"
+#include "sherpa-onnx/csrc/polyphase-resample.h"
 #include "sherpa-onnx/csrc/resample.h"
+#include "sherpa-onnx/csrc/simd-fbank.h"
 
 namespace sherpa_onnx {
 
@@ -38,6 +40,16 @@ void FeatureExtractorConfig::Register(ParseOptions *po) {
                "By default the audio samples are in range [-1,+1], "
                "so 0.00003 is a good value, "
                "equivalent to the default 1.0 from kaldi");
+
+  po->Register("resampler", &resampler,
+               "Resampler for input waveforms whose sample rate differs from "
+               "--sample-rate. Valid values: linear, polyphase. polyphase "
+               "gives the same output up to rounding, but is faster");
+
+  po->Register("fbank-backend", &fbank_backend,
+               "Implementation of fbank features. Valid values: knf, simd. "
+               "simd gives the same output up to rounding, but is faster. "
+               "It falls back to knf for unsupported options, e.g., dither");
 }
 
 std::string FeatureExtractorConfig::ToString() const {
@@ -50,7 +62,9 @@ std::string FeatureExtractorConfig::ToString() const {
   os << "high_freq=" << high_freq << ", ";
   os << "dither=" << dither << ", ";
   os << "normalize_samples=" << (normalize_samples ? "True" : "False") << ", ";
-  os << "snip_edges=" << (snip_edges ? "True" : "False") << ")";
+  os << "snip_edges=" << (snip_edges ? "True" : "False") << ", ";
+  os << "resampler=\"" << resampler << "\", ";
+  os << "fbank_backend=\"" << fbank_backend << "\")";
 
   return os.str();
 }
@@ -66,10 +80,13 @@ class FeatureExtractor::Impl {
   }
 
   void AcceptWaveform(int32_t sampling_rate, const float *waveform, int32_t n) {
+    auto lock = Lock();
+
     if (config_.normalize_samples) {
       AcceptWaveformImpl(sampling_rate, waveform, n);
     } else {
-      std::vector<float> buf(n);
+      std::vector<float> &buf = scaled_;
+      buf.resize(n);
       for (int32_t i = 0; i != n; ++i) {
         buf[i] = waveform[i] * 32768;
       }
@@ -77,28 +94,24 @@ class FeatureExtractor::Impl {
     }
   }
 
+  // The caller should hold mutex_
   void AcceptWaveformImpl(int32_t sampling_rate, const float *waveform,
                           int32_t n) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    if (resampler_) {
-      if (sampling_rate != resampler_->GetInputSamplingRate()) {
+    if (resampler_ || polyphase_resampler_) {
+      int32_t input_sampling_rate =
+          resampler_ ? resampler_->GetInputSamplingRate()
+                     : polyphase_resampler_->GetInputSamplingRate();
+      if (sampling_rate != input_sampling_rate) {
         SHERPA_ONNX_LOGE(
             "You changed the input sampling rate!! Expected: %d, given: "
             "%d",
-            resampler_->GetInputSamplingRate(), sampling_rate);
+            input_sampling_rate, sampling_rate);
         exit(-1);
       }
 
-      std::vector<float> samples;
-      resampler_->Resample(waveform, n, false, &samples);
-      if (fbank_) {
-        fbank_->AcceptWaveform(config_.sampling_rate, samples.data(),
-                               samples.size());
-      } else {
-        mfcc_->AcceptWaveform(config_.sampling_rate, samples.data(),
-                              samples.size());
-      }
+      std::vector<float> &samples = resampled_;
+      Resample(waveform, n, &samples);
+      Feed(samples.data(), samples.size());
       return;
     }
 
@@ -113,74 +126,108 @@ class FeatureExtractor::Impl {
       float lowpass_cutoff = 0.99 * 0.5 * min_freq;
 
       int32_t lowpass_filter_width = 6;
-      resampler_ = std::make_unique<LinearResample>(
-          sampling_rate, config_.sampling_rate, lowpass_cutoff,
-          lowpass_filter_width);
-
-      std::vector<float> samples;
-      resampler_->Resample(waveform, n, false, &samples);
-      if (fbank_) {
-        fbank_->AcceptWaveform(config_.sampling_rate, samples.data(),
-                               samples.size());
+      if (config_.resampler == "polyphase") {
+        polyphase_resampler_ = std::make_unique<PolyphaseResample>(
+            sampling_rate, config_.sampling_rate, lowpass_cutoff,
+            lowpass_filter_width);
+      } else if (config_.resampler == "linear") {
+        resampler_ = std::make_unique<LinearResample>(
+            sampling_rate, config_.sampling_rate, lowpass_cutoff,
+            lowpass_filter_width);
       } else {
-        mfcc_->AcceptWaveform(config_.sampling_rate, samples.data(),
-                              samples.size());
+        SHERPA_ONNX_LOGE("Unknown resampler: '%s'. Valid values: linear, "
+                         "polyphase",
+                         config_.resampler.c_str());
+        exit(-1);
       }
+
+      std::vector<float> &samples = resampled_;
+      Resample(waveform, n, &samples);
+      Feed(samples.data(), samples.size());
       return;
     }
 
-    if (fbank_) {
-      fbank_->AcceptWaveform(sampling_rate, waveform, n);
-    } else {
-      mfcc_->AcceptWaveform(sampling_rate, waveform, n);
-    }
+    Feed(waveform, n);
   }
 
-  void InputFinished() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    fbank_->InputFinished();
+  void InputFinished() {
+    auto lock = Lock();
+    WithExtractor([](auto *extractor) { extractor->InputFinished(); });
+    input_finished_ = true;
   }
 
   int32_t NumFramesReady() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return fbank_->NumFramesReady();
+    auto lock = Lock();
+    int32_t n = WithExtractor(
+        [](auto *extractor) { return extractor->NumFramesReady(); });
+    return std::max(n - num_skipped_frames_, 0);
   }
 
   bool IsLastFrame(int32_t frame) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return fbank_->IsLastFrame(frame);
+    auto lock = Lock();
+    frame += num_skipped_frames_;
+    return WithExtractor(
+        [frame](auto *extractor) { return extractor->IsLastFrame(frame); });
   }
 
   std::vector<float> GetFrames(int32_t frame_index, int32_t n) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (frame_index + n > fbank_->NumFramesReady()) {
-      SHERPA_ONNX_LOGE("%d + %d > %d\n", frame_index, n,
-                       fbank_->NumFramesReady());
-      exit(-1);
+    std::vector<float> features(FeatureDim() * n);
+    GetFrames(frame_index, n, features.data());
+    return features;
+  }
+
+  void GetFrames(int32_t frame_index, int32_t n, float *p) {
+    auto lock = Lock();
+    frame_index += num_skipped_frames_;
+    WithExtractor([this, frame_index, n, p](auto *extractor) {
+      GetFramesImpl(extractor, frame_index, n, p);
+    });
+  }
+
+  bool RestartFrameIndex() {
+    auto lock = Lock();
+    if (input_finished_) {
+      return false;
     }
 
-    int32_t discard_num = frame_index - last_frame_index_;
-    if (discard_num < 0) {
-      SHERPA_ONNX_LOGE("last_frame_index_: %d, frame_index_: %d",
-                       last_frame_index_, frame_index);
-      exit(-1);
+    int32_t num_frames = WithExtractor(
+        [](auto *extractor) { return extractor->NumFramesReady(); });
+    int32_t num_warmup_frames = NumWarmupFrames();
+    if (num_frames < num_warmup_frames) {
+      return false;
     }
-    fbank_->Pop(discard_num);
 
-    int32_t feature_dim = fbank_->Dim();
-    std::vector<float> features(feature_dim * n);
+    // Frame num_frames, the next one, becomes frame num_warmup_frames of
+    // the new extractor. Its first num_warmup_frames frames reflect the
+    // samples before the start and are skipped.
+    int64_t first_sample =
+        static_cast<int64_t>(num_frames - num_warmup_frames) * frame_shift_;
+    int64_t num_samples = num_samples_ - first_sample;
+    if (num_samples < 0 ||
+        num_samples > static_cast<int64_t>(history_.size())) {
+      SHERPA_ONNX_LOGE("Need %d samples to restart, but only %d are kept",
+                       static_cast<int32_t>(num_samples),
+                       static_cast<int32_t>(history_.size()));
+      exit(-1);
+    }
 
-    float *p = features.data();
+    std::vector<float> samples(history_.end() - num_samples, history_.end());
+    history_.clear();
+    num_samples_ = 0;
 
-    for (int32_t i = 0; i != n; ++i) {
-      const float *f = fbank_->GetFrame(i + frame_index);
-      std::copy(f, f + feature_dim, p);
-      p += feature_dim;
+    if (mfcc_) {
+      mfcc_ = std::make_unique<knf::OnlineMfcc>(mfcc_opts_);
+    } else if (simd_fbank_) {
+      simd_fbank_ = std::make_unique<SimdFbank>(opts_);
+    } else {
+      fbank_ = std::make_unique<knf::OnlineFbank>(opts_);
     }
+    last_frame_index_ = 0;
+    num_skipped_frames_ = num_warmup_frames;
 
-    last_frame_index_ = frame_index;
+    Feed(samples.data(), samples.size());
 
-    return features;
+    return true;
   }
 
   int32_t FeatureDim() const {
@@ -205,8 +252,26 @@ class FeatureExtractor::Impl {
 
     opts_.mel_opts.is_librosa = config_.is_librosa;
 
+    InitHistory(opts_.frame_opts);
+
+    if (config_.fbank_backend == "simd") {
+      std::string reason;
+      if (SimdFbank::IsSupported(opts_, &reason)) {
+        simd_fbank_ = std::make_unique<SimdFbank>(opts_);
+        return;
+      }
+
+      SHERPA_ONNX_LOGE("Use knf for fbank since simd does not support it: %s",
+                       reason.c_str());
+    } else if (config_.fbank_backend != "knf") {
+      SHERPA_ONNX_LOGE("Unknown fbank backend: '%s'. Valid values: knf, simd",
+                       config_.fbank_backend.c_str());
+      exit(-1);
+    }
+
     fbank_ = std::make_unique<knf::OnlineFbank>(opts_);
   }
+
   void InitMfcc() {
     mfcc_opts_.frame_opts.dither = config_.dither;
     mfcc_opts_.frame_opts.snip_edges = config_.snip_edges;
@@ -227,18 +292,137 @@ class FeatureExtractor::Impl {
     mfcc_opts_.num_ceps = config_.num_ceps;
     mfcc_opts_.use_energy = config_.use_energy;
 
+    InitHistory(mfcc_opts_.frame_opts);
+
     mfcc_ = std::make_unique<knf::OnlineMfcc>(mfcc_opts_);
   }
 
+  void InitHistory(const knf::FrameExtractionOptions &frame_opts) {
+    // The same as knf::FrameExtractionOptions::WindowSize() and
+    // WindowShift()
+    frame_length_ = static_cast<int32_t>(frame_opts.samp_freq * 0.001f *
+                                         frame_opts.frame_length_ms);
+    frame_shift_ = static_cast<int32_t>(frame_opts.samp_freq * 0.001f *
+                                        frame_opts.frame_shift_ms);
+
+    // Enough samples for RestartFrameIndex(). The next frame starts less
+    // than frame_length_ samples before the end of the input.
+    history_.reserve(frame_length_ + (NumWarmupFrames() + 1) * frame_shift_);
+  }
+
+  // The caller should hold mutex_
+  template <typename Extractor>
+  void GetFramesImpl(Extractor *extractor, int32_t frame_index, int32_t n,
+                     float *p) {
+    if (frame_index + n > extractor->NumFramesReady()) {
+      SHERPA_ONNX_LOGE("%d + %d > %d\n", frame_index, n,
+                       extractor->NumFramesReady());
+      exit(-1);
+    }
+
+    int32_t discard_num = frame_index - last_frame_index_;
+    if (discard_num < 0) {
+      SHERPA_ONNX_LOGE("last_frame_index_: %d, frame_index_: %d",
+                       last_frame_index_, frame_index);
+      exit(-1);
+    }
+    extractor->Pop(discard_num);
+
+    int32_t feature_dim = extractor->Dim();
+
+    for (int32_t i = 0; i != n; ++i) {
+      const float *f = extractor->GetFrame(i + frame_index);
+      std::copy(f, f + feature_dim, p);
+      p += feature_dim;
+    }
+
+    last_frame_index_ = frame_index;
+  }
+
+  // Number of frames at the start of an extractor whose samples are
+  // partly reflected from the samples after them
+  int32_t NumWarmupFrames() const {
+    if (config_.snip_edges) {
+      return 0;
+    }
+
+    // Frame f starts at f * shift + shift / 2 - length / 2
+    int32_t d = frame_length_ / 2 - frame_shift_ / 2;
+    return d <= 0 ? 0 : (d + frame_shift_ - 1) / frame_shift_;
+  }
+
+  // Feed samples at config_.sampling_rate to the extractor.
+  // The caller should hold mutex_.
+  void Feed(const float *samples, int32_t n) {
+    WithExtractor([this, samples, n](auto *extractor) {
+      extractor->AcceptWaveform(config_.sampling_rate, samples, n);
+    });
+
+    // Keep the last history_.capacity() samples for RestartFrameIndex()
+    num_samples_ += n;
+    int32_t capacity = history_.capacity();
+    if (n >= capacity) {
+      history_.assign(samples + n - capacity, samples + n);
+    } else {
+      int32_t num_kept = std::min<int32_t>(history_.size(), capacity - n);
+      history_.erase(history_.begin(), history_.end() - num_kept);
+      history_.insert(history_.end(), samples, samples + n);
+    }
+  }
+
+  // Call f with the extractor in use. The caller should hold mutex_.
+  template <typename F>
+  auto WithExtractor(F f) const
+      -> decltype(f(static_cast<knf::OnlineFbank *>(nullptr))) {
+    if (mfcc_) {
+      return f(mfcc_.get());
+    }
+    if (simd_fbank_) {
+      return f(simd_fbank_.get());
+    }
+    return f(fbank_.get());
+  }
+
+  // Return a lock that does not own mutex_ in single-threaded mode
+  std::unique_lock<std::mutex> Lock() const {
+    if (config_.single_threaded) {
+      return {};
+    }
+    return std::unique_lock<std::mutex>(mutex_);
+  }
+
+  // The caller should hold mutex_ and have created a resampler
+  void Resample(const float *waveform, int32_t n, std::vector<float> *out) {
+    if (resampler_) {
+      resampler_->Resample(waveform, n, false, out);
+    } else {
+      polyphase_resampler_->Resample(waveform, n, false, out);
+    }
+  }
+
  private:
   std::unique_ptr<knf::OnlineFbank> fbank_;
+  std::unique_ptr<SimdFbank> simd_fbank_;
   std::unique_ptr<knf::OnlineMfcc> mfcc_;
   knf::FbankOptions opts_;
   knf::MfccOptions mfcc_opts_;
   FeatureExtractorConfig config_;
   mutable std::mutex mutex_;
   std::unique_ptr<LinearResample> resampler_;
+  std::unique_ptr<PolyphaseResample> polyphase_resampler_;
   int32_t last_frame_index_ = 0;
+  bool input_finished_ = false;
+
+  // For RestartFrameIndex()
+  int32_t frame_length_ = 0;  // in samples
+  int32_t frame_shift_ = 0;   // in samples
+  int32_t num_skipped_frames_ = 0;
+  int64_t num_samples_ = 0;  // fed to the current extractor
+  std::vector<float> history_;
+
+  // Scratch buffers reused across calls to AcceptWaveform()
+  std::vector<float> scaled_;
+  std::vector<float> resampled_;
 };
 
 FeatureExtractor::FeatureExtractor(const FeatureExtractorConfig &config /*={}*/)
@@ -266,6 +450,15 @@ std::vector<float> FeatureExtractor::GetFrames(int32_t frame_index,
   return impl_->GetFrames(frame_index, n);
 }
 
+void FeatureExtractor::GetFrames(int32_t frame_index, int32_t n,
+                                 float *out) const {
+  impl_->GetFrames(frame_index, n, out);
+}
+
+bool FeatureExtractor::RestartFrameIndex() const {
+  return impl_->RestartFrameIndex();
+}
+
 int32_t FeatureExtractor::FeatureDim() const { return impl_->FeatureDim(); }
 
 }  // namespace sherpa_onnx
@@ -79,6 +79,36 @@ struct FeatureExtractorConfig {
 
   bool is_mfcc = false;
 
+  // Resampler used when the sampling rate of the input waveform differs
+  // from sampling_rate. Possible values:
+  // - linear: LinearResample from resample.h
+  // - polyphase: PolyphaseResample from polyphase-resample.h. Same output
+  //   up to rounding, but faster.
+  std::string resampler = "linear";
+
+  // Implementation of fbank features. Possible values:
+  // - knf: knf::OnlineFbank from kaldi-native-fbank
+  // - simd: SimdFbank from simd-fbank.h. Same output up to rounding, but
+  //   faster. It falls back to knf for options it does not support,
+  //   e.g., dither.
+  // Not used by MFCC.
+  std::string fbank_backend = "knf";
+
+  // If true, FeatureExtractor does not lock its internal mutex. Set it only
+  // if each stream is used by a single thread, e.g., the decoding thread
+  // that also feeds it audio. If audio comes from another thread, keep it
+  // false, or hand the audio over through an SpscRingBuffer (see
+  // spsc-ring-buffer.h) and feed the stream from the decoding thread.
+  // This parameter is not exposed to users from the commandline.
+  bool single_threaded = false;
+
+  // OnlineStream restarts the frame indexes of its FeatureExtractor, see
+  // FeatureExtractor::RestartFrameIndex(), once it holds this many frames,
+  // i.e., about every 124 days with a 10 ms frame shift by default. It must
+  // be less than 2^31. Tests set it lower to exercise the restart.
+  // This parameter is not exposed to users from the commandline.
+  int32_t max_extractor_frames = 1 << 30;
+
   std::string ToString() const;
 
   void Register(ParseOptions *po);
@@ -124,6 +154,26 @@ class FeatureExtractor {
    */
   std::vector<float> GetFrames(int32_t frame_index, int32_t n) const;
 
+  /** Same as the above one, but write the frames to a caller-provided buffer
+   * so that no memory is allocated.
+   *
+   * @param out  Pointer to an array of size n * FeatureDim().
+   */
+  void GetFrames(int32_t frame_index, int32_t n, float *out) const;
+
+  /** Discard all frames that are ready and restart frame indexes from 0.
+   *
+   * Frame indexes are int32_t and would overflow after about 248 days of
+   * audio with a 10 ms frame shift. A caller that streams for longer, e.g.,
+   * OnlineStream, copies out the ready frames it still needs and then calls
+   * this method from time to time. The frames after the call are the same
+   * as without it, since the samples they still need are fed again to a new
+   * fbank or MFCC extractor. It does nothing after InputFinished().
+   *
+   * @return Return false if it does nothing.
+   */
+  bool RestartFrameIndex() const;
+
   /// Return feature dim of this extractor
   int32_t FeatureDim() const;
 
@@ -0,0 +1,83 @@
+// sherpa-onnx/csrc/file-watcher-test.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/file-watcher.h"
+
+#include <chrono>  // NOLINT
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <mutex>  // NOLINT
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace sherpa_onnx {
+
+namespace {
+
+class Counter {
+ public:
+  void Increment() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++count_;
+    cv_.notify_all();
+  }
+
+  // Return true if count reaches n within 5 seconds
+  bool WaitFor(int32_t n) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, std::chrono::seconds(5),
+                        [this, n]() { return count_ >= n; });
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  int32_t count_ = 0;
+};
+
+void WriteFile(const std::string &filename, const std::string &text) {
+  std::ofstream os(filename);
+  os << text;
+}
+
+}  // namespace
+
+TEST(FileWatcher, Write) {
+  std::string filename = "./file-watcher-test-write.txt";
+  WriteFile(filename, "a");
+
+  Counter counter;
+  FileWatcher watcher(
+      filename, [&counter](const std::string &) { counter.Increment(); }, 50);
+
+  // Make the modification time differ for the polling fallback
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  WriteFile(filename, "b");
+  EXPECT_TRUE(counter.WaitFor(1));
+
+  watcher.Stop();
+  std::remove(filename.c_str());
+}
+
+TEST(FileWatcher, Rename) {
+  std::string filename = "./file-watcher-test-rename.txt";
+  std::string tmp = filename + ".tmp";
+  WriteFile(filename, "a");
+
+  Counter counter;
+  FileWatcher watcher(
+      filename, [&counter](const std::string &) { counter.Increment(); }, 50);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  WriteFile(tmp, "b");
+  std::rename(tmp.c_str(), filename.c_str());
+  EXPECT_TRUE(counter.WaitFor(1));
+
+  watcher.Stop();
+  std::remove(filename.c_str());
+}
+
+}  // namespace sherpa_onnx
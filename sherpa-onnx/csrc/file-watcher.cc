@@ -0,0 +1,145 @@
+// sherpa-onnx/csrc/file-watcher.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/file-watcher.h"
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <chrono>  // NOLINT
+#include <utility>
+
+#include "sherpa-onnx/csrc/macros.h"
+
+namespace sherpa_onnx {
+
+static int64_t GetModificationTimeNs(const std::string &filename) {
+  struct stat st;
+  if (::stat(filename.c_str(), &st) != 0) {
+    return -1;
+  }
+
+#if defined(__linux__)
+  return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 +
+         st.st_mtim.tv_nsec;
+#else
+  return static_cast<int64_t>(st.st_mtime) * 1000000000;
+#endif
+}
+
+FileWatcher::FileWatcher(const std::string &filename, Callback callback,
+                         int32_t poll_interval_ms /*= 500*/)
+    : filename_(filename),
+      callback_(std::move(callback)),
+      poll_interval_ms_(poll_interval_ms) {
+  auto pos = filename_.find_last_of('/');
+  if (pos == std::string::npos) {
+    dir_ = ".";
+    basename_ = filename_;
+  } else {
+    dir_ = pos == 0 ? "/" : filename_.substr(0, pos);
+    basename_ = filename_.substr(pos + 1);
+  }
+
+#if defined(__linux__)
+  inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotify_fd_ != -1 &&
+      inotify_add_watch(inotify_fd_, dir_.c_str(),
+                        IN_CLOSE_WRITE | IN_MOVED_TO) == -1) {
+    close(inotify_fd_);
+    inotify_fd_ = -1;
+  }
+
+  if (inotify_fd_ == -1) {
+    SHERPA_ONNX_LOGE("Failed to watch %s with inotify. Poll it instead.",
+                     dir_.c_str());
+  }
+#endif
+
+  last_mtime_ns_ = GetModificationTimeNs(filename_);
+
+  thread_ = std::thread([this]() { Run(); });
+}
+
+FileWatcher::~FileWatcher() {
+  Stop();
+
+#if defined(__linux__)
+  if (inotify_fd_ != -1) {
+    close(inotify_fd_);
+  }
+#endif
+}
+
+void FileWatcher::Stop() {
+  stop_ = true;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void FileWatcher::Run() {
+  while (!stop_) {
+    bool changed =
+        inotify_fd_ != -1 ? WaitInotify() : PollModificationTime();
+
+    if (changed && !stop_) {
+      callback_(filename_);
+    }
+  }
+}
+
+bool FileWatcher::WaitInotify() {
+#if defined(__linux__)
+  struct pollfd pfd;
+  pfd.fd = inotify_fd_;
+  pfd.events = POLLIN;
+
+  if (poll(&pfd, 1, poll_interval_ms_) <= 0) {
+    return false;
+  }
+
+  alignas(struct inotify_event) char buf[4096];
+  bool changed = false;
+
+  while (true) {
+    ssize_t len = read(inotify_fd_, buf, sizeof(buf));
+    if (len <= 0) {
+      break;
+    }
+
+    for (char *p = buf; p < buf + len;) {
+      auto event = reinterpret_cast<const struct inotify_event *>(p);
+      if (event->len > 0 && basename_ == event->name) {
+        changed = true;
+      }
+      p += sizeof(struct inotify_event) + event->len;
+    }
+  }
+
+  return changed;
+#else
+  return false;
+#endif
+}
+
+bool FileWatcher::PollModificationTime() {
+  std::this_thread::sleep_for(std::chrono::milliseconds(poll_interval_ms_));
+
+  int64_t mtime_ns = GetModificationTimeNs(filename_);
+  if (mtime_ns == -1 || mtime_ns == last_mtime_ns_) {
+    return false;
+  }
+
+  last_mtime_ns_ = mtime_ns;
+  return true;
+}
+
+}  // namespace sherpa_onnx
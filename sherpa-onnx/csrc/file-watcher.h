@@ -0,0 +1,67 @@
+// sherpa-onnx/csrc/file-watcher.h
+//
+// Copyright (c)  2025  Xiaomi Corporation
+#ifndef SHERPA_ONNX_CSRC_FILE_WATCHER_H_
+#define SHERPA_ONNX_CSRC_FILE_WATCHER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>  // NOLINT
+
+namespace sherpa_onnx {
+
+// Watch a file and invoke a callback from a background thread each time the
+// file is changed.
+//
+// On Linux, it uses inotify on the directory of the file, so that it also
+// works for editors and tools that replace the file with rename(). A change
+// is reported once the writer has closed the file. On other platforms, or
+// if inotify is not available, it polls the modification time of the file.
+class FileWatcher {
+ public:
+  using Callback = std::function<void(const std::string &filename)>;
+
+  // @param filename The file to watch. It does not need to exist yet.
+  // @param callback It is invoked from the watcher thread with filename.
+  // @param poll_interval_ms Interval for checking whether Stop() is called
+  //                         and, if inotify is not used, for polling the
+  //                         modification time.
+  FileWatcher(const std::string &filename, Callback callback,
+              int32_t poll_interval_ms = 500);
+
+  FileWatcher(const FileWatcher &) = delete;
+  FileWatcher &operator=(const FileWatcher &) = delete;
+
+  ~FileWatcher();
+
+  // Stop the watcher thread. The callback is not invoked after it returns.
+  void Stop();
+
+ private:
+  void Run();
+
+  // Return true if inotify reported a change to the file in poll_interval_ms
+  bool WaitInotify();
+
+  // Return true if the modification time of the file has changed
+  bool PollModificationTime();
+
+ private:
+  std::string filename_;
+  std::string dir_;
+  std::string basename_;
+  Callback callback_;
+  int32_t poll_interval_ms_;
+
+  int32_t inotify_fd_ = -1;
+  int64_t last_mtime_ns_ = -1;
+
+  std::atomic<bool> stop_{false};
+  std::thread thread_;
+};
+
+}  // namespace sherpa_onnx
+
+#endif  // SHERPA_ONNX_CSRC_FILE_WATCHER_H_
@@ -0,0 +1,126 @@
+// sherpa-onnx/csrc/hypothesis-arena-test.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/hypothesis-arena.h"
+
+#include <array>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace sherpa_onnx {
+
+TEST(HypothesisArena, ImportExport) {
+  Hypothesis hyp({-1, 0, 5, 8}, -1.5);
+  hyp.timestamps = {3, 7};
+  hyp.ys_probs = {0.5, 0.25};
+  hyp.context_scores = {1, 2};
+  hyp.num_trailing_blanks = 2;
+
+  HypothesisArena arena;
+  ArenaHypothesis h = arena.Import(hyp);
+  EXPECT_EQ(h.num_tokens, 4);
+  EXPECT_EQ(arena.Size(), 4);
+
+  h = arena.Extend(h, 9, 10, 0.75, 3);
+  EXPECT_EQ(h.num_tokens, 5);
+  EXPECT_EQ(arena.Size(), 5);
+
+  std::vector<int64_t> context(2);
+  arena.LastTokens(h, 2, context.data());
+  EXPECT_EQ(context, (std::vector<int64_t>{8, 9}));
+
+  Hypothesis out = arena.Export(h, true);
+  EXPECT_EQ(out.ys, (std::vector<int64_t>{-1, 0, 5, 8, 9}));
+  EXPECT_EQ(out.timestamps, (std::vector<int32_t>{3, 7, 10}));
+  EXPECT_EQ(out.ys_probs, (std::vector<float>{0.5, 0.25, 0.75}));
+  EXPECT_EQ(out.context_scores, (std::vector<float>{1, 2, 3}));
+  EXPECT_EQ(out.log_prob, -1.5);
+  EXPECT_EQ(out.num_trailing_blanks, 2);
+
+  out = arena.Export(h, false);
+  EXPECT_TRUE(out.context_scores.empty());
+}
+
+TEST(HypothesisArena, LmStates) {
+  Ort::AllocatorWithDefaultOptions allocator;
+  std::array<int64_t, 2> shape{1, 1};
+  Ort::Value state = Ort::Value::CreateTensor<float>(allocator, shape.data(),
+                                                     shape.size());
+  *state.GetTensorMutableData<float>() = 3;
+
+  Hypothesis hyp({-1, 0, 5}, -1.5);
+  hyp.timestamps = {3};
+  hyp.ys_probs = {0.5};
+  hyp.lm_probs = {-2};
+  hyp.lm_log_prob = -0.5;
+  hyp.cur_scored_pos = 1;
+  hyp.nn_lm_states.emplace_back(std::move(state));
+
+  HypothesisArena arena;
+  ArenaHypothesis h = arena.Import(hyp);
+  EXPECT_EQ(h.lm_log_prob, -0.5);
+  EXPECT_EQ(h.TotalLogProb(), -2);
+  ASSERT_NE(h.lm_state, -1);
+
+  // A new hyp keeps the LM states of its parent until they are replaced
+  ArenaHypothesis e = arena.Extend(h, 9, 10, 0.75, 0, -4);
+  EXPECT_EQ(e.lm_state, h.lm_state);
+
+  Hypothesis out = arena.Export(e, false, true);
+  EXPECT_EQ(out.lm_probs, (std::vector<float>{-2, -4}));
+  EXPECT_EQ(out.lm_log_prob, -0.5);
+  EXPECT_EQ(out.cur_scored_pos, 1);
+  ASSERT_EQ(out.nn_lm_states.size(), 1);
+  EXPECT_EQ(*out.nn_lm_states[0].value.GetTensorData<float>(), 3);
+
+  out.cur_scored_pos = 2;
+  e.lm_state = arena.SaveLmState(&out);
+  EXPECT_NE(e.lm_state, h.lm_state);
+  EXPECT_EQ(arena.Export(e, false).cur_scored_pos, 2);
+  EXPECT_EQ(arena.Export(h, false).cur_scored_pos, 1);
+  EXPECT_TRUE(arena.Export(e, false).lm_probs.empty());
+}
+
+TEST(ArenaHypotheses, Merge) {
+  HypothesisArena arena;
+  ArenaHypothesis root = arena.Import({{-1, 0}, 0});
+
+  // (a, b) from two different paths share only the root
+  ArenaHypothesis a = arena.Extend(root, 1, 0, 0, 0);
+  ArenaHypothesis ab1 = arena.Extend(a, 2, 1, 0, 0);
+  ArenaHypothesis ab2 =
+      arena.Extend(arena.Extend(root, 1, 1, 0, 0), 2, 2, 0, 0);
+  ArenaHypothesis ba =
+      arena.Extend(arena.Extend(root, 2, 0, 0, 0), 1, 1, 0, 0);
+
+  ab1.log_prob = std::log(0.25);
+  ab2.log_prob = std::log(0.5);
+  ba.log_prob = std::log(0.125);
+
+  EXPECT_EQ(ab1.hash, ab2.hash);
+  EXPECT_NE(ab1.hash, ba.hash);
+  EXPECT_TRUE(arena.SameTokens(ab1, ab2));
+  EXPECT_FALSE(arena.SameTokens(ab1, ba));
+
+  ArenaHypotheses hyps(&arena);
+  hyps.Add(ab1);
+  hyps.Add(ba);
+  hyps.Add(ab2);
+
+  ASSERT_EQ(hyps.Size(), 2);
+  EXPECT_NEAR(hyps[0].log_prob, std::log(0.75), 1e-6);
+  EXPECT_EQ(hyps[0].tail, ab1.tail);
+  EXPECT_EQ(hyps.MostProbable(false), 0);
+
+  // Same hash but different tokens must not be merged
+  ArenaHypothesis fake = ba;
+  fake.hash = ab1.hash;
+  hyps.Add(fake);
+  EXPECT_EQ(hyps.Size(), 3);
+}
+
+}  // namespace sherpa_onnx
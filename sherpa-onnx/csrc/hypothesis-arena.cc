@@ -0,0 +1,212 @@
+// sherpa-onnx/csrc/hypothesis-arena.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/hypothesis-arena.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "sherpa-onnx/csrc/math.h"
+
+namespace sherpa_onnx {
+
+ArenaHypothesis HypothesisArena::Extend(const ArenaHypothesis &hyp,
+                                        int64_t token, int32_t timestamp,
+                                        float prob, float context_score,
+                                        float lm_prob) {
+  HypothesisToken t;
+  t.token = token;
+  t.timestamp = timestamp;
+  t.prob = prob;
+  t.lm_prob = lm_prob;
+  t.context_score = context_score;
+  t.prev = hyp.tail;
+
+  ArenaHypothesis ans = hyp;
+  ans.tail = Append(t);
+  ans.num_tokens += 1;
+  ans.hash = ExtendHash(hyp.hash, token);
+
+  return ans;
+}
+
+int32_t HypothesisArena::SaveLmState(Hypothesis *hyp) {
+  HypothesisLmState s;
+  s.nn_lm_scores = std::move(hyp->nn_lm_scores);
+  s.nn_lm_states = std::move(hyp->nn_lm_states);
+  s.cur_scored_pos = hyp->cur_scored_pos;
+
+  lm_states_.push_back(std::move(s));
+  return static_cast<int32_t>(lm_states_.size()) - 1;
+}
+
+void HypothesisArena::LoadLmState(int32_t i, Hypothesis *hyp) const {
+  if (i == -1) {
+    return;
+  }
+
+  const auto &s = lm_states_[i];
+  hyp->nn_lm_scores = s.nn_lm_scores;
+  hyp->nn_lm_states = s.nn_lm_states;
+  hyp->cur_scored_pos = s.cur_scored_pos;
+}
+
+void HypothesisArena::LastTokens(const ArenaHypothesis &hyp, int32_t n,
+                                 int64_t *out) const {
+  int32_t i = hyp.tail;
+  for (int32_t k = n - 1; k >= 0; --k) {
+    out[k] = tokens_[i].token;
+    i = tokens_[i].prev;
+  }
+}
+
+bool HypothesisArena::SameTokens(const ArenaHypothesis &a,
+                                 const ArenaHypothesis &b) const {
+  if (a.num_tokens != b.num_tokens) {
+    return false;
+  }
+
+  // Once the two chains reach a common token, the remaining prefixes are
+  // shared, so this usually stops after a few tokens.
+  int32_t i = a.tail;
+  int32_t k = b.tail;
+  while (i != k) {
+    if (tokens_[i].token != tokens_[k].token) {
+      return false;
+    }
+
+    i = tokens_[i].prev;
+    k = tokens_[k].prev;
+  }
+
+  return true;
+}
+
+ArenaHypothesis HypothesisArena::Import(const Hypothesis &hyp) {
+  int32_t num_tokens = static_cast<int32_t>(hyp.ys.size());
+
+  // The last timestamps.size() tokens of ys are decoded ones. ys_probs,
+  // lm_probs and context_scores, if present, are aligned with their ends.
+  int32_t num_decoded =
+      std::min(num_tokens, static_cast<int32_t>(hyp.timestamps.size()));
+  int32_t num_probs = static_cast<int32_t>(hyp.ys_probs.size());
+  int32_t num_lm_probs = static_cast<int32_t>(hyp.lm_probs.size());
+  int32_t num_context_scores = static_cast<int32_t>(hyp.context_scores.size());
+
+  ArenaHypothesis ans;
+  for (int32_t i = 0; i != num_tokens; ++i) {
+    HypothesisToken t;
+    t.token = hyp.ys[i];
+    t.prev = ans.tail;
+
+    int32_t k = i - (num_tokens - num_decoded);
+    if (k >= 0) {
+      t.timestamp = hyp.timestamps[k];
+
+      int32_t p = k - (num_decoded - num_probs);
+      if (p >= 0) {
+        t.prob = hyp.ys_probs[p];
+      }
+
+      int32_t l = k - (num_decoded - num_lm_probs);
+      if (l >= 0) {
+        t.lm_prob = hyp.lm_probs[l];
+      }
+
+      int32_t c = k - (num_decoded - num_context_scores);
+      if (c >= 0) {
+        t.context_score = hyp.context_scores[c];
+      }
+    }
+
+    ans.tail = Append(t);
+    ans.hash = ExtendHash(ans.hash, t.token);
+  }
+
+  ans.num_tokens = num_tokens;
+  ans.log_prob = hyp.log_prob;
+  ans.lm_log_prob = hyp.lm_log_prob;
+  ans.context_state = hyp.context_state;
+  ans.num_trailing_blanks = hyp.num_trailing_blanks;
+
+  if (!hyp.nn_lm_states.empty() || hyp.nn_lm_scores.value) {
+    HypothesisLmState s;
+    s.nn_lm_scores = hyp.nn_lm_scores;
+    s.nn_lm_states = hyp.nn_lm_states;
+    s.cur_scored_pos = hyp.cur_scored_pos;
+
+    lm_states_.push_back(std::move(s));
+    ans.lm_state = static_cast<int32_t>(lm_states_.size()) - 1;
+  }
+
+  return ans;
+}
+
+Hypothesis HypothesisArena::Export(const ArenaHypothesis &hyp,
+                                   bool with_context_scores,
+                                   bool with_lm_probs) const {
+  Hypothesis ans;
+  ans.ys.resize(hyp.num_tokens);
+
+  for (int32_t i = hyp.tail, k = hyp.num_tokens - 1; i != -1;
+       i = tokens_[i].prev, --k) {
+    const auto &t = tokens_[i];
+    ans.ys[k] = t.token;
+
+    if (t.timestamp != -1) {
+      ans.timestamps.push_back(t.timestamp);
+      ans.ys_probs.push_back(t.prob);
+      if (with_lm_probs) {
+        ans.lm_probs.push_back(t.lm_prob);
+      }
+      if (with_context_scores) {
+        ans.context_scores.push_back(t.context_score);
+      }
+    }
+  }
+
+  std::reverse(ans.timestamps.begin(), ans.timestamps.end());
+  std::reverse(ans.ys_probs.begin(), ans.ys_probs.end());
+  std::reverse(ans.lm_probs.begin(), ans.lm_probs.end());
+  std::reverse(ans.context_scores.begin(), ans.context_scores.end());
+
+  ans.log_prob = hyp.log_prob;
+  ans.lm_log_prob = hyp.lm_log_prob;
+  ans.context_state = hyp.context_state;
+  ans.num_trailing_blanks = hyp.num_trailing_blanks;
+  LoadLmState(hyp.lm_state, &ans);
+
+  return ans;
+}
+
+void ArenaHypotheses::Add(const ArenaHypothesis &hyp) {
+  for (auto &h : hyps_) {
+    if (h.hash == hyp.hash && arena_->SameTokens(h, hyp)) {
+      h.log_prob = LogAdd<double>()(h.log_prob, hyp.log_prob);
+      return;
+    }
+  }
+
+  hyps_.push_back(hyp);
+}
+
+int32_t ArenaHypotheses::MostProbable(bool length_norm) const {
+  int32_t ans = 0;
+  double best = 0;
+  for (int32_t i = 0; i != Size(); ++i) {
+    double score = hyps_[i].TotalLogProb();
+    if (length_norm) {
+      score /= hyps_[i].num_tokens;
+    }
+
+    if (i == 0 || score > best) {
+      ans = i;
+      best = score;
+    }
+  }
+
+  return ans;
+}
+
+}  // namespace sherpa_onnx
@@ -0,0 +1,168 @@
+// sherpa-onnx/csrc/hypothesis-arena.h
+//
+// Copyright (c)  2025  Xiaomi Corporation
+#ifndef SHERPA_ONNX_CSRC_HYPOTHESIS_ARENA_H_
+#define SHERPA_ONNX_CSRC_HYPOTHESIS_ARENA_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "sherpa-onnx/csrc/context-graph.h"
+#include "sherpa-onnx/csrc/hypothesis.h"
+
+namespace sherpa_onnx {
+
+// A token of a hypothesis. Hypotheses with a common prefix share the
+// tokens of the prefix, so extending a hypothesis appends only one token.
+struct HypothesisToken {
+  int64_t token = 0;
+
+  // Frame number after subsampling on which the token is decoded.
+  // -1 for tokens that are not decoded, e.g., the leading blanks.
+  int32_t timestamp = -1;
+
+  // Used only if timestamp is not -1. See ys_probs, lm_probs and
+  // context_scores in Hypothesis.
+  float prob = 0;
+  float lm_prob = 0;
+  float context_score = 0;
+
+  // Index of the preceding token in the arena. -1 for the first token.
+  int32_t prev = -1;
+};
+
+// A hypothesis whose tokens are stored in a HypothesisArena.
+// It is small and trivially copyable.
+struct ArenaHypothesis {
+  // Index of the last token of ys in the arena. -1 if ys is empty.
+  int32_t tail = -1;
+
+  // Number of tokens in ys
+  int32_t num_tokens = 0;
+
+  // Rolling hash of ys. See ExtendHash().
+  uint64_t hash = 0;
+
+  double log_prob = 0;
+
+  // LM log prob if any. See Hypothesis.
+  double lm_log_prob = 0;
+
+  // Index of the LM states in the arena. -1 if there are none.
+  int32_t lm_state = -1;
+
+  const ContextState *context_state = nullptr;
+
+  int32_t num_trailing_blanks = 0;
+
+  double TotalLogProb() const { return log_prob + lm_log_prob; }
+};
+
+// States of an LM for a hypothesis. See Hypothesis.
+struct HypothesisLmState {
+  CopyableOrtValue nn_lm_scores;
+  std::vector<CopyableOrtValue> nn_lm_states;
+  int32_t cur_scored_pos = 0;
+};
+
+// Return the hash of a token sequence after appending token to a sequence
+// with the given hash.
+inline uint64_t ExtendHash(uint64_t hash, int64_t token) {
+  return hash * 0x9e3779b97f4a7c15ull + static_cast<uint64_t>(token) + 1;
+}
+
+// Storage of the tokens of all hypotheses of a beam search.
+//
+// Tokens are only appended, so indexes stay valid until Clear(). It is
+// meant to be cleared at the start of each Decode() call; hypotheses that
+// outlive the call are converted back with Export().
+//
+// LM states are kept aside, since they are used only with an LM. A
+// hypothesis shares the LM states of its parent until the LM scores a new
+// token.
+class HypothesisArena {
+ public:
+  void Clear() {
+    tokens_.clear();
+    lm_states_.clear();
+  }
+
+  int32_t Size() const { return static_cast<int32_t>(tokens_.size()); }
+
+  // @return Return the index of the token
+  int32_t Append(const HypothesisToken &token) {
+    tokens_.push_back(token);
+    return static_cast<int32_t>(tokens_.size()) - 1;
+  }
+
+  const HypothesisToken &Get(int32_t i) const { return tokens_[i]; }
+
+  // Return hyp extended with a decoded token
+  ArenaHypothesis Extend(const ArenaHypothesis &hyp, int64_t token,
+                         int32_t timestamp, float prob, float context_score,
+                         float lm_prob = 0);
+
+  // Move the LM states of hyp into the arena.
+  // @return Return the index for ArenaHypothesis::lm_state
+  int32_t SaveLmState(Hypothesis *hyp);
+
+  // Copy the LM states with the given index to hyp. Nothing is copied if
+  // i is -1.
+  void LoadLmState(int32_t i, Hypothesis *hyp) const;
+
+  // Copy the last n token IDs of hyp to out, oldest first.
+  // hyp must contain at least n tokens.
+  void LastTokens(const ArenaHypothesis &hyp, int32_t n, int64_t *out) const;
+
+  // Return true if a and b contain the same token sequence
+  bool SameTokens(const ArenaHypothesis &a, const ArenaHypothesis &b) const;
+
+  // Copy the tokens of a Hypothesis into the arena
+  ArenaHypothesis Import(const Hypothesis &hyp);
+
+  // Convert back to a Hypothesis.
+  // @param with_context_scores true to fill context_scores
+  // @param with_lm_probs true to fill lm_probs
+  Hypothesis Export(const ArenaHypothesis &hyp, bool with_context_scores,
+                    bool with_lm_probs = false) const;
+
+ private:
+  std::vector<HypothesisToken> tokens_;
+  std::vector<HypothesisLmState> lm_states_;
+};
+
+// Hypotheses of one stream during a beam search, backed by a
+// HypothesisArena. Like Hypotheses::Add(), hypotheses with the same token
+// sequence are merged with log-sum-exp.
+//
+// Unlike Hypotheses, keys are the rolling hashes of the token sequences,
+// so no string is built. Since a beam holds at most max_active_paths
+// hypotheses, they are kept in a flat array and looked up by a linear scan
+// over the hashes; tokens are compared only if the hashes are equal.
+class ArenaHypotheses {
+ public:
+  explicit ArenaHypotheses(const HypothesisArena *arena) : arena_(arena) {}
+
+  void Add(const ArenaHypothesis &hyp);
+
+  void Clear() { hyps_.clear(); }
+
+  int32_t Size() const { return static_cast<int32_t>(hyps_.size()); }
+
+  const ArenaHypothesis &operator[](int32_t i) const { return hyps_[i]; }
+
+  // Return the index of the hyp that has the largest TotalLogProb().
+  // If length_norm is true, it is divided by num_tokens before comparison.
+  int32_t MostProbable(bool length_norm) const;
+
+  auto begin() const { return hyps_.begin(); }
+  auto end() const { return hyps_.end(); }
+
+ private:
+  const HypothesisArena *arena_;  // Not owned
+  std::vector<ArenaHypothesis> hyps_;
+};
+
+}  // namespace sherpa_onnx
+
+#endif  // SHERPA_ONNX_CSRC_HYPOTHESIS_ARENA_H_
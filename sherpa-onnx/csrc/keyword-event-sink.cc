@@ -0,0 +1,230 @@
+// sherpa-onnx/csrc/keyword-event-sink.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/keyword-event-sink.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <utility>
+
+#include "sherpa-onnx/csrc/macros.h"
+
+namespace sherpa_onnx {
+
+std::string KeywordEvent::AsJsonString() const {
+  std::ostringstream os;
+  os << "{";
+  os << "\"time_ms\":" << time_ms << ", ";
+  if (!source.empty()) {
+    os << "\"source\":" << std::quoted(source) << ", ";
+  }
+  os << "\"score\":" << std::fixed << std::setprecision(3) << result.score
+     << ", ";
+
+  // Skip the leading "{" of the result
+  os << result.AsJsonString().substr(1);
+
+  return os.str();
+}
+
+RingLogSink::RingLogSink(const std::string &filename,
+                         int32_t max_lines /*= 10*/)
+    : filename_(filename), max_lines_(std::max(max_lines, 1)) {
+  auto pos = filename_.find_last_of('/');
+  if (pos != std::string::npos && pos != 0) {
+    std::string dir = filename_.substr(0, pos);
+    struct stat st;
+    if (::stat(dir.c_str(), &st) == -1) {
+      ::mkdir(dir.c_str(), 0755);
+    }
+  }
+}
+
+void RingLogSink::Write(const KeywordEvent &event) {
+  lines_.push_back(std::to_string(event.time_ms) + "@" +
+                   event.result.keyword);
+  while (static_cast<int32_t>(lines_.size()) > max_lines_) {
+    lines_.pop_front();
+  }
+
+  std::string tmp = filename_ + ".tmp";
+  FILE *fp = fopen(tmp.c_str(), "w");
+  if (!fp) {
+    SHERPA_ONNX_LOGE("Failed to open %s: %s", tmp.c_str(), strerror(errno));
+    return;
+  }
+
+  for (const auto &line : lines_) {
+    fprintf(fp, "%s\n", line.c_str());
+  }
+  fclose(fp);
+
+  if (rename(tmp.c_str(), filename_.c_str()) != 0) {
+    SHERPA_ONNX_LOGE("Failed to rename %s to %s: %s", tmp.c_str(),
+                     filename_.c_str(), strerror(errno));
+  }
+}
+
+UnixSocketSink::UnixSocketSink(const std::string &path) : path_(path) {
+  if (path_.size() >= sizeof(sockaddr_un::sun_path)) {
+    SHERPA_ONNX_LOGE("Socket path is too long: %s", path_.c_str());
+    return;
+  }
+
+  fd_ = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  if (fd_ == -1) {
+    SHERPA_ONNX_LOGE("Failed to create socket: %s", strerror(errno));
+  }
+}
+
+UnixSocketSink::~UnixSocketSink() {
+  if (fd_ != -1) {
+    close(fd_);
+  }
+}
+
+void UnixSocketSink::Write(const KeywordEvent &event) {
+  if (fd_ == -1) {
+    return;
+  }
+
+  sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  memcpy(addr.sun_path, path_.c_str(), path_.size());
+
+  std::string json = event.AsJsonString();
+
+  // It fails if no one is listening. The event is dropped in that case.
+  sendto(fd_, json.data(), json.size(), MSG_DONTWAIT | MSG_NOSIGNAL,
+         reinterpret_cast<const sockaddr *>(&addr), sizeof(addr));
+}
+
+FifoSink::FifoSink(const std::string &path) : path_(path) {
+  struct stat st;
+  if (::stat(path_.c_str(), &st) == -1) {
+    if (mkfifo(path_.c_str(), 0644) == -1) {
+      SHERPA_ONNX_LOGE("Failed to create fifo %s: %s", path_.c_str(),
+                       strerror(errno));
+    }
+  } else if (!S_ISFIFO(st.st_mode)) {
+    SHERPA_ONNX_LOGE("%s exists and is not a fifo", path_.c_str());
+  }
+}
+
+FifoSink::~FifoSink() {
+  if (fd_ != -1) {
+    close(fd_);
+  }
+}
+
+void FifoSink::Write(const KeywordEvent &event) {
+  if (fd_ == -1) {
+    // It fails with ENXIO if no reader has opened the fifo
+    fd_ = open(path_.c_str(), O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd_ == -1) {
+      return;
+    }
+  }
+
+  std::string line = event.AsJsonString() + "\n";
+  if (write(fd_, line.data(), line.size()) == -1 && errno == EPIPE) {
+    // The reader has gone. Reopen the fifo for the next event.
+    close(fd_);
+    fd_ = -1;
+  }
+}
+
+void StdoutSink::Write(const KeywordEvent &event) {
+  fprintf(stdout, "%s\n", event.AsJsonString().c_str());
+  fflush(stdout);
+}
+
+std::unique_ptr<KeywordEventSink> CreateKeywordEventSink(
+    const std::string &spec) {
+  auto pos = spec.find(':');
+  std::string type = spec.substr(0, pos);
+  std::string path = pos == std::string::npos ? "" : spec.substr(pos + 1);
+
+  if (type == "stdout") {
+    return std::make_unique<StdoutSink>();
+  }
+
+  if (path.empty()) {
+    SHERPA_ONNX_LOGE("Please provide a path for event sink '%s'",
+                     spec.c_str());
+    return nullptr;
+  }
+
+  if (type == "ring-log") {
+    return std::make_unique<RingLogSink>(path);
+  } else if (type == "socket") {
+    return std::make_unique<UnixSocketSink>(path);
+  } else if (type == "fifo") {
+    return std::make_unique<FifoSink>(path);
+  }
+
+  SHERPA_ONNX_LOGE("Unknown event sink '%s'", spec.c_str());
+  return nullptr;
+}
+
+KeywordEventDispatcher::KeywordEventDispatcher(
+    std::vector<std::unique_ptr<KeywordEventSink>> sinks,
+    int32_t capacity /*= 64*/, LatencyHistogram *sink_latency /*= nullptr*/)
+    : sinks_(std::move(sinks)), queue_(capacity), sink_latency_(sink_latency) {
+  thread_ = std::thread([this]() { Run(); });
+}
+
+KeywordEventDispatcher::~KeywordEventDispatcher() { Stop(); }
+
+bool KeywordEventDispatcher::Post(KeywordEvent &&event) {
+  return queue_.PushItem(std::move(event));
+}
+
+void KeywordEventDispatcher::Stop() {
+  // The dispatcher delivers the events that are already queued and exits
+  queue_.Close();
+
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void KeywordEventDispatcher::Run() {
+  // Writing to a fifo or socket whose reader has gone raises SIGPIPE in the
+  // writing thread. Block it here; the write fails with EPIPE instead.
+  sigset_t set;
+  sigemptyset(&set);
+  sigaddset(&set, SIGPIPE);
+  pthread_sigmask(SIG_BLOCK, &set, nullptr);
+
+  KeywordEvent event;
+  while (queue_.WaitPopItem(&event)) {
+    auto start = std::chrono::steady_clock::now();
+
+    for (auto &sink : sinks_) {
+      sink->Write(event);
+    }
+
+    if (sink_latency_) {
+      sink_latency_->AddSince(start);
+    }
+  }
+}
+
+}  // namespace sherpa_onnx
@@ -0,0 +1,150 @@
+// sherpa-onnx/csrc/keyword-event-sink.h
+//
+// Copyright (c)  2025  Xiaomi Corporation
+#ifndef SHERPA_ONNX_CSRC_KEYWORD_EVENT_SINK_H_
+#define SHERPA_ONNX_CSRC_KEYWORD_EVENT_SINK_H_
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "sherpa-onnx/csrc/keyword-spotter.h"
+#include "sherpa-onnx/csrc/latency-stats.h"
+#include "sherpa-onnx/csrc/spsc-ring-buffer.h"
+
+namespace sherpa_onnx {
+
+struct KeywordEvent {
+  /// Wall-clock time of the detection in milliseconds since the Unix epoch
+  int64_t time_ms = 0;
+
+  /// The detection, including token timestamps and the score
+  KeywordResult result;
+
+  /// Name of the audio source. Empty if there is only one source.
+  std::string source;
+
+  /** Return a json string. It contains the fields of
+   *  KeywordResult::AsJsonString() plus "time_ms", "score" and, if it is
+   *  not empty, "source".
+   */
+  std::string AsJsonString() const;
+};
+
+// Destination of keyword events. Sinks are only called from the
+// dispatcher thread of KeywordEventDispatcher, so they may block.
+class KeywordEventSink {
+ public:
+  virtual ~KeywordEventSink() = default;
+
+  virtual void Write(const KeywordEvent &event) = 0;
+};
+
+// Keep the last max_lines events in a file, one "time_ms@keyword" per line.
+// The file is replaced atomically with rename(), so readers never see a
+// partially written file.
+class RingLogSink : public KeywordEventSink {
+ public:
+  explicit RingLogSink(const std::string &filename, int32_t max_lines = 10);
+
+  void Write(const KeywordEvent &event) override;
+
+ private:
+  std::string filename_;
+  int32_t max_lines_;
+  std::deque<std::string> lines_;
+};
+
+// Send each event as a json datagram to a Unix-domain socket. Events are
+// dropped while no one is listening on the socket.
+class UnixSocketSink : public KeywordEventSink {
+ public:
+  explicit UnixSocketSink(const std::string &path);
+  ~UnixSocketSink() override;
+
+  void Write(const KeywordEvent &event) override;
+
+ private:
+  std::string path_;
+  int32_t fd_ = -1;
+};
+
+// Write each event as a line of json to a FIFO, which is created if it does
+// not exist. Events are dropped while no reader has the FIFO open.
+class FifoSink : public KeywordEventSink {
+ public:
+  explicit FifoSink(const std::string &path);
+  ~FifoSink() override;
+
+  void Write(const KeywordEvent &event) override;
+
+ private:
+  std::string path_;
+  int32_t fd_ = -1;
+};
+
+// Print each event as a line of json to stdout
+class StdoutSink : public KeywordEventSink {
+ public:
+  void Write(const KeywordEvent &event) override;
+};
+
+/** Create a sink from a spec of the form type[:path]. Supported specs:
+ *
+ *   ring-log:/path/to/file
+ *   socket:/path/to/socket
+ *   fifo:/path/to/fifo
+ *   stdout
+ *
+ * @return Return nullptr if the spec is invalid.
+ */
+std::unique_ptr<KeywordEventSink> CreateKeywordEventSink(
+    const std::string &spec);
+
+// Deliver keyword events to sinks on a background thread.
+//
+// Post() is meant to be called from the decoding thread. It moves the event
+// into a lock-free ring and never blocks on I/O; the ring only takes its
+// mutex to wake up the dispatcher thread when it is idle.
+class KeywordEventDispatcher {
+ public:
+  // @param sinks Destinations of the events.
+  // @param capacity Maximum number of events waiting to be delivered.
+  // @param sink_latency If not nullptr, the time to deliver each event to all
+  //                     sinks is added to it. Not owned.
+  explicit KeywordEventDispatcher(
+      std::vector<std::unique_ptr<KeywordEventSink>> sinks,
+      int32_t capacity = 64, LatencyHistogram *sink_latency = nullptr);
+
+  KeywordEventDispatcher(const KeywordEventDispatcher &) = delete;
+  KeywordEventDispatcher &operator=(const KeywordEventDispatcher &) = delete;
+
+  ~KeywordEventDispatcher();
+
+  // Called only by one producer thread.
+  // @return Return false if the queue is full. The event is dropped and
+  //         counted in NumDropped().
+  bool Post(KeywordEvent &&event);
+
+  // Deliver pending events and stop the dispatcher thread.
+  void Stop();
+
+  int64_t NumDropped() const { return queue_.NumDropped(); }
+
+ private:
+  void Run();
+
+ private:
+  std::vector<std::unique_ptr<KeywordEventSink>> sinks_;
+  BasicSpscRingBuffer<KeywordEvent> queue_;
+  LatencyHistogram *sink_latency_;  // Not owned
+
+  std::thread thread_;
+};
+
+}  // namespace sherpa_onnx
+
+#endif  // SHERPA_ONNX_CSRC_KEYWORD_EVENT_SINK_H_
@@ -10,6 +10,7 @@
 #include <vector>
 
 #include "sherpa-onnx/csrc/keyword-spotter.h"
+#include "sherpa-onnx/csrc/latency-stats.h"
 #include "sherpa-onnx/csrc/online-stream.h"
 
 namespace sherpa_onnx {
@@ -34,9 +35,16 @@ class KeywordSpotterImpl {
 
   virtual void Reset(OnlineStream *s) const = 0;
 
+  virtual int32_t SkipFrames(OnlineStream *s,
+                             int32_t num_kept_frames) const = 0;
+
   virtual void DecodeStreams(OnlineStream **ss, int32_t n) const = 0;
 
   virtual KeywordResult GetResult(OnlineStream *s) const = 0;
+
+  virtual bool ReloadKeywords(const std::string &keywords) = 0;
+
+  virtual void SetLatencyStats(KeywordSpotterLatencyStats *stats) = 0;
 };
 
 }  // namespace sherpa_onnx
@@ -0,0 +1,252 @@
+// sherpa-onnx/csrc/keyword-spotter-scheduler-test.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/keyword-spotter-scheduler.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "sherpa-onnx/csrc/keyword-spotter-impl.h"
+
+namespace sherpa_onnx {
+
+// Number of frames decoded by one DecodeStreams() call
+static constexpr int32_t kChunkSize = 10;
+
+// A spotter without models. Each DecodeStreams() call consumes one chunk of
+// each stream and records the indexes of the streams, in the order they
+// were created.
+class FakeKeywordSpotterImpl : public KeywordSpotterImpl {
+ public:
+  std::unique_ptr<OnlineStream> CreateStream() const override {
+    auto s = std::make_unique<OnlineStream>();
+    streams_.push_back(s.get());
+    return s;
+  }
+
+  std::unique_ptr<OnlineStream> CreateStream(
+      const std::string & /*keywords*/) const override {
+    return CreateStream();
+  }
+
+  bool IsReady(OnlineStream *s) const override {
+    return s->GetNumProcessedFrames() + kChunkSize <= s->NumFramesReady();
+  }
+
+  void Reset(OnlineStream * /*s*/) const override {}
+
+  int32_t SkipFrames(OnlineStream * /*s*/,
+                     int32_t /*num_kept_frames*/) const override {
+    return 0;
+  }
+
+  void DecodeStreams(OnlineStream **ss, int32_t n) const override {
+    std::vector<int32_t> batch;
+    for (int32_t i = 0; i != n; ++i) {
+      ss[i]->GetNumProcessedFrames() += kChunkSize;
+
+      auto it = std::find(streams_.begin(), streams_.end(), ss[i]);
+      batch.push_back(static_cast<int32_t>(it - streams_.begin()));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    batches_.push_back(batch);
+  }
+
+  KeywordResult GetResult(OnlineStream * /*s*/) const override { return {}; }
+
+  bool ReloadKeywords(const std::string & /*keywords*/) override {
+    return true;
+  }
+
+  void SetLatencyStats(KeywordSpotterLatencyStats * /*stats*/) override {}
+
+  std::vector<std::vector<int32_t>> Batches() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return batches_;
+  }
+
+ private:
+  // Streams are created only before the scheduler starts
+  mutable std::vector<OnlineStream *> streams_;
+
+  mutable std::mutex mutex_;
+  mutable std::vector<std::vector<int32_t>> batches_;
+};
+
+// Samples that give num_chunks chunks of frames, and a few frames more
+static std::vector<float> GenerateChunks(int32_t num_chunks) {
+  int32_t n = num_chunks * kChunkSize * 160 + 800;
+  std::vector<float> samples(n);
+  for (int32_t i = 0; i != n; ++i) {
+    samples[i] = 0.1 * ((i % 100) / 50.0 - 1);
+  }
+  return samples;
+}
+
+static void Push(KeywordSpotterScheduler *scheduler, int32_t source,
+                 int32_t num_chunks) {
+  auto samples = GenerateChunks(num_chunks);
+  scheduler->AcceptWaveform(source, samples.data(), samples.size());
+}
+
+// Wait until the scheduler has decoded n streams in total
+static bool WaitForDecodedStreams(const KeywordSpotterScheduler &scheduler,
+                                  int64_t n) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (scheduler.NumDecodedStreams() < n) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+static void NoCallback(int32_t /*source*/, const KeywordResult & /*r*/) {}
+
+TEST(KeywordSpotterScheduler, Batching) {
+  auto impl = std::make_unique<FakeKeywordSpotterImpl>();
+  auto fake = impl.get();
+  KeywordSpotter spotter(std::move(impl));
+
+  KeywordSpotterSchedulerConfig config;
+  config.max_batch_size = 3;
+  config.max_latency_ms = 10000;
+
+  KeywordSpotterScheduler scheduler(&spotter, config, NoCallback);
+  for (int32_t i = 0; i != 3; ++i) {
+    scheduler.AddSource("source-" + std::to_string(i));
+    Push(&scheduler, i, 1);
+  }
+
+  scheduler.Start();
+  ASSERT_TRUE(WaitForDecodedStreams(scheduler, 3));
+  scheduler.Stop();
+
+  // A full batch does not wait for max_latency_ms
+  std::vector<std::vector<int32_t>> expected = {{0, 1, 2}};
+  EXPECT_EQ(fake->Batches(), expected);
+  EXPECT_EQ(scheduler.NumBatches(), 1);
+}
+
+TEST(KeywordSpotterScheduler, PartialBatchAfterMaxLatency) {
+  auto impl = std::make_unique<FakeKeywordSpotterImpl>();
+  auto fake = impl.get();
+  KeywordSpotter spotter(std::move(impl));
+
+  KeywordSpotterSchedulerConfig config;
+  config.max_batch_size = 4;
+  config.max_latency_ms = 20;
+
+  KeywordSpotterScheduler scheduler(&spotter, config, NoCallback);
+  scheduler.AddSource("source-0");
+  scheduler.AddSource("source-1");
+  Push(&scheduler, 1, 1);
+
+  scheduler.Start();
+  ASSERT_TRUE(WaitForDecodedStreams(scheduler, 1));
+  scheduler.Stop();
+
+  std::vector<std::vector<int32_t>> expected = {{1}};
+  EXPECT_EQ(fake->Batches(), expected);
+}
+
+TEST(KeywordSpotterScheduler, Fairness) {
+  auto impl = std::make_unique<FakeKeywordSpotterImpl>();
+  auto fake = impl.get();
+  KeywordSpotter spotter(std::move(impl));
+
+  KeywordSpotterSchedulerConfig config;
+  config.max_batch_size = 1;
+  config.max_latency_ms = 0;
+
+  KeywordSpotterScheduler scheduler(&spotter, config, NoCallback);
+  for (int32_t i = 0; i != 3; ++i) {
+    scheduler.AddSource("source-" + std::to_string(i));
+  }
+
+  // Sources 0 and 1 have a backlog. They take turns and do not delay
+  // source 2 until they have caught up.
+  Push(&scheduler, 0, 3);
+  Push(&scheduler, 1, 3);
+  Push(&scheduler, 2, 1);
+
+  scheduler.Start();
+  ASSERT_TRUE(WaitForDecodedStreams(scheduler, 7));
+  scheduler.Stop();
+
+  std::vector<std::vector<int32_t>> expected = {{0}, {1}, {2}, {0},
+                                                {1}, {0}, {1}};
+  EXPECT_EQ(fake->Batches(), expected);
+}
+
+TEST(KeywordSpotterScheduler, RemoveSourceBeforeStart) {
+  auto impl = std::make_unique<FakeKeywordSpotterImpl>();
+  auto fake = impl.get();
+  KeywordSpotter spotter(std::move(impl));
+
+  KeywordSpotterSchedulerConfig config;
+  config.max_batch_size = 3;
+  config.max_latency_ms = 20;
+
+  KeywordSpotterScheduler scheduler(&spotter, config, NoCallback);
+  for (int32_t i = 0; i != 3; ++i) {
+    scheduler.AddSource("source-" + std::to_string(i));
+    Push(&scheduler, i, 1);
+  }
+
+  scheduler.RemoveSource(1);
+  EXPECT_EQ(scheduler.NumSources(), 3);
+
+  scheduler.Start();
+  ASSERT_TRUE(WaitForDecodedStreams(scheduler, 2));
+
+  // Give the scheduler time to decode the removed source by mistake
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  scheduler.Stop();
+
+  std::vector<std::vector<int32_t>> expected = {{0, 2}};
+  EXPECT_EQ(fake->Batches(), expected);
+}
+
+TEST(KeywordSpotterScheduler, RemoveSourceWhileRunning) {
+  auto impl = std::make_unique<FakeKeywordSpotterImpl>();
+  auto fake = impl.get();
+  KeywordSpotter spotter(std::move(impl));
+
+  KeywordSpotterSchedulerConfig config;
+  config.max_batch_size = 2;
+  config.max_latency_ms = 10000;
+
+  KeywordSpotterScheduler scheduler(&spotter, config, NoCallback);
+  for (int32_t i = 0; i != 3; ++i) {
+    scheduler.AddSource("source-" + std::to_string(i));
+  }
+
+  scheduler.Start();
+
+  // Source 1 is ready and waits for a second stream to fill the batch. It
+  // is removed before that happens.
+  Push(&scheduler, 1, 1);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  scheduler.RemoveSource(1);
+
+  Push(&scheduler, 0, 1);
+  Push(&scheduler, 2, 1);
+
+  ASSERT_TRUE(WaitForDecodedStreams(scheduler, 2));
+  scheduler.Stop();
+
+  std::vector<std::vector<int32_t>> expected = {{0, 2}};
+  EXPECT_EQ(fake->Batches(), expected);
+}
+
+}  // namespace sherpa_onnx
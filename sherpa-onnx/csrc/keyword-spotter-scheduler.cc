@@ -0,0 +1,221 @@
+// sherpa-onnx/csrc/keyword-spotter-scheduler.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/keyword-spotter-scheduler.h"
+
+#include <algorithm>
+#include <sstream>
+#include <utility>
+
+#include "sherpa-onnx/csrc/macros.h"
+
+namespace sherpa_onnx {
+
+void KeywordSpotterSchedulerConfig::Register(ParseOptions *po) {
+  po->Register("max-batch-size", &max_batch_size,
+               "Maximum number of streams decoded in one batch");
+  po->Register("max-latency-ms", &max_latency_ms,
+               "A stream that is ready to decode waits at most this many "
+               "milliseconds for other streams to join its batch");
+  po->Register("poll-interval-ms", &poll_interval_ms,
+               "How often the scheduler checks the sources for new samples");
+  po->Register("ring-size", &ring_size,
+               "Number of samples buffered for each source");
+}
+
+bool KeywordSpotterSchedulerConfig::Validate() const {
+  if (max_batch_size < 1) {
+    SHERPA_ONNX_LOGE("--max-batch-size should be at least 1. Given: %d",
+                     max_batch_size);
+    return false;
+  }
+
+  if (max_latency_ms < 0) {
+    SHERPA_ONNX_LOGE("--max-latency-ms should be non-negative. Given: %d",
+                     max_latency_ms);
+    return false;
+  }
+
+  if (poll_interval_ms < 1) {
+    SHERPA_ONNX_LOGE("--poll-interval-ms should be at least 1. Given: %d",
+                     poll_interval_ms);
+    return false;
+  }
+
+  if (ring_size < 1) {
+    SHERPA_ONNX_LOGE("--ring-size should be positive. Given: %d", ring_size);
+    return false;
+  }
+
+  return true;
+}
+
+std::string KeywordSpotterSchedulerConfig::ToString() const {
+  std::ostringstream os;
+
+  os << "KeywordSpotterSchedulerConfig(";
+  os << "max_batch_size=" << max_batch_size << ", ";
+  os << "max_latency_ms=" << max_latency_ms << ", ";
+  os << "poll_interval_ms=" << poll_interval_ms << ", ";
+  os << "ring_size=" << ring_size << ", ";
+  os << "sample_rate=" << sample_rate << ")";
+
+  return os.str();
+}
+
+KeywordSpotterScheduler::KeywordSpotterScheduler(
+    KeywordSpotter *spotter, const KeywordSpotterSchedulerConfig &config,
+    Callback callback)
+    : spotter_(spotter), config_(config), callback_(std::move(callback)) {}
+
+KeywordSpotterScheduler::~KeywordSpotterScheduler() { Stop(); }
+
+int32_t KeywordSpotterScheduler::AddSource(const std::string &name) {
+  if (thread_.joinable()) {
+    SHERPA_ONNX_LOGE("Add source %s before starting the scheduler",
+                     name.c_str());
+    exit(-1);
+  }
+
+  auto source = std::make_unique<Source>(name, config_.ring_size);
+  source->stream = spotter_->CreateStream();
+  sources_.push_back(std::move(source));
+
+  return static_cast<int32_t>(sources_.size()) - 1;
+}
+
+void KeywordSpotterScheduler::RemoveSource(int32_t source) {
+  sources_[source]->removed = true;
+}
+
+void KeywordSpotterScheduler::AcceptWaveform(int32_t source,
+                                             const float *samples,
+                                             int32_t n) {
+  sources_[source]->ring.Push(samples, n);
+}
+
+void KeywordSpotterScheduler::Start() {
+  if (thread_.joinable()) {
+    return;
+  }
+
+  stop_ = false;
+  thread_ = std::thread([this]() { Run(); });
+}
+
+void KeywordSpotterScheduler::Stop() {
+  stop_ = true;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void KeywordSpotterScheduler::Run() {
+  using Clock = std::chrono::steady_clock;
+
+  auto max_latency = std::chrono::milliseconds(config_.max_latency_ms);
+  auto poll_interval = std::chrono::milliseconds(config_.poll_interval_ms);
+
+  while (!stop_) {
+    Feed();
+
+    if (!ready_.empty()) {
+      auto oldest = sources_[ready_.front()]->ready_since;
+      auto deadline = oldest + max_latency;
+
+      if (static_cast<int32_t>(ready_.size()) >= config_.max_batch_size ||
+          Clock::now() >= deadline) {
+        DecodeBatch();
+
+        // Streams that are still ready may already be due, so check again
+        // without sleeping
+        continue;
+      }
+
+      std::this_thread::sleep_until(std::min(deadline, Clock::now() +
+                                                           poll_interval));
+      continue;
+    }
+
+    std::this_thread::sleep_for(poll_interval);
+  }
+}
+
+void KeywordSpotterScheduler::Feed() {
+  auto now = std::chrono::steady_clock::now();
+
+  for (auto &s : sources_) {
+    if (s->removed) {
+      s->stream.reset();
+      s->ready = false;
+      continue;
+    }
+
+    int32_t n = s->ring.Size();
+    if (n > 0) {
+      samples_.resize(std::max<int32_t>(samples_.size(), n));
+      n = s->ring.Pop(samples_.data(), n);
+      s->stream->AcceptWaveform(config_.sample_rate, samples_.data(), n);
+    }
+
+    if (!s->ready && spotter_->IsReady(s->stream.get())) {
+      s->ready = true;
+      s->ready_since = now;
+    }
+  }
+
+  // Oldest first. A source may have been removed after the loop above
+  // looked at it.
+  ready_.clear();
+  for (int32_t i = 0; i != NumSources(); ++i) {
+    if (sources_[i]->ready && !sources_[i]->removed) {
+      ready_.push_back(i);
+    }
+  }
+
+  std::stable_sort(ready_.begin(), ready_.end(),
+                   [this](int32_t a, int32_t b) {
+                     return sources_[a]->ready_since < sources_[b]->ready_since;
+                   });
+}
+
+void KeywordSpotterScheduler::DecodeBatch() {
+  int32_t n = std::min<int32_t>(ready_.size(), config_.max_batch_size);
+
+  batch_.clear();
+  for (int32_t i = 0; i != n; ++i) {
+    const auto &s = sources_[ready_[i]];
+    schedule_delay_.AddSince(s->ready_since);
+    batch_.push_back(s->stream.get());
+  }
+
+  spotter_->DecodeStreams(batch_.data(), n);
+
+  num_batches_ += 1;
+  num_decoded_streams_ += n;
+
+  auto now = std::chrono::steady_clock::now();
+
+  for (int32_t i = 0; i != n; ++i) {
+    int32_t source = ready_[i];
+    auto &s = sources_[source];
+
+    const auto r = spotter_->GetResult(s->stream.get());
+    if (!r.keyword.empty()) {
+      callback_(source, r);
+      spotter_->Reset(s->stream.get());
+    }
+
+    // A stream that has more than one chunk buffered waits for its next
+    // turn, as if its next chunk had just arrived, so that streams that are
+    // already waiting are decoded first.
+    if (spotter_->IsReady(s->stream.get())) {
+      s->ready_since = now;
+    } else {
+      s->ready = false;
+    }
+  }
+}
+
+}  // namespace sherpa_onnx
@@ -0,0 +1,171 @@
+// sherpa-onnx/csrc/keyword-spotter-scheduler.h
+//
+// Copyright (c)  2025  Xiaomi Corporation
+#ifndef SHERPA_ONNX_CSRC_KEYWORD_SPOTTER_SCHEDULER_H_
+#define SHERPA_ONNX_CSRC_KEYWORD_SPOTTER_SCHEDULER_H_
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "sherpa-onnx/csrc/keyword-spotter.h"
+#include "sherpa-onnx/csrc/latency-stats.h"
+#include "sherpa-onnx/csrc/online-stream.h"
+#include "sherpa-onnx/csrc/parse-options.h"
+#include "sherpa-onnx/csrc/spsc-ring-buffer.h"
+
+namespace sherpa_onnx {
+
+struct KeywordSpotterSchedulerConfig {
+  /// Maximum number of streams decoded by one DecodeStreams() call
+  int32_t max_batch_size = 8;
+
+  /// A stream that is ready to decode waits at most this long for other
+  /// streams to become ready, so that they are decoded in one batch.
+  int32_t max_latency_ms = 40;
+
+  /// How often the scheduler moves samples from the sources to the streams
+  /// when no batch is due
+  int32_t poll_interval_ms = 10;
+
+  /// Number of samples buffered for each source. Samples that do not fit
+  /// are dropped.
+  int32_t ring_size = 16000;
+
+  /// Sample rate of the samples given to AcceptWaveform(). It is not
+  /// registered as an option; set it from the feature config.
+  int32_t sample_rate = 16000;
+
+  KeywordSpotterSchedulerConfig() = default;
+
+  void Register(ParseOptions *po);
+  bool Validate() const;
+
+  std::string ToString() const;
+};
+
+// Run keyword spotting on many audio sources with one KeywordSpotter.
+//
+// Each source has its own OnlineStream. Its producer thread, e.g., an ALSA
+// capture thread or a network receiver, calls AcceptWaveform(), which only
+// writes to a lock-free ring buffer. A scheduler thread moves the samples
+// to the streams and decodes the streams that are ready in batches: a
+// batch is decoded as soon as max_batch_size streams are ready, or when
+// the oldest ready stream has waited for max_latency_ms. Each batch runs
+// the encoder once, so throughput grows with the number of sources while
+// every stream stays within the latency budget. A stream with several
+// chunks buffered, e.g., after a network stall, gets one chunk decoded per
+// turn, so it cannot hold back the other streams while it catches up.
+class KeywordSpotterScheduler {
+ public:
+  // @param source Index returned by AddSource()
+  using Callback =
+      std::function<void(int32_t source, const KeywordResult &result)>;
+
+  // @param spotter Not owned. It must outlive this object.
+  // @param callback Called on the scheduler thread for each detection.
+  KeywordSpotterScheduler(KeywordSpotter *spotter,
+                          const KeywordSpotterSchedulerConfig &config,
+                          Callback callback);
+
+  KeywordSpotterScheduler(const KeywordSpotterScheduler &) = delete;
+  KeywordSpotterScheduler &operator=(const KeywordSpotterScheduler &) =
+      delete;
+
+  ~KeywordSpotterScheduler();
+
+  // Must be called before Start().
+  // @param name Name of the source, for logging
+  // @return Return the index of the source.
+  int32_t AddSource(const std::string &name);
+
+  // Stop decoding the source and free its stream on the scheduler thread.
+  // It can be called while the scheduler is running, but only after the
+  // producer of the source has stopped calling AcceptWaveform(). Indexes of
+  // other sources do not change.
+  void RemoveSource(int32_t source);
+
+  // Removed sources are included
+  int32_t NumSources() const { return static_cast<int32_t>(sources_.size()); }
+
+  const std::string &SourceName(int32_t source) const {
+    return sources_[source]->name;
+  }
+
+  // Called only by the producer thread of the source. It never blocks.
+  // @param samples Samples in the range [-1, 1] at config.sample_rate
+  void AcceptWaveform(int32_t source, const float *samples, int32_t n);
+
+  // Start the scheduler thread
+  void Start();
+
+  // Stop the scheduler thread. Samples not decoded yet are discarded.
+  void Stop();
+
+  // Number of samples of the source dropped because its ring was full
+  int64_t NumDropped(int32_t source) const {
+    return sources_[source]->ring.NumDropped();
+  }
+
+  // Number of DecodeStreams() calls so far
+  int64_t NumBatches() const { return num_batches_; }
+
+  // Number of streams decoded so far, summed over all batches
+  int64_t NumDecodedStreams() const { return num_decoded_streams_; }
+
+  // Time from a stream becoming ready to it being decoded
+  const LatencyHistogram &ScheduleDelay() const { return schedule_delay_; }
+
+ private:
+  struct Source {
+    explicit Source(const std::string &name, int32_t ring_size)
+        : name(name), ring(ring_size) {}
+
+    std::string name;
+    SpscRingBuffer ring;
+    std::unique_ptr<OnlineStream> stream;
+
+    // Set by RemoveSource()
+    std::atomic<bool> removed{false};
+
+    bool ready = false;
+    std::chrono::steady_clock::time_point ready_since;
+  };
+
+  void Run();
+
+  // Move samples from the rings to the streams and update the ready state.
+  void Feed();
+
+  // Decode up to max_batch_size ready streams, oldest first. A stream that
+  // is still ready afterwards goes behind the streams that are waiting.
+  void DecodeBatch();
+
+ private:
+  KeywordSpotter *spotter_;  // Not owned
+  KeywordSpotterSchedulerConfig config_;
+  Callback callback_;
+
+  std::vector<std::unique_ptr<Source>> sources_;
+
+  std::atomic<bool> stop_{false};
+  std::thread thread_;
+
+  // Accessed only by the scheduler thread
+  std::vector<float> samples_;
+  std::vector<int32_t> ready_;
+  std::vector<OnlineStream *> batch_;
+
+  std::atomic<int64_t> num_batches_{0};
+  std::atomic<int64_t> num_decoded_streams_{0};
+  LatencyHistogram schedule_delay_{"schedule_delay"};
+};
+
+}  // namespace sherpa_onnx
+
+#endif  // SHERPA_ONNX_CSRC_KEYWORD_SPOTTER_SCHEDULER_H_
@@ -0,0 +1,268 @@
+// sherpa-onnx/csrc/keyword-spotter-test.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/keyword-spotter.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "sherpa-onnx/csrc/cat.h"
+#include "sherpa-onnx/csrc/file-utils.h"
+#include "sherpa-onnx/csrc/file-watcher.h"
+#include "sherpa-onnx/csrc/keyword-spotter-transducer-impl.h"
+#include "sherpa-onnx/csrc/onnx-utils.h"
+#include "sherpa-onnx/csrc/unbind.h"
+
+namespace sherpa_onnx {
+
+namespace {
+
+// A transducer without a network. Each output frame of the encoder carries
+// a token from a script, and the joiner makes that token the most probable
+// one. Output frames without a scripted token are blanks.
+class ScriptedTransducerModel : public OnlineTransducerModel {
+ public:
+  // Emit the given tokens, each followed by a few blanks, in the next output
+  // frames
+  void Say(const std::vector<int32_t> &tokens) {
+    for (auto t : tokens) {
+      script_.push_back(t);
+      script_.insert(script_.end(), 3, 0);
+    }
+  }
+
+  std::vector<Ort::Value> StackStates(
+      const std::vector<std::vector<Ort::Value>> &states) const override {
+    std::vector<const Ort::Value *> v;
+    for (const auto &s : states) {
+      v.push_back(&s[0]);
+    }
+
+    std::vector<Ort::Value> ans;
+    ans.push_back(Cat(allocator_, v, 0));
+    return ans;
+  }
+
+  std::vector<std::vector<Ort::Value>> UnStackStates(
+      const std::vector<Ort::Value> &states) const override {
+    std::vector<std::vector<Ort::Value>> ans;
+    for (auto &v : Unbind(allocator_, &states[0], 0)) {
+      ans.emplace_back();
+      ans.back().push_back(std::move(v));
+    }
+    return ans;
+  }
+
+  std::vector<Ort::Value> GetEncoderInitStates() override {
+    std::array<int64_t, 2> shape{1, kDim};
+    Ort::Value s = Ort::Value::CreateTensor<float>(allocator_, shape.data(),
+                                                   shape.size());
+    Fill<float>(&s, 0);
+
+    std::vector<Ort::Value> ans;
+    ans.push_back(std::move(s));
+    return ans;
+  }
+
+  std::pair<Ort::Value, std::vector<Ort::Value>> RunEncoder(
+      Ort::Value features, std::vector<Ort::Value> states,
+      Ort::Value /*processed_frames*/) override {
+    int64_t batch_size = features.GetTensorTypeAndShapeInfo().GetShape()[0];
+    int64_t num_frames = ChunkShift() / 4;
+    std::array<int64_t, 3> shape{batch_size, num_frames, kDim};
+    Ort::Value encoder_out = Ort::Value::CreateTensor<float>(
+        allocator_, shape.data(), shape.size());
+    Fill<float>(&encoder_out, 0);
+
+    float *p = encoder_out.GetTensorMutableData<float>();
+    for (int64_t i = 0; i != batch_size * num_frames; ++i, p += kDim) {
+      if (!script_.empty()) {
+        p[0] = script_.front();
+        script_.pop_front();
+      }
+    }
+
+    return {std::move(encoder_out), std::move(states)};
+  }
+
+  Ort::Value RunDecoder(Ort::Value decoder_input) override {
+    int64_t n = decoder_input.GetTensorTypeAndShapeInfo().GetShape()[0];
+    std::array<int64_t, 2> shape{n, kDim};
+    Ort::Value decoder_out = Ort::Value::CreateTensor<float>(
+        allocator_, shape.data(), shape.size());
+    Fill<float>(&decoder_out, 0);
+    return decoder_out;
+  }
+
+  Ort::Value RunJoiner(Ort::Value encoder_out,
+                       Ort::Value /*decoder_out*/) override {
+    int64_t n = encoder_out.GetTensorTypeAndShapeInfo().GetShape()[0];
+    const float *q = encoder_out.GetTensorData<float>();
+
+    std::array<int64_t, 2> shape{n, kVocabSize};
+    Ort::Value logit = Ort::Value::CreateTensor<float>(
+        allocator_, shape.data(), shape.size());
+    float *p = logit.GetTensorMutableData<float>();
+    for (int64_t i = 0; i != n; ++i, p += kVocabSize, q += kDim) {
+      std::fill(p, p + kVocabSize, 0);
+      p[static_cast<int32_t>(q[0])] = 10;
+    }
+    return logit;
+  }
+
+  int32_t ContextSize() const override { return 2; }
+
+  int32_t ChunkSize() const override { return 45; }
+
+  int32_t ChunkShift() const override { return 32; }
+
+  int32_t VocabSize() const override { return kVocabSize; }
+
+  OrtAllocator *Allocator() override { return allocator_; }
+
+ private:
+  static constexpr int32_t kDim = 4;
+  static constexpr int32_t kVocabSize = 4;
+
+  mutable Ort::AllocatorWithDefaultOptions allocator_;
+  std::deque<int32_t> script_;
+};
+
+void WriteFile(const std::string &filename, const std::string &text) {
+  std::ofstream os(filename);
+  os << text;
+}
+
+std::vector<float> GenerateWave(int32_t n) {
+  std::vector<float> samples(n);
+  for (int32_t i = 0; i != n; ++i) {
+    samples[i] = 0.1 * ((i % 100) / 50.0 - 1);
+  }
+  return samples;
+}
+
+}  // namespace
+
+// Reloading the keywords file, as sherpa-onnx-keyword-spotter-alsa does
+// with a FileWatcher, switches a stream that is already decoding to the new
+// keywords.
+TEST(KeywordSpotter, ReloadKeywordsFileWhileDecoding) {
+  std::string filename = "./keyword-spotter-test-keywords.txt";
+  WriteFile(filename, "a b @AB\n");
+
+  KeywordSpotterConfig config;
+  config.model_config.tokens_buf = "<blk> 0\na 1\nb 2\nc 3\n";
+  config.keywords_file = filename;
+
+  auto model = std::make_unique<ScriptedTransducerModel>();
+  auto scripted = model.get();
+  KeywordSpotterTransducerImpl kws(config, std::move(model));
+
+  auto s = kws.CreateStream();
+  auto samples = GenerateWave(60 * 16000);
+  s->AcceptWaveform(16000, samples.data(), samples.size());
+
+  // Say the tokens and decode a few chunks. Return the detected keyword,
+  // if any.
+  auto say = [&](const std::vector<int32_t> &tokens) {
+    scripted->Say(tokens);
+
+    std::string keyword;
+    for (int32_t i = 0; i != 3; ++i) {
+      EXPECT_TRUE(kws.IsReady(s.get()));
+
+      OnlineStream *p = s.get();
+      kws.DecodeStreams(&p, 1);
+
+      auto r = kws.GetResult(s.get());
+      if (!r.keyword.empty()) {
+        keyword = r.keyword;
+        kws.Reset(s.get());
+      }
+    }
+    return keyword;
+  };
+
+  EXPECT_EQ(say({1, 2}), "AB");
+  EXPECT_EQ(say({2, 3}), "");
+
+  std::atomic<int32_t> num_reloads{0};
+  FileWatcher watcher(
+      filename,
+      [&](const std::string &name) {
+        auto buf = ReadFile(name);
+        if (kws.ReloadKeywords(std::string(buf.begin(), buf.end()))) {
+          ++num_reloads;
+        }
+      },
+      50);
+
+  // Make the modification time differ for the polling fallback
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  WriteFile(filename, "b c @BC\n");
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (num_reloads == 0 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  watcher.Stop();
+  std::remove(filename.c_str());
+
+  ASSERT_GT(num_reloads, 0);
+
+  EXPECT_EQ(say({1, 2}), "");
+  EXPECT_EQ(say({2, 3}), "BC");
+}
+
+// Keyword timestamps are relative to start_time, and frames are exact, on a
+// stream that has run for longer than a float can count frames.
+TEST(KeywordSpotter, TimestampsOnLongStream) {
+  KeywordSpotterConfig config;
+  config.model_config.tokens_buf = "<blk> 0\na 1\nb 2\nc 3\n";
+  config.keywords_buf = "a b @AB";
+
+  auto model = std::make_unique<ScriptedTransducerModel>();
+  auto scripted = model.get();
+  KeywordSpotterTransducerImpl kws(config, std::move(model));
+
+  auto s = kws.CreateStream();
+  auto samples = GenerateWave(2 * 16000);
+  s->AcceptWaveform(16000, samples.data(), samples.size());
+
+  // About a year of output frames, 40 ms each, as if decoded already
+  int64_t offset = (int64_t{1} << 30) + 1;
+  s->GetKeywordResult().frame_offset = offset;
+  s->GetKeywordResult().hyps_frame_offset = offset;
+
+  scripted->Say({1, 2});
+  ASSERT_TRUE(kws.IsReady(s.get()));
+
+  OnlineStream *p = s.get();
+  kws.DecodeStreams(&p, 1);
+
+  auto r = kws.GetResult(s.get());
+  ASSERT_EQ(r.keyword, "AB");
+
+  // Each output frame is 4 feature frames. Tokens are 4 output frames apart.
+  std::vector<int64_t> expected_frames = {offset * 4, offset * 4 + 16};
+  EXPECT_EQ(r.frames, expected_frames);
+
+  ASSERT_EQ(r.timestamps.size(), 2);
+  EXPECT_FLOAT_EQ(r.timestamps[0], 0);
+  EXPECT_FLOAT_EQ(r.timestamps[1], 0.16);
+  EXPECT_DOUBLE_EQ(r.start_time, offset * 4 * 0.01);
+}
+
+}  // namespace sherpa_onnx
@@ -6,7 +6,11 @@
 #define SHERPA_ONNX_CSRC_KEYWORD_SPOTTER_TRANSDUCER_IMPL_H_
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <memory>
+#include <mutex>  // NOLINT
 #include <regex>  // NOLINT
 #include <string>
 #include <strstream>
@@ -26,12 +30,13 @@ namespace sherpa_onnx {
 
 static KeywordResult Convert(const TransducerKeywordResult &src,
                              const SymbolTable &sym_table, float frame_shift_ms,
-                             int32_t subsampling_factor,
-                             int32_t frames_since_start) {
+                             int32_t subsampling_factor) {
   KeywordResult r;
   r.tokens.reserve(src.tokens.size());
   r.timestamps.reserve(src.tokens.size());
+  r.frames.reserve(src.tokens.size());
   r.keyword = src.keyword;
+  r.score = src.score;
   bool from_tokens = src.keyword.empty();
 
   for (auto i : src.tokens) {
@@ -45,13 +50,20 @@ static KeywordResult Convert(const TransducerKeywordResult &src,
     r.keyword = r.keyword.substr(1);
   }
 
+  if (src.timestamps.empty()) {
+    return r;
+  }
+
+  // Timestamps count output frames from the start of the stream. They are
+  // made relative to the first one before they are converted to float.
+  int64_t start = src.timestamps[0];
   float frame_shift_s = frame_shift_ms / 1000. * subsampling_factor;
   for (auto t : src.timestamps) {
-    float time = frame_shift_s * t;
-    r.timestamps.push_back(time);
+    r.timestamps.push_back(frame_shift_s * (t - start));
+    r.frames.push_back(t * subsampling_factor);
   }
 
-  r.start_time = frames_since_start * frame_shift_ms / 1000.;
+  r.start_time = start * subsampling_factor * (frame_shift_ms / 1000.);
 
   return r;
 }
@@ -59,8 +71,17 @@ static KeywordResult Convert(const TransducerKeywordResult &src,
 class KeywordSpotterTransducerImpl : public KeywordSpotterImpl {
  public:
   explicit KeywordSpotterTransducerImpl(const KeywordSpotterConfig &config)
+      : KeywordSpotterTransducerImpl(
+            config, OnlineTransducerModel::Create(config.model_config)) {}
+
+  // Use the given model instead of the one in config.model_config, e.g., a
+  // fake model in tests. Tokens and keywords are still read from config.
+  KeywordSpotterTransducerImpl(const KeywordSpotterConfig &config,
+                               std::unique_ptr<OnlineTransducerModel> model)
       : config_(config),
-        model_(OnlineTransducerModel::Create(config.model_config)) {
+        model_(std::move(model)),
+        memory_info_(Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator,
+                                                OrtMemTypeDefault)) {
     if (!config.model_config.tokens_buf.empty()) {
       sym_ = SymbolTable(config.model_config.tokens_buf, false);
     } else {
@@ -89,7 +110,9 @@ class KeywordSpotterTransducerImpl : public KeywordSpotterImpl {
   KeywordSpotterTransducerImpl(Manager *mgr, const KeywordSpotterConfig &config)
       : config_(config),
         model_(OnlineTransducerModel::Create(mgr, config.model_config)),
-        sym_(mgr, config.model_config.tokens) {
+        sym_(mgr, config.model_config.tokens),
+        memory_info_(Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator,
+                                                OrtMemTypeDefault)) {
     if (sym_.Contains("<unk>")) {
       unk_id_ = sym_["<unk>"];
     }
@@ -104,8 +127,11 @@ class KeywordSpotterTransducerImpl : public KeywordSpotterImpl {
   }
 
   std::unique_ptr<OnlineStream> CreateStream() const override {
-    auto stream =
-        std::make_unique<OnlineStream>(config_.feat_config, keywords_graph_);
+    auto stream = std::make_unique<OnlineStream>(config_.feat_config);
+    {
+      std::lock_guard<std::mutex> lock(keywords_mutex_);
+      stream->SetContextGraph(keywords_graph_, keywords_version_);
+    }
     InitOnlineStream(stream.get());
     return stream;
   }
@@ -130,6 +156,9 @@ class KeywordSpotterTransducerImpl : public KeywordSpotterImpl {
       return nullptr;
     }
 
+    // Guard the default keywords against ReloadKeywords()
+    std::lock_guard<std::mutex> lock(keywords_mutex_);
+
     int32_t num_kws = current_ids.size();
     int32_t num_default_kws = keywords_id_.size();
 
@@ -191,16 +220,56 @@ class KeywordSpotterTransducerImpl : public KeywordSpotterImpl {
     return s->GetNumProcessedFrames() + model_->ChunkSize() <
            s->NumFramesReady();
   }
-  void Reset(OnlineStream *s) const override { InitOnlineStream(s); }
+  void Reset(OnlineStream *s) const override {
+    // Start a new segment of the stream, so that its frame counters are
+    // relative to the last reset and do not grow on a stream that runs for
+    // months. It also restarts the processed frames of the encoder along
+    // with its states.
+    s->Reset();
+    InitOnlineStream(s);
+  }
+
+  int32_t SkipFrames(OnlineStream *s, int32_t num_kept_frames) const override {
+    int32_t chunk_shift = model_->ChunkShift();
+    int32_t n = s->NumFramesReady() - s->GetNumProcessedFrames() -
+                num_kept_frames;
+    if (n < chunk_shift) {
+      return 0;
+    }
+
+    int32_t num_chunks = n / chunk_shift;
+    n = num_chunks * chunk_shift;
+
+    s->GetNumProcessedFrames() += n;
+    s->Reset();
+
+    // The stream is usually skipped again before it is decoded, so instead
+    // of creating initial states for each skipped chunk, the stale states
+    // are dropped here and DecodeStreams() starts the stream afresh.
+    s->GetStates().clear();
+
+    s->GetKeywordResult().frame_offset +=
+        static_cast<int64_t>(num_chunks) * NumOutputFramesPerChunk();
+
+    return num_chunks;
+  }
 
   void DecodeStreams(OnlineStream **ss, int32_t n) const override {
+    UpdateKeywords(ss, n);
+
+    float output_frame_shift = OutputFrameShift();
+
     for (int32_t i = 0; i < n; ++i) {
       auto s = ss[i];
-      auto r = s->GetKeywordResult(true);
+      if (s->GetStates().empty()) {
+        // Frames were dropped by SkipFrames() after the last chunk
+        InitOnlineStream(s);
+        continue;
+      }
+
+      const auto &r = s->GetKeywordResult(true);
       int32_t num_trailing_blanks = r.num_trailing_blanks;
-      // assume subsampling_factor is 4
-      // assume frameshift is 0.01 second
-      float trailing_slience = num_trailing_blanks * 4 * 0.01;
+      float trailing_slience = num_trailing_blanks * output_frame_shift;
 
       // it resets automatically after detecting 1.5 seconds of silence
       float threshold = 1.5;
@@ -214,72 +283,164 @@ class KeywordSpotterTransducerImpl : public KeywordSpotterImpl {
 
     int32_t feature_dim = ss[0]->FeatureDim();
 
-    std::vector<TransducerKeywordResult> results(n);
-    std::vector<float> features_vec(n * chunk_size * feature_dim);
-    std::vector<std::vector<Ort::Value>> states_vec(n);
-    std::vector<int64_t> all_processed_frames(n);
+    // The workspace is reused across calls so that, once it has grown to
+    // the largest batch seen, no memory is allocated for it. There is one
+    // per thread, so that concurrent calls still run in parallel.
+    static thread_local DecodeWorkspace workspace;
+    auto &results = workspace.results;
+    auto &features_vec = workspace.features;
+    auto &states_vec = workspace.states;
+    auto &all_processed_frames = workspace.processed_frames;
+
+    results.resize(n);
+    features_vec.resize(n * chunk_size * feature_dim);
+    states_vec.resize(n);
+    all_processed_frames.resize(n);
 
     for (int32_t i = 0; i != n; ++i) {
       SHERPA_ONNX_CHECK(ss[i]->GetContextGraph() != nullptr);
 
       const auto num_processed_frames = ss[i]->GetNumProcessedFrames();
-      std::vector<float> features =
-          ss[i]->GetFrames(num_processed_frames, chunk_size);
+      ss[i]->GetFrames(num_processed_frames, chunk_size,
+                       features_vec.data() + i * chunk_size * feature_dim);
 
       // Question: should num_processed_frames include chunk_shift?
       ss[i]->GetNumProcessedFrames() += chunk_shift;
 
-      std::copy(features.begin(), features.end(),
-                features_vec.data() + i * chunk_size * feature_dim);
-
       results[i] = std::move(ss[i]->GetKeywordResult());
       states_vec[i] = std::move(ss[i]->GetStates());
       all_processed_frames[i] = num_processed_frames;
     }
 
-    auto memory_info =
-        Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeDefault);
-
     std::array<int64_t, 3> x_shape{n, chunk_size, feature_dim};
 
-    Ort::Value x = Ort::Value::CreateTensor(memory_info, features_vec.data(),
+    Ort::Value x = Ort::Value::CreateTensor(memory_info_, features_vec.data(),
                                             features_vec.size(), x_shape.data(),
                                             x_shape.size());
 
-    std::array<int64_t, 1> processed_frames_shape{
-        static_cast<int64_t>(all_processed_frames.size())};
+    std::array<int64_t, 1> processed_frames_shape{n};
 
     Ort::Value processed_frames = Ort::Value::CreateTensor(
-        memory_info, all_processed_frames.data(), all_processed_frames.size(),
+        memory_info_, all_processed_frames.data(), all_processed_frames.size(),
         processed_frames_shape.data(), processed_frames_shape.size());
 
-    auto states = model_->StackStates(states_vec);
+    std::vector<Ort::Value> states;
+    if (n == 1) {
+      // The state of a single stream already has a batch dim of size 1, so it
+      // is identical to its stacked version. Feed it to the encoder directly
+      // instead of copying it in StackStates() and again in UnStackStates().
+      states = std::move(states_vec[0]);
+    } else {
+      states = model_->StackStates(states_vec);
+
+      // The old states have been copied into `states`. Release them now
+      // instead of keeping them alive until the next call.
+      for (auto &v : states_vec) {
+        v.clear();
+      }
+    }
+
+    auto encoder_start = std::chrono::steady_clock::now();
 
     auto pair = model_->RunEncoder(std::move(x), std::move(states),
                                    std::move(processed_frames));
 
+    // DecodeStreams() adds the number of output frames to frame_offset, and
+    // so does SkipFrames()
+    std::array<int64_t, 3> encoder_out_shape;
+    pair.first.GetTensorTypeAndShapeInfo().GetDimensions(
+        encoder_out_shape.data(), encoder_out_shape.size());
+    num_output_frames_per_chunk_.store(
+        static_cast<int32_t>(encoder_out_shape[1]), std::memory_order_relaxed);
+
+    auto search_start = std::chrono::steady_clock::now();
+
     decoder_->Decode(std::move(pair.first), ss, &results);
 
+    if (latency_stats_) {
+      latency_stats_->encoder.Add(std::chrono::duration<double, std::milli>(
+                                      search_start - encoder_start)
+                                      .count());
+      latency_stats_->search.AddSince(search_start);
+    }
+
+    if (n == 1) {
+      ss[0]->SetKeywordResult(std::move(results[0]));
+      ss[0]->SetStates(std::move(pair.second));
+      return;
+    }
+
     std::vector<std::vector<Ort::Value>> next_states =
         model_->UnStackStates(pair.second);
 
     for (int32_t i = 0; i != n; ++i) {
-      ss[i]->SetKeywordResult(results[i]);
+      ss[i]->SetKeywordResult(std::move(results[i]));
       ss[i]->SetStates(std::move(next_states[i]));
     }
   }
 
   KeywordResult GetResult(OnlineStream *s) const override {
-    TransducerKeywordResult decoder_result = s->GetKeywordResult(true);
+    const auto &decoder_result = s->GetKeywordResult(true);
 
-    // TODO(fangjun): Remember to change these constants if needed
-    int32_t frame_shift_ms = 10;
-    int32_t subsampling_factor = 4;
-    return Convert(decoder_result, sym_, frame_shift_ms, subsampling_factor,
-                   s->GetNumFramesSinceStart());
+    float frame_shift_ms = config_.feat_config.frame_shift_ms;
+    int32_t subsampling_factor =
+        model_->ChunkShift() / NumOutputFramesPerChunk();
+    return Convert(decoder_result, sym_, frame_shift_ms, subsampling_factor);
+  }
+
+  bool ReloadKeywords(const std::string &keywords) override {
+    std::istringstream is(keywords);
+
+    std::vector<std::vector<int32_t>> keywords_id;
+    std::vector<std::string> keywords_str;
+    std::vector<float> boost_scores;
+    std::vector<float> thresholds;
+
+    if (!EncodeKeywords(is, sym_, &keywords_id, &keywords_str, &boost_scores,
+                        &thresholds)) {
+      SHERPA_ONNX_LOGE("Encode keywords failed. Keep the current keywords.");
+      return false;
+    }
+
+    // Build the graph before taking the lock so that decoding is not blocked
+    auto keywords_graph = std::make_shared<ContextGraph>(
+        keywords_id, config_.keywords_score, config_.keywords_threshold,
+        boost_scores, keywords_str, thresholds);
+
+    std::lock_guard<std::mutex> lock(keywords_mutex_);
+    keywords_id_ = std::move(keywords_id);
+    keywords_ = std::move(keywords_str);
+    boost_scores_ = std::move(boost_scores);
+    thresholds_ = std::move(thresholds);
+    keywords_graph_ = std::move(keywords_graph);
+    keywords_version_.store(keywords_version_.load() + 1);
+
+    return true;
+  }
+
+  void SetLatencyStats(KeywordSpotterLatencyStats *stats) override {
+    latency_stats_ = stats;
   }
 
  private:
+  // Number of encoder output frames for the chunk_shift feature frames
+  // that each encoder run consumes
+  int32_t NumOutputFramesPerChunk() const {
+    int32_t n = num_output_frames_per_chunk_.load(std::memory_order_relaxed);
+    if (n > 0) {
+      return n;
+    }
+
+    // Nothing has been decoded yet
+    return std::max(1, model_->ChunkShift() / model_->SubsamplingFactor());
+  }
+
+  // Duration of an encoder output frame in seconds
+  float OutputFrameShift() const {
+    return config_.feat_config.frame_shift_ms / 1000 * model_->ChunkShift() /
+           NumOutputFramesPerChunk();
+  }
+
   void InitKeywords(std::istream &is) {
     if (!EncodeKeywords(is, sym_, &keywords_id_, &keywords_, &boost_scores_,
                         &thresholds_)) {
@@ -342,10 +503,44 @@ class KeywordSpotterTransducerImpl : public KeywordSpotterImpl {
     InitKeywords(is);
   }
 
+  // Switch streams created by CreateStream() to the current keywords if they
+  // were reloaded. It runs between two chunks, so no audio is lost; only the
+  // hypotheses, which point into the previous graph, are discarded.
+  void UpdateKeywords(OnlineStream **ss, int32_t n) const {
+    int32_t version = keywords_version_.load(std::memory_order_relaxed);
+    ContextGraphPtr keywords_graph;
+
+    for (int32_t i = 0; i != n; ++i) {
+      int32_t v = ss[i]->GetKeywordsVersion();
+      if (v == -1 || v == version) {
+        continue;
+      }
+
+      if (!keywords_graph) {
+        std::lock_guard<std::mutex> lock(keywords_mutex_);
+        keywords_graph = keywords_graph_;
+        version = keywords_version_;
+      }
+
+      auto r = decoder_->GetEmptyResult();
+      r.frame_offset = ss[i]->GetKeywordResult().frame_offset;
+      r.hyps_frame_offset = r.frame_offset;
+      r.hyps.begin()->second.context_state = keywords_graph->Root();
+
+      ss[i]->SetKeywordResult(std::move(r));
+      ss[i]->SetContextGraph(keywords_graph, version);
+    }
+  }
+
   void InitOnlineStream(OnlineStream *stream) const {
     auto r = decoder_->GetEmptyResult();
     SHERPA_ONNX_CHECK_EQ(r.hyps.Size(), 1);
 
+    // Keep counting frames from the start of the stream, so that keyword
+    // timestamps can be mapped to the captured audio.
+    r.frame_offset = stream->GetKeywordResult().frame_offset;
+    r.hyps_frame_offset = r.frame_offset;
+
     SHERPA_ONNX_CHECK(stream->GetContextGraph() != nullptr);
     r.hyps.begin()->second.context_state = stream->GetContextGraph()->Root();
 
@@ -360,10 +555,32 @@ class KeywordSpotterTransducerImpl : public KeywordSpotterImpl {
   std::vector<float> thresholds_;
   std::vector<std::string> keywords_;
   ContextGraphPtr keywords_graph_;
+
+  // Incremented by ReloadKeywords(). The keywords above are guarded by
+  // keywords_mutex_ after construction.
+  std::atomic<int32_t> keywords_version_{0};
+  mutable std::mutex keywords_mutex_;
+
   std::unique_ptr<OnlineTransducerModel> model_;
   std::unique_ptr<TransducerKeywordDecoder> decoder_;
   SymbolTable sym_;
   int32_t unk_id_ = -1;
+
+  Ort::MemoryInfo memory_info_;
+
+  // Scratch buffers for DecodeStreams(). They hold nothing between calls:
+  // results and states are moved back to the streams.
+  struct DecodeWorkspace {
+    std::vector<TransducerKeywordResult> results;
+    std::vector<float> features;
+    std::vector<std::vector<Ort::Value>> states;
+    std::vector<int64_t> processed_frames;
+  };
+
+  // Taken from the encoder output, see NumOutputFramesPerChunk()
+  mutable std::atomic<int32_t> num_output_frames_per_chunk_{0};
+
+  KeywordSpotterLatencyStats *latency_stats_ = nullptr;  // Not owned
 };
 
 }  // namespace sherpa_onnx
@@ -149,6 +149,9 @@ template <typename Manager>
 KeywordSpotter::KeywordSpotter(Manager *mgr, const KeywordSpotterConfig &config)
     : impl_(KeywordSpotterImpl::Create(mgr, config)) {}
 
+KeywordSpotter::KeywordSpotter(std::unique_ptr<KeywordSpotterImpl> impl)
+    : impl_(std::move(impl)) {}
+
 KeywordSpotter::~KeywordSpotter() = default;
 
 std::unique_ptr<OnlineStream> KeywordSpotter::CreateStream() const {
@@ -166,6 +169,11 @@ bool KeywordSpotter::IsReady(OnlineStream *s) const {
 
 void KeywordSpotter::Reset(OnlineStream *s) const { impl_->Reset(s); }
 
+int32_t KeywordSpotter::SkipFrames(OnlineStream *s,
+                                   int32_t num_kept_frames) const {
+  return impl_->SkipFrames(s, num_kept_frames);
+}
+
 void KeywordSpotter::DecodeStreams(OnlineStream **ss, int32_t n) const {
   impl_->DecodeStreams(ss, n);
 }
@@ -174,6 +182,14 @@ KeywordResult KeywordSpotter::GetResult(OnlineStream *s) const {
   return impl_->GetResult(s);
 }
 
+bool KeywordSpotter::ReloadKeywords(const std::string &keywords) {
+  return impl_->ReloadKeywords(keywords);
+}
+
+void KeywordSpotter::SetLatencyStats(KeywordSpotterLatencyStats *stats) {
+  impl_->SetLatencyStats(stats);
+}
+
 #if __ANDROID_API__ >= 9
 template KeywordSpotter::KeywordSpotter(AAssetManager *mgr,
                                         const KeywordSpotterConfig &config);
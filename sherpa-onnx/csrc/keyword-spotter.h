@@ -10,6 +10,7 @@
 #include <vector>
 
 #include "sherpa-onnx/csrc/features.h"
+#include "sherpa-onnx/csrc/latency-stats.h"
 #include "sherpa-onnx/csrc/online-model-config.h"
 #include "sherpa-onnx/csrc/online-stream.h"
 #include "sherpa-onnx/csrc/online-transducer-model-config.h"
@@ -30,12 +31,25 @@ struct KeywordResult {
   std::vector<std::string> tokens;
 
   /// timestamps.size() == tokens.size()
-  /// timestamps[i] records the time in seconds when tokens[i] is decoded.
+  /// timestamps[i] records the time in seconds, relative to start_time, when
+  /// tokens[i] is decoded.
   std::vector<float> timestamps;
 
-  /// Starting time of this segment.
-  /// When an endpoint is detected, it will change
-  float start_time = 0;
+  /// frames.size() == tokens.size()
+  /// frames[i] is the index of the feature frame, counting from the start of
+  /// the stream, at which tokens[i] is decoded. Multiply it by the frame
+  /// shift to get the time since the start of the stream. Unlike
+  /// start_time + timestamps[i], it is exact however long the stream runs.
+  std::vector<int64_t> frames;
+
+  /// Average probability of the tokens of the keyword, in [0, 1].
+  /// It is compared with the threshold of the keyword to trigger it.
+  float score = 0;
+
+  /// Time in seconds, counting from the start of the stream, when the first
+  /// token of the keyword is decoded. It is a double so that it stays
+  /// precise on streams that run for months.
+  double start_time = 0;
 
   /** Return a json string.
    *
@@ -99,6 +113,9 @@ class KeywordSpotter {
   template <typename Manager>
   KeywordSpotter(Manager *mgr, const KeywordSpotterConfig &config);
 
+  // Use the given implementation, e.g., a fake one in tests
+  explicit KeywordSpotter(std::unique_ptr<KeywordSpotterImpl> impl);
+
   ~KeywordSpotter();
 
   /** Create a stream for decoding.
@@ -126,6 +143,21 @@ class KeywordSpotter {
   // Remember to call it after detecting a keyword
   void Reset(OnlineStream *s) const;
 
+  /** Drop the frames of a stream that are not decoded yet, instead of
+   *  running the encoder on them, e.g., while a speech gate finds no speech.
+   *  The last num_kept_frames frames, or a few more so that whole chunks
+   *  are dropped, are kept as pre-roll.
+   *
+   *  Timestamps of later keywords still count from the start of the stream.
+   *  The encoder states and partial matches refer to the audio before the
+   *  dropped frames, so they are reset when the stream is decoded again,
+   *  i.e., the encoder starts from its initial states at the pre-roll
+   *  frames.
+   *
+   *  @return Return the number of encoder runs skipped for this stream.
+   */
+  int32_t SkipFrames(OnlineStream *s, int32_t num_kept_frames) const;
+
   /** Decode a single stream. */
   void DecodeStream(OnlineStream *s) const {
     OnlineStream *ss[1] = {s};
@@ -141,6 +173,32 @@ class KeywordSpotter {
 
   KeywordResult GetResult(OnlineStream *s) const;
 
+  /** Replace the default keywords, i.e., the ones from keywords_file or
+   *  keywords_buf in the config, without reloading the models.
+   *
+   *  The new keywords are encoded and compiled in the calling thread. Streams
+   *  created by CreateStream() switch to them at the start of their next
+   *  DecodeStreams() call; partial matches in progress are discarded, while
+   *  buffered audio and encoder states are kept. Streams created by
+   *  CreateStream(keywords) keep their keywords.
+   *
+   *  It is safe to call it while other threads are decoding.
+   *
+   *  @param keywords Keywords in the same format as the keywords file.
+   *  @return Return false if the keywords cannot be encoded. In that case,
+   *          the current keywords are kept.
+   */
+  bool ReloadKeywords(const std::string &keywords);
+
+  /** Record the encoder and search time of each DecodeStreams() call.
+   *
+   *  Call it before decoding starts. Pass nullptr to stop recording.
+   *
+   *  @param stats Not owned. It must outlive the spotter or be unset
+   *               before it is destroyed.
+   */
+  void SetLatencyStats(KeywordSpotterLatencyStats *stats);
+
  private:
   std::unique_ptr<KeywordSpotterImpl> impl_;
 };
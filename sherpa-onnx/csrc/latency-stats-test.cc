@@ -0,0 +1,93 @@
+// sherpa-onnx/csrc/latency-stats-test.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/latency-stats.h"
+
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace sherpa_onnx {
+
+TEST(LatencyHistogram, Empty) {
+  LatencyHistogram h("empty");
+  EXPECT_EQ(h.Count(), 0);
+  EXPECT_EQ(h.Mean(), 0);
+  EXPECT_EQ(h.Max(), 0);
+  EXPECT_EQ(h.Quantile(0.5), 0);
+}
+
+TEST(LatencyHistogram, Quantile) {
+  LatencyHistogram h("test");
+
+  // 1, 2, ..., 100 ms
+  for (int32_t i = 1; i <= 100; ++i) {
+    h.Add(i);
+  }
+
+  EXPECT_EQ(h.Count(), 100);
+  EXPECT_NEAR(h.Mean(), 50.5, 1e-3);
+  EXPECT_NEAR(h.Max(), 100, 1e-3);
+
+  // Buckets are 2^(1/4) apart, i.e., at most 19% too large
+  EXPECT_GE(h.Quantile(0.5), 50);
+  EXPECT_LE(h.Quantile(0.5), 50 * 1.19);
+
+  EXPECT_GE(h.Quantile(0.9), 90);
+  EXPECT_LE(h.Quantile(0.9), 90 * 1.19);
+
+  EXPECT_NEAR(h.Quantile(1), 100, 1e-3);
+}
+
+TEST(LatencyHistogram, Concurrent) {
+  LatencyHistogram h("concurrent");
+
+  std::vector<std::thread> threads;
+  for (int32_t t = 0; t != 4; ++t) {
+    threads.emplace_back([&h]() {
+      for (int32_t i = 0; i != 10000; ++i) {
+        h.Add(0.5);
+      }
+    });
+  }
+
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  EXPECT_EQ(h.Count(), 40000);
+  EXPECT_NEAR(h.Mean(), 0.5, 1e-6);
+}
+
+TEST(SampleClock, Lookup) {
+  using Clock = std::chrono::steady_clock;
+  SampleClock clock(3);
+
+  Clock::time_point t0 = Clock::now();
+  auto ms = [t0](int32_t i) { return t0 + std::chrono::milliseconds(i); };
+
+  // 4 reads of 160 samples each, 10 ms apart. Only the last 3 are kept.
+  for (int32_t i = 1; i <= 4; ++i) {
+    clock.Stamp(i * 160, ms(i * 10));
+  }
+
+  Clock::time_point t;
+  EXPECT_TRUE(clock.Lookup(160, &t));
+  EXPECT_EQ(t, ms(20));
+
+  EXPECT_TRUE(clock.Lookup(319, &t));
+  EXPECT_EQ(t, ms(20));
+
+  EXPECT_TRUE(clock.Lookup(639, &t));
+  EXPECT_EQ(t, ms(40));
+
+  // Not captured yet
+  EXPECT_FALSE(clock.Lookup(640, &t));
+
+  // Captured by the first read, which is no longer kept
+  EXPECT_FALSE(clock.Lookup(100, &t));
+}
+
+}  // namespace sherpa_onnx
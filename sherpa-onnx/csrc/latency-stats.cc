@@ -0,0 +1,140 @@
+// sherpa-onnx/csrc/latency-stats.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/latency-stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+
+namespace sherpa_onnx {
+
+void LatencyHistogram::Add(double ms) {
+  int64_t us = static_cast<int64_t>(std::max(ms, 0.0) * 1000);
+
+  int32_t i = 0;
+  if (us > 1) {
+    i = static_cast<int32_t>(std::log2(static_cast<double>(us)) *
+                             kBucketsPerOctave);
+    i = std::min(i, kNumBuckets - 1);
+  }
+
+  buckets_[i].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_us_.fetch_add(us, std::memory_order_relaxed);
+
+  int64_t max_us = max_us_.load(std::memory_order_relaxed);
+  while (us > max_us &&
+         !max_us_.compare_exchange_weak(max_us, us,
+                                        std::memory_order_relaxed)) {
+  }
+}
+
+double LatencyHistogram::Mean() const {
+  int64_t count = Count();
+  if (count == 0) {
+    return 0;
+  }
+
+  return sum_us_.load(std::memory_order_relaxed) / 1000.0 / count;
+}
+
+double LatencyHistogram::Max() const {
+  return max_us_.load(std::memory_order_relaxed) / 1000.0;
+}
+
+double LatencyHistogram::Quantile(double q) const {
+  int64_t count = Count();
+  if (count == 0) {
+    return 0;
+  }
+
+  int64_t target = std::max<int64_t>(1, std::ceil(q * count));
+  int64_t acc = 0;
+  for (int32_t i = 0; i != kNumBuckets; ++i) {
+    acc += buckets_[i].load(std::memory_order_relaxed);
+    if (acc >= target) {
+      double upper_us =
+          std::exp2(static_cast<double>(i + 1) / kBucketsPerOctave);
+      return std::min(upper_us / 1000, Max());
+    }
+  }
+
+  return Max();
+}
+
+std::string LatencyHistogram::ToString() const {
+  char buf[256];
+  snprintf(buf, sizeof(buf),
+           "%s: count=%lld mean=%.3f p50=%.3f p90=%.3f p99=%.3f max=%.3f (ms)",
+           name_.c_str(), static_cast<long long>(Count()),  // NOLINT
+           Mean(), Quantile(0.5), Quantile(0.9), Quantile(0.99), Max());
+  return buf;
+}
+
+std::string KeywordSpotterLatencyStats::ToString() const {
+  std::ostringstream os;
+  for (const auto *h :
+       {&capture_wait, &queue, &feature, &encoder, &search, &sink,
+        &end_to_end}) {
+    os << h->ToString() << "\n";
+  }
+  return os.str();
+}
+
+bool KeywordSpotterLatencyStats::WriteToFile(
+    const std::string &filename) const {
+  FILE *fp = fopen(filename.c_str(), "w");
+  if (!fp) {
+    return false;
+  }
+
+  std::string s = ToString();
+  bool ok = fwrite(s.data(), 1, s.size(), fp) == s.size();
+  ok = (fclose(fp) == 0) && ok;
+
+  return ok;
+}
+
+void SampleClock::Stamp(int64_t end_sample,
+                        std::chrono::steady_clock::time_point t) {
+  Entry e;
+  e.end_sample = end_sample;
+  e.time = t;
+
+  // If the decoding thread does not look up for a while, the queue may be
+  // full. Losing some stamps only makes Lookup() slightly less accurate.
+  queue_.PushItem(std::move(e));
+}
+
+bool SampleClock::Lookup(int64_t sample,
+                         std::chrono::steady_clock::time_point *t) {
+  Entry e;
+  while (queue_.PopItem(&e)) {
+    history_.push_back(e);
+    if (static_cast<int32_t>(history_.size()) > history_size_) {
+      min_sample_ = history_.front().end_sample;
+      history_.pop_front();
+    }
+  }
+
+  if (sample < min_sample_) {
+    return false;
+  }
+
+  // The first entry whose end_sample is larger than sample
+  auto it = std::upper_bound(
+      history_.begin(), history_.end(), sample,
+      [](int64_t s, const Entry &e) { return s < e.end_sample; });
+
+  if (it == history_.end()) {
+    return false;
+  }
+
+  *t = it->time;
+  return true;
+}
+
+}  // namespace sherpa_onnx
@@ -0,0 +1,143 @@
+// sherpa-onnx/csrc/latency-stats.h
+//
+// Copyright (c)  2025  Xiaomi Corporation
+#ifndef SHERPA_ONNX_CSRC_LATENCY_STATS_H_
+#define SHERPA_ONNX_CSRC_LATENCY_STATS_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <deque>
+#include <string>
+
+#include "sherpa-onnx/csrc/spsc-ring-buffer.h"
+
+namespace sherpa_onnx {
+
+// A histogram of latencies with logarithmic buckets from 1 us to about 16 s.
+// Each power of two is split into 4 buckets, so quantiles are accurate to
+// within 19%.
+//
+// Add() is lock-free and can be called from any thread.
+class LatencyHistogram {
+ public:
+  explicit LatencyHistogram(const std::string &name) : name_(name) {}
+
+  LatencyHistogram(const LatencyHistogram &) = delete;
+  LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+  // @param ms Latency in milliseconds
+  void Add(double ms);
+
+  // Add the time elapsed since start
+  void AddSince(std::chrono::steady_clock::time_point start) {
+    Add(std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start)
+            .count());
+  }
+
+  int64_t Count() const { return count_.load(std::memory_order_relaxed); }
+
+  // All values below are in milliseconds. They are 0 if Count() is 0.
+  double Mean() const;
+  double Max() const;
+
+  // Return the upper bound of the bucket containing the q-quantile.
+  // @param q In [0, 1]
+  double Quantile(double q) const;
+
+  const std::string &Name() const { return name_; }
+
+  // Return a line of the form
+  //   name: count=x mean=x p50=x p90=x p99=x max=x (ms)
+  std::string ToString() const;
+
+ private:
+  static constexpr int32_t kBucketsPerOctave = 4;
+  static constexpr int32_t kNumBuckets = 24 * kBucketsPerOctave;
+
+  std::string name_;
+
+  std::array<std::atomic<int64_t>, kNumBuckets> buckets_{};
+  std::atomic<int64_t> count_{0};
+  std::atomic<int64_t> sum_us_{0};
+  std::atomic<int64_t> max_us_{0};
+};
+
+// Per-stage latencies of the keyword spotting pipeline.
+//
+// KeywordSpotter::SetLatencyStats() fills encoder and search. The other
+// stages are filled by the application, e.g.,
+// sherpa-onnx-keyword-spotter-alsa.
+struct KeywordSpotterLatencyStats {
+  /// Time blocked in Alsa::Read() waiting for a period of audio
+  LatencyHistogram capture_wait{"capture_wait"};
+
+  /// From capturing the newest sample of a chunk to taking the chunk
+  /// out of the queue between the capture and decoding threads
+  LatencyHistogram queue{"queue"};
+
+  /// OnlineStream::AcceptWaveform(), i.e., feature extraction of a chunk
+  LatencyHistogram feature{"feature"};
+
+  /// Running the encoder in KeywordSpotter::DecodeStreams()
+  LatencyHistogram encoder{"encoder"};
+
+  /// Running the decoder and joiner with beam search in
+  /// KeywordSpotter::DecodeStreams()
+  LatencyHistogram search{"search"};
+
+  /// Delivering a keyword event to the sinks
+  LatencyHistogram sink{"sink"};
+
+  /// From capturing the last sample of a keyword to reporting it by
+  /// KeywordSpotter::GetResult()
+  LatencyHistogram end_to_end{"end_to_end"};
+
+  std::string ToString() const;
+
+  // @return Return false if the file cannot be written
+  bool WriteToFile(const std::string &filename) const;
+};
+
+// Map sample indexes of an audio stream to the time they were captured.
+//
+// The capture thread calls Stamp() after each read; the decoding thread
+// calls Lookup(). They communicate through a lock-free queue, so the
+// capture thread is never blocked.
+class SampleClock {
+ public:
+  // @param history Number of stamps kept for Lookup(). With 10 ms periods,
+  //                the default covers the last 20 seconds.
+  explicit SampleClock(int32_t history = 2048)
+      : queue_(256), history_size_(history) {}
+
+  // Called only by the capture thread.
+  // @param end_sample Total number of samples captured so far, i.e., the
+  //                   index of the first sample that is not captured yet.
+  // @param t Time when the samples before end_sample were captured.
+  void Stamp(int64_t end_sample, std::chrono::steady_clock::time_point t);
+
+  // Called only by the decoding thread.
+  // @return Return false if sample is not captured yet or is older than
+  //         the history.
+  bool Lookup(int64_t sample, std::chrono::steady_clock::time_point *t);
+
+ private:
+  struct Entry {
+    int64_t end_sample = 0;
+    std::chrono::steady_clock::time_point time;
+  };
+
+  BasicSpscRingBuffer<Entry> queue_;
+
+  // Accessed only by the decoding thread
+  std::deque<Entry> history_;
+  int32_t history_size_;
+  int64_t min_sample_ = 0;  // Samples before it are no longer in history_
+};
+
+}  // namespace sherpa_onnx
+
+#endif  // SHERPA_ONNX_CSRC_LATENCY_STATS_H_
@@ -0,0 +1,145 @@
+// sherpa-onnx/csrc/log-softmax-topk-benchmark.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+// Compare LogSoftmax() + TopkIndex() from math.h with the fused kernels
+// in log-softmax-topk.h, as used by the beam search of keyword spotting.
+//
+// Usage:
+//
+//   ./bin/log-softmax-topk-benchmark [/path/to/tokens.txt]
+//
+// The vocab size is the number of lines in tokens.txt. If it is not given,
+// 227 is used, which is the vocab size of scripts/tokens.txt.
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "sherpa-onnx/csrc/log-softmax-topk.h"
+#include "sherpa-onnx/csrc/math.h"
+
+namespace {
+
+int32_t ReadVocabSize(const char *filename) {
+  std::ifstream is(filename);
+  if (!is) {
+    fprintf(stderr, "Failed to open %s\n", filename);
+    exit(-1);
+  }
+
+  int32_t n = 0;
+  std::string line;
+  while (std::getline(is, line)) {
+    if (!line.empty()) {
+      ++n;
+    }
+  }
+  return n;
+}
+
+// Mirrors what TransducerKeywordDecoder::Decode() did before the fused
+// kernels: log-softmax, a scalar loop adding the hypothesis scores, and
+// TopkIndex() from math.h.
+float RunBaseline(std::vector<float> *logit, const std::vector<float> &offsets,
+                  int32_t vocab_size, int32_t num_hyps, int32_t k) {
+  float *p = logit->data();
+  sherpa_onnx::LogSoftmax(p, vocab_size, num_hyps);
+
+  std::vector<float> logprobs(vocab_size * num_hyps);
+  std::copy(p, p + logprobs.size(), logprobs.begin());
+
+  for (int32_t i = 0; i != num_hyps; ++i) {
+    float offset = offsets[i];
+    for (int32_t j = 0; j != vocab_size; ++j, ++p) {
+      *p += offset;
+    }
+  }
+
+  auto topk = sherpa_onnx::TopkIndex(logit->data(), logit->size(), k);
+  return logprobs[topk[0]];
+}
+
+float RunFused(std::vector<float> *logit, const std::vector<float> &offsets,
+               std::vector<float> *logprobs, std::vector<int32_t> *topk,
+               int32_t vocab_size, int32_t num_hyps, int32_t k) {
+  sherpa_onnx::LogSoftmaxWithOffset(logit->data(), vocab_size, num_hyps,
+                                    offsets.data(), logprobs->data());
+
+  sherpa_onnx::TopkIndex(logit->data(), logit->size(), k, topk->data());
+  return (*logprobs)[(*topk)[0]];
+}
+
+}  // namespace
+
+int main(int32_t argc, char *argv[]) {
+  int32_t vocab_size = 227;
+  if (argc > 1) {
+    vocab_size = ReadVocabSize(argv[1]);
+  }
+
+  constexpr int32_t kNumIterations = 20000;
+  constexpr int32_t kBeam = 4;
+
+  std::mt19937 gen(0);
+  std::normal_distribution<float> dist(0, 5);
+
+  fprintf(stderr, "vocab size: %d, iterations: %d\n", vocab_size,
+          kNumIterations);
+  fprintf(stderr, "%8s %14s %14s %8s\n", "num_hyps", "baseline(us)",
+          "fused(us)", "speedup");
+
+  for (int32_t num_hyps : {1, 2, 4, 8, 16}) {
+    std::vector<float> input(vocab_size * num_hyps);
+    for (auto &f : input) {
+      f = dist(gen);
+    }
+
+    std::vector<float> offsets(num_hyps);
+    for (auto &f : offsets) {
+      f = -std::abs(dist(gen));
+    }
+
+    std::vector<float> logit;
+    std::vector<float> logprobs(input.size());
+    std::vector<int32_t> topk(kBeam);
+
+    // Prevent the compiler from optimizing the loops away
+    float sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int32_t i = 0; i != kNumIterations; ++i) {
+      logit = input;
+      sink += RunBaseline(&logit, offsets, vocab_size, num_hyps, kBeam);
+    }
+    auto baseline = std::chrono::duration<double, std::micro>(
+                        std::chrono::steady_clock::now() - start)
+                        .count() /
+                    kNumIterations;
+
+    start = std::chrono::steady_clock::now();
+    for (int32_t i = 0; i != kNumIterations; ++i) {
+      logit = input;
+      sink += RunFused(&logit, offsets, &logprobs, &topk, vocab_size,
+                       num_hyps, kBeam);
+    }
+    auto fused = std::chrono::duration<double, std::micro>(
+                     std::chrono::steady_clock::now() - start)
+                     .count() /
+                 kNumIterations;
+
+    fprintf(stderr, "%8d %14.3f %14.3f %7.2fx\n", num_hyps, baseline, fused,
+            baseline / fused);
+
+    if (sink == 1) {
+      fprintf(stderr, " ");
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,91 @@
+// sherpa-onnx/csrc/log-softmax-topk-test.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/log-softmax-topk.h"
+
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "sherpa-onnx/csrc/math.h"
+
+namespace sherpa_onnx {
+
+static std::vector<float> RandomVector(int32_t n, float scale) {
+  std::mt19937 gen(20250101);
+  std::uniform_real_distribution<float> dist(-scale, scale);
+
+  std::vector<float> ans(n);
+  for (auto &f : ans) {
+    f = dist(gen);
+  }
+  return ans;
+}
+
+TEST(LogSoftmaxWithOffset, CompareWithLogSoftmax) {
+  // 227 is the vocab size of the model in scripts/tokens.txt. The others
+  // cover rows that are shorter than or not a multiple of the SIMD width.
+  for (int32_t w : {1, 3, 4, 8, 13, 227, 500}) {
+    for (int32_t h : {1, 4, 7}) {
+      std::vector<float> expected = RandomVector(w * h, 20);
+      std::vector<float> offsets = RandomVector(h, 5);
+
+      std::vector<float> actual = expected;
+      std::vector<float> log_probs(w * h);
+
+      LogSoftmax(expected.data(), w, h);
+      LogSoftmaxWithOffset(actual.data(), w, h, offsets.data(),
+                           log_probs.data());
+
+      for (int32_t r = 0; r != h; ++r) {
+        for (int32_t i = 0; i != w; ++i) {
+          int32_t k = r * w + i;
+          EXPECT_NEAR(log_probs[k], expected[k], 1e-4) << w << " " << h;
+          EXPECT_NEAR(actual[k], expected[k] + offsets[r], 1e-4);
+        }
+      }
+    }
+  }
+}
+
+TEST(LogSoftmaxWithOffset, NoOffset) {
+  std::vector<float> expected = RandomVector(227 * 2, 100);
+  std::vector<float> actual = expected;
+
+  LogSoftmax(expected.data(), 227, 2);
+  LogSoftmaxWithOffset(actual.data(), 227, 2);
+
+  for (int32_t i = 0; i != static_cast<int32_t>(actual.size()); ++i) {
+    EXPECT_NEAR(actual[i], expected[i], 1e-4);
+  }
+}
+
+TEST(TopkIndex, CompareWithPartialSort) {
+  std::vector<float> v = RandomVector(227 * 4, 10);
+
+  for (int32_t k : {1, 4, 10, 227 * 4}) {
+    std::vector<int32_t> expected = TopkIndex(v.data(), v.size(), k);
+
+    std::vector<int32_t> actual(k);
+    int32_t n = TopkIndex(v.data(), v.size(), k, actual.data());
+
+    EXPECT_EQ(n, k);
+    EXPECT_EQ(actual, expected);
+  }
+}
+
+TEST(TopkIndex, KLargerThanN) {
+  std::vector<float> v = {3, 1, 2};
+  std::vector<int32_t> out(5, -1);
+
+  int32_t n = TopkIndex(v.data(), v.size(), 5, out.data());
+
+  EXPECT_EQ(n, 3);
+  EXPECT_EQ(out[0], 0);
+  EXPECT_EQ(out[1], 2);
+  EXPECT_EQ(out[2], 1);
+  EXPECT_EQ(out[3], -1);
+}
+
+}  // namespace sherpa_onnx
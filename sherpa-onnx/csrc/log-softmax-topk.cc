@@ -0,0 +1,429 @@
+// sherpa-onnx/csrc/log-softmax-topk.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/log-softmax-topk.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SHERPA_ONNX_LOG_SOFTMAX_NEON 1
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define SHERPA_ONNX_LOG_SOFTMAX_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SHERPA_ONNX_LOG_SOFTMAX_SSE2 1
+#endif
+
+namespace sherpa_onnx {
+
+namespace {
+
+// Constants for the polynomial approximation of exp() from Cephes.
+// See also http://gruntthepeon.free.fr/ssemath/
+constexpr float kExpHi = 88.3762626647949f;
+constexpr float kExpLo = -88.3762626647949f;
+constexpr float kLog2e = 1.44269504088896341f;
+constexpr float kExpC1 = 0.693359375f;
+constexpr float kExpC2 = -2.12194440e-4f;
+constexpr float kExpP0 = 1.9875691500e-4f;
+constexpr float kExpP1 = 1.3981999507e-3f;
+constexpr float kExpP2 = 8.3334519073e-3f;
+constexpr float kExpP3 = 4.1665795894e-2f;
+constexpr float kExpP4 = 1.6666665459e-1f;
+constexpr float kExpP5 = 5.0000001201e-1f;
+
+#if SHERPA_ONNX_LOG_SOFTMAX_NEON
+
+constexpr int32_t kLanes = 4;
+
+inline float32x4_t Exp(float32x4_t x) {
+  const float32x4_t one = vdupq_n_f32(1.0f);
+
+  x = vminq_f32(x, vdupq_n_f32(kExpHi));
+  x = vmaxq_f32(x, vdupq_n_f32(kExpLo));
+
+  // fx = floor(x * log2(e) + 0.5)
+  float32x4_t fx = vmlaq_f32(vdupq_n_f32(0.5f), x, vdupq_n_f32(kLog2e));
+  float32x4_t tmp = vcvtq_f32_s32(vcvtq_s32_f32(fx));
+  uint32x4_t mask = vcgtq_f32(tmp, fx);
+  mask = vandq_u32(mask, vreinterpretq_u32_f32(one));
+  fx = vsubq_f32(tmp, vreinterpretq_f32_u32(mask));
+
+  x = vmlsq_f32(x, fx, vdupq_n_f32(kExpC1));
+  x = vmlsq_f32(x, fx, vdupq_n_f32(kExpC2));
+
+  float32x4_t z = vmulq_f32(x, x);
+
+  float32x4_t y = vdupq_n_f32(kExpP0);
+  y = vmlaq_f32(vdupq_n_f32(kExpP1), y, x);
+  y = vmlaq_f32(vdupq_n_f32(kExpP2), y, x);
+  y = vmlaq_f32(vdupq_n_f32(kExpP3), y, x);
+  y = vmlaq_f32(vdupq_n_f32(kExpP4), y, x);
+  y = vmlaq_f32(vdupq_n_f32(kExpP5), y, x);
+  y = vmlaq_f32(x, y, z);
+  y = vaddq_f32(y, one);
+
+  // 2^n
+  int32x4_t n = vcvtq_s32_f32(fx);
+  n = vaddq_s32(n, vdupq_n_s32(0x7f));
+  n = vshlq_n_s32(n, 23);
+
+  return vmulq_f32(y, vreinterpretq_f32_s32(n));
+}
+
+inline float Max(const float *p, int32_t n) {
+  int32_t i = 0;
+  float ans = p[0];
+  if (n >= kLanes) {
+    float32x4_t m = vld1q_f32(p);
+    for (i = kLanes; i + kLanes <= n; i += kLanes) {
+      m = vmaxq_f32(m, vld1q_f32(p + i));
+    }
+    float32x2_t t = vpmax_f32(vget_low_f32(m), vget_high_f32(m));
+    t = vpmax_f32(t, t);
+    ans = vget_lane_f32(t, 0);
+  }
+
+  for (; i < n; ++i) {
+    ans = std::max(ans, p[i]);
+  }
+  return ans;
+}
+
+// Return sum(exp(p[i] - m))
+inline float SumExp(const float *p, int32_t n, float m) {
+  int32_t i = 0;
+  float ans = 0;
+  if (n >= kLanes) {
+    float32x4_t vm = vdupq_n_f32(m);
+    float32x4_t s = vdupq_n_f32(0);
+    for (; i + kLanes <= n; i += kLanes) {
+      s = vaddq_f32(s, Exp(vsubq_f32(vld1q_f32(p + i), vm)));
+    }
+    float32x2_t t = vadd_f32(vget_low_f32(s), vget_high_f32(s));
+    t = vpadd_f32(t, t);
+    ans = vget_lane_f32(t, 0);
+  }
+
+  for (; i < n; ++i) {
+    ans += std::exp(p[i] - m);
+  }
+  return ans;
+}
+
+// p[i] = p[i] - offset + bias; if q is not nullptr, q[i] = p[i] - offset
+inline void Shift(float *p, int32_t n, float offset, float bias, float *q) {
+  int32_t i = 0;
+  float32x4_t vo = vdupq_n_f32(offset);
+  float32x4_t vb = vdupq_n_f32(bias);
+  for (; i + kLanes <= n; i += kLanes) {
+    float32x4_t x = vsubq_f32(vld1q_f32(p + i), vo);
+    if (q) {
+      vst1q_f32(q + i, x);
+    }
+    vst1q_f32(p + i, vaddq_f32(x, vb));
+  }
+
+  for (; i < n; ++i) {
+    float x = p[i] - offset;
+    if (q) {
+      q[i] = x;
+    }
+    p[i] = x + bias;
+  }
+}
+
+#elif SHERPA_ONNX_LOG_SOFTMAX_AVX2
+
+constexpr int32_t kLanes = 8;
+
+inline __m256 Exp(__m256 x) {
+  const __m256 one = _mm256_set1_ps(1.0f);
+
+  x = _mm256_min_ps(x, _mm256_set1_ps(kExpHi));
+  x = _mm256_max_ps(x, _mm256_set1_ps(kExpLo));
+
+  // fx = floor(x * log2(e) + 0.5)
+  __m256 fx = _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(kLog2e)),
+                            _mm256_set1_ps(0.5f));
+  fx = _mm256_floor_ps(fx);
+
+  x = _mm256_sub_ps(x, _mm256_mul_ps(fx, _mm256_set1_ps(kExpC1)));
+  x = _mm256_sub_ps(x, _mm256_mul_ps(fx, _mm256_set1_ps(kExpC2)));
+
+  __m256 z = _mm256_mul_ps(x, x);
+
+  __m256 y = _mm256_set1_ps(kExpP0);
+  y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(kExpP1));
+  y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(kExpP2));
+  y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(kExpP3));
+  y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(kExpP4));
+  y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(kExpP5));
+  y = _mm256_add_ps(_mm256_mul_ps(y, z), x);
+  y = _mm256_add_ps(y, one);
+
+  // 2^n
+  __m256i n = _mm256_cvttps_epi32(fx);
+  n = _mm256_add_epi32(n, _mm256_set1_epi32(0x7f));
+  n = _mm256_slli_epi32(n, 23);
+
+  return _mm256_mul_ps(y, _mm256_castsi256_ps(n));
+}
+
+inline float HorizontalMax(__m256 v) {
+  __m128 m = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+  m = _mm_max_ss(m, _mm_shuffle_ps(m, m, 1));
+  return _mm_cvtss_f32(m);
+}
+
+inline float HorizontalSum(__m256 v) {
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+  s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+  return _mm_cvtss_f32(s);
+}
+
+inline float Max(const float *p, int32_t n) {
+  int32_t i = 0;
+  float ans = p[0];
+  if (n >= kLanes) {
+    __m256 m = _mm256_loadu_ps(p);
+    for (i = kLanes; i + kLanes <= n; i += kLanes) {
+      m = _mm256_max_ps(m, _mm256_loadu_ps(p + i));
+    }
+    ans = HorizontalMax(m);
+  }
+
+  for (; i < n; ++i) {
+    ans = std::max(ans, p[i]);
+  }
+  return ans;
+}
+
+inline float SumExp(const float *p, int32_t n, float m) {
+  int32_t i = 0;
+  float ans = 0;
+  if (n >= kLanes) {
+    __m256 vm = _mm256_set1_ps(m);
+    __m256 s = _mm256_setzero_ps();
+    for (; i + kLanes <= n; i += kLanes) {
+      s = _mm256_add_ps(s, Exp(_mm256_sub_ps(_mm256_loadu_ps(p + i), vm)));
+    }
+    ans = HorizontalSum(s);
+  }
+
+  for (; i < n; ++i) {
+    ans += std::exp(p[i] - m);
+  }
+  return ans;
+}
+
+inline void Shift(float *p, int32_t n, float offset, float bias, float *q) {
+  int32_t i = 0;
+  __m256 vo = _mm256_set1_ps(offset);
+  __m256 vb = _mm256_set1_ps(bias);
+  for (; i + kLanes <= n; i += kLanes) {
+    __m256 x = _mm256_sub_ps(_mm256_loadu_ps(p + i), vo);
+    if (q) {
+      _mm256_storeu_ps(q + i, x);
+    }
+    _mm256_storeu_ps(p + i, _mm256_add_ps(x, vb));
+  }
+
+  for (; i < n; ++i) {
+    float x = p[i] - offset;
+    if (q) {
+      q[i] = x;
+    }
+    p[i] = x + bias;
+  }
+}
+
+#elif SHERPA_ONNX_LOG_SOFTMAX_SSE2
+
+constexpr int32_t kLanes = 4;
+
+inline __m128 Exp(__m128 x) {
+  const __m128 one = _mm_set1_ps(1.0f);
+
+  x = _mm_min_ps(x, _mm_set1_ps(kExpHi));
+  x = _mm_max_ps(x, _mm_set1_ps(kExpLo));
+
+  // fx = floor(x * log2(e) + 0.5). SSE2 has no floor, so truncate and
+  // subtract 1 where the truncated value is larger.
+  __m128 fx =
+      _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(kLog2e)), _mm_set1_ps(0.5f));
+  __m128 tmp = _mm_cvtepi32_ps(_mm_cvttps_epi32(fx));
+  __m128 mask = _mm_and_ps(_mm_cmpgt_ps(tmp, fx), one);
+  fx = _mm_sub_ps(tmp, mask);
+
+  x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(kExpC1)));
+  x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(kExpC2)));
+
+  __m128 z = _mm_mul_ps(x, x);
+
+  __m128 y = _mm_set1_ps(kExpP0);
+  y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kExpP1));
+  y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kExpP2));
+  y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kExpP3));
+  y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kExpP4));
+  y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kExpP5));
+  y = _mm_add_ps(_mm_mul_ps(y, z), x);
+  y = _mm_add_ps(y, one);
+
+  // 2^n
+  __m128i n = _mm_cvttps_epi32(fx);
+  n = _mm_add_epi32(n, _mm_set1_epi32(0x7f));
+  n = _mm_slli_epi32(n, 23);
+
+  return _mm_mul_ps(y, _mm_castsi128_ps(n));
+}
+
+inline float Max(const float *p, int32_t n) {
+  int32_t i = 0;
+  float ans = p[0];
+  if (n >= kLanes) {
+    __m128 m = _mm_loadu_ps(p);
+    for (i = kLanes; i + kLanes <= n; i += kLanes) {
+      m = _mm_max_ps(m, _mm_loadu_ps(p + i));
+    }
+    m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+    m = _mm_max_ss(m, _mm_shuffle_ps(m, m, 1));
+    ans = _mm_cvtss_f32(m);
+  }
+
+  for (; i < n; ++i) {
+    ans = std::max(ans, p[i]);
+  }
+  return ans;
+}
+
+inline float SumExp(const float *p, int32_t n, float m) {
+  int32_t i = 0;
+  float ans = 0;
+  if (n >= kLanes) {
+    __m128 vm = _mm_set1_ps(m);
+    __m128 s = _mm_setzero_ps();
+    for (; i + kLanes <= n; i += kLanes) {
+      s = _mm_add_ps(s, Exp(_mm_sub_ps(_mm_loadu_ps(p + i), vm)));
+    }
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    ans = _mm_cvtss_f32(s);
+  }
+
+  for (; i < n; ++i) {
+    ans += std::exp(p[i] - m);
+  }
+  return ans;
+}
+
+inline void Shift(float *p, int32_t n, float offset, float bias, float *q) {
+  int32_t i = 0;
+  __m128 vo = _mm_set1_ps(offset);
+  __m128 vb = _mm_set1_ps(bias);
+  for (; i + kLanes <= n; i += kLanes) {
+    __m128 x = _mm_sub_ps(_mm_loadu_ps(p + i), vo);
+    if (q) {
+      _mm_storeu_ps(q + i, x);
+    }
+    _mm_storeu_ps(p + i, _mm_add_ps(x, vb));
+  }
+
+  for (; i < n; ++i) {
+    float x = p[i] - offset;
+    if (q) {
+      q[i] = x;
+    }
+    p[i] = x + bias;
+  }
+}
+
+#else
+
+inline float Max(const float *p, int32_t n) { return *std::max_element(p, p + n); }
+
+inline float SumExp(const float *p, int32_t n, float m) {
+  float ans = 0;
+  for (int32_t i = 0; i != n; ++i) {
+    ans += std::exp(p[i] - m);
+  }
+  return ans;
+}
+
+inline void Shift(float *p, int32_t n, float offset, float bias, float *q) {
+  for (int32_t i = 0; i != n; ++i) {
+    float x = p[i] - offset;
+    if (q) {
+      q[i] = x;
+    }
+    p[i] = x + bias;
+  }
+}
+
+#endif
+
+}  // namespace
+
+void LogSoftmaxWithOffset(float *in, int32_t w, int32_t h,
+                          const float *offsets /*= nullptr*/,
+                          float *log_probs /*= nullptr*/) {
+  if (w <= 0) {
+    return;
+  }
+
+  // The three passes below run over a single row at a time, which stays in
+  // L1 cache for typical vocab sizes of keyword spotting models.
+  for (int32_t r = 0; r != h; ++r) {
+    float m = Max(in, w);
+    float offset = m + std::log(SumExp(in, w, m));
+    float bias = offsets ? offsets[r] : 0;
+
+    Shift(in, w, offset, bias, log_probs);
+
+    in += w;
+    if (log_probs) {
+      log_probs += w;
+    }
+  }
+}
+
+int32_t TopkIndex(const float *vec, int32_t n, int32_t k, int32_t *out) {
+  k = std::min(n, k);
+  if (k <= 0) {
+    return 0;
+  }
+
+  // A min-heap on values: out[0] is the index of the smallest of the k
+  // largest values seen so far.
+  auto greater = [vec](int32_t a, int32_t b) { return vec[a] > vec[b]; };
+
+  for (int32_t i = 0; i != k; ++i) {
+    out[i] = i;
+  }
+  std::make_heap(out, out + k, greater);
+
+  float threshold = vec[out[0]];
+  for (int32_t i = k; i < n; ++i) {
+    if (vec[i] <= threshold) {
+      continue;
+    }
+
+    std::pop_heap(out, out + k, greater);
+    out[k - 1] = i;
+    std::push_heap(out, out + k, greater);
+    threshold = vec[out[0]];
+  }
+
+  std::sort_heap(out, out + k, greater);
+
+  return k;
+}
+
+}  // namespace sherpa_onnx
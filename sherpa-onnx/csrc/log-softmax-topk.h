@@ -0,0 +1,49 @@
+// sherpa-onnx/csrc/log-softmax-topk.h
+//
+// Copyright (c)  2025  Xiaomi Corporation
+#ifndef SHERPA_ONNX_CSRC_LOG_SOFTMAX_TOPK_H_
+#define SHERPA_ONNX_CSRC_LOG_SOFTMAX_TOPK_H_
+
+#include <cstdint>
+
+namespace sherpa_onnx {
+
+/** Vectorized log-softmax for the beam search of transducer models.
+ *
+ * For each row r of the h x w matrix `in`, it computes in-place
+ *
+ *   in[r][i] = log_softmax(in[r])[i] + offsets[r]
+ *
+ * It uses NEON on ARM and AVX2/SSE2 on x86 if they are enabled at compile
+ * time, and falls back to scalar code otherwise.
+ *
+ * @param in  Pointer to a row-major matrix of shape (h, w).
+ * @param w  Number of columns, e.g., vocab size.
+ * @param h  Number of rows, e.g., number of hypotheses.
+ * @param offsets  Pointer to an array of size h. If it is nullptr, no offset
+ *                 is added and it is the same as LogSoftmax() in math.h.
+ * @param log_probs  If not nullptr, it is a matrix of shape (h, w) and
+ *                   receives log_softmax(in) without offsets.
+ */
+void LogSoftmaxWithOffset(float *in, int32_t w, int32_t h,
+                          const float *offsets = nullptr,
+                          float *log_probs = nullptr);
+
+/** Get the indexes of the k largest values of an array.
+ *
+ * Unlike TopkIndex() in math.h, it keeps a bounded min-heap of size k and
+ * does not allocate memory.
+ *
+ * @param vec  Pointer to an array of size n.
+ * @param n  Number of elements in vec.
+ * @param k  Number of indexes to get.
+ * @param out  Pointer to an array of size at least min(n, k). On return, it
+ *             contains the indexes sorted by their values in descending
+ *             order.
+ * @return Return min(n, k).
+ */
+int32_t TopkIndex(const float *vec, int32_t n, int32_t k, int32_t *out);
+
+}  // namespace sherpa_onnx
+
+#endif  // SHERPA_ONNX_CSRC_LOG_SOFTMAX_TOPK_H_
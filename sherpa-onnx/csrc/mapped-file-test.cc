@@ -0,0 +1,52 @@
+// sherpa-onnx/csrc/mapped-file-test.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/mapped-file.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "sherpa-onnx/csrc/file-utils.h"
+
+namespace sherpa_onnx {
+
+TEST(MappedFile, SameBytesAsReadFile) {
+  std::string filename = "mapped-file-test.bin";
+  {
+    std::ofstream os(filename, std::ios::binary);
+    for (int32_t i = 0; i != 100000; ++i) {
+      os.put(static_cast<char>(i * 7));
+    }
+  }
+
+  std::vector<char> expected = ReadFile(filename);
+  {
+    MappedFile file(filename);
+    ASSERT_TRUE(file.IsValid());
+    ASSERT_EQ(file.Size(), expected.size());
+    EXPECT_EQ(std::vector<char>(file.Data(), file.Data() + file.Size()),
+              expected);
+  }
+
+  std::remove(filename.c_str());
+}
+
+TEST(MappedFile, Invalid) {
+  MappedFile missing("mapped-file-test-does-not-exist.bin");
+  EXPECT_FALSE(missing.IsValid());
+  EXPECT_EQ(missing.Size(), 0);
+
+  std::string filename = "mapped-file-test-empty.bin";
+  std::ofstream(filename, std::ios::binary).close();
+
+  MappedFile empty(filename);
+  EXPECT_FALSE(empty.IsValid());
+
+  std::remove(filename.c_str());
+}
+
+}  // namespace sherpa_onnx
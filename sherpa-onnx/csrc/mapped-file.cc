@@ -0,0 +1,77 @@
+// sherpa-onnx/csrc/mapped-file.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/mapped-file.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <string>
+
+#include "sherpa-onnx/csrc/file-utils.h"
+
+namespace sherpa_onnx {
+
+#if !defined(_WIN32)
+
+MappedFile::MappedFile(const std::string &filename) {
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    close(fd);
+    return;
+  }
+
+  void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  // The mapping keeps the file open
+  close(fd);
+
+  if (p == MAP_FAILED) {
+    // e.g., a file system that does not support mmap
+    buffer_ = ReadFile(filename);
+    if (!buffer_.empty()) {
+      data_ = buffer_.data();
+      size_ = buffer_.size();
+    }
+    return;
+  }
+
+  // Models are parsed from the start to the end once
+  madvise(p, st.st_size, MADV_SEQUENTIAL);
+
+  data_ = static_cast<const char *>(p);
+  size_ = st.st_size;
+  mapped_ = true;
+}
+
+MappedFile::~MappedFile() {
+  if (mapped_) {
+    munmap(const_cast<char *>(data_), size_);
+  }
+}
+
+#else
+
+MappedFile::MappedFile(const std::string &filename)
+    : buffer_(ReadFile(filename)) {
+  if (!buffer_.empty()) {
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+  }
+}
+
+MappedFile::~MappedFile() = default;
+
+#endif
+
+}  // namespace sherpa_onnx
@@ -0,0 +1,50 @@
+// sherpa-onnx/csrc/mapped-file.h
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#ifndef SHERPA_ONNX_CSRC_MAPPED_FILE_H_
+#define SHERPA_ONNX_CSRC_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace sherpa_onnx {
+
+/** A read-only view of a whole file.
+ *
+ * Unlike ReadFile() from file-utils.h, the file is memory-mapped, so its
+ * pages are backed by the page cache rather than by a heap copy. They are
+ * loaded on demand and can be reclaimed by the kernel under memory
+ * pressure. The mapping is released in the destructor.
+ *
+ * On platforms without mmap(), the file is read into memory instead.
+ */
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string &filename);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  // Return false if the file cannot be opened or is empty
+  bool IsValid() const { return data_ != nullptr; }
+
+  const char *Data() const { return data_; }
+  size_t Size() const { return size_; }
+
+ private:
+  const char *data_ = nullptr;
+  size_t size_ = 0;
+
+  // true if data_ is from mmap()
+  bool mapped_ = false;
+
+  // Used when mmap() is not available
+  std::vector<char> buffer_;
+};
+
+}  // namespace sherpa_onnx
+
+#endif  // SHERPA_ONNX_CSRC_MAPPED_FILE_H_
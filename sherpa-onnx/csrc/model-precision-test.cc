@@ -0,0 +1,99 @@
+// sherpa-onnx/csrc/model-precision-test.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/model-precision.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace sherpa_onnx {
+
+// Write a fake model of the given size. If op is not empty, it contains a
+// node of that type, serialized as in an ONNX file.
+static void WriteModel(const std::string &filename, int32_t size,
+                       const std::string &op) {
+  std::ofstream os(filename, std::ios::binary);
+  std::string node;
+  if (!op.empty()) {
+    node = "\x22";
+    node += static_cast<char>(op.size());
+    node += op;
+  }
+
+  os << node;
+  for (int32_t i = node.size(); i < size; ++i) {
+    os.put(static_cast<char>(i * 7));
+  }
+}
+
+TEST(ModelPrecision, Filename) {
+  EXPECT_EQ(GetModelFilenameOfPrecision("a/encoder.onnx", ""),
+            "a/encoder.onnx");
+  EXPECT_EQ(GetModelFilenameOfPrecision("a/encoder.onnx", "int8"),
+            "a/encoder.int8.onnx");
+  EXPECT_EQ(GetModelFilenameOfPrecision("a/encoder.onnx", "fp16"),
+            "a/encoder.fp16.onnx");
+  EXPECT_EQ(GetModelFilenameOfPrecision("a/encoder.onnx", "fp32"),
+            "a/encoder.onnx");
+
+  EXPECT_EQ(GetModelFilenameOfPrecision("a/encoder.int8.onnx", "fp32"),
+            "a/encoder.onnx");
+  EXPECT_EQ(GetModelFilenameOfPrecision("a/encoder.fp16.onnx", "int8"),
+            "a/encoder.int8.onnx");
+  EXPECT_EQ(GetModelFilenameOfPrecision("a/encoder.int8.onnx", "int8"),
+            "a/encoder.int8.onnx");
+
+  // Only .onnx files have variants
+  EXPECT_EQ(GetModelFilenameOfPrecision("a/encoder.rknn", "int8"),
+            "a/encoder.rknn");
+}
+
+TEST(ModelPrecision, Valid) {
+  EXPECT_TRUE(IsValidModelPrecision(""));
+  EXPECT_TRUE(IsValidModelPrecision("fp32"));
+  EXPECT_TRUE(IsValidModelPrecision("int8"));
+  EXPECT_TRUE(IsValidModelPrecision("fp16"));
+  EXPECT_FALSE(IsValidModelPrecision("int4"));
+}
+
+TEST(ModelPrecision, Check) {
+  std::string fp32 = "model-precision-test.onnx";
+  std::string int8 = "model-precision-test.int8.onnx";
+  std::string fp16 = "model-precision-test.fp16.onnx";
+
+  WriteModel(fp32, 40000, "MatMul");
+  WriteModel(int8, 12000, "MatMulInteger");
+  WriteModel(fp16, 20000, "MatMul");
+
+  EXPECT_TRUE(CheckModelPrecision(fp32, "fp32"));
+  EXPECT_TRUE(CheckModelPrecision(int8, "int8"));
+  EXPECT_TRUE(CheckModelPrecision(fp16, "fp16"));
+  EXPECT_TRUE(CheckModelPrecision(fp32, ""));
+
+  // Wrong precision
+  EXPECT_FALSE(CheckModelPrecision(int8, "fp32"));
+  EXPECT_FALSE(CheckModelPrecision(fp32, "int8"));
+
+  // An fp32 model renamed to fp16
+  WriteModel(fp16, 40000, "MatMul");
+  EXPECT_FALSE(CheckModelPrecision(fp16, "fp16"));
+
+  // A quantized model that is not smaller
+  WriteModel(int8, 40000, "DynamicQuantizeLinear");
+  EXPECT_FALSE(CheckModelPrecision(int8, "int8"));
+
+  // Nothing to compare with
+  std::remove(fp32.c_str());
+  EXPECT_TRUE(CheckModelPrecision(int8, "int8"));
+
+  EXPECT_FALSE(CheckModelPrecision(fp32, "fp32"));
+
+  std::remove(int8.c_str());
+  std::remove(fp16.c_str());
+}
+
+}  // namespace sherpa_onnx
@@ -0,0 +1,172 @@
+// sherpa-onnx/csrc/model-precision.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/model-precision.h"
+
+#include <sys/stat.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "sherpa-onnx/csrc/macros.h"
+#include "sherpa-onnx/csrc/mapped-file.h"
+#include "sherpa-onnx/csrc/text-utils.h"
+
+namespace sherpa_onnx {
+
+// Operators that only quantized models contain
+static const char *kQuantizedOps[] = {
+    "ConvInteger",
+    "DequantizeLinear",
+    "DynamicQuantizeLinear",
+    "DynamicQuantizeLSTM",
+    "DynamicQuantizeMatMul",
+    "MatMulInteger",
+    "MatMulIntegerToFloat",
+    "QAttention",
+    "QLinearConv",
+    "QLinearMatMul",
+    "QuantizeLinear",
+};
+
+// @return Return -1 if the file does not exist
+static int64_t GetFileSize(const std::string &filename) {
+  struct stat st;
+  if (stat(filename.c_str(), &st) != 0) {
+    return -1;
+  }
+
+  return st.st_size;
+}
+
+// Look for the op_type of a node in the serialized ONNX model, i.e., field 4
+// of NodeProto, which is the tag 0x22 followed by the length of the name and
+// the name. The tag and length make it unlikely to match bytes of weights.
+static bool HasQuantizedOps(const MappedFile &file) {
+  std::string_view data(file.Data(), file.Size());
+
+  for (const char *op : kQuantizedOps) {
+    std::string pattern = "\x22";
+    pattern += static_cast<char>(strlen(op));
+    pattern += op;
+
+    if (data.find(pattern) != std::string_view::npos) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool IsValidModelPrecision(const std::string &precision) {
+  return precision.empty() || precision == "fp32" || precision == "int8" ||
+         precision == "fp16";
+}
+
+std::string GetModelFilenameOfPrecision(const std::string &filename,
+                                        const std::string &precision) {
+  if (precision.empty() || !EndsWith(filename, ".onnx")) {
+    return filename;
+  }
+
+  std::string stem = filename.substr(0, filename.size() - 5);
+  if (EndsWith(stem, ".int8") || EndsWith(stem, ".fp16") ||
+      EndsWith(stem, ".fp32")) {
+    stem.resize(stem.size() - 5);
+  }
+
+  if (precision == "fp32") {
+    return stem + ".onnx";
+  }
+
+  return stem + "." + precision + ".onnx";
+}
+
+OnlineTransducerModelConfig GetModelConfigOfPrecision(
+    const OnlineTransducerModelConfig &config, const std::string &precision) {
+  OnlineTransducerModelConfig ans = config;
+  ans.encoder = GetModelFilenameOfPrecision(config.encoder, precision);
+  ans.decoder = GetModelFilenameOfPrecision(config.decoder, precision);
+  ans.joiner = GetModelFilenameOfPrecision(config.joiner, precision);
+
+  return ans;
+}
+
+OnlineModelConfig ApplyModelPrecision(const OnlineModelConfig &config) {
+  OnlineModelConfig ans = config;
+  ans.transducer =
+      GetModelConfigOfPrecision(config.transducer, config.precision);
+  ans.precision.clear();
+
+  return ans;
+}
+
+bool CheckModelPrecision(const std::string &filename,
+                         const std::string &precision) {
+  if (precision.empty()) {
+    return true;
+  }
+
+  MappedFile file(filename);
+  if (!file.IsValid()) {
+    SHERPA_ONNX_LOGE("Failed to read model file '%s'", filename.c_str());
+    return false;
+  }
+
+  bool quantized = HasQuantizedOps(file);
+
+  if (precision == "int8" && !quantized) {
+    SHERPA_ONNX_LOGE(
+        "--model-precision is int8, but '%s' has no quantized operators. Is "
+        "it a float model?",
+        filename.c_str());
+    return false;
+  }
+
+  if (precision != "int8" && quantized) {
+    SHERPA_ONNX_LOGE("--model-precision is %s, but '%s' is quantized",
+                     precision.c_str(), filename.c_str());
+    return false;
+  }
+
+  if (precision == "fp32") {
+    return true;
+  }
+
+  std::string fp32_filename = GetModelFilenameOfPrecision(filename, "fp32");
+  int64_t fp32_size = GetFileSize(fp32_filename);
+  if (fp32_filename == filename || fp32_size < 0) {
+    // There is nothing to compare with
+    return true;
+  }
+
+  int64_t size = static_cast<int64_t>(file.Size());
+  if (size * 4 >= fp32_size * 3) {
+    SHERPA_ONNX_LOGE(
+        "'%s' (%.2f MB) is not much smaller than the fp32 model '%s' (%.2f "
+        "MB). Is it really %s?",
+        filename.c_str(), size / 1024. / 1024., fp32_filename.c_str(),
+        fp32_size / 1024. / 1024., precision.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+void LogModelFootprint(const OnlineTransducerModelConfig &config,
+                       const std::string &precision) {
+  float encoder = GetFileSize(config.encoder) / 1024.f / 1024.f;
+  float decoder = GetFileSize(config.decoder) / 1024.f / 1024.f;
+  float joiner = GetFileSize(config.joiner) / 1024.f / 1024.f;
+
+  SHERPA_ONNX_LOGE(
+      "Model precision %s. Expected memory of the weights: encoder %.2f MB, "
+      "decoder %.2f MB, joiner %.2f MB, total %.2f MB",
+      precision.empty() ? "as given" : precision.c_str(), encoder, decoder,
+      joiner, encoder + decoder + joiner);
+}
+
+}  // namespace sherpa_onnx
@@ -0,0 +1,66 @@
+// sherpa-onnx/csrc/model-precision.h
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#ifndef SHERPA_ONNX_CSRC_MODEL_PRECISION_H_
+#define SHERPA_ONNX_CSRC_MODEL_PRECISION_H_
+
+#include <string>
+
+#include "sherpa-onnx/csrc/online-model-config.h"
+#include "sherpa-onnx/csrc/online-transducer-model-config.h"
+
+namespace sherpa_onnx {
+
+// Precision of the weights of a model. As in the pre-trained models of
+// sherpa-onnx, the files of a model are named like
+//
+//   fp32: encoder.onnx
+//   int8: encoder.int8.onnx
+//   fp16: encoder.fp16.onnx
+//
+// An empty precision means to use the given files as they are.
+bool IsValidModelPrecision(const std::string &precision);
+
+/** Get the file of the given precision next to the given model file.
+ *
+ * For instance, with int8, both encoder.onnx and encoder.fp16.onnx give
+ * encoder.int8.onnx.
+ *
+ * @return Return filename unchanged if precision is empty or if filename
+ *         does not end with .onnx.
+ */
+std::string GetModelFilenameOfPrecision(const std::string &filename,
+                                        const std::string &precision);
+
+// Return a copy of config with the encoder, decoder and joiner of the given
+// precision
+OnlineTransducerModelConfig GetModelConfigOfPrecision(
+    const OnlineTransducerModelConfig &config, const std::string &precision);
+
+// Return a copy of config that loads the transducer files of
+// config.precision as they are, i.e., with an empty precision
+OnlineModelConfig ApplyModelPrecision(const OnlineModelConfig &config);
+
+/** Check that a model file has the given precision.
+ *
+ * ONNX files do not record how they were quantized, so it checks that
+ *  - an int8 model contains quantized operators, e.g., MatMulInteger from
+ *    dynamic quantization, and an fp32 model does not
+ *  - an int8 or fp16 model is smaller than 3/4 of the fp32 model next to it,
+ *    if there is one, which catches an fp32 model copied or renamed by
+ *    mistake
+ *
+ * @return Return false if the file cannot be read or does not match.
+ */
+bool CheckModelPrecision(const std::string &filename,
+                         const std::string &precision);
+
+// Log the size of the model files, which is about the memory their weights
+// take after loading
+void LogModelFootprint(const OnlineTransducerModelConfig &config,
+                       const std::string &precision);
+
+}  // namespace sherpa_onnx
+
+#endif  // SHERPA_ONNX_CSRC_MODEL_PRECISION_H_
@@ -12,6 +12,7 @@
 #include "onnxruntime_cxx_api.h"  // NOLINT
 #include "sherpa-onnx/csrc/online-model-config.h"
 #include "sherpa-onnx/csrc/online-transducer-model.h"
+#include "sherpa-onnx/csrc/session-binding.h"
 
 namespace sherpa_onnx {
 
@@ -61,6 +62,11 @@ class OnlineLstmTransducerModel : public OnlineTransducerModel {
   std::unique_ptr<Ort::Session> decoder_sess_;
   std::unique_ptr<Ort::Session> joiner_sess_;
 
+  // Outputs of the joiner are reused across calls, see RunJoiner()
+  std::unique_ptr<SessionBinding> encoder_binding_;
+  std::unique_ptr<SessionBinding> decoder_binding_;
+  std::unique_ptr<SessionBinding> joiner_binding_;
+
   std::vector<std::string> encoder_input_names_;
   std::vector<const char *> encoder_input_names_ptr_;
 
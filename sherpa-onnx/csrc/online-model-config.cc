@@ -7,6 +7,7 @@
 
 #include "sherpa-onnx/csrc/file-utils.h"
 #include "sherpa-onnx/csrc/macros.h"
+#include "sherpa-onnx/csrc/model-precision.h"
 #include "sherpa-onnx/csrc/text-utils.h"
 
 namespace sherpa_onnx {
@@ -49,6 +50,12 @@ void OnlineModelConfig::Register(ParseOptions *po) {
                "Valid values are: conformer, lstm, zipformer, zipformer2, "
                "wenet_ctc, nemo_ctc. "
                "All other values lead to loading the model twice.");
+
+  po->Register("model-precision", &precision,
+               "Precision of the transducer model files to load: fp32, int8 "
+               "or fp16. For instance, int8 loads encoder.int8.onnx given "
+               "--encoder=encoder.onnx. The files are checked to match it. "
+               "Leave it empty to load the given files as they are.");
 }
 
 bool OnlineModelConfig::Validate() const {
@@ -109,6 +116,18 @@ bool OnlineModelConfig::Validate() const {
     }
   }
 
+  if (!IsValidModelPrecision(precision)) {
+    SHERPA_ONNX_LOGE(
+        "Invalid --model-precision '%s'. Valid values are: fp32, int8, fp16",
+        precision.c_str());
+    return false;
+  }
+
+  if (!precision.empty() && transducer.encoder.empty()) {
+    SHERPA_ONNX_LOGE("--model-precision supports only transducer models");
+    return false;
+  }
+
   if (!tokens_buf.empty() && FileExists(tokens)) {
     SHERPA_ONNX_LOGE(
         "you can not provide a tokens_buf and a tokens file: '%s', "
@@ -153,6 +172,15 @@ bool OnlineModelConfig::Validate() const {
     return false;
   }
 
+  if (!precision.empty()) {
+    OnlineTransducerModelConfig t =
+        GetModelConfigOfPrecision(transducer, precision);
+
+    return t.Validate() && CheckModelPrecision(t.encoder, precision) &&
+           CheckModelPrecision(t.decoder, precision) &&
+           CheckModelPrecision(t.joiner, precision);
+  }
+
   return transducer.Validate();
 }
 
@@ -172,7 +200,8 @@ std::string OnlineModelConfig::ToString() const {
   os << "debug=" << (debug ? "True" : "False") << ", ";
   os << "model_type=\"" << model_type << "\", ";
   os << "modeling_unit=\"" << modeling_unit << "\", ";
-  os << "bpe_vocab=\"" << bpe_vocab << "\")";
+  os << "bpe_vocab=\"" << bpe_vocab << "\", ";
+  os << "precision=\"" << precision << "\")";
 
   return os.str();
 }
@@ -45,6 +45,16 @@ struct OnlineModelConfig {
   std::string modeling_unit = "cjkchar";
   std::string bpe_vocab;
 
+  // Precision of the transducer files to load. Valid values:
+  //  - "" (default), load the given files
+  //  - fp32, e.g., encoder.onnx
+  //  - int8, e.g., encoder.int8.onnx
+  //  - fp16, e.g., encoder.fp16.onnx
+  //
+  // The files of the precision are looked up next to the given ones and
+  // checked at load time. See model-precision.h
+  std::string precision;
+
   /// if tokens_buf is non-empty,
   /// the tokens will be loaded from the buffer instead of from the
   /// "tokens" file
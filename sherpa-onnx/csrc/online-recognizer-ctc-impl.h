@@ -28,7 +28,7 @@ OnlineRecognizerResult ConvertCtc(const OnlineCtcDecoderResult &src,
                                   const SymbolTable &sym_table,
                                   float frame_shift_ms,
                                   int32_t subsampling_factor, int32_t segment,
-                                  int32_t frames_since_start) {
+                                  int64_t frames_since_start) {
   OnlineRecognizerResult r;
   r.tokens.reserve(src.tokens.size());
   r.timestamps.reserve(src.tokens.size());
@@ -144,16 +144,14 @@ class OnlineRecognizerCtcImpl : public OnlineRecognizerImpl {
     std::vector<int64_t> all_processed_frames(n);
 
     for (int32_t i = 0; i != n; ++i) {
+      // Frames are written directly into the batch slot of the model input
       const auto num_processed_frames = ss[i]->GetNumProcessedFrames();
-      std::vector<float> features =
-          ss[i]->GetFrames(num_processed_frames, chunk_length);
+      ss[i]->GetFrames(num_processed_frames, chunk_length,
+                       features_vec.data() + i * chunk_length * feat_dim);
 
       // Question: should num_processed_frames include chunk_shift?
       ss[i]->GetNumProcessedFrames() += chunk_shift;
 
-      std::copy(features.begin(), features.end(),
-                features_vec.data() + i * chunk_length * feat_dim);
-
       results[i] = std::move(ss[i]->GetCtcResult());
       states_vec[i] = std::move(ss[i]->GetStates());
       all_processed_frames[i] = num_processed_frames;
@@ -285,8 +283,8 @@ class OnlineRecognizerCtcImpl : public OnlineRecognizerImpl {
     int32_t feat_dim = s->FeatureDim();
 
     const auto num_processed_frames = s->GetNumProcessedFrames();
-    std::vector<float> frames =
-        s->GetFrames(num_processed_frames, chunk_length);
+    std::vector<float> frames(chunk_length * feat_dim);
+    s->GetFrames(num_processed_frames, chunk_length, frames.data());
     s->GetNumProcessedFrames() += chunk_shift;
 
     auto memory_info =
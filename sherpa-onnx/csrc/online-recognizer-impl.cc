@@ -19,6 +19,7 @@
 #include "fst/extensions/far/far.h"
 #include "kaldifst/csrc/kaldi-fst-io.h"
 #include "sherpa-onnx/csrc/macros.h"
+#include "sherpa-onnx/csrc/model-precision.h"
 #include "sherpa-onnx/csrc/online-recognizer-ctc-impl.h"
 #include "sherpa-onnx/csrc/online-recognizer-paraformer-impl.h"
 #include "sherpa-onnx/csrc/online-recognizer-transducer-impl.h"
@@ -35,6 +36,13 @@ namespace sherpa_onnx {
 
 std::unique_ptr<OnlineRecognizerImpl> OnlineRecognizerImpl::Create(
     const OnlineRecognizerConfig &config) {
+  if (!config.model_config.precision.empty()) {
+    OnlineRecognizerConfig c = config;
+    c.model_config = ApplyModelPrecision(config.model_config);
+    LogModelFootprint(c.model_config.transducer, config.model_config.precision);
+    return Create(c);
+  }
+
   if (config.model_config.provider_config.provider == "rknn") {
 #if SHERPA_ONNX_ENABLE_RKNN
     // Currently, only zipformer v1 is suported for rknn
@@ -94,6 +102,12 @@ std::unique_ptr<OnlineRecognizerImpl> OnlineRecognizerImpl::Create(
 template <typename Manager>
 std::unique_ptr<OnlineRecognizerImpl> OnlineRecognizerImpl::Create(
     Manager *mgr, const OnlineRecognizerConfig &config) {
+  if (!config.model_config.precision.empty()) {
+    OnlineRecognizerConfig c = config;
+    c.model_config = ApplyModelPrecision(config.model_config);
+    return Create(mgr, c);
+  }
+
   if (config.model_config.provider_config.provider == "rknn") {
 #if SHERPA_ONNX_ENABLE_RKNN
     // Currently, only zipformer v1 is suported for rknn
@@ -33,7 +33,7 @@ namespace sherpa_onnx {
 OnlineRecognizerResult Convert(const OnlineTransducerDecoderResult &src,
                                const SymbolTable &sym_table,
                                float frame_shift_ms, int32_t subsampling_factor,
-                               int32_t segment, int32_t frames_since_start) {
+                               int32_t segment, int64_t frames_since_start) {
   OnlineRecognizerResult r;
   r.tokens.reserve(src.tokens.size());
   r.timestamps.reserve(src.tokens.size());
@@ -288,16 +288,14 @@ class OnlineRecognizerTransducerImpl : public OnlineRecognizerImpl {
         has_context_graph = true;
       }
 
+      // Frames are written directly into the batch slot of the encoder input
       const auto num_processed_frames = ss[i]->GetNumProcessedFrames();
-      std::vector<float> features =
-          ss[i]->GetFrames(num_processed_frames, chunk_size);
+      ss[i]->GetFrames(num_processed_frames, chunk_size,
+                       features_vec.data() + i * chunk_size * feature_dim);
 
       // Question: should num_processed_frames include chunk_shift?
       ss[i]->GetNumProcessedFrames() += chunk_shift;
 
-      std::copy(features.begin(), features.end(),
-                features_vec.data() + i * chunk_size * feature_dim);
-
       results[i] = std::move(ss[i]->GetResult());
       states_vec[i] = std::move(ss[i]->GetStates());
       all_processed_frames[i] = num_processed_frames;
@@ -31,7 +31,7 @@ namespace sherpa_onnx {
 OnlineRecognizerResult Convert(const OnlineTransducerDecoderResult &src,
                                const SymbolTable &sym_table,
                                float frame_shift_ms, int32_t subsampling_factor,
-                               int32_t segment, int32_t frames_since_start);
+                               int32_t segment, int64_t frames_since_start);
 
 class OnlineRecognizerTransducerNeMoImpl : public OnlineRecognizerImpl {
  public:
@@ -152,16 +152,14 @@ class OnlineRecognizerTransducerNeMoImpl : public OnlineRecognizerImpl {
     std::vector<std::vector<Ort::Value>> encoder_states(n);
 
     for (int32_t i = 0; i != n; ++i) {
+      // Frames are written directly into the batch slot of the encoder input
       const auto num_processed_frames = ss[i]->GetNumProcessedFrames();
-      std::vector<float> features =
-          ss[i]->GetFrames(num_processed_frames, chunk_size);
+      ss[i]->GetFrames(num_processed_frames, chunk_size,
+                       features_vec.data() + i * chunk_size * feature_dim);
 
       // Question: should num_processed_frames include chunk_shift?
       ss[i]->GetNumProcessedFrames() += chunk_shift;
 
-      std::copy(features.begin(), features.end(),
-                features_vec.data() + i * chunk_size * feature_dim);
-
       encoder_states[i] = std::move(ss[i]->GetStates());
     }
 
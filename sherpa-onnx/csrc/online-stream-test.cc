@@ -0,0 +1,387 @@
+// sherpa-onnx/csrc/online-stream-test.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/online-stream.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "sherpa-onnx/csrc/cat.h"
+#include "sherpa-onnx/csrc/keyword-spotter-transducer-impl.h"
+#include "sherpa-onnx/csrc/onnx-utils.h"
+#include "sherpa-onnx/csrc/transducer-keyword-decoder.h"
+#include "sherpa-onnx/csrc/unbind.h"
+
+// Count heap allocations made while g_count_allocations is true.
+static std::atomic<bool> g_count_allocations{false};
+static std::atomic<int64_t> g_num_allocations{0};
+
+void *operator new(std::size_t size) {
+  if (g_count_allocations.load(std::memory_order_relaxed)) {
+    g_num_allocations.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void *p = std::malloc(size == 0 ? 1 : size);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+namespace sherpa_onnx {
+
+class AllocationCounter {
+ public:
+  AllocationCounter() {
+    g_num_allocations = 0;
+    g_count_allocations = true;
+  }
+
+  ~AllocationCounter() { g_count_allocations = false; }
+
+  int64_t Get() const { return g_num_allocations.load(); }
+};
+
+static std::vector<float> GenerateWave(int32_t n) {
+  std::vector<float> samples(n);
+  for (int32_t i = 0; i != n; ++i) {
+    samples[i] = 0.1 * std::sin(2 * M_PI * 440 * i / 16000.0);
+  }
+  return samples;
+}
+
+TEST(OnlineStream, GetFramesToBuffer) {
+  OnlineStream s;
+  auto samples = GenerateWave(16000);
+  s.AcceptWaveform(16000, samples.data(), samples.size());
+
+  int32_t n = 10;
+  int32_t feature_dim = s.FeatureDim();
+  std::vector<float> expected = s.GetFrames(5, n);
+
+  std::vector<float> out(n * feature_dim);
+  s.GetFrames(5, n, out.data());
+
+  EXPECT_EQ(expected, out);
+}
+
+TEST(OnlineStream, SingleThreadedFeatureExtractor) {
+  FeatureExtractorConfig config;
+  config.single_threaded = true;
+
+  OnlineStream s(config);
+  OnlineStream expected_s;
+
+  auto samples = GenerateWave(16000);
+  for (int32_t i = 0; i < 16000; i += 1600) {
+    s.AcceptWaveform(16000, samples.data() + i, 1600);
+    expected_s.AcceptWaveform(16000, samples.data() + i, 1600);
+  }
+
+  ASSERT_EQ(s.NumFramesReady(), expected_s.NumFramesReady());
+  EXPECT_EQ(s.GetFrames(0, s.NumFramesReady()),
+            expected_s.GetFrames(0, expected_s.NumFramesReady()));
+}
+
+// Frames of a stream that is reset from time to time, as the keyword
+// spotter does, are the same as those of a stream that is never reset.
+TEST(OnlineStream, FramesAfterReset) {
+  OnlineStream s;
+  OnlineStream expected_s;
+
+  auto samples = GenerateWave(5 * 16000);
+  int32_t chunk_size = 45;
+  int32_t chunk_shift = 32;
+  int32_t feature_dim = s.FeatureDim();
+  std::vector<float> features(chunk_size * feature_dim);
+  std::vector<float> expected(chunk_size * feature_dim);
+
+  for (int32_t k = 0, i = 0; i < 5 * 16000; i += 1600) {
+    s.AcceptWaveform(16000, samples.data() + i, 1600);
+    expected_s.AcceptWaveform(16000, samples.data() + i, 1600);
+
+    while (s.GetNumProcessedFrames() + chunk_size < s.NumFramesReady()) {
+      int32_t &num_processed_frames = s.GetNumProcessedFrames();
+      int64_t frame = s.GetNumFramesSinceStart() + num_processed_frames;
+
+      s.GetFrames(num_processed_frames, chunk_size, features.data());
+      expected_s.GetFrames(static_cast<int32_t>(frame), chunk_size,
+                           expected.data());
+      ASSERT_EQ(features, expected) << frame;
+
+      num_processed_frames += chunk_shift;
+      if (++k % 4 == 0) {
+        s.Reset();
+      }
+    }
+  }
+
+  EXPECT_GT(s.GetNumFramesSinceStart(), 0);
+
+  s.InputFinished();
+  EXPECT_TRUE(s.IsLastFrame(s.NumFramesReady() - 1));
+}
+
+// Feed a stream for a while with a low max_extractor_frames, so that the
+// frame indexes of its extractor restart many times, as they would every
+// 2^30 frames of a stream that runs for months. Frames and frame numbers
+// must continue across the restarts as if there were none.
+static void CheckFramesAcrossRestarts(FeatureExtractorConfig config) {
+  OnlineStream expected_s(config);
+
+  config.max_extractor_frames = 100;
+  OnlineStream s(config);
+
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> dist(-0.5, 0.5);
+  std::uniform_int_distribution<int32_t> chunk_dist(1, 3200);
+
+  std::vector<float> samples(60 * 16000);
+  for (auto &x : samples) {
+    x = dist(gen);
+  }
+
+  int32_t chunk_size = 45;
+  int32_t chunk_shift = 32;
+  int32_t feature_dim = s.FeatureDim();
+  std::vector<float> features(chunk_size * feature_dim);
+  std::vector<float> expected(chunk_size * feature_dim);
+
+  int64_t num_read_frames = 0;
+  size_t start = 0;
+  for (int32_t k = 0; start < samples.size();) {
+    int32_t n = std::min<int32_t>(chunk_dist(gen), samples.size() - start);
+    s.AcceptWaveform(16000, samples.data() + start, n);
+    expected_s.AcceptWaveform(16000, samples.data() + start, n);
+    start += n;
+
+    ASSERT_EQ(s.GetNumFramesSinceStart() + s.NumFramesReady(),
+              expected_s.NumFramesReady());
+
+    while (s.GetNumProcessedFrames() + chunk_size < s.NumFramesReady()) {
+      int32_t &num_processed_frames = s.GetNumProcessedFrames();
+      int64_t frame = s.GetNumFramesSinceStart() + num_processed_frames;
+      ASSERT_EQ(frame, num_read_frames);
+
+      s.GetFrames(num_processed_frames, chunk_size, features.data());
+      expected_s.GetFrames(static_cast<int32_t>(frame), chunk_size,
+                           expected.data());
+      ASSERT_EQ(features, expected) << frame;
+
+      num_processed_frames += chunk_shift;
+      num_read_frames += chunk_shift;
+      if (++k % 4 == 0) {
+        s.Reset();
+      }
+    }
+  }
+
+  // 6000 frames, i.e., about 60 restarts
+  EXPECT_GT(num_read_frames, 50 * config.max_extractor_frames);
+
+  s.InputFinished();
+  expected_s.InputFinished();
+  ASSERT_EQ(s.GetNumFramesSinceStart() + s.NumFramesReady(),
+            expected_s.NumFramesReady());
+  EXPECT_TRUE(s.IsLastFrame(s.NumFramesReady() - 1));
+}
+
+TEST(OnlineStream, FramesAcrossFrameIndexRestarts) {
+  FeatureExtractorConfig config;
+  CheckFramesAcrossRestarts(config);
+}
+
+TEST(OnlineStream, FramesAcrossFrameIndexRestartsMfcc) {
+  FeatureExtractorConfig config;
+  config.is_mfcc = true;
+  CheckFramesAcrossRestarts(config);
+}
+
+// A transducer model whose joiner always prefers blank
+class FakeTransducerModel : public OnlineTransducerModel {
+ public:
+  std::vector<Ort::Value> StackStates(
+      const std::vector<std::vector<Ort::Value>> &states) const override {
+    std::vector<const Ort::Value *> v;
+    for (const auto &s : states) {
+      v.push_back(&s[0]);
+    }
+
+    std::vector<Ort::Value> ans;
+    ans.push_back(Cat(allocator_, v, 0));
+    return ans;
+  }
+
+  std::vector<std::vector<Ort::Value>> UnStackStates(
+      const std::vector<Ort::Value> &states) const override {
+    std::vector<std::vector<Ort::Value>> ans;
+    for (auto &v : Unbind(allocator_, &states[0], 0)) {
+      ans.emplace_back();
+      ans.back().push_back(std::move(v));
+    }
+    return ans;
+  }
+
+  std::vector<Ort::Value> GetEncoderInitStates() override {
+    std::array<int64_t, 2> shape{1, kDim};
+    Ort::Value s = Ort::Value::CreateTensor<float>(allocator_, shape.data(),
+                                                   shape.size());
+    Fill<float>(&s, 0);
+
+    std::vector<Ort::Value> ans;
+    ans.push_back(std::move(s));
+    return ans;
+  }
+
+  std::pair<Ort::Value, std::vector<Ort::Value>> RunEncoder(
+      Ort::Value features, std::vector<Ort::Value> states,
+      Ort::Value /*processed_frames*/) override {
+    int64_t batch_size = features.GetTensorTypeAndShapeInfo().GetShape()[0];
+    std::array<int64_t, 3> shape{batch_size, ChunkShift() / 4, kDim};
+    Ort::Value encoder_out = Ort::Value::CreateTensor<float>(
+        allocator_, shape.data(), shape.size());
+    Fill<float>(&encoder_out, 0);
+
+    return {std::move(encoder_out), std::move(states)};
+  }
+
+  Ort::Value RunDecoder(Ort::Value decoder_input) override {
+    int64_t n = decoder_input.GetTensorTypeAndShapeInfo().GetShape()[0];
+    std::array<int64_t, 2> shape{n, kDim};
+    Ort::Value decoder_out = Ort::Value::CreateTensor<float>(
+        allocator_, shape.data(), shape.size());
+    Fill<float>(&decoder_out, 0);
+    return decoder_out;
+  }
+
+  Ort::Value RunJoiner(Ort::Value encoder_out,
+                       Ort::Value /*decoder_out*/) override {
+    int64_t n = encoder_out.GetTensorTypeAndShapeInfo().GetShape()[0];
+    std::array<int64_t, 2> shape{n, kVocabSize};
+    Ort::Value logit = Ort::Value::CreateTensor<float>(
+        allocator_, shape.data(), shape.size());
+    float *p = logit.GetTensorMutableData<float>();
+    for (int64_t i = 0; i != n; ++i, p += kVocabSize) {
+      std::fill(p, p + kVocabSize, 0);
+      p[0] = 5;
+    }
+    return logit;
+  }
+
+  int32_t ContextSize() const override { return 2; }
+
+  int32_t ChunkSize() const override { return 45; }
+
+  int32_t ChunkShift() const override { return 32; }
+
+  int32_t VocabSize() const override { return kVocabSize; }
+
+  OrtAllocator *Allocator() override { return allocator_; }
+
+ private:
+  static constexpr int32_t kDim = 4;
+  static constexpr int32_t kVocabSize = 4;
+
+  mutable Ort::AllocatorWithDefaultOptions allocator_;
+};
+
+static KeywordSpotterConfig GetFakeKeywordSpotterConfig() {
+  KeywordSpotterConfig config;
+  config.model_config.tokens_buf = "<blk> 0\na 1\nb 2\nc 3\n";
+  config.keywords_buf = "a b c";
+  return config;
+}
+
+// DecodeStreams() must not copy the keyword result, or anything else that
+// grows with a stream, on each chunk. It still allocates, e.g., for the
+// encoder output, the stacked states and the search, but the same for two
+// streams with the same audio. So a stream with a large keyword result must
+// cost no allocation more than one with an empty result.
+TEST(OnlineStream, DecodeStreamsDoesNotCopyKeywordResult) {
+  KeywordSpotterTransducerImpl kws(GetFakeKeywordSpotterConfig(),
+                                   std::make_unique<FakeTransducerModel>());
+
+  auto small = kws.CreateStream();
+  auto large = kws.CreateStream();
+
+  auto samples = GenerateWave(5 * 16000);
+  small->AcceptWaveform(16000, samples.data(), samples.size());
+  large->AcceptWaveform(16000, samples.data(), samples.size());
+
+  auto decode = [&kws](OnlineStream *s) {
+    AllocationCounter counter;
+    kws.DecodeStreams(&s, 1);
+    return counter.Get();
+  };
+
+  auto fill = [](OnlineStream *s) {
+    TransducerKeywordResult &r = s->GetKeywordResult();
+    r.tokens.assign(1000, 1);
+    r.keyword.assign(1000, 'a');
+  };
+
+  // warm up
+  for (int32_t i = 0; i != 2; ++i) {
+    fill(large.get());
+    decode(small.get());
+    decode(large.get());
+  }
+
+  int32_t num_chunks = 0;
+  while (kws.IsReady(small.get())) {
+    ASSERT_TRUE(kws.IsReady(large.get()));
+
+    // A stream is reset after enough trailing blanks, which drops the
+    // tokens, so fill them before each chunk
+    fill(large.get());
+
+    int64_t expected = decode(small.get());
+    EXPECT_EQ(decode(large.get()), expected) << num_chunks;
+    ++num_chunks;
+  }
+
+  EXPECT_GT(num_chunks, 0);
+}
+
+// Frames dropped by SkipFrames() count towards keyword timestamps like
+// decoded ones, and the next chunk is decoded from the initial states.
+TEST(OnlineStream, SkipFramesThenDecode) {
+  KeywordSpotterTransducerImpl kws(GetFakeKeywordSpotterConfig(),
+                                   std::make_unique<FakeTransducerModel>());
+
+  auto s = kws.CreateStream();
+  auto samples = GenerateWave(3 * 16000);
+  s->AcceptWaveform(16000, samples.data(), 2 * 16000);
+
+  // Before anything is decoded, a chunk of 32 frames gives 32 / 4 output
+  // frames
+  int32_t num_chunks = kws.SkipFrames(s.get(), 0);
+  EXPECT_GT(num_chunks, 0);
+  EXPECT_TRUE(s->GetStates().empty());
+  EXPECT_EQ(s->GetKeywordResult().frame_offset, num_chunks * 8);
+
+  s->AcceptWaveform(16000, samples.data() + 2 * 16000, 16000);
+  ASSERT_TRUE(kws.IsReady(s.get()));
+
+  OnlineStream *p = s.get();
+  kws.DecodeStreams(&p, 1);
+
+  EXPECT_FALSE(s->GetStates().empty());
+  EXPECT_EQ(s->GetKeywordResult().frame_offset, num_chunks * 8 + 8);
+}
+
+}  // namespace sherpa_onnx
@@ -3,11 +3,13 @@
 // Copyright (c)  2023  Xiaomi Corporation
 #include "sherpa-onnx/csrc/online-stream.h"
 
+#include <algorithm>
 #include <memory>
 #include <utility>
 #include <vector>
 
 #include "sherpa-onnx/csrc/features.h"
+#include "sherpa-onnx/csrc/macros.h"
 #include "sherpa-onnx/csrc/transducer-keyword-decoder.h"
 
 namespace sherpa_onnx {
@@ -16,35 +18,78 @@ class OnlineStream::Impl {
  public:
   explicit Impl(const FeatureExtractorConfig &config,
                 ContextGraphPtr context_graph)
-      : feat_extractor_(config), context_graph_(std::move(context_graph)) {}
+      : feat_extractor_(config),
+        max_extractor_frames_(config.max_extractor_frames),
+        context_graph_(std::move(context_graph)) {
+    if (max_extractor_frames_ <= 0) {
+      SHERPA_ONNX_LOGE("max_extractor_frames should be positive. Given: %d",
+                       max_extractor_frames_);
+      exit(-1);
+    }
+  }
 
   void AcceptWaveform(int32_t sampling_rate, const float *waveform, int32_t n) {
     feat_extractor_.AcceptWaveform(sampling_rate, waveform, n);
+    MaybeRestartFrameIndex();
   }
 
-  void InputFinished() const { feat_extractor_.InputFinished(); }
+  void InputFinished() {
+    feat_extractor_.InputFinished();
+    input_finished_ = true;
+  }
 
   int32_t NumFramesReady() const {
-    return feat_extractor_.NumFramesReady() - start_frame_index_;
+    return static_cast<int32_t>(NumFramesSinceCreation() - start_frame_index_);
   }
 
   bool IsLastFrame(int32_t frame) const {
-    return feat_extractor_.IsLastFrame(frame);
+    return input_finished_ &&
+           start_frame_index_ + frame == NumFramesSinceCreation() - 1;
   }
 
-  std::vector<float> GetFrames(int32_t frame_index, int32_t n) const {
-    return feat_extractor_.GetFrames(frame_index + start_frame_index_, n);
+  std::vector<float> GetFrames(int32_t frame_index, int32_t n) {
+    std::vector<float> features(n * FeatureDim());
+    GetFrames(frame_index, n, features.data());
+    return features;
+  }
+
+  // Frames before frame_index are discarded
+  void GetFrames(int32_t frame_index, int32_t n, float *out) {
+    int64_t frame = start_frame_index_ + frame_index;
+    DiscardBefore(frame);
+
+    // Frames kept by the last restart of the extractor come first
+    if (frame < extractor_start_) {
+      int32_t dim = FeatureDim();
+      int32_t m =
+          static_cast<int32_t>(std::min<int64_t>(n, extractor_start_ - frame));
+      auto begin = kept_frames_.begin() + (frame - kept_start_) * dim;
+      std::copy(begin, begin + m * dim, out);
+
+      frame += m;
+      n -= m;
+      out += m * dim;
+    }
+
+    if (n > 0) {
+      feat_extractor_.GetFrames(static_cast<int32_t>(frame - extractor_start_),
+                                n, out);
+    }
   }
 
   void Reset() {
     // we don't reset the feature extractor
     start_frame_index_ += num_processed_frames_;
     num_processed_frames_ = 0;
+
+    // Frames before the new segment are never read again. Drop them here,
+    // since frames can be skipped without calling GetFrames().
+    DiscardBefore(start_frame_index_);
   }
 
   int32_t &GetNumProcessedFrames() { return num_processed_frames_; }
 
-  int32_t GetNumFramesSinceStart() const { return start_frame_index_; }
+  int64_t GetNumFramesSinceStart() const { return start_frame_index_; }
 
   int32_t &GetCurrentSegment() { return segment_; }
 
@@ -55,15 +100,22 @@ class OnlineStream::Impl {
   void SetKeywordResult(const TransducerKeywordResult &r) {
     keyword_result_ = r;
   }
+
+  void SetKeywordResult(TransducerKeywordResult &&r) {
+    keyword_result_ = std::move(r);
+  }
+
   TransducerKeywordResult &GetKeywordResult(bool remove_duplicates) {
     if (remove_duplicates) {
-      if (!prev_keyword_result_.timestamps.empty() &&
+      if (!prev_keyword_timestamps_.empty() &&
           !keyword_result_.timestamps.empty() &&
-          keyword_result_.timestamps[0] <=
-              prev_keyword_result_.timestamps.back()) {
+          keyword_result_.timestamps[0] <= prev_keyword_timestamps_.back()) {
         return empty_keyword_result_;
       } else {
-        prev_keyword_result_ = keyword_result_;
+        // Only the timestamps are needed. Copying the whole result, including
+        // its hypotheses, would allocate on every call.
+        prev_keyword_timestamps_.assign(keyword_result_.timestamps.begin(),
+                                        keyword_result_.timestamps.end());
       }
       return keyword_result_;
     } else {
@@ -99,6 +151,14 @@ class OnlineStream::Impl {
 
   const ContextGraphPtr &GetContextGraph() const { return context_graph_; }
 
+  void SetContextGraph(ContextGraphPtr context_graph,
+                       int32_t keywords_version) {
+    context_graph_ = std::move(context_graph);
+    keywords_version_ = keywords_version;
+  }
+
+  int32_t GetKeywordsVersion() const { return keywords_version_; }
+
   std::vector<float> &GetParaformerFeatCache() {
     return paraformer_feat_cache_;
   }
@@ -111,6 +171,8 @@ class OnlineStream::Impl {
     return paraformer_alpha_cache_;
   }
 
+  DecoderOutCache &GetDecoderOutCache() { return decoder_out_cache_; }
+
   void SetFasterDecoder(std::unique_ptr<kaldi_decoder::FasterDecoder> decoder) {
     faster_decoder_ = std::move(decoder);
   }
@@ -123,17 +185,89 @@ class OnlineStream::Impl {
     return faster_decoder_processed_frames_;
   }
 
+ private:
+  // Frame number of the next frame that the extractor will produce
+  int64_t NumFramesSinceCreation() const {
+    return extractor_start_ + feat_extractor_.NumFramesReady();
+  }
+
+  void DiscardBefore(int64_t frame) {
+    first_kept_frame_ = std::max(first_kept_frame_, frame);
+    if (frame < extractor_start_) {
+      return;
+    }
+
+    if (!kept_frames_.empty()) {
+      kept_frames_.clear();
+      kept_frames_.shrink_to_fit();
+    }
+
+    // GetFrames() of the extractor discards the frames before the given one
+    feat_extractor_.GetFrames(static_cast<int32_t>(frame - extractor_start_), 0,
+                              nullptr);
+  }
+
+  // Restart the frame indexes of the extractor before they overflow. The
+  // frames that may still be read are copied to kept_frames_ first. By
+  // default it happens about every 124 days, so frames are otherwise read
+  // straight from the extractor.
+  void MaybeRestartFrameIndex() {
+    int32_t num_frames = feat_extractor_.NumFramesReady();
+    if (num_frames < max_extractor_frames_ || !can_restart_ ||
+        !kept_frames_.empty()) {
+      return;
+    }
+
+    int64_t first = std::max(first_kept_frame_, extractor_start_);
+
+    int32_t dim = FeatureDim();
+    int32_t n = static_cast<int32_t>(extractor_start_ + num_frames - first);
+    kept_frames_.resize(static_cast<int64_t>(n) * dim);
+    feat_extractor_.GetFrames(static_cast<int32_t>(first - extractor_start_),
+                              n, kept_frames_.data());
+
+    if (!feat_extractor_.RestartFrameIndex()) {
+      // e.g., after InputFinished(). It will not work later either.
+      can_restart_ = false;
+      kept_frames_.clear();
+      return;
+    }
+
+    kept_start_ = first;
+    extractor_start_ += num_frames;
+  }
+
  private:
   FeatureExtractor feat_extractor_;
+  bool input_finished_ = false;
+
+  // See FeatureExtractorConfig::max_extractor_frames
+  int32_t max_extractor_frames_;
+
+  // Frame number of frame 0 of feat_extractor_. It grows each time the
+  // extractor restarts its frame indexes.
+  int64_t extractor_start_ = 0;
+
+  // Frames [kept_start_, extractor_start_), saved by the last restart of
+  // the extractor until they are discarded
+  std::vector<float> kept_frames_;
+  int64_t kept_start_ = 0;
+  bool can_restart_ = true;
+
+  // Frames before it have been discarded
+  int64_t first_kept_frame_ = 0;
+
   /// For contextual-biasing
   ContextGraphPtr context_graph_;
+  int32_t keywords_version_ = -1;
   int32_t num_processed_frames_ = 0;  // before subsampling
-  int32_t start_frame_index_ = 0;     // never reset
+  int64_t start_frame_index_ = 0;     // never reset
   int32_t segment_ = 0;
   OnlineTransducerDecoderResult result_;
-  TransducerKeywordResult prev_keyword_result_;
+  std::vector<int64_t> prev_keyword_timestamps_;
   TransducerKeywordResult keyword_result_;
   TransducerKeywordResult empty_keyword_result_;
+  DecoderOutCache decoder_out_cache_;
   OnlineCtcDecoderResult ctc_result_;
   std::vector<Ort::Value> states_;  // states for transducer or ctc models
   std::vector<Ort::Value> decoder_states_;  // states for nemo transducer models
@@ -169,6 +303,11 @@ std::vector<float> OnlineStream::GetFrames(int32_t frame_index,
   return impl_->GetFrames(frame_index, n);
 }
 
+void OnlineStream::GetFrames(int32_t frame_index, int32_t n,
+                             float *out) const {
+  impl_->GetFrames(frame_index, n, out);
+}
+
 void OnlineStream::Reset() { impl_->Reset(); }
 
 int32_t OnlineStream::FeatureDim() const { return impl_->FeatureDim(); }
@@ -177,7 +316,7 @@ int32_t &OnlineStream::GetNumProcessedFrames() {
   return impl_->GetNumProcessedFrames();
 }
 
-int32_t OnlineStream::GetNumFramesSinceStart() const {
+int64_t OnlineStream::GetNumFramesSinceStart() const {
   return impl_->GetNumFramesSinceStart();
 }
 
@@ -197,6 +336,10 @@ void OnlineStream::SetKeywordResult(const TransducerKeywordResult &r) {
   impl_->SetKeywordResult(r);
 }
 
+void OnlineStream::SetKeywordResult(TransducerKeywordResult &&r) {
+  impl_->SetKeywordResult(std::move(r));
+}
+
 TransducerKeywordResult &OnlineStream::GetKeywordResult(
     bool remove_duplicates /*=false*/) {
   return impl_->GetKeywordResult(remove_duplicates);
@@ -239,6 +382,19 @@ const ContextGraphPtr &OnlineStream::GetContextGraph() const {
   return impl_->GetContextGraph();
 }
 
+void OnlineStream::SetContextGraph(ContextGraphPtr context_graph,
+                                   int32_t keywords_version) {
+  impl_->SetContextGraph(std::move(context_graph), keywords_version);
+}
+
+int32_t OnlineStream::GetKeywordsVersion() const {
+  return impl_->GetKeywordsVersion();
+}
+
+DecoderOutCache &OnlineStream::GetDecoderOutCache() {
+  return impl_->GetDecoderOutCache();
+}
+
 void OnlineStream::SetFasterDecoder(
     std::unique_ptr<kaldi_decoder::FasterDecoder> decoder) {
   impl_->SetFasterDecoder(std::move(decoder));
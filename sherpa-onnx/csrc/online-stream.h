@@ -11,6 +11,7 @@
 #include "kaldi-decoder/csrc/faster-decoder.h"
 #include "onnxruntime_cxx_api.h"  // NOLINT
 #include "sherpa-onnx/csrc/context-graph.h"
+#include "sherpa-onnx/csrc/decoder-out-cache.h"
 #include "sherpa-onnx/csrc/features.h"
 #include "sherpa-onnx/csrc/online-ctc-decoder.h"
 #include "sherpa-onnx/csrc/online-paraformer-decoder.h"
@@ -61,6 +62,12 @@ class OnlineStream {
    */
   std::vector<float> GetFrames(int32_t frame_index, int32_t n) const;
 
+  /** Same as the above one, but write the frames to a caller-provided buffer.
+   *
+   * @param out  Pointer to an array of size n * FeatureDim().
+   */
+  void GetFrames(int32_t frame_index, int32_t n, float *out) const;
+
   void Reset();
 
   int32_t FeatureDim() const;
@@ -72,7 +79,9 @@ class OnlineStream {
   // The returned reference is valid as long as this object is alive.
   int32_t &GetNumProcessedFrames();  // It's reset after calling Reset()
 
-  int32_t GetNumFramesSinceStart() const;
+  // Number of frames before the current segment. It is 64-bit since
+  // a stream may run for months.
+  int64_t GetNumFramesSinceStart() const;
 
   int32_t &GetCurrentSegment();
 
@@ -80,6 +89,7 @@ class OnlineStream {
   OnlineTransducerDecoderResult &GetResult();
 
   void SetKeywordResult(const TransducerKeywordResult &r);
+  void SetKeywordResult(TransducerKeywordResult &&r);
   TransducerKeywordResult &GetKeywordResult(bool remove_duplicates = false);
 
   void SetCtcResult(const OnlineCtcDecoderResult &r);
@@ -101,6 +111,19 @@ class OnlineStream {
    */
   const ContextGraphPtr &GetContextGraph() const;
 
+  // for keyword spotting. Replace the context graph of a live stream, e.g.,
+  // after the keywords are reloaded. The caller must also reset the keyword
+  // result, since its hypotheses point into the previous graph.
+  //
+  // @param keywords_version Version of the keywords the graph is built from.
+  //                         -1 means the graph is not replaced on reloading.
+  void SetContextGraph(ContextGraphPtr context_graph,
+                       int32_t keywords_version);
+  int32_t GetKeywordsVersion() const;
+
+  // for keyword spotting. Decoder outputs keyed by the decoder input.
+  DecoderOutCache &GetDecoderOutCache();
+
   // for online ctc decoder
   void SetFasterDecoder(std::unique_ptr<kaldi_decoder::FasterDecoder> decoder);
   kaldi_decoder::FasterDecoder *GetFasterDecoder() const;
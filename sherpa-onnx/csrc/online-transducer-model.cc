@@ -20,12 +20,15 @@
 
 #include "sherpa-onnx/csrc/file-utils.h"
 #include "sherpa-onnx/csrc/macros.h"
+#include "sherpa-onnx/csrc/model-precision.h"
 #include "sherpa-onnx/csrc/online-conformer-transducer-model.h"
 #include "sherpa-onnx/csrc/online-ebranchformer-transducer-model.h"
 #include "sherpa-onnx/csrc/online-lstm-transducer-model.h"
 #include "sherpa-onnx/csrc/online-zipformer-transducer-model.h"
 #include "sherpa-onnx/csrc/online-zipformer2-transducer-model.h"
 #include "sherpa-onnx/csrc/onnx-utils.h"
+#include "sherpa-onnx/csrc/session-registry.h"
+#include "sherpa-onnx/csrc/session.h"
 
 namespace {
 
@@ -42,16 +45,7 @@ enum class ModelType : std::uint8_t {
 
 namespace sherpa_onnx {
 
-static ModelType GetModelType(char *model_data, size_t model_data_length,
-                              bool debug) {
-  Ort::Env env(ORT_LOGGING_LEVEL_ERROR);
-  Ort::SessionOptions sess_opts;
-  sess_opts.SetIntraOpNumThreads(1);
-  sess_opts.SetInterOpNumThreads(1);
-
-  auto sess = std::make_unique<Ort::Session>(env, model_data, model_data_length,
-                                             sess_opts);
-
+static ModelType GetModelType(Ort::Session *sess, bool debug) {
   Ort::ModelMetadata meta_data = sess->GetModelMetadata();
   if (debug) {
     std::ostringstream os;
@@ -90,8 +84,27 @@ static ModelType GetModelType(char *model_data, size_t model_data_length,
   }
 }
 
+static ModelType GetModelType(char *model_data, size_t model_data_length,
+                              bool debug) {
+  Ort::SessionOptions sess_opts;
+  sess_opts.SetIntraOpNumThreads(1);
+  sess_opts.SetInterOpNumThreads(1);
+
+  auto sess = std::make_unique<Ort::Session>(GetOrtEnv(), model_data,
+                                             model_data_length, sess_opts);
+
+  return GetModelType(sess.get(), debug);
+}
+
 std::unique_ptr<OnlineTransducerModel> OnlineTransducerModel::Create(
     const OnlineModelConfig &config) {
+  if (!config.precision.empty()) {
+    // The files of the precision are checked in OnlineModelConfig::Validate()
+    OnlineModelConfig c = ApplyModelPrecision(config);
+    LogModelFootprint(c.transducer, config.precision);
+    return Create(c);
+  }
+
   if (!config.model_type.empty()) {
     const auto &model_type = config.model_type;
     if (model_type == "conformer") {
@@ -110,12 +123,18 @@ std::unique_ptr<OnlineTransducerModel> OnlineTransducerModel::Create(
           model_type.c_str());
     }
   }
-  ModelType model_type = ModelType::kUnknown;
-
-  {
-    auto buffer = ReadFile(config.transducer.encoder);
-
-    model_type = GetModelType(buffer.data(), buffer.size(), config.debug);
+  // The encoder is loaded with the options of the model, so that a
+  // zipformer2 model gets this session from the registry instead of loading
+  // the file a second time
+  std::shared_ptr<Ort::Session> encoder_sess =
+      GetSharedSession(config.transducer.encoder, GetSessionOptions(config),
+                       GetSessionOptionsKey(config, "encoder"));
+
+  ModelType model_type = GetModelType(encoder_sess.get(), config.debug);
+
+  if (model_type != ModelType::kZipformer2) {
+    // Other models load their own sessions. Free this one first.
+    encoder_sess.reset();
   }
 
   switch (model_type) {
@@ -175,6 +194,10 @@ Ort::Value OnlineTransducerModel::BuildDecoderInput(
 template <typename Manager>
 std::unique_ptr<OnlineTransducerModel> OnlineTransducerModel::Create(
     Manager *mgr, const OnlineModelConfig &config) {
+  if (!config.precision.empty()) {
+    return Create(mgr, ApplyModelPrecision(config));
+  }
+
   if (!config.model_type.empty()) {
     const auto &model_type = config.model_type;
     if (model_type == "conformer") {
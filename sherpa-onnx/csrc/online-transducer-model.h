@@ -101,6 +101,10 @@ class OnlineTransducerModel {
    * @return Return a tensor of shape (N, vocab_size). In icefall, the last
    *         last layer of the joint network is `nn.Linear`,
    *         not `nn.LogSoftmax`.
+   *
+   * Caution: The returned tensor may share its buffer with the model. It is
+   *          overwritten by the next call from the same thread with the
+   *          same batch size, so it must not be kept across calls.
    */
   virtual Ort::Value RunJoiner(Ort::Value encoder_out,
                                Ort::Value decoder_out) = 0;
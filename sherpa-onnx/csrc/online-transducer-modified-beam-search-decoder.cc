@@ -6,9 +6,11 @@
 #include "sherpa-onnx/csrc/online-transducer-modified-beam-search-decoder.h"
 
 #include <algorithm>
+#include <array>
 #include <utility>
 #include <vector>
 
+#include "sherpa-onnx/csrc/log-softmax-topk.h"
 #include "sherpa-onnx/csrc/log.h"
 #include "sherpa-onnx/csrc/onnx-utils.h"
 
@@ -37,6 +39,36 @@ static void UseCachedDecoderOut(
   }
 }
 
+// Return the decoder input for hyps, a tensor of shape
+// (hyps.size(), context_size) with the last context_size tokens of each hyp
+static Ort::Value BuildDecoderInput(const HypothesisArena &arena,
+                                    const std::vector<ArenaHypothesis> &hyps,
+                                    int32_t context_size,
+                                    OrtAllocator *allocator) {
+  std::array<int64_t, 2> shape{static_cast<int64_t>(hyps.size()),
+                               context_size};
+  Ort::Value decoder_input =
+      Ort::Value::CreateTensor<int64_t>(allocator, shape.data(), shape.size());
+  int64_t *p = decoder_input.GetTensorMutableData<int64_t>();
+  for (const auto &h : hyps) {
+    arena.LastTokens(h, context_size, p);
+    p += context_size;
+  }
+  return decoder_input;
+}
+
+// Compute log_softmax(logit / temperature_scale) into out, which is
+// resized to num_hyps * vocab_size. logit is not changed.
+static void ScaledLogSoftmax(const float *logit, int32_t vocab_size,
+                             int32_t num_hyps, float temperature_scale,
+                             std::vector<float> *out) {
+  out->resize(vocab_size * num_hyps);
+  std::transform(
+      logit, logit + out->size(), out->begin(),
+      [temperature_scale](float x) { return x / temperature_scale; });
+  LogSoftmaxWithOffset(out->data(), vocab_size, num_hyps);
+}
+
 OnlineTransducerDecoderResult
 OnlineTransducerModifiedBeamSearchDecoder::GetEmptyResult() const {
   int32_t context_size = model_->ContextSize();
@@ -93,29 +125,48 @@ void OnlineTransducerModifiedBeamSearchDecoder::Decode(
 
   int32_t num_frames = static_cast<int32_t>(encoder_out_shape[1]);
   int32_t vocab_size = model_->VocabSize();
+  int32_t context_size = model_->ContextSize();
+
+  bool use_shallow_fusion = lm_ && shallow_fusion_;
+  bool use_rescore = lm_ && !shallow_fusion_;
+
+  // Decode() may run on several threads at once, e.g., in the websocket
+  // server, so each thread has its own workspace.
+  static thread_local DecodeWorkspace workspace;
+  auto &arena = workspace.arena;
+  auto &cur = workspace.cur;
+  auto &prev = workspace.prev;
+  auto &hyps_row_splits = workspace.hyps_row_splits;
 
-  std::vector<Hypotheses> cur;
-  for (auto &r : *result) {
-    cur.push_back(std::move(r.hyps));
+  // Tokens of all hyps of this call. A new hyp appends one token to it
+  // instead of copying all vectors of its parent.
+  arena.Clear();
+
+  cur.resize(batch_size, ArenaHypotheses(&arena));
+  for (int32_t b = 0; b != batch_size; ++b) {
+    cur[b].Clear();
+    for (const auto &h : (*result)[b].hyps) {
+      cur[b].Add(arena.Import(h.second));
+    }
   }
-  std::vector<Hypothesis> prev;
+
+  hyps_row_splits.resize(batch_size + 1);
+  hyps_row_splits[0] = 0;
 
   for (int32_t t = 0; t != num_frames; ++t) {
     // Due to merging paths with identical token sequences,
     // not all utterances have "num_active_paths" paths.
-    auto hyps_row_splits = GetHypsRowSplits(cur);
-    int32_t num_hyps =
-        hyps_row_splits.back();  // total num hyps for all utterance
     prev.clear();
-    for (auto &hyps : cur) {
-      for (auto &h : hyps) {
-        prev.push_back(std::move(h.second));
-      }
+    for (int32_t b = 0; b != batch_size; ++b) {
+      prev.insert(prev.end(), cur[b].begin(), cur[b].end());
+      hyps_row_splits[b + 1] = static_cast<int32_t>(prev.size());
+      cur[b].Clear();
     }
-    cur.clear();
-    cur.reserve(batch_size);
+    int32_t num_hyps =
+        hyps_row_splits.back();  // total num hyps for all utterance
 
-    Ort::Value decoder_input = model_->BuildDecoderInput(prev);
+    Ort::Value decoder_input =
+        BuildDecoderInput(arena, prev, context_size, model_->Allocator());
     Ort::Value decoder_out = model_->RunDecoder(std::move(decoder_input));
     if (t == 0) {
       UseCachedDecoderOut(hyps_row_splits, *result, &decoder_out);
@@ -130,131 +181,154 @@ void OnlineTransducerModifiedBeamSearchDecoder::Decode(
 
     float *p_logit = logit.GetTensorMutableData<float>();
 
-    // copy raw logits, apply temperature-scaling  (for confidences)
     // Note: temperature scaling is used only for the confidences,
     //       the decoding algorithm uses the original logits
-    int32_t p_logit_items = vocab_size * num_hyps;
-    std::vector<float> logit_with_temperature(p_logit_items);
-    {
-      std::copy(p_logit, p_logit + p_logit_items,
-                logit_with_temperature.begin());
-      for (float &elem : logit_with_temperature) {
-        elem /= temperature_scale_;
-      }
-      LogSoftmax(logit_with_temperature.data(), vocab_size, num_hyps);
-    }
+    ScaledLogSoftmax(p_logit, vocab_size, num_hyps, temperature_scale_,
+                     &workspace.logit_with_temperature);
+    const float *logit_with_temperature =
+        workspace.logit_with_temperature.data();
 
     if (blank_penalty_ > 0.0) {
       // assuming blank id is 0
       SubtractBlank(p_logit, vocab_size, num_hyps, 0, blank_penalty_);
     }
-    LogSoftmax(p_logit, vocab_size, num_hyps);
+
+    // add log_prob of each hypothesis to the log_softmax output
+    // before taking top_k
+    auto &offsets = workspace.offsets;
+    offsets.resize(num_hyps);
+    for (int32_t i = 0; i != num_hyps; ++i) {
+      offsets[i] = use_shallow_fusion ? prev[i].TotalLogProb()
+                                      : prev[i].log_prob;
+    }
+
+    LogSoftmaxWithOffset(p_logit, vocab_size, num_hyps, offsets.data());
 
     // now p_logit contains log_softmax output, we rename it to p_logprob
     // to match what it actually contains
-    float *p_logprob = p_logit;
+    const float *p_logprob = p_logit;
 
-    // add log_prob of each hypothesis to p_logprob before taking top_k
-    for (int32_t i = 0; i != num_hyps; ++i) {
-      float log_prob = prev[i].log_prob;
-      if (lm_ && shallow_fusion_) {
-         log_prob += prev[i].lm_log_prob;
-      }
-
-      for (int32_t k = 0; k != vocab_size; ++k, ++p_logprob) {
-        *p_logprob += log_prob;
-      }
-    }
-    p_logprob = p_logit;  // we changed p_logprob in the above for loop
+    auto &topk = workspace.topk;
+    topk.resize(max_active_paths_);
 
     for (int32_t b = 0; b != batch_size; ++b) {
       int32_t frame_offset = (*result)[b].frame_offset;
       int32_t start = hyps_row_splits[b];
       int32_t end = hyps_row_splits[b + 1];
-      auto topk =
-          TopkIndex(p_logprob, vocab_size * (end - start), max_active_paths_);
+      int32_t num_topk = TopkIndex(p_logprob, vocab_size * (end - start),
+                                   max_active_paths_, topk.data());
 
-      Hypotheses hyps;
-      for (auto k : topk) {
+      for (int32_t i = 0; i != num_topk; ++i) {
+        int32_t k = topk[i];
         int32_t hyp_index = k / vocab_size + start;
         int32_t new_token = k % vocab_size;
 
-        Hypothesis new_hyp = prev[hyp_index];
-        const float prev_lm_log_prob = new_hyp.lm_log_prob;
+        const ArenaHypothesis &prev_hyp = prev[hyp_index];
+        ArenaHypothesis new_hyp = prev_hyp;
         float context_score = 0;
-        auto context_state = new_hyp.context_state;
 
         // blank is hardcoded to 0
         // also, it treats unk as blank
         if (new_token != 0 && new_token != unk_id_) {
-          new_hyp.ys.push_back(new_token);
-          new_hyp.timestamps.push_back(t + frame_offset);
-          new_hyp.num_trailing_blanks = 0;
+          const ContextState *context_state = new_hyp.context_state;
           if (ss != nullptr && ss[b]->GetContextGraph() != nullptr) {
             auto context_res = ss[b]->GetContextGraph()->ForwardOneStep(
                 context_state, new_token, false /*strict mode*/);
             context_score = std::get<0>(context_res);
-            new_hyp.context_state = std::get<1>(context_res);
+            context_state = std::get<1>(context_res);
           }
-          if (lm_ && shallow_fusion_) {
-            lm_->ComputeLMScoreSF(lm_scale_, &new_hyp);
+
+          float lm_prob = 0;
+          if (use_shallow_fusion) {
+            lm_prob = ComputeLMScoreSF(prev_hyp, new_token, &arena, &new_hyp);
           }
+
+          float y_prob = logit_with_temperature[start * vocab_size + k];
+          new_hyp = arena.Extend(new_hyp, new_token, t + frame_offset, y_prob,
+                                 context_score, lm_prob);
+          new_hyp.context_state = context_state;
+          new_hyp.num_trailing_blanks = 0;
         } else {
           ++new_hyp.num_trailing_blanks;
         }
-        if (lm_ && shallow_fusion_) {
-           new_hyp.log_prob = p_logprob[k] + context_score -
-                           prev_lm_log_prob;  // log_prob only includes the
-                                              // score of the transducer
-        } else {
-           new_hyp.log_prob = p_logprob[k] + context_score;  // rescore or no LM
-                                                             // previous token
-                                                             // score is ignored
-        }
-
-        // export the per-token log scores
-        if (new_token != 0 && new_token != unk_id_) {
-          float y_prob = logit_with_temperature[start * vocab_size + k];
-          new_hyp.ys_probs.push_back(y_prob);
-
-          if (lm_ && shallow_fusion_) {  // export only if
-                                         // LM shallow fusion is used
-            float lm_prob = new_hyp.lm_log_prob - prev_lm_log_prob;
-
-            if (lm_scale_ != 0.0) {
-              lm_prob /= lm_scale_;  // remove lm-scale
-            }
-            new_hyp.lm_probs.push_back(lm_prob);
-          }
 
-          // export only when `ContextGraph` is used
-          if (ss != nullptr && ss[b]->GetContextGraph() != nullptr) {
-            new_hyp.context_scores.push_back(context_score);
-          }
+        // log_prob includes only the score of the transducer, so the
+        // previous LM score added for shallow fusion is removed
+        new_hyp.log_prob = p_logprob[k] + context_score;
+        if (use_shallow_fusion) {
+          new_hyp.log_prob -= prev_hyp.lm_log_prob;
         }
 
-        hyps.Add(std::move(new_hyp));
-      }  // for (auto k : topk)
-      cur.push_back(std::move(hyps));
+        cur[b].Add(new_hyp);
+      }  // for (int32_t i = 0; i != num_topk; ++i)
       p_logprob += (end - start) * vocab_size;
     }  // for (int32_t b = 0; b != batch_size; ++b)
   }    // for (int32_t t = 0; t != num_frames; ++t)
 
-  // classic lm rescore
-  if (lm_ && !shallow_fusion_) {
-    lm_->ComputeLMScore(lm_scale_, model_->ContextSize(), &cur);
-  }
-
   for (int32_t b = 0; b != batch_size; ++b) {
-    auto &hyps = cur[b];
-    auto best_hyp = hyps.GetMostProbable(true);
+    // context_scores are exported only when `ContextGraph` is used
+    bool with_context_scores =
+        ss != nullptr && ss[b]->GetContextGraph() != nullptr;
+
     auto &r = (*result)[b];
+    r.hyps.Clear();
+    for (const auto &h : cur[b]) {
+      r.hyps.Add(arena.Export(h, with_context_scores, use_shallow_fusion));
+    }
+
+    if (!use_rescore) {
+      const auto &best_hyp = cur[b][cur[b].MostProbable(true)];
+      r.tokens.resize(best_hyp.num_tokens);
+      arena.LastTokens(best_hyp, best_hyp.num_tokens, r.tokens.data());
+      r.num_trailing_blanks = best_hyp.num_trailing_blanks;
+    }
 
-    r.hyps = std::move(hyps);
-    r.tokens = std::move(best_hyp.ys);
-    r.num_trailing_blanks = best_hyp.num_trailing_blanks;
     r.frame_offset += num_frames;
   }
+
+  // Release the LM states now instead of keeping them until the next call
+  arena.Clear();
+
+  // classic lm rescore
+  if (use_rescore) {
+    std::vector<Hypotheses> hyps(batch_size);
+    for (int32_t b = 0; b != batch_size; ++b) {
+      hyps[b] = std::move((*result)[b].hyps);
+    }
+
+    lm_->ComputeLMScore(lm_scale_, context_size, &hyps);
+
+    for (int32_t b = 0; b != batch_size; ++b) {
+      auto &r = (*result)[b];
+      r.hyps = std::move(hyps[b]);
+
+      auto best_hyp = r.hyps.GetMostProbable(true);
+      r.tokens = std::move(best_hyp.ys);
+      r.num_trailing_blanks = best_hyp.num_trailing_blanks;
+    }
+  }
+}
+
+float OnlineTransducerModifiedBeamSearchDecoder::ComputeLMScoreSF(
+    const ArenaHypothesis &prev_hyp, int32_t new_token,
+    HypothesisArena *arena, ArenaHypothesis *new_hyp) const {
+  // OnlineLM::ComputeLMScoreSF() uses only the last token and the LM states
+  Hypothesis h;
+  h.ys.push_back(new_token);
+  h.lm_log_prob = prev_hyp.lm_log_prob;
+  arena->LoadLmState(prev_hyp.lm_state, &h);
+
+  lm_->ComputeLMScoreSF(lm_scale_, &h);
+
+  new_hyp->lm_log_prob = h.lm_log_prob;
+  new_hyp->lm_state = arena->SaveLmState(&h);
+
+  float lm_prob = h.lm_log_prob - prev_hyp.lm_log_prob;
+  if (lm_scale_ != 0.0) {
+    lm_prob /= lm_scale_;  // remove lm-scale
+  }
+
+  return lm_prob;
 }
 
 void OnlineTransducerModifiedBeamSearchDecoder::UpdateDecoderOut(
@@ -8,6 +8,7 @@
 
 #include <vector>
 
+#include "sherpa-onnx/csrc/hypothesis-arena.h"
 #include "sherpa-onnx/csrc/online-lm.h"
 #include "sherpa-onnx/csrc/online-stream.h"
 #include "sherpa-onnx/csrc/online-transducer-decoder.h"
@@ -47,6 +48,37 @@ class OnlineTransducerModifiedBeamSearchDecoder
 
   void UpdateDecoderOut(OnlineTransducerDecoderResult *result) override;
 
+ private:
+  // Buffers of Decode() that are reused across frames and calls, so that
+  // no memory is allocated for them once they have grown to the largest
+  // batch seen.
+  struct DecodeWorkspace {
+    // Tokens of all hypotheses. It is cleared at the start and the end of
+    // each call.
+    HypothesisArena arena;
+
+    // Hypotheses of the previous frame for all streams
+    std::vector<ArenaHypothesis> prev;
+
+    // Hypotheses of the current frame, one beam per stream
+    std::vector<ArenaHypotheses> cur;
+
+    std::vector<int32_t> hyps_row_splits;
+
+    // Scratch buffers for the log-softmax and top-k of each frame
+    std::vector<float> logit_with_temperature;
+    std::vector<float> offsets;
+    std::vector<int32_t> topk;
+  };
+
+  // Run the LM on new_token for shallow fusion and update the LM score and
+  // states of new_hyp, which extends prev_hyp with new_token.
+  //
+  // @return Return the LM score of new_token without lm_scale
+  float ComputeLMScoreSF(const ArenaHypothesis &prev_hyp, int32_t new_token,
+                         HypothesisArena *arena,
+                         ArenaHypothesis *new_hyp) const;
+
  private:
   OnlineTransducerModel *model_;  // Not owned
   OnlineLM *lm_;                  // Not owned
@@ -89,6 +89,9 @@ void OnlineZipformerTransducerModel::InitEncoder(void *model_data,
   GetOutputNames(encoder_sess_.get(), &encoder_output_names_,
                  &encoder_output_names_ptr_);
 
+  encoder_binding_ = std::make_unique<SessionBinding>(
+      encoder_sess_.get(), encoder_input_names_, encoder_output_names_, false);
+
   // get meta data
   Ort::ModelMetadata meta_data = encoder_sess_->GetModelMetadata();
   if (config_.debug) {
@@ -151,6 +154,9 @@ void OnlineZipformerTransducerModel::InitDecoder(void *model_data,
   GetOutputNames(decoder_sess_.get(), &decoder_output_names_,
                  &decoder_output_names_ptr_);
 
+  decoder_binding_ = std::make_unique<SessionBinding>(
+      decoder_sess_.get(), decoder_input_names_, decoder_output_names_, false);
+
   // get meta data
   Ort::ModelMetadata meta_data = decoder_sess_->GetModelMetadata();
   if (config_.debug) {
@@ -180,6 +186,9 @@ void OnlineZipformerTransducerModel::InitJoiner(void *model_data,
   GetOutputNames(joiner_sess_.get(), &joiner_output_names_,
                  &joiner_output_names_ptr_);
 
+  joiner_binding_ = std::make_unique<SessionBinding>(
+      joiner_sess_.get(), joiner_input_names_, joiner_output_names_, true);
+
   // get meta data
   Ort::ModelMetadata meta_data = joiner_sess_->GetModelMetadata();
   if (config_.debug) {
@@ -470,10 +479,8 @@ OnlineZipformerTransducerModel::RunEncoder(Ort::Value features,
     encoder_inputs.push_back(std::move(v));
   }
 
-  auto encoder_out = encoder_sess_->Run(
-      {}, encoder_input_names_ptr_.data(), encoder_inputs.data(),
-      encoder_inputs.size(), encoder_output_names_ptr_.data(),
-      encoder_output_names_ptr_.size());
+  auto encoder_out = encoder_binding_->Run(encoder_inputs.data(),
+                                           encoder_inputs.size());
 
   std::vector<Ort::Value> next_states;
   next_states.reserve(states.size());
@@ -487,9 +494,7 @@ OnlineZipformerTransducerModel::RunEncoder(Ort::Value features,
 
 Ort::Value OnlineZipformerTransducerModel::RunDecoder(
     Ort::Value decoder_input) {
-  auto decoder_out = decoder_sess_->Run(
-      {}, decoder_input_names_ptr_.data(), &decoder_input, 1,
-      decoder_output_names_ptr_.data(), decoder_output_names_ptr_.size());
+  auto decoder_out = decoder_binding_->Run(&decoder_input, 1);
   return std::move(decoder_out[0]);
 }
 
@@ -497,10 +502,7 @@ Ort::Value OnlineZipformerTransducerModel::RunJoiner(Ort::Value encoder_out,
                                                      Ort::Value decoder_out) {
   std::array<Ort::Value, 2> joiner_input = {std::move(encoder_out),
                                             std::move(decoder_out)};
-  auto logit =
-      joiner_sess_->Run({}, joiner_input_names_ptr_.data(), joiner_input.data(),
-                        joiner_input.size(), joiner_output_names_ptr_.data(),
-                        joiner_output_names_ptr_.size());
+  auto logit = joiner_binding_->Run(joiner_input.data(), joiner_input.size());
 
   return std::move(logit[0]);
 }
@@ -29,6 +29,7 @@
 #include "sherpa-onnx/csrc/macros.h"
 #include "sherpa-onnx/csrc/online-transducer-decoder.h"
 #include "sherpa-onnx/csrc/onnx-utils.h"
+#include "sherpa-onnx/csrc/session-registry.h"
 #include "sherpa-onnx/csrc/session.h"
 #include "sherpa-onnx/csrc/text-utils.h"
 #include "sherpa-onnx/csrc/unbind.h"
@@ -37,64 +38,66 @@ namespace sherpa_onnx {
 
 OnlineZipformer2TransducerModel::OnlineZipformer2TransducerModel(
     const OnlineModelConfig &config)
-    : env_(ORT_LOGGING_LEVEL_ERROR),
-      encoder_sess_opts_(GetSessionOptions(config)),
+    : encoder_sess_opts_(GetSessionOptions(config)),
       decoder_sess_opts_(GetSessionOptions(config, "decoder")),
       joiner_sess_opts_(GetSessionOptions(config, "joiner")),
       config_(config),
       allocator_{} {
-  {
-    auto buf = ReadFile(config.transducer.encoder);
-    InitEncoder(buf.data(), buf.size());
-  }
-
-  {
-    auto buf = ReadFile(config.transducer.decoder);
-    InitDecoder(buf.data(), buf.size());
-  }
-
-  {
-    auto buf = ReadFile(config.transducer.joiner);
-    InitJoiner(buf.data(), buf.size());
-  }
+  encoder_sess_ =
+      GetSharedSession(config.transducer.encoder, encoder_sess_opts_,
+                       GetSessionOptionsKey(config, "encoder"));
+  InitEncoder();
+
+  decoder_sess_ =
+      GetSharedSession(config.transducer.decoder, decoder_sess_opts_,
+                       GetSessionOptionsKey(config, "decoder"));
+  InitDecoder();
+
+  joiner_sess_ = GetSharedSession(config.transducer.joiner, joiner_sess_opts_,
+                                  GetSessionOptionsKey(config, "joiner"));
+  InitJoiner();
 }
 
 template <typename Manager>
 OnlineZipformer2TransducerModel::OnlineZipformer2TransducerModel(
     Manager *mgr, const OnlineModelConfig &config)
-    : env_(ORT_LOGGING_LEVEL_ERROR),
-      config_(config),
+    : config_(config),
       encoder_sess_opts_(GetSessionOptions(config)),
       decoder_sess_opts_(GetSessionOptions(config)),
       joiner_sess_opts_(GetSessionOptions(config)),
       allocator_{} {
   {
     auto buf = ReadFile(mgr, config.transducer.encoder);
-    InitEncoder(buf.data(), buf.size());
+    encoder_sess_ = std::make_shared<Ort::Session>(
+        GetOrtEnv(), buf.data(), buf.size(), encoder_sess_opts_);
   }
+  InitEncoder();
 
   {
     auto buf = ReadFile(mgr, config.transducer.decoder);
-    InitDecoder(buf.data(), buf.size());
+    decoder_sess_ = std::make_shared<Ort::Session>(
+        GetOrtEnv(), buf.data(), buf.size(), decoder_sess_opts_);
   }
+  InitDecoder();
 
   {
     auto buf = ReadFile(mgr, config.transducer.joiner);
-    InitJoiner(buf.data(), buf.size());
+    joiner_sess_ = std::make_shared<Ort::Session>(
+        GetOrtEnv(), buf.data(), buf.size(), joiner_sess_opts_);
   }
+  InitJoiner();
 }
 
-void OnlineZipformer2TransducerModel::InitEncoder(void *model_data,
-                                                  size_t model_data_length) {
-  encoder_sess_ = std::make_unique<Ort::Session>(
-      env_, model_data, model_data_length, encoder_sess_opts_);
-
+void OnlineZipformer2TransducerModel::InitEncoder() {
   GetInputNames(encoder_sess_.get(), &encoder_input_names_,
                 &encoder_input_names_ptr_);
 
   GetOutputNames(encoder_sess_.get(), &encoder_output_names_,
                  &encoder_output_names_ptr_);
 
+  encoder_binding_ = std::make_unique<SessionBinding>(
+      encoder_sess_.get(), encoder_input_names_, encoder_output_names_, false);
+
   // get meta data
   Ort::ModelMetadata meta_data = encoder_sess_->GetModelMetadata();
   if (config_.debug) {
@@ -151,17 +154,16 @@ void OnlineZipformer2TransducerModel::InitEncoder(void *model_data,
   }
 }
 
-void OnlineZipformer2TransducerModel::InitDecoder(void *model_data,
-                                                  size_t model_data_length) {
-  decoder_sess_ = std::make_unique<Ort::Session>(
-      env_, model_data, model_data_length, decoder_sess_opts_);
-
+void OnlineZipformer2TransducerModel::InitDecoder() {
   GetInputNames(decoder_sess_.get(), &decoder_input_names_,
                 &decoder_input_names_ptr_);
 
   GetOutputNames(decoder_sess_.get(), &decoder_output_names_,
                  &decoder_output_names_ptr_);
 
+  decoder_binding_ = std::make_unique<SessionBinding>(
+      decoder_sess_.get(), decoder_input_names_, decoder_output_names_, false);
+
   // get meta data
   Ort::ModelMetadata meta_data = decoder_sess_->GetModelMetadata();
   if (config_.debug) {
@@ -176,17 +178,16 @@ void OnlineZipformer2TransducerModel::InitDecoder(void *model_data,
   SHERPA_ONNX_READ_META_DATA(context_size_, "context_size");
 }
 
-void OnlineZipformer2TransducerModel::InitJoiner(void *model_data,
-                                                 size_t model_data_length) {
-  joiner_sess_ = std::make_unique<Ort::Session>(
-      env_, model_data, model_data_length, joiner_sess_opts_);
-
+void OnlineZipformer2TransducerModel::InitJoiner() {
   GetInputNames(joiner_sess_.get(), &joiner_input_names_,
                 &joiner_input_names_ptr_);
 
   GetOutputNames(joiner_sess_.get(), &joiner_output_names_,
                  &joiner_output_names_ptr_);
 
+  joiner_binding_ = std::make_unique<SessionBinding>(
+      joiner_sess_.get(), joiner_input_names_, joiner_output_names_, true);
+
   // get meta data
   Ort::ModelMetadata meta_data = joiner_sess_->GetModelMetadata();
   if (config_.debug) {
@@ -458,10 +459,8 @@ OnlineZipformer2TransducerModel::RunEncoder(Ort::Value features,
     encoder_inputs.push_back(std::move(v));
   }
 
-  auto encoder_out = encoder_sess_->Run(
-      {}, encoder_input_names_ptr_.data(), encoder_inputs.data(),
-      encoder_inputs.size(), encoder_output_names_ptr_.data(),
-      encoder_output_names_ptr_.size());
+  auto encoder_out = encoder_binding_->Run(encoder_inputs.data(),
+                                           encoder_inputs.size());
 
   std::vector<Ort::Value> next_states;
   next_states.reserve(states.size());
@@ -474,9 +473,7 @@ OnlineZipformer2TransducerModel::RunEncoder(Ort::Value features,
 
 Ort::Value OnlineZipformer2TransducerModel::RunDecoder(
     Ort::Value decoder_input) {
-  auto decoder_out = decoder_sess_->Run(
-      {}, decoder_input_names_ptr_.data(), &decoder_input, 1,
-      decoder_output_names_ptr_.data(), decoder_output_names_ptr_.size());
+  auto decoder_out = decoder_binding_->Run(&decoder_input, 1);
   return std::move(decoder_out[0]);
 }
 
@@ -484,10 +481,7 @@ Ort::Value OnlineZipformer2TransducerModel::RunJoiner(Ort::Value encoder_out,
                                                       Ort::Value decoder_out) {
   std::array<Ort::Value, 2> joiner_input = {std::move(encoder_out),
                                             std::move(decoder_out)};
-  auto logit =
-      joiner_sess_->Run({}, joiner_input_names_ptr_.data(), joiner_input.data(),
-                        joiner_input.size(), joiner_output_names_ptr_.data(),
-                        joiner_output_names_ptr_.size());
+  auto logit = joiner_binding_->Run(joiner_input.data(), joiner_input.size());
 
   return std::move(logit[0]);
 }
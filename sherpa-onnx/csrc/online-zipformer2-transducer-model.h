@@ -12,6 +12,7 @@
 #include "onnxruntime_cxx_api.h"  // NOLINT
 #include "sherpa-onnx/csrc/online-model-config.h"
 #include "sherpa-onnx/csrc/online-transducer-model.h"
+#include "sherpa-onnx/csrc/session-binding.h"
 
 namespace sherpa_onnx {
 
@@ -53,21 +54,28 @@ class OnlineZipformer2TransducerModel : public OnlineTransducerModel {
   OrtAllocator *Allocator() override { return allocator_; }
 
  private:
-  void InitEncoder(void *model_data, size_t model_data_length);
-  void InitDecoder(void *model_data, size_t model_data_length);
-  void InitJoiner(void *model_data, size_t model_data_length);
+  // Read the names and meta data of the models from their sessions
+  void InitEncoder();
+  void InitDecoder();
+  void InitJoiner();
 
  private:
-  Ort::Env env_;
   Ort::SessionOptions encoder_sess_opts_;
   Ort::SessionOptions decoder_sess_opts_;
   Ort::SessionOptions joiner_sess_opts_;
 
   Ort::AllocatorWithDefaultOptions allocator_;
 
-  std::unique_ptr<Ort::Session> encoder_sess_;
-  std::unique_ptr<Ort::Session> decoder_sess_;
-  std::unique_ptr<Ort::Session> joiner_sess_;
+  // Shared with other models that load the same files, see
+  // session-registry.h
+  std::shared_ptr<Ort::Session> encoder_sess_;
+  std::shared_ptr<Ort::Session> decoder_sess_;
+  std::shared_ptr<Ort::Session> joiner_sess_;
+
+  // Outputs of the joiner are reused across calls, see RunJoiner()
+  std::unique_ptr<SessionBinding> encoder_binding_;
+  std::unique_ptr<SessionBinding> decoder_binding_;
+  std::unique_ptr<SessionBinding> joiner_binding_;
 
   std::vector<std::string> encoder_input_names_;
   std::vector<const char *> encoder_input_names_ptr_;
@@ -0,0 +1,132 @@
+// sherpa-onnx/csrc/pcm-convert-test.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/pcm-convert.h"
+
+#include <cmath>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "sherpa-onnx/csrc/resample.h"
+
+namespace sherpa_onnx {
+
+TEST(PcmConvert, Int16ToFloat) {
+  // Not a multiple of 8, so the tail is covered
+  std::vector<int16_t> in = {0,     1,     -1,    32767, -32768, 16384,
+                             -16384, 100,  -100,  7,     -7,     12345,
+                             -12345};
+  std::vector<float> out(in.size());
+  Int16ToFloat(in.data(), in.size(), out.data());
+
+  for (size_t i = 0; i != in.size(); ++i) {
+    EXPECT_EQ(out[i], in[i] / 32768.0f) << i;
+  }
+}
+
+TEST(PcmConvert, Deinterleave) {
+  for (int32_t num_channels : {1, 2, 3, 4, 6, 8}) {
+    // Not a multiple of 8, so the tail is covered
+    int32_t num_frames = 37;
+
+    std::vector<int16_t> in(num_frames * num_channels);
+    for (int32_t i = 0; i != num_frames; ++i) {
+      for (int32_t c = 0; c != num_channels; ++c) {
+        in[i * num_channels + c] = static_cast<int16_t>(c * 1000 - i * 17);
+      }
+    }
+
+    std::vector<std::vector<float>> out(num_channels,
+                                        std::vector<float>(num_frames));
+    std::vector<float *> p;
+    for (auto &v : out) {
+      p.push_back(v.data());
+    }
+
+    DeinterleaveInt16ToFloat(in.data(), num_frames, num_channels, p.data());
+
+    for (int32_t c = 0; c != num_channels; ++c) {
+      for (int32_t i = 0; i != num_frames; ++i) {
+        EXPECT_EQ(out[c][i], (c * 1000 - i * 17) / 32768.0f)
+            << "channel " << c << ", frame " << i << ", num_channels "
+            << num_channels;
+      }
+    }
+  }
+}
+
+TEST(PcmConvert, ChannelInt16ToFloat) {
+  for (int32_t num_channels : {1, 2, 3}) {
+    int32_t num_frames = 37;
+
+    std::vector<int16_t> in(num_frames * num_channels);
+    for (int32_t i = 0; i != static_cast<int32_t>(in.size()); ++i) {
+      in[i] = static_cast<int16_t>(i * 331 - 20000);
+    }
+
+    std::vector<float> out(num_frames);
+    for (int32_t c = 0; c != num_channels; ++c) {
+      ChannelInt16ToFloat(in.data(), num_frames, num_channels, c, out.data());
+
+      for (int32_t i = 0; i != num_frames; ++i) {
+        EXPECT_EQ(out[i], in[i * num_channels + c] / 32768.0f)
+            << "channel " << c << ", frame " << i << ", num_channels "
+            << num_channels;
+      }
+    }
+  }
+}
+
+TEST(PcmConverter, Resample) {
+  int32_t num_frames = 480;
+  int32_t num_chunks = 5;
+
+  // Stereo 48 kHz. Only the second channel is converted.
+  std::vector<int16_t> in(num_frames * num_chunks * 2);
+  std::vector<float> expected_in(num_frames * num_chunks);
+  for (int32_t i = 0; i != num_frames * num_chunks; ++i) {
+    auto x = static_cast<int16_t>(10000 * std::sin(i * 0.01f));
+    in[2 * i] = 0;
+    in[2 * i + 1] = x;
+    expected_in[i] = x / 32768.0f;
+  }
+
+  PcmConverter converter(2, 1, 48000, 16000);
+  EXPECT_TRUE(converter.IsResampling());
+
+  float min_freq = 16000;
+  LinearResample resampler(48000, 16000, 0.99 * 0.5 * min_freq, 6);
+
+  std::vector<float> out;
+  std::vector<float> expected;
+  for (int32_t k = 0; k != num_chunks; ++k) {
+    out.resize(converter.MaxOutputSize(num_frames));
+    int32_t n = converter.Convert(in.data() + k * num_frames * 2, num_frames,
+                                  out.data());
+    ASSERT_LE(n, static_cast<int32_t>(out.size()));
+
+    resampler.Resample(expected_in.data() + k * num_frames, num_frames, false,
+                       &expected);
+    ASSERT_EQ(n, static_cast<int32_t>(expected.size()));
+
+    for (int32_t i = 0; i != n; ++i) {
+      EXPECT_NEAR(out[i], expected[i], 1e-5) << "chunk " << k << ", sample " << i;
+    }
+  }
+}
+
+TEST(PcmConverter, NoResample) {
+  std::vector<int16_t> in = {1, 2, 3, 4, 5, 6};
+  PcmConverter converter(1, 0, 16000, 16000);
+  EXPECT_FALSE(converter.IsResampling());
+  EXPECT_EQ(converter.MaxOutputSize(6), 6);
+
+  std::vector<float> out(6);
+  EXPECT_EQ(converter.Convert(in.data(), 6, out.data()), 6);
+  for (int32_t i = 0; i != 6; ++i) {
+    EXPECT_EQ(out[i], in[i] / 32768.0f);
+  }
+}
+
+}  // namespace sherpa_onnx
@@ -0,0 +1,195 @@
+// sherpa-onnx/csrc/pcm-convert.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/pcm-convert.h"
+
+#include <algorithm>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SHERPA_ONNX_PCM_CONVERT_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SHERPA_ONNX_PCM_CONVERT_SSE2 1
+#endif
+
+namespace sherpa_onnx {
+
+namespace {
+
+constexpr float kScale = 1.0f / 32768;
+
+#if SHERPA_ONNX_PCM_CONVERT_NEON
+
+// Convert 8 samples to float and store them to out
+inline void Store8(int16x8_t v, float *out) {
+  float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+  float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v)));
+  vst1q_f32(out, vmulq_n_f32(lo, kScale));
+  vst1q_f32(out + 4, vmulq_n_f32(hi, kScale));
+}
+
+// Return the number of frames processed. The rest is left to the caller.
+int32_t DeinterleaveNeon(const int16_t *in, int32_t num_frames,
+                         int32_t num_channels, float *const *out) {
+  int32_t i = 0;
+  switch (num_channels) {
+    case 2:
+      for (; i + 8 <= num_frames; i += 8) {
+        int16x8x2_t v = vld2q_s16(in + i * 2);
+        Store8(v.val[0], out[0] + i);
+        Store8(v.val[1], out[1] + i);
+      }
+      break;
+    case 4:
+      for (; i + 8 <= num_frames; i += 8) {
+        int16x8x4_t v = vld4q_s16(in + i * 4);
+        for (int32_t c = 0; c != 4; ++c) {
+          Store8(v.val[c], out[c] + i);
+        }
+      }
+      break;
+    case 8:
+      for (; i + 8 <= num_frames; i += 8) {
+        // Each vld4q covers 4 frames. Even lanes of val[c] are channel c
+        // and odd lanes are channel c + 4, so unzipping the two loads
+        // gives 8 frames of both channels.
+        int16x8x4_t a = vld4q_s16(in + i * 8);
+        int16x8x4_t b = vld4q_s16(in + i * 8 + 32);
+        for (int32_t c = 0; c != 4; ++c) {
+          int16x8x2_t u = vuzpq_s16(a.val[c], b.val[c]);
+          Store8(u.val[0], out[c] + i);
+          Store8(u.val[1], out[c + 4] + i);
+        }
+      }
+      break;
+    default:
+      break;
+  }
+
+  return i;
+}
+
+#endif
+
+}  // namespace
+
+void Int16ToFloat(const int16_t *in, int32_t n, float *out) {
+  int32_t i = 0;
+
+#if SHERPA_ONNX_PCM_CONVERT_NEON
+  for (; i + 8 <= n; i += 8) {
+    Store8(vld1q_s16(in + i), out + i);
+  }
+#elif SHERPA_ONNX_PCM_CONVERT_SSE2
+  const __m128 scale = _mm_set1_ps(kScale);
+  for (; i + 8 <= n; i += 8) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+
+    // Sign-extend to 32 bits by putting each sample in the upper half
+    __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+    __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+
+    _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+    _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+  }
+#endif
+
+  for (; i < n; ++i) {
+    out[i] = in[i] * kScale;
+  }
+}
+
+void DeinterleaveInt16ToFloat(const int16_t *in, int32_t num_frames,
+                              int32_t num_channels, float *const *out) {
+  if (num_channels == 1) {
+    Int16ToFloat(in, num_frames, out[0]);
+    return;
+  }
+
+  int32_t i = 0;
+
+#if SHERPA_ONNX_PCM_CONVERT_NEON
+  i = DeinterleaveNeon(in, num_frames, num_channels, out);
+#endif
+
+  for (; i < num_frames; ++i) {
+    const int16_t *p = in + i * num_channels;
+    for (int32_t c = 0; c != num_channels; ++c) {
+      out[c][i] = p[c] * kScale;
+    }
+  }
+}
+
+void ChannelInt16ToFloat(const int16_t *in, int32_t num_frames,
+                         int32_t num_channels, int32_t channel, float *out) {
+  if (num_channels == 1) {
+    Int16ToFloat(in, num_frames, out);
+    return;
+  }
+
+  int32_t i = 0;
+
+  // Stereo devices are the common case when mono is not supported
+  if (num_channels == 2) {
+#if SHERPA_ONNX_PCM_CONVERT_NEON
+    for (; i + 8 <= num_frames; i += 8) {
+      Store8(vld2q_s16(in + i * 2).val[channel], out + i);
+    }
+#elif SHERPA_ONNX_PCM_CONVERT_SSE2
+    const __m128 scale = _mm_set1_ps(kScale);
+    for (; i + 4 <= num_frames; i += 4) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i * 2));
+
+      // Each 32-bit lane is one frame. Channel 0 is in the lower half.
+      __m128i x = channel == 0 ? _mm_srai_epi32(_mm_slli_epi32(v, 16), 16)
+                               : _mm_srai_epi32(v, 16);
+
+      _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(x), scale));
+    }
+#endif
+  }
+
+  for (; i < num_frames; ++i) {
+    out[i] = in[i * num_channels + channel] * kScale;
+  }
+}
+
+PcmConverter::PcmConverter(int32_t num_channels, int32_t channel,
+                           int32_t in_sample_rate, int32_t out_sample_rate)
+    : num_channels_(num_channels), channel_(channel) {
+  if (in_sample_rate != out_sample_rate) {
+    float min_freq = std::min(in_sample_rate, out_sample_rate);
+    float lowpass_cutoff = 0.99 * 0.5 * min_freq;
+
+    int32_t lowpass_filter_width = 6;
+    resampler_ = std::make_unique<PolyphaseResample>(
+        in_sample_rate, out_sample_rate, lowpass_cutoff, lowpass_filter_width);
+  }
+}
+
+int32_t PcmConverter::MaxOutputSize(int32_t num_frames) const {
+  return resampler_ ? resampler_->MaxOutputSamples(num_frames) : num_frames;
+}
+
+int32_t PcmConverter::Convert(const int16_t *in, int32_t num_frames,
+                              float *out) {
+  if (!resampler_) {
+    ChannelInt16ToFloat(in, num_frames, num_channels_, channel_, out);
+    return num_frames;
+  }
+
+  // It only grows to the largest period
+  if (static_cast<int32_t>(scratch_.size()) < num_frames) {
+    scratch_.resize(num_frames);
+  }
+
+  ChannelInt16ToFloat(in, num_frames, num_channels_, channel_,
+                      scratch_.data());
+
+  return resampler_->Resample(scratch_.data(), num_frames, false, out);
+}
+
+}  // namespace sherpa_onnx
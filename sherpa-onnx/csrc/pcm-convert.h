@@ -0,0 +1,94 @@
+// sherpa-onnx/csrc/pcm-convert.h
+//
+// Copyright (c)  2025  Xiaomi Corporation
+#ifndef SHERPA_ONNX_CSRC_PCM_CONVERT_H_
+#define SHERPA_ONNX_CSRC_PCM_CONVERT_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "sherpa-onnx/csrc/polyphase-resample.h"
+
+namespace sherpa_onnx {
+
+/** Convert 16-bit PCM samples to float samples in the range [-1, 1).
+ *
+ * @param in  Pointer to an array of n samples.
+ * @param n   Number of samples.
+ * @param out Pointer to an array of n floats. It must not overlap with in.
+ */
+void Int16ToFloat(const int16_t *in, int32_t n, float *out);
+
+/** De-interleave 16-bit PCM samples and convert them to float samples in
+ * the range [-1, 1) in a single pass.
+ *
+ * It uses NEON for 2, 4 and 8 channels if available.
+ *
+ * @param in  Pointer to an array of num_frames * num_channels samples.
+ *            Sample i of channel c is in[i * num_channels + c].
+ * @param num_frames Number of samples per channel.
+ * @param num_channels Number of channels.
+ * @param out Array of num_channels pointers. out[c] points to an array of
+ *            num_frames floats that receives channel c.
+ */
+void DeinterleaveInt16ToFloat(const int16_t *in, int32_t num_frames,
+                              int32_t num_channels, float *const *out);
+
+/** Convert one channel of interleaved 16-bit PCM samples to float samples
+ * in the range [-1, 1).
+ *
+ * @param in  Pointer to an array of num_frames * num_channels samples.
+ * @param num_frames Number of samples per channel.
+ * @param num_channels Number of channels.
+ * @param channel The channel to convert, starting from 0.
+ * @param out Pointer to an array of num_frames floats.
+ */
+void ChannelInt16ToFloat(const int16_t *in, int32_t num_frames,
+                         int32_t num_channels, int32_t channel, float *out);
+
+/** Convert captured 16-bit PCM to float samples of one channel at the
+ * sample rate of the model.
+ *
+ * Samples are converted into a scratch buffer that is reused across calls
+ * and then resampled directly into the buffer of the caller, so there is
+ * no other intermediate copy.
+ */
+class PcmConverter {
+ public:
+  /**
+   * @param num_channels Number of interleaved channels of the input.
+   * @param channel The channel to convert, starting from 0.
+   * @param in_sample_rate Sample rate of the input.
+   * @param out_sample_rate Sample rate of the output. If it differs from
+   *                        in_sample_rate, the output is resampled.
+   */
+  PcmConverter(int32_t num_channels, int32_t channel, int32_t in_sample_rate,
+               int32_t out_sample_rate);
+
+  /** Return the maximum number of samples written by the next call to
+   * Convert() with num_frames frames.
+   */
+  int32_t MaxOutputSize(int32_t num_frames) const;
+
+  /**
+   * @param in  Pointer to an array of num_frames * num_channels samples.
+   * @param num_frames Number of frames in the input.
+   * @param out Pointer to an array with room for at least
+   *            MaxOutputSize(num_frames) floats.
+   * @return Return the number of samples written to out.
+   */
+  int32_t Convert(const int16_t *in, int32_t num_frames, float *out);
+
+  bool IsResampling() const { return resampler_ != nullptr; }
+
+ private:
+  int32_t num_channels_;
+  int32_t channel_;
+  std::unique_ptr<PolyphaseResample> resampler_;
+  std::vector<float> scratch_;
+};
+
+}  // namespace sherpa_onnx
+
+#endif  // SHERPA_ONNX_CSRC_PCM_CONVERT_H_
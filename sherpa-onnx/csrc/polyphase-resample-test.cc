@@ -0,0 +1,90 @@
+// sherpa-onnx/csrc/polyphase-resample-test.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/polyphase-resample.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "sherpa-onnx/csrc/resample.h"
+
+namespace sherpa_onnx {
+
+static void CheckSameAsLinearResample(int32_t in_rate, int32_t out_rate) {
+  float min_freq = std::min(in_rate, out_rate);
+  float lowpass_cutoff = 0.99 * 0.5 * min_freq;
+  int32_t lowpass_filter_width = 6;
+
+  LinearResample expected_resampler(in_rate, out_rate, lowpass_cutoff,
+                                    lowpass_filter_width);
+  PolyphaseResample resampler(in_rate, out_rate, lowpass_cutoff,
+                              lowpass_filter_width);
+
+  std::mt19937 gen(in_rate + out_rate);
+  std::uniform_real_distribution<float> dist(-1, 1);
+  std::uniform_int_distribution<int32_t> chunk_dist(0, 1000);
+
+  std::vector<float> expected;
+  std::vector<float> out;
+
+  // Two signals, to check that state is reset by flush
+  for (int32_t s = 0; s != 2; ++s) {
+    for (int32_t k = 0; k != 20; ++k) {
+      // Includes empty and very short chunks
+      std::vector<float> in(chunk_dist(gen) / (k % 3 + 1));
+      for (auto &x : in) {
+        x = dist(gen);
+      }
+
+      bool flush = k == 19;
+      expected_resampler.Resample(in.data(), in.size(), flush, &expected);
+      resampler.Resample(in.data(), in.size(), flush, &out);
+
+      ASSERT_EQ(out.size(), expected.size())
+          << in_rate << " -> " << out_rate << ", chunk " << k;
+
+      for (size_t i = 0; i != out.size(); ++i) {
+        EXPECT_NEAR(out[i], expected[i], 1e-5)
+            << in_rate << " -> " << out_rate << ", chunk " << k
+            << ", sample " << i;
+      }
+    }
+  }
+}
+
+TEST(PolyphaseResample, Downsample) {
+  CheckSameAsLinearResample(48000, 16000);
+  CheckSameAsLinearResample(44100, 16000);
+  CheckSameAsLinearResample(22050, 16000);
+}
+
+TEST(PolyphaseResample, Upsample) {
+  CheckSameAsLinearResample(8000, 16000);
+  CheckSameAsLinearResample(11025, 16000);
+}
+
+TEST(PolyphaseResample, BufferOutput) {
+  PolyphaseResample resampler(48000, 16000, 0.99 * 0.5 * 16000, 6);
+  EXPECT_EQ(resampler.GetInputSamplingRate(), 48000);
+  EXPECT_EQ(resampler.GetOutputSamplingRate(), 16000);
+  EXPECT_EQ(resampler.NumTaps() % 8, 0);
+
+  std::vector<float> in(480, 0.5);
+  int64_t total = 0;
+  for (int32_t k = 0; k != 10; ++k) {
+    std::vector<float> out(resampler.MaxOutputSamples(in.size()));
+    int32_t n = resampler.Resample(in.data(), in.size(), false, out.data());
+    EXPECT_LE(n, static_cast<int32_t>(out.size()));
+    total += n;
+  }
+
+  // A 3:1 ratio, minus the look-ahead of the filter
+  EXPECT_GT(total, 1600 - 20);
+  EXPECT_LE(total, 1600);
+}
+
+}  // namespace sherpa_onnx
@@ -0,0 +1,350 @@
+// sherpa-onnx/csrc/polyphase-resample.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/polyphase-resample.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <mutex>  // NOLINT
+#include <tuple>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SHERPA_ONNX_POLYPHASE_NEON 1
+#elif defined(__AVX__)
+#include <immintrin.h>
+#define SHERPA_ONNX_POLYPHASE_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SHERPA_ONNX_POLYPHASE_SSE2 1
+#endif
+
+#ifndef M_2PI
+#define M_2PI 6.283185307179586476925286766559005
+#endif
+
+#ifndef M_PI
+#define M_PI 3.1415926535897932384626433832795
+#endif
+
+namespace sherpa_onnx {
+
+namespace {
+
+// Taps of each phase are padded to a multiple of it, so the inner product
+// has no tail. It is also the alignment of each phase in floats.
+constexpr int32_t kTapAlignment = 8;
+
+int32_t Gcd(int32_t m, int32_t n) {
+  while (n != 0) {
+    int32_t t = m % n;
+    m = n;
+    n = t;
+  }
+  return m;
+}
+
+// The same as LinearResample::FilterFunc(), including the mix of float
+// and double, so that the weights are identical.
+float FilterFunc(float t, float filter_cutoff, int32_t num_zeros) {
+  float window = 0, filter = 0;
+  if (std::fabs(t) < num_zeros / (2.0 * filter_cutoff))
+    window = 0.5 * (1 + cos(M_2PI * filter_cutoff / num_zeros * t));
+  else
+    window = 0.0;
+  if (t != 0)
+    filter = sin(M_2PI * filter_cutoff * t) / (M_PI * t);
+  else
+    filter = 2 * filter_cutoff;
+  return filter * window;
+}
+
+// n must be a multiple of kTapAlignment. w must be aligned to
+// kTapAlignment floats.
+inline float DotProduct(const float *x, const float *w, int32_t n) {
+#if SHERPA_ONNX_POLYPHASE_NEON
+  float32x4_t acc0 = vdupq_n_f32(0);
+  float32x4_t acc1 = vdupq_n_f32(0);
+  for (int32_t i = 0; i != n; i += 8) {
+    acc0 = vmlaq_f32(acc0, vld1q_f32(x + i), vld1q_f32(w + i));
+    acc1 = vmlaq_f32(acc1, vld1q_f32(x + i + 4), vld1q_f32(w + i + 4));
+  }
+  float32x4_t acc = vaddq_f32(acc0, acc1);
+  float32x2_t s = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+  return vget_lane_f32(vpadd_f32(s, s), 0);
+#elif SHERPA_ONNX_POLYPHASE_AVX
+  __m256 acc = _mm256_setzero_ps();
+  for (int32_t i = 0; i != n; i += 8) {
+    acc = _mm256_add_ps(
+        acc, _mm256_mul_ps(_mm256_loadu_ps(x + i), _mm256_load_ps(w + i)));
+  }
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(acc),
+                        _mm256_extractf128_ps(acc, 1));
+  s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+  s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+  return _mm_cvtss_f32(s);
+#elif SHERPA_ONNX_POLYPHASE_SSE2
+  __m128 acc0 = _mm_setzero_ps();
+  __m128 acc1 = _mm_setzero_ps();
+  for (int32_t i = 0; i != n; i += 8) {
+    acc0 = _mm_add_ps(acc0,
+                      _mm_mul_ps(_mm_loadu_ps(x + i), _mm_load_ps(w + i)));
+    acc1 = _mm_add_ps(
+        acc1, _mm_mul_ps(_mm_loadu_ps(x + i + 4), _mm_load_ps(w + i + 4)));
+  }
+  __m128 s = _mm_add_ps(acc0, acc1);
+  s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+  s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+  return _mm_cvtss_f32(s);
+#else
+  float sum = 0;
+  for (int32_t i = 0; i != n; ++i) {
+    sum += x[i] * w[i];
+  }
+  return sum;
+#endif
+}
+
+}  // namespace
+
+class PolyphaseFilterBank {
+ public:
+  PolyphaseFilterBank(int32_t samp_rate_in, int32_t samp_rate_out,
+                      float filter_cutoff, int32_t num_zeros)
+      : samp_rate_in_(samp_rate_in),
+        samp_rate_out_(samp_rate_out),
+        filter_cutoff_(filter_cutoff),
+        num_zeros_(num_zeros) {
+    int32_t base_freq = Gcd(samp_rate_in, samp_rate_out);
+    input_samples_in_unit_ = samp_rate_in / base_freq;
+    output_samples_in_unit_ = samp_rate_out / base_freq;
+
+    // The same as LinearResample::SetIndexesAndWeights()
+    double window_width = num_zeros / (2.0 * filter_cutoff);
+
+    std::vector<std::vector<float>> weights(output_samples_in_unit_);
+    first_index_.resize(output_samples_in_unit_);
+
+    int32_t max_taps = 0;
+    for (int32_t i = 0; i < output_samples_in_unit_; ++i) {
+      double output_t = i / static_cast<double>(samp_rate_out);
+      double min_t = output_t - window_width, max_t = output_t + window_width;
+      int32_t min_input_index = ceil(min_t * samp_rate_in),
+              max_input_index = floor(max_t * samp_rate_in),
+              num_indices = max_input_index - min_input_index + 1;
+      first_index_[i] = min_input_index;
+      weights[i].resize(num_indices);
+      for (int32_t j = 0; j < num_indices; ++j) {
+        int32_t input_index = min_input_index + j;
+        double input_t = input_index / static_cast<double>(samp_rate_in),
+               delta_t = input_t - output_t;
+        weights[i][j] =
+            FilterFunc(delta_t, filter_cutoff, num_zeros) / samp_rate_in;
+      }
+      max_taps = std::max(max_taps, num_indices);
+    }
+
+    num_taps_ = (max_taps + kTapAlignment - 1) / kTapAlignment * kTapAlignment;
+
+    // Over-allocate so that the table can start at an aligned address
+    storage_.resize(output_samples_in_unit_ * num_taps_ + kTapAlignment);
+    auto addr = reinterpret_cast<uintptr_t>(storage_.data());
+    size_t align = kTapAlignment * sizeof(float);
+    size_t offset = (align - addr % align) % align / sizeof(float);
+    float *table = storage_.data() + offset;
+
+    for (int32_t i = 0; i < output_samples_in_unit_; ++i) {
+      std::copy(weights[i].begin(), weights[i].end(), table + i * num_taps_);
+    }
+    table_ = table;
+  }
+
+  // Filter banks are shared by all resamplers with the same arguments
+  static std::shared_ptr<const PolyphaseFilterBank> Get(int32_t samp_rate_in,
+                                                        int32_t samp_rate_out,
+                                                        float filter_cutoff,
+                                                        int32_t num_zeros) {
+    using Key = std::tuple<int32_t, int32_t, float, int32_t>;
+    static std::mutex mutex;
+    static std::map<Key, std::weak_ptr<const PolyphaseFilterBank>> cache;
+
+    Key key{samp_rate_in, samp_rate_out, filter_cutoff, num_zeros};
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto bank = cache[key].lock();
+    if (!bank) {
+      bank = std::make_shared<const PolyphaseFilterBank>(
+          samp_rate_in, samp_rate_out, filter_cutoff, num_zeros);
+      cache[key] = bank;
+    }
+    return bank;
+  }
+
+  PolyphaseFilterBank(const PolyphaseFilterBank &) = delete;
+  PolyphaseFilterBank &operator=(const PolyphaseFilterBank &) = delete;
+
+  int32_t samp_rate_in_;
+  int32_t samp_rate_out_;
+  float filter_cutoff_;
+  int32_t num_zeros_;
+
+  int32_t input_samples_in_unit_;
+  int32_t output_samples_in_unit_;
+
+  int32_t num_taps_;
+  std::vector<int32_t> first_index_;
+
+  // Row i, i.e., the weights of phase i, starts at table_ + i * num_taps_
+  const float *table_ = nullptr;
+
+ private:
+  std::vector<float> storage_;
+};
+
+PolyphaseResample::PolyphaseResample(int32_t samp_rate_in_hz,
+                                     int32_t samp_rate_out_hz,
+                                     float filter_cutoff_hz, int32_t num_zeros)
+    : bank_(PolyphaseFilterBank::Get(samp_rate_in_hz, samp_rate_out_hz,
+                                     filter_cutoff_hz, num_zeros)) {
+  assert(samp_rate_in_hz > 0.0 && samp_rate_out_hz > 0.0 &&
+         filter_cutoff_hz > 0.0 && filter_cutoff_hz * 2 <= samp_rate_in_hz &&
+         filter_cutoff_hz * 2 <= samp_rate_out_hz && num_zeros > 0);
+  Reset();
+}
+
+PolyphaseResample::~PolyphaseResample() = default;
+
+int32_t PolyphaseResample::GetInputSamplingRate() const {
+  return bank_->samp_rate_in_;
+}
+
+int32_t PolyphaseResample::GetOutputSamplingRate() const {
+  return bank_->samp_rate_out_;
+}
+
+int32_t PolyphaseResample::NumTaps() const { return bank_->num_taps_; }
+
+void PolyphaseResample::Reset() {
+  input_sample_offset_ = 0;
+  output_sample_offset_ = 0;
+
+  // The first output sample has the smallest input index. Inputs before
+  // the start of the signal are zeros.
+  history_start_ = std::min(bank_->first_index_[0], 0);
+  history_size_ = static_cast<int32_t>(-history_start_);
+  history_.assign(history_size_ + bank_->num_taps_, 0);
+}
+
+void PolyphaseResample::Resample(const float *input, int32_t input_dim,
+                                 bool flush, std::vector<float> *output) {
+  output->resize(MaxOutputSamples(input_dim));
+  int32_t n = Resample(input, input_dim, flush, output->data());
+  output->resize(n);
+}
+
+int32_t PolyphaseResample::MaxOutputSamples(int32_t input_dim) const {
+  return static_cast<int32_t>(
+      GetNumOutputSamples(input_sample_offset_ + input_dim, true) -
+      output_sample_offset_);
+}
+
+int32_t PolyphaseResample::Resample(const float *input, int32_t input_dim,
+                                    bool flush, float *output) {
+  int64_t tot_input_samp = input_sample_offset_ + input_dim,
+          tot_output_samp = GetNumOutputSamples(tot_input_samp, flush);
+
+  assert(tot_output_samp >= output_sample_offset_);
+
+  int32_t num_taps = bank_->num_taps_;
+
+  // Append the input and keep num_taps zeros after it. With flush, they
+  // are also the zeros past the end of the signal.
+  if (static_cast<int32_t>(history_.size()) <
+      history_size_ + input_dim + num_taps) {
+    history_.resize(history_size_ + input_dim + num_taps);
+  }
+  std::copy(input, input + input_dim, history_.begin() + history_size_);
+  history_size_ += input_dim;
+  std::fill(history_.begin() + history_size_,
+            history_.begin() + history_size_ + num_taps, 0);
+
+  const float *table = bank_->table_;
+  const float *history = history_.data();
+
+  for (int64_t samp_out = output_sample_offset_; samp_out < tot_output_samp;
+       ++samp_out) {
+    int32_t samp_out_wrapped = 0;
+    int64_t first = FirstInputIndex(samp_out, &samp_out_wrapped);
+
+    output[samp_out - output_sample_offset_] =
+        DotProduct(history + (first - history_start_),
+                   table + samp_out_wrapped * num_taps, num_taps);
+  }
+
+  int32_t num_output_samp =
+      static_cast<int32_t>(tot_output_samp - output_sample_offset_);
+
+  if (flush) {
+    Reset();
+    return num_output_samp;
+  }
+
+  input_sample_offset_ = tot_input_samp;
+  output_sample_offset_ = tot_output_samp;
+
+  // Drop inputs that no later output sample needs
+  int32_t unused = 0;
+  int64_t next_first = FirstInputIndex(tot_output_samp, &unused);
+  int64_t num_dropped =
+      std::min<int64_t>(next_first - history_start_, history_size_);
+  if (num_dropped > 0) {
+    std::memmove(history_.data(), history_.data() + num_dropped,
+                 (history_size_ - num_dropped) * sizeof(float));
+    history_start_ += num_dropped;
+    history_size_ -= static_cast<int32_t>(num_dropped);
+  }
+
+  return num_output_samp;
+}
+
+int64_t PolyphaseResample::FirstInputIndex(int64_t samp_out,
+                                           int32_t *samp_out_wrapped) const {
+  int64_t unit_index = samp_out / bank_->output_samples_in_unit_;
+  *samp_out_wrapped = static_cast<int32_t>(
+      samp_out - unit_index * bank_->output_samples_in_unit_);
+  return bank_->first_index_[*samp_out_wrapped] +
+         unit_index * bank_->input_samples_in_unit_;
+}
+
+// The same as LinearResample::GetNumOutputSamples()
+int64_t PolyphaseResample::GetNumOutputSamples(int64_t input_num_samp,
+                                               bool flush) const {
+  int32_t samp_rate_in = bank_->samp_rate_in_;
+  int32_t samp_rate_out = bank_->samp_rate_out_;
+
+  int32_t gcd = Gcd(samp_rate_in, samp_rate_out);
+  int32_t tick_freq = gcd * (samp_rate_in / gcd) * (samp_rate_out / gcd);
+  int32_t ticks_per_input_period = tick_freq / samp_rate_in;
+
+  int64_t interval_length_in_ticks = input_num_samp * ticks_per_input_period;
+  if (!flush) {
+    float window_width = bank_->num_zeros_ / (2.0 * bank_->filter_cutoff_);
+    int32_t window_width_ticks = std::floor(window_width * tick_freq);
+    interval_length_in_ticks -= window_width_ticks;
+  }
+  if (interval_length_in_ticks <= 0) return 0;
+
+  int32_t ticks_per_output_period = tick_freq / samp_rate_out;
+  int64_t last_output_samp = interval_length_in_ticks / ticks_per_output_period;
+  if (last_output_samp * ticks_per_output_period == interval_length_in_ticks)
+    last_output_samp--;
+
+  return last_output_samp + 1;
+}
+
+}  // namespace sherpa_onnx
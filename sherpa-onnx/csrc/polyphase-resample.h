@@ -0,0 +1,80 @@
+// sherpa-onnx/csrc/polyphase-resample.h
+//
+// Copyright (c)  2025  Xiaomi Corporation
+#ifndef SHERPA_ONNX_CSRC_POLYPHASE_RESAMPLE_H_
+#define SHERPA_ONNX_CSRC_POLYPHASE_RESAMPLE_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace sherpa_onnx {
+
+class PolyphaseFilterBank;
+
+/** A drop-in replacement for LinearResample.
+ *
+ * It uses the same windowed-sinc filter as LinearResample, so the output
+ * matches it up to rounding, but the filter of each phase is padded to the
+ * same number of taps and stored in one aligned table. The table is
+ * computed once per (rates, cutoff, num_zeros) and shared by all
+ * resamplers in the process, e.g., by all streams of a server.
+ *
+ * Input is appended to a history buffer, so every output sample is a
+ * single contiguous dot product computed with NEON, AVX or SSE, without
+ * the edge cases of LinearResample.
+ */
+class PolyphaseResample {
+ public:
+  /// See LinearResample for the meaning of the arguments
+  PolyphaseResample(int32_t samp_rate_in_hz, int32_t samp_rate_out_hz,
+                    float filter_cutoff_hz, int32_t num_zeros);
+
+  ~PolyphaseResample();
+
+  /// Same as LinearResample::Reset()
+  void Reset();
+
+  /// Same as LinearResample::Resample()
+  void Resample(const float *input, int32_t input_dim, bool flush,
+                std::vector<float> *output);
+
+  /// Same as the above, but it writes to a caller-supplied buffer, which
+  /// must have room for at least MaxOutputSamples(input_dim) samples.
+  /// Returns the number of samples written to output.
+  int32_t Resample(const float *input, int32_t input_dim, bool flush,
+                   float *output);
+
+  /// Return an upper bound on the number of output samples of the next
+  /// call to Resample() with input_dim input samples.
+  int32_t MaxOutputSamples(int32_t input_dim) const;
+
+  int32_t GetInputSamplingRate() const;
+  int32_t GetOutputSamplingRate() const;
+
+  /// Number of taps of each phase, after padding
+  int32_t NumTaps() const;
+
+ private:
+  int64_t GetNumOutputSamples(int64_t input_num_samp, bool flush) const;
+
+  // Return the index of the first input sample of the given output sample
+  int64_t FirstInputIndex(int64_t samp_out, int32_t *samp_out_wrapped) const;
+
+ private:
+  std::shared_ptr<const PolyphaseFilterBank> bank_;
+
+  int64_t input_sample_offset_ = 0;
+  int64_t output_sample_offset_ = 0;
+
+  // history_[i] is input sample history_start_ + i. Samples before the
+  // start of the signal are zeros. It is followed by NumTaps() zeros so
+  // that the padded taps never read past the end.
+  std::vector<float> history_;
+  int64_t history_start_ = 0;
+  int32_t history_size_ = 0;
+};
+
+}  // namespace sherpa_onnx
+
+#endif  // SHERPA_ONNX_CSRC_POLYPHASE_RESAMPLE_H_
@@ -0,0 +1,102 @@
+// sherpa-onnx/csrc/resample-benchmark.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+// Compare the throughput of LinearResample from resample.h with
+// PolyphaseResample from polyphase-resample.h for the capture rates of our
+// devices.
+//
+// Usage:
+//
+//   ./bin/resample-benchmark [seconds]
+//
+// Each rate pair resamples `seconds` (default 60) of noise for one channel
+// in 10 ms chunks, as the capture thread does.
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "sherpa-onnx/csrc/polyphase-resample.h"
+#include "sherpa-onnx/csrc/resample.h"
+
+namespace {
+
+// @return Return the elapsed time in seconds and the sum of the output, so
+//         that the work is not optimized away
+template <typename Resampler>
+double Run(Resampler *resampler, const std::vector<float> &input,
+           int32_t chunk_size, std::vector<float> *output, float *sum) {
+  auto start = std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < input.size(); i += chunk_size) {
+    int32_t n = std::min<int32_t>(chunk_size, input.size() - i);
+    resampler->Resample(input.data() + i, n, false, output);
+    if (!output->empty()) {
+      *sum += (*output)[0];
+    }
+  }
+
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+}  // namespace
+
+int main(int32_t argc, char *argv[]) {
+  float seconds = 60;
+  if (argc > 1) {
+    seconds = atof(argv[1]);
+  }
+
+  int32_t out_rate = 16000;
+  int32_t lowpass_filter_width = 6;
+
+  fprintf(stderr, "Resampling %.0f seconds of one channel in 10 ms chunks\n",
+          seconds);
+  fprintf(stderr, "%-16s %-10s %14s %14s %10s\n", "rates", "resampler",
+          "Msamples/s", "x realtime", "speedup");
+
+  for (int32_t in_rate : {48000, 44100, 22050, 8000}) {
+    std::vector<float> input(static_cast<int64_t>(seconds * in_rate));
+    std::mt19937 gen(in_rate);
+    std::uniform_real_distribution<float> dist(-1, 1);
+    for (auto &x : input) {
+      x = dist(gen);
+    }
+
+    int32_t chunk_size = in_rate / 100;
+    float min_freq = std::min(in_rate, out_rate);
+    float lowpass_cutoff = 0.99 * 0.5 * min_freq;
+
+    std::vector<float> output;
+    float sum = 0;
+
+    sherpa_onnx::LinearResample linear(in_rate, out_rate, lowpass_cutoff,
+                                       lowpass_filter_width);
+    double linear_time = Run(&linear, input, chunk_size, &output, &sum);
+
+    sherpa_onnx::PolyphaseResample polyphase(in_rate, out_rate, lowpass_cutoff,
+                                             lowpass_filter_width);
+    double polyphase_time = Run(&polyphase, input, chunk_size, &output, &sum);
+
+    char rates[32];
+    snprintf(rates, sizeof(rates), "%d->%d", in_rate, out_rate);
+
+    fprintf(stderr, "%-16s %-10s %14.2f %14.1f %10s\n", rates, "linear",
+            input.size() / linear_time / 1e6, seconds / linear_time, "");
+    fprintf(stderr, "%-16s %-10s %14.2f %14.1f %9.2fx\n", rates, "polyphase",
+            input.size() / polyphase_time / 1e6, seconds / polyphase_time,
+            linear_time / polyphase_time);
+
+    if (std::isnan(sum)) {
+      fprintf(stderr, "Unexpected NaN\n");
+    }
+  }
+
+  return 0;
+}
@@ -160,12 +160,28 @@ void LinearResample::Reset() {
 
 void LinearResample::Resample(const float *input, int32_t input_dim, bool flush,
                               std::vector<float> *output) {
+  output->resize(MaxOutputSamples(input_dim));
+  int32_t n = Resample(input, input_dim, flush, output->data());
+  output->resize(n);
+}
+
+int32_t LinearResample::MaxOutputSamples(int32_t input_dim) const {
+  // The number of output samples with flush == true is never less than
+  // the one with flush == false
+  return static_cast<int32_t>(
+      GetNumOutputSamples(input_sample_offset_ + input_dim, true) -
+      output_sample_offset_);
+}
+
+int32_t LinearResample::Resample(const float *input, int32_t input_dim,
+                                 bool flush, float *output) {
   int64_t tot_input_samp = input_sample_offset_ + input_dim,
           tot_output_samp = GetNumOutputSamples(tot_input_samp, flush);
 
   assert(tot_output_samp >= output_sample_offset_);
 
-  output->resize(tot_output_samp - output_sample_offset_);
+  int32_t num_output_samp =
+      static_cast<int32_t>(tot_output_samp - output_sample_offset_);
 
   // samp_out is the index into the total output signal, not just the part
   // of it we are producing here.
@@ -205,7 +221,7 @@ void LinearResample::Resample(const float *input, int32_t input_dim, bool flush,
     }
     int32_t output_index =
         static_cast<int32_t>(samp_out - output_sample_offset_);
-    (*output)[output_index] = this_output;
+    output[output_index] = this_output;
   }
 
   if (flush) {
@@ -215,6 +231,8 @@ void LinearResample::Resample(const float *input, int32_t input_dim, bool flush,
     input_sample_offset_ = tot_input_samp;
     output_sample_offset_ = tot_output_samp;
   }
+
+  return num_output_samp;
 }
 
 int64_t LinearResample::GetNumOutputSamples(int64_t input_num_samp,
@@ -73,6 +73,16 @@ class LinearResample {
   void Resample(const float *input, int32_t input_dim, bool flush,
                 std::vector<float> *output);
 
+  /// Same as the above, but it writes to a caller-supplied buffer, which
+  /// must have room for at least MaxOutputSamples(input_dim) samples.
+  /// Returns the number of samples written to output.
+  int32_t Resample(const float *input, int32_t input_dim, bool flush,
+                   float *output);
+
+  /// Return an upper bound on the number of output samples of the next
+  /// call to Resample() with input_dim input samples.
+  int32_t MaxOutputSamples(int32_t input_dim) const;
+
   //// Return the input and output sampling rates (for checks, for example)
   int32_t GetInputSamplingRate() const { return samp_rate_in_; }
   int32_t GetOutputSamplingRate() const { return samp_rate_out_; }
@@ -30,7 +30,7 @@ OnlineRecognizerResult ConvertCtc(const OnlineCtcDecoderResult &src,
                                   const SymbolTable &sym_table,
                                   float frame_shift_ms,
                                   int32_t subsampling_factor, int32_t segment,
-                                  int32_t frames_since_start);
+                                  int64_t frames_since_start);
 
 class OnlineRecognizerCtcRknnImpl : public OnlineRecognizerImpl {
  public:
@@ -27,7 +27,7 @@ namespace sherpa_onnx {
 OnlineRecognizerResult Convert(const OnlineTransducerDecoderResultRknn &src,
                                const SymbolTable &sym_table,
                                float frame_shift_ms, int32_t subsampling_factor,
-                               int32_t segment, int32_t frames_since_start) {
+                               int32_t segment, int64_t frames_since_start) {
   OnlineRecognizerResult r;
   r.tokens.reserve(src.tokens.size());
   r.timestamps.reserve(src.tokens.size());
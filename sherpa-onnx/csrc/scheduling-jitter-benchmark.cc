@@ -0,0 +1,92 @@
+// sherpa-onnx/csrc/scheduling-jitter-benchmark.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+// Measure how late a capture-like thread wakes up while all CPUs are busy,
+// with the default scheduling and with the affinity and realtime priority
+// from thread-scheduling.h
+//
+// Usage:
+//
+//   ./bin/scheduling-jitter-benchmark [seconds] [capture_cpus] [priority]
+//
+// The capture thread wakes up every 10 ms, like a capture thread with a
+// 160-sample period at 16 kHz, for `seconds` (default 10) per run. One
+// busy thread per CPU stands in for the decoder and the rest of the audio
+// stack. The default is capture_cpus=0 and priority=80. Realtime
+// priorities need root or CAP_SYS_NICE.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "sherpa-onnx/csrc/latency-stats.h"
+#include "sherpa-onnx/csrc/thread-scheduling.h"
+
+namespace {
+
+void Run(float seconds, const std::string &cpus, int32_t priority,
+         sherpa_onnx::LatencyHistogram *lateness) {
+  std::atomic<bool> stop(false);
+
+  std::vector<std::thread> load;
+  int32_t num_cpus = std::max<int32_t>(std::thread::hardware_concurrency(), 1);
+  for (int32_t i = 0; i != num_cpus; ++i) {
+    load.emplace_back([&stop]() {
+      volatile double x = 1;
+      while (!stop.load(std::memory_order_relaxed)) {
+        for (int32_t k = 0; k != 1000; ++k) {
+          x = std::sqrt(x + k);
+        }
+      }
+    });
+  }
+
+  std::thread capture([&]() {
+    sherpa_onnx::ConfigureCurrentThread(cpus, priority, "capture");
+
+    constexpr auto kPeriod = std::chrono::milliseconds(10);
+    auto next = std::chrono::steady_clock::now();
+    auto end = next + std::chrono::duration<float>(seconds);
+
+    while (next < end) {
+      next += kPeriod;
+      std::this_thread::sleep_until(next);
+      lateness->AddSince(next);
+    }
+  });
+
+  capture.join();
+
+  stop = true;
+  for (auto &t : load) {
+    t.join();
+  }
+}
+
+}  // namespace
+
+int main(int32_t argc, char *argv[]) {
+  float seconds = argc > 1 ? atof(argv[1]) : 10;
+  std::string cpus = argc > 2 ? argv[2] : "0";
+  int32_t priority = argc > 3 ? atoi(argv[3]) : 80;
+
+  sherpa_onnx::LatencyHistogram default_lateness("default scheduling");
+  Run(seconds, "", 0, &default_lateness);
+
+  sherpa_onnx::LatencyHistogram configured_lateness(
+      "cpus " + cpus + ", SCHED_FIFO " + std::to_string(priority));
+  Run(seconds, cpus, priority, &configured_lateness);
+
+  printf("Wakeup lateness of a 10 ms periodic thread with all CPUs busy\n");
+  printf("%s\n", default_lateness.ToString().c_str());
+  printf("%s\n", configured_lateness.ToString().c_str());
+
+  return 0;
+}
@@ -0,0 +1,129 @@
+// sherpa-onnx/csrc/session-binding-benchmark.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+// Compare the time per call of a small model, e.g., the joiner of a
+// transducer, run with Ort::Session::Run() and with SessionBinding from
+// session-binding.h
+//
+// Usage:
+//
+//   ./bin/session-binding-benchmark joiner.onnx [batch_size] [num_runs]
+//
+// All inputs must be float tensors. Their first dynamic dimension is set to
+// batch_size (default 4) and other dynamic dimensions to 1.
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "sherpa-onnx/csrc/onnx-utils.h"
+#include "sherpa-onnx/csrc/session-binding.h"
+#include "sherpa-onnx/csrc/session-registry.h"
+#include "sherpa-onnx/csrc/session.h"
+
+namespace {
+
+std::vector<Ort::Value> CreateInputs(Ort::Session *sess, int32_t batch_size) {
+  Ort::AllocatorWithDefaultOptions allocator;
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> dist(-1, 1);
+
+  std::vector<Ort::Value> ans;
+  for (size_t i = 0; i != sess->GetInputCount(); ++i) {
+    auto type_info = sess->GetInputTypeInfo(i);
+    auto tensor_info = type_info.GetTensorTypeAndShapeInfo();
+    if (tensor_info.GetElementType() != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
+      fprintf(stderr, "Input %d is not a float tensor\n",
+              static_cast<int32_t>(i));
+      exit(-1);
+    }
+
+    std::vector<int64_t> shape = tensor_info.GetShape();
+    bool batch_dim_set = false;
+    for (auto &d : shape) {
+      if (d < 0) {
+        d = batch_dim_set ? 1 : batch_size;
+        batch_dim_set = true;
+      }
+    }
+
+    auto v = Ort::Value::CreateTensor<float>(allocator, shape.data(),
+                                             shape.size());
+    float *p = v.GetTensorMutableData<float>();
+    int64_t n = v.GetTensorTypeAndShapeInfo().GetElementCount();
+    for (int64_t k = 0; k != n; ++k) {
+      p[k] = dist(gen);
+    }
+
+    ans.push_back(std::move(v));
+  }
+
+  return ans;
+}
+
+}  // namespace
+
+int main(int32_t argc, char *argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s model.onnx [batch_size] [num_runs]\n",
+            argv[0]);
+    return -1;
+  }
+
+  std::string filename = argv[1];
+  int32_t batch_size = argc > 2 ? atoi(argv[2]) : 4;
+  int32_t num_runs = argc > 3 ? atoi(argv[3]) : 10000;
+
+  auto sess = sherpa_onnx::CreateSessionFromFile(
+      filename, sherpa_onnx::GetSessionOptions(1, "cpu"));
+
+  std::vector<std::string> input_names;
+  std::vector<const char *> input_names_ptr;
+  sherpa_onnx::GetInputNames(sess.get(), &input_names, &input_names_ptr);
+
+  std::vector<std::string> output_names;
+  std::vector<const char *> output_names_ptr;
+  sherpa_onnx::GetOutputNames(sess.get(), &output_names, &output_names_ptr);
+
+  std::vector<Ort::Value> inputs = CreateInputs(sess.get(), batch_size);
+
+  // Warm up
+  sess->Run({}, input_names_ptr.data(), inputs.data(), inputs.size(),
+            output_names_ptr.data(), output_names_ptr.size());
+
+  auto start = std::chrono::steady_clock::now();
+  for (int32_t i = 0; i != num_runs; ++i) {
+    auto out =
+        sess->Run({}, input_names_ptr.data(), inputs.data(), inputs.size(),
+                  output_names_ptr.data(), output_names_ptr.size());
+  }
+  double session_run = std::chrono::duration<double, std::micro>(
+                           std::chrono::steady_clock::now() - start)
+                           .count() /
+                       num_runs;
+
+  sherpa_onnx::SessionBinding binding(sess.get(), input_names, output_names,
+                                      true);
+  binding.Run(inputs.data(), inputs.size());
+
+  start = std::chrono::steady_clock::now();
+  for (int32_t i = 0; i != num_runs; ++i) {
+    auto out = binding.Run(inputs.data(), inputs.size());
+  }
+  double binding_run = std::chrono::duration<double, std::micro>(
+                           std::chrono::steady_clock::now() - start)
+                           .count() /
+                       num_runs;
+
+  printf("model: %s, batch_size: %d, num_runs: %d\n", filename.c_str(),
+         batch_size, num_runs);
+  printf("Ort::Session::Run(): %8.2f us per call\n", session_run);
+  printf("SessionBinding::Run(): %8.2f us per call (%.2fx)\n", binding_run,
+         session_run / binding_run);
+
+  return 0;
+}
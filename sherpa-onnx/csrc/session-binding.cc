@@ -0,0 +1,145 @@
+// sherpa-onnx/csrc/session-binding.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/session-binding.h"
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "sherpa-onnx/csrc/macros.h"
+
+namespace sherpa_onnx {
+
+// Bounds the memory held by preallocated outputs if input shapes keep
+// changing, e.g., the number of hypotheses of a beam search. Calls with new
+// shapes after that fall back to allocating their outputs.
+static constexpr int32_t kMaxSlots = 32;
+
+struct SessionBinding::Slot {
+  Slot(Ort::Session *sess, std::thread::id thread_id,
+       const std::vector<int64_t> &shapes)
+      : thread_id(thread_id), shapes(shapes), binding(*sess) {}
+
+  std::thread::id thread_id;
+
+  // See SessionBinding::shapes_
+  std::vector<int64_t> shapes;
+
+  Ort::IoBinding binding;
+
+  // true if outputs of a previous call are bound to be reused
+  bool has_outputs = false;
+};
+
+SessionBinding::SessionBinding(Ort::Session *sess,
+                               const std::vector<std::string> &input_names,
+                               const std::vector<std::string> &output_names,
+                               bool reuse_outputs)
+    : sess_(sess),
+      input_names_(input_names),
+      output_names_(output_names),
+      reuse_outputs_(reuse_outputs),
+      memory_info_(
+          Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeDefault)) {
+  for (const auto &name : input_names_) {
+    input_names_ptr_.push_back(name.c_str());
+  }
+
+  for (const auto &name : output_names_) {
+    output_names_ptr_.push_back(name.c_str());
+  }
+}
+
+SessionBinding::~SessionBinding() = default;
+
+SessionBinding::Slot *SessionBinding::GetSlot(const Ort::Value *inputs,
+                                              int32_t n) {
+  std::thread::id thread_id = std::this_thread::get_id();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  // shapes_ keeps its capacity, so this does not allocate once it has grown
+  // to the largest shapes seen
+  shapes_.clear();
+  if (reuse_outputs_) {
+    for (int32_t i = 0; i != n; ++i) {
+      auto info = inputs[i].GetTensorTypeAndShapeInfo();
+      size_t rank = info.GetDimensionsCount();
+
+      // The rank separates shapes like (2, 3) + (4,) and (2,) + (3, 4)
+      shapes_.push_back(static_cast<int64_t>(rank));
+
+      size_t offset = shapes_.size();
+      shapes_.resize(offset + rank);
+      info.GetDimensions(shapes_.data() + offset, rank);
+    }
+  }
+
+  for (auto &slot : slots_) {
+    if (slot->thread_id == thread_id && slot->shapes == shapes_) {
+      return slot.get();
+    }
+  }
+
+  if (static_cast<int32_t>(slots_.size()) >= kMaxSlots) {
+    return nullptr;
+  }
+
+  slots_.push_back(std::make_unique<Slot>(sess_, thread_id, shapes_));
+
+  return slots_.back().get();
+}
+
+std::vector<Ort::Value> SessionBinding::Run(const Ort::Value *inputs,
+                                            int32_t n) {
+  if (n != static_cast<int32_t>(input_names_.size())) {
+    SHERPA_ONNX_LOGE("Expect %d inputs. Given: %d",
+                     static_cast<int32_t>(input_names_.size()), n);
+    exit(-1);
+  }
+
+  Slot *slot = GetSlot(inputs, n);
+  if (!slot) {
+    return sess_->Run(Ort::RunOptions{nullptr}, input_names_ptr_.data(),
+                      inputs, n, output_names_ptr_.data(),
+                      output_names_ptr_.size());
+  }
+
+  Ort::IoBinding &binding = slot->binding;
+
+  for (int32_t i = 0; i != n; ++i) {
+    binding.BindInput(input_names_ptr_[i], inputs[i]);
+  }
+
+  if (!slot->has_outputs) {
+    for (const auto *name : output_names_ptr_) {
+      binding.BindOutput(name, memory_info_);
+    }
+  }
+
+  sess_->Run(Ort::RunOptions{nullptr}, binding);
+
+  // The returned values share their buffers with the bound outputs
+  std::vector<Ort::Value> ans = binding.GetOutputValues();
+
+  // Inputs belong to the caller and may be views of its buffers, so the
+  // binding must not keep them alive
+  binding.ClearBoundInputs();
+
+  if (!reuse_outputs_) {
+    binding.ClearBoundOutputs();
+  } else if (!slot->has_outputs) {
+    for (int32_t i = 0; i != static_cast<int32_t>(ans.size()); ++i) {
+      binding.BindOutput(output_names_ptr_[i], ans[i]);
+    }
+    slot->has_outputs = true;
+  }
+
+  return ans;
+}
+
+}  // namespace sherpa_onnx
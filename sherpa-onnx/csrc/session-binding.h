@@ -0,0 +1,88 @@
+// sherpa-onnx/csrc/session-binding.h
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#ifndef SHERPA_ONNX_CSRC_SESSION_BINDING_H_
+#define SHERPA_ONNX_CSRC_SESSION_BINDING_H_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "onnxruntime_cxx_api.h"  // NOLINT
+
+namespace sherpa_onnx {
+
+// Run a session through Ort::IoBinding, with one binding per calling thread
+// that is kept across calls.
+//
+// If reuse_outputs is true, outputs are allocated once for each combination
+// of input shapes, e.g., once per batch size of the joiner, and later calls
+// with the same shapes write into them. The returned tensors then share
+// their buffers with the binding: they are overwritten by the next call
+// from the same thread with the same input shapes, so callers must be done
+// with them by then. Otherwise, every call returns newly allocated outputs,
+// as Ort::Session::Run() does.
+class SessionBinding {
+ public:
+  /**
+   * @param sess  The session to run. It must outlive this object.
+   * @param input_names  Names of the inputs, in the order they are passed
+   *                     to Run().
+   * @param output_names  Names of the outputs, in the order they are
+   *                      returned by Run().
+   * @param reuse_outputs  See above.
+   */
+  SessionBinding(Ort::Session *sess,
+                 const std::vector<std::string> &input_names,
+                 const std::vector<std::string> &output_names,
+                 bool reuse_outputs);
+
+  ~SessionBinding();
+
+  SessionBinding(const SessionBinding &) = delete;
+  SessionBinding &operator=(const SessionBinding &) = delete;
+
+  /** Run the session. It is safe to call it from several threads.
+   *
+   * @param inputs  Array of size n. They are not kept after returning.
+   * @param n  Number of inputs. It must equal the number of input names.
+   */
+  std::vector<Ort::Value> Run(const Ort::Value *inputs, int32_t n);
+
+ private:
+  struct Slot;
+
+  // @return Return nullptr if there are already too many slots
+  Slot *GetSlot(const Ort::Value *inputs, int32_t n);
+
+ private:
+  Ort::Session *sess_;
+
+  std::vector<std::string> input_names_;
+  std::vector<const char *> input_names_ptr_;
+
+  std::vector<std::string> output_names_;
+  std::vector<const char *> output_names_ptr_;
+
+  bool reuse_outputs_;
+
+  Ort::MemoryInfo memory_info_;
+
+  std::mutex mutex_;
+
+  // One for each calling thread and, if reuse_outputs_ is true, each
+  // combination of input shapes
+  std::vector<std::unique_ptr<Slot>> slots_;
+
+  // Rank followed by the dims of each input if reuse_outputs_ is true,
+  // otherwise empty. It is the key of a slot and is filled in place on each
+  // call, so that looking up a slot does not allocate.
+  std::vector<int64_t> shapes_;
+};
+
+}  // namespace sherpa_onnx
+
+#endif  // SHERPA_ONNX_CSRC_SESSION_BINDING_H_
@@ -0,0 +1,244 @@
+// sherpa-onnx/csrc/session-registry.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/session-registry.h"
+
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+
+#include "sherpa-onnx/csrc/macros.h"
+#include "sherpa-onnx/csrc/mapped-file.h"
+#include "sherpa-onnx/csrc/session.h"
+#include "sherpa-onnx/csrc/text-utils.h"
+
+namespace sherpa_onnx {
+
+namespace {
+
+struct SessionRegistry {
+  std::mutex mutex;
+
+  // Keyed by the absolute path of the model file and the options key.
+  // Entries expire when the last model that uses the session is destroyed.
+  std::map<std::string, std::weak_ptr<Ort::Session>> sessions;
+
+  // Empty if the optimized model cache is disabled
+  std::string cache_dir;
+};
+
+}  // namespace
+
+static SessionRegistry &GetSessionRegistry() {
+  static auto *registry = new SessionRegistry;
+  return *registry;
+}
+
+// So that "./a.onnx" and "a.onnx" share a session
+static std::string GetAbsolutePath(const std::string &filename) {
+#if defined(_WIN32)
+  char buf[4096];
+  if (_fullpath(buf, filename.c_str(), sizeof(buf))) {
+    return buf;
+  }
+#else
+  char *p = realpath(filename.c_str(), nullptr);
+  if (p) {
+    std::string ans = p;
+    free(p);
+    return ans;
+  }
+#endif
+  return filename;
+}
+
+// 64-bit FNV-1a over 8-byte words. It only has to tell model files apart,
+// and is several times faster than hashing byte by byte, which matters for
+// encoders of hundreds of MB on slow devices.
+static uint64_t HashBytes(const char *p, size_t n, uint64_t hash) {
+  constexpr uint64_t kPrime = 0x100000001b3ULL;
+
+  for (; n >= 8; p += 8, n -= 8) {
+    uint64_t w;
+    std::memcpy(&w, p, 8);
+    hash = (hash ^ w) * kPrime;
+  }
+
+  for (; n > 0; ++p, --n) {
+    hash = (hash ^ static_cast<uint8_t>(*p)) * kPrime;
+  }
+
+  return hash;
+}
+
+// Path of the optimized model in cache_dir for the given model file and
+// session options
+static std::string GetCachedModelPath(const std::string &cache_dir,
+                                      const std::string &filename,
+                                      const MappedFile &file,
+                                      const std::string &sess_opts_key) {
+  uint64_t hash = HashBytes(file.Data(), file.Size(), 0xcbf29ce484222325ULL);
+
+  std::string key = OrtGetApiBase()->GetVersionString();
+  key += "\n" + sess_opts_key;
+  hash = HashBytes(key.data(), key.size(), hash);
+
+  // Keep the name of the model, so that entries are easy to tell apart
+  std::string name = filename.substr(filename.find_last_of("/\\") + 1);
+  if (EndsWith(name, ".onnx")) {
+    name.resize(name.size() - 5);
+  }
+
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%016llx",
+           static_cast<unsigned long long>(hash));  // NOLINT
+
+  return cache_dir + "/" + name + "-" + buf + ".onnx";
+}
+
+static void SetOptimizedModelFilePath(Ort::SessionOptions *sess_opts,
+                                      const std::string &filename) {
+#if defined(_WIN32)
+  std::wstring w = ToWideString(filename);
+  sess_opts->SetOptimizedModelFilePath(w.c_str());
+#else
+  sess_opts->SetOptimizedModelFilePath(filename.c_str());
+#endif
+}
+
+// Like CreateSessionFromFile(), but the model is loaded from or saved to
+// the optimized model cache
+static std::unique_ptr<Ort::Session> CreateCachedSession(
+    const std::string &filename, const Ort::SessionOptions &sess_opts,
+    const std::string &sess_opts_key, const std::string &cache_dir) {
+  MappedFile file(filename);
+  if (!file.IsValid()) {
+    SHERPA_ONNX_LOGE("Failed to read model file '%s'", filename.c_str());
+    exit(-1);
+  }
+
+  std::string cached_filename =
+      GetCachedModelPath(cache_dir, filename, file, sess_opts_key);
+
+  {
+    MappedFile cached_file(cached_filename);
+    if (cached_file.IsValid()) {
+      // It is already optimized
+      Ort::SessionOptions opts = sess_opts.Clone();
+      opts.SetGraphOptimizationLevel(ORT_DISABLE_ALL);
+
+      return std::make_unique<Ort::Session>(GetOrtEnv(), cached_file.Data(),
+                                            cached_file.Size(), opts);
+    }
+  }
+
+  // onnxruntime writes the optimized model while building the session. It
+  // is written to a temporary file first, so that an interrupted write,
+  // e.g., by a power loss, or another process that loads the same model at
+  // the same time never leaves a truncated entry.
+  std::string tmp_filename =
+      cached_filename + ".tmp" +
+      std::to_string(
+          std::chrono::steady_clock::now().time_since_epoch().count());
+
+  Ort::SessionOptions opts = sess_opts.Clone();
+  SetOptimizedModelFilePath(&opts, tmp_filename);
+
+  auto sess = std::make_unique<Ort::Session>(GetOrtEnv(), file.Data(),
+                                             file.Size(), opts);
+
+  if (std::rename(tmp_filename.c_str(), cached_filename.c_str()) != 0) {
+    SHERPA_ONNX_LOGE("Failed to save optimized model '%s'",
+                     cached_filename.c_str());
+    std::remove(tmp_filename.c_str());
+  }
+
+  return sess;
+}
+
+bool SetOptimizedModelCacheDir(const std::string &dir) {
+  auto &registry = GetSessionRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+
+  registry.cache_dir.clear();
+
+  if (dir.empty()) {
+    return true;
+  }
+
+  struct stat st;
+  if (stat(dir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+    SHERPA_ONNX_LOGE(
+        "'%s' is not a directory. Disable the optimized model cache",
+        dir.c_str());
+    return false;
+  }
+
+  registry.cache_dir = dir;
+  return true;
+}
+
+Ort::Env &GetOrtEnv() {
+  static auto *env = new Ort::Env(ORT_LOGGING_LEVEL_ERROR);
+  return *env;
+}
+
+std::unique_ptr<Ort::Session> CreateSessionFromFile(
+    const std::string &filename, const Ort::SessionOptions &sess_opts) {
+  MappedFile file(filename);
+  if (!file.IsValid()) {
+    SHERPA_ONNX_LOGE("Failed to read model file '%s'", filename.c_str());
+    exit(-1);
+  }
+
+  // onnxruntime does not use the bytes after the session is built, so the
+  // file is unmapped when returning
+  return std::make_unique<Ort::Session>(GetOrtEnv(), file.Data(), file.Size(),
+                                        sess_opts);
+}
+
+std::shared_ptr<Ort::Session> GetSharedSession(
+    const std::string &filename, const Ort::SessionOptions &sess_opts,
+    const std::string &sess_opts_key) {
+  std::string key = GetAbsolutePath(filename) + "\n" + sess_opts_key;
+
+  auto &registry = GetSessionRegistry();
+
+  // The lock is held while a session is built, so that models that are
+  // created at the same time from the same file build it only once.
+  std::lock_guard<std::mutex> lock(registry.mutex);
+
+  for (auto it = registry.sessions.begin(); it != registry.sessions.end();) {
+    if (it->second.expired() && it->first != key) {
+      it = registry.sessions.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  auto &entry = registry.sessions[key];
+  std::shared_ptr<Ort::Session> sess = entry.lock();
+  if (!sess) {
+    if (!registry.cache_dir.empty() &&
+        IsOptimizedModelCacheSupported(sess_opts_key)) {
+      sess = CreateCachedSession(filename, sess_opts, sess_opts_key,
+                                 registry.cache_dir);
+    } else {
+      sess = CreateSessionFromFile(filename, sess_opts);
+    }
+    entry = sess;
+  }
+
+  return sess;
+}
+
+}  // namespace sherpa_onnx
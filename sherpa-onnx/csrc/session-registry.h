@@ -0,0 +1,67 @@
+// sherpa-onnx/csrc/session-registry.h
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#ifndef SHERPA_ONNX_CSRC_SESSION_REGISTRY_H_
+#define SHERPA_ONNX_CSRC_SESSION_REGISTRY_H_
+
+#include <memory>
+#include <string>
+
+#include "onnxruntime_cxx_api.h"  // NOLINT
+
+namespace sherpa_onnx {
+
+// Return the Ort::Env shared by all models of this process.
+// It is never destroyed, so that models in static objects can outlive it.
+Ort::Env &GetOrtEnv();
+
+/** Enable an on-disk cache of optimized models, so that graph optimization
+ * runs only on the first start instead of on every start.
+ *
+ * When GetSharedSession() loads a model for the first time, the model after
+ * graph optimization is saved to dir. Later, the saved model is loaded
+ * instead, with graph optimization disabled. Saved models are keyed by a
+ * hash of the model file, the onnxruntime version and the session options,
+ * so a changed model, a new onnxruntime or other options never use a stale
+ * entry. Old entries are not removed.
+ *
+ * Only the cpu provider is cached, since other providers may compile nodes
+ * that cannot be saved.
+ *
+ * @param dir  An existing, writable directory. An empty string disables the
+ *             cache, which is the default. It should be called before
+ *             models are created.
+ * @return Return false if dir is not a directory. The cache is then
+ *         disabled.
+ */
+bool SetOptimizedModelCacheDir(const std::string &dir);
+
+/** Create a session from a model file, which is memory-mapped while the
+ * session is built and unmapped afterwards, so that the bytes of the file
+ * and the initialized session are not both kept in heap memory.
+ *
+ * It exits the program if the file cannot be read.
+ */
+std::unique_ptr<Ort::Session> CreateSessionFromFile(
+    const std::string &filename, const Ort::SessionOptions &sess_opts);
+
+/** Same as CreateSessionFromFile(), but a session is shared by all callers
+ * that pass the same file and the same sess_opts_key while any of them
+ * holds it, e.g., by a keyword spotter and a recognizer that use the same
+ * encoder. Ort::Session::Run() can be called from several threads at the
+ * same time.
+ *
+ * @param filename  Path to the model file.
+ * @param sess_opts  Used only if a new session is created.
+ * @param sess_opts_key  Identifies sess_opts, see GetSessionOptionsKey()
+ *                       from session.h. Sessions created with different
+ *                       options are never shared.
+ */
+std::shared_ptr<Ort::Session> GetSharedSession(
+    const std::string &filename, const Ort::SessionOptions &sess_opts,
+    const std::string &sess_opts_key);
+
+}  // namespace sherpa_onnx
+
+#endif  // SHERPA_ONNX_CSRC_SESSION_REGISTRY_H_
@@ -0,0 +1,78 @@
+// sherpa-onnx/csrc/session-startup-benchmark.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+// Compare the time to create a session of a model without and with the
+// optimized model cache from session-registry.h
+//
+// Usage:
+//
+//   ./bin/session-startup-benchmark model.onnx cache_dir [num_threads]
+//
+// cache_dir must be an existing directory. Start with an empty one to also
+// measure the start that fills the cache.
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "sherpa-onnx/csrc/session-registry.h"
+#include "sherpa-onnx/csrc/session.h"
+
+namespace {
+
+// @return Return the time in seconds to create a session of the model
+double Run(const std::string &filename, int32_t num_threads) {
+  auto start = std::chrono::steady_clock::now();
+
+  // The session is destroyed when returning, so every call creates a new
+  // one, as a new process would
+  auto sess = sherpa_onnx::GetSharedSession(
+      filename, sherpa_onnx::GetSessionOptions(num_threads, "cpu"),
+      sherpa_onnx::GetSessionOptionsKey(num_threads, "cpu"));
+
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+}  // namespace
+
+int main(int32_t argc, char *argv[]) {
+  if (argc < 3) {
+    fprintf(stderr, "Usage: %s model.onnx cache_dir [num_threads]\n",
+            argv[0]);
+    return -1;
+  }
+
+  std::string filename = argv[1];
+  std::string cache_dir = argv[2];
+  int32_t num_threads = argc > 3 ? atoi(argv[3]) : 1;
+  constexpr int32_t kNumRuns = 5;
+
+  double cold = 0;
+  for (int32_t i = 0; i != kNumRuns; ++i) {
+    cold += Run(filename, num_threads);
+  }
+  cold /= kNumRuns;
+
+  if (!sherpa_onnx::SetOptimizedModelCacheDir(cache_dir)) {
+    return -1;
+  }
+
+  double first = Run(filename, num_threads);
+
+  double cached = 0;
+  for (int32_t i = 0; i != kNumRuns; ++i) {
+    cached += Run(filename, num_threads);
+  }
+  cached /= kNumRuns;
+
+  printf("model: %s, num_threads: %d\n", filename.c_str(), num_threads);
+  printf("cold start:                 %8.1f ms\n", cold * 1000);
+  printf("first start with the cache: %8.1f ms\n", first * 1000);
+  printf("cached start:               %8.1f ms (%.2fx)\n", cached * 1000,
+         cold / cached);
+
+  return 0;
+}
@@ -5,6 +5,8 @@
 #include "sherpa-onnx/csrc/session.h"
 
 #include <algorithm>
+#include <mutex>  // NOLINT
+#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
@@ -35,6 +37,50 @@ static void OrtStatusFailure(OrtStatus *status, const char *s) {
   api.ReleaseStatus(status);
 }
 
+namespace {
+
+// Set by SetOrtThreadOptions()
+struct OrtThreadOptions {
+  std::mutex mutex;
+  std::vector<int32_t> intra_op_cpus;
+  bool allow_spinning = true;
+};
+
+}  // namespace
+
+static OrtThreadOptions &GetOrtThreadOptions() {
+  static auto *options = new OrtThreadOptions;
+  return *options;
+}
+
+void SetOrtThreadOptions(const std::vector<int32_t> &intra_op_cpus,
+                         bool allow_spinning) {
+  auto &options = GetOrtThreadOptions();
+  std::lock_guard<std::mutex> lock(options.mutex);
+  options.intra_op_cpus = intra_op_cpus;
+  options.allow_spinning = allow_spinning;
+}
+
+// Return the value of session.intra_op_thread_affinities for num_threads
+// threads, or an empty string to leave them unpinned. It has one entry per
+// worker thread, i.e., num_threads - 1, and CPUs start from 1.
+static std::string GetIntraOpThreadAffinities(
+    int32_t num_threads, const std::vector<int32_t> &cpus) {
+  if (cpus.empty() || num_threads < 2) {
+    return {};
+  }
+
+  std::ostringstream os;
+  for (int32_t i = 0; i != num_threads - 1; ++i) {
+    if (i != 0) {
+      os << ";";
+    }
+    os << cpus[i % cpus.size()] + 1;
+  }
+
+  return os.str();
+}
+
 Ort::SessionOptions GetSessionOptionsImpl(
     int32_t num_threads, const std::string &provider_str,
     const ProviderConfig *provider_config /*= nullptr*/) {
@@ -45,6 +91,23 @@ Ort::SessionOptions GetSessionOptionsImpl(
 
   sess_opts.SetInterOpNumThreads(num_threads);
 
+  {
+    auto &options = GetOrtThreadOptions();
+    std::lock_guard<std::mutex> lock(options.mutex);
+
+    auto affinities =
+        GetIntraOpThreadAffinities(num_threads, options.intra_op_cpus);
+    if (!affinities.empty()) {
+      sess_opts.AddConfigEntry("session.intra_op_thread_affinities",
+                               affinities.c_str());
+    }
+
+    if (!options.allow_spinning) {
+      sess_opts.AddConfigEntry("session.intra_op.allow_spinning", "0");
+      sess_opts.AddConfigEntry("session.inter_op.allow_spinning", "0");
+    }
+  }
+
   std::vector<std::string> available_providers = Ort::GetAvailableProviders();
   std::ostringstream os;
   for (const auto &ep : available_providers) {
@@ -265,6 +328,49 @@ Ort::SessionOptions GetSessionOptions(const OnlineModelConfig &config,
                                &config.provider_config);
 }
 
+std::string GetSessionOptionsKey(
+    int32_t num_threads, const std::string &provider_str,
+    const ProviderConfig *provider_config /*= nullptr*/) {
+  std::ostringstream os;
+  os << "num_threads=" << num_threads << ", ";
+  os << "provider=\"" << provider_str << "\"";
+  if (provider_config) {
+    os << ", " << provider_config->ToString();
+  }
+
+  {
+    auto &options = GetOrtThreadOptions();
+    std::lock_guard<std::mutex> lock(options.mutex);
+    os << ", intra_op_thread_affinities=\""
+       << GetIntraOpThreadAffinities(num_threads, options.intra_op_cpus)
+       << "\", ";
+    os << "allow_spinning=" << (options.allow_spinning ? "True" : "False");
+  }
+
+  return os.str();
+}
+
+std::string GetSessionOptionsKey(const OnlineModelConfig &config,
+                                 const std::string &model_type) {
+  if (config.provider_config.provider == "trt" &&
+      (model_type == "decoder" || model_type == "joiner")) {
+    return GetSessionOptionsKey(config.num_threads, "cuda",
+                                &config.provider_config);
+  }
+  return GetSessionOptionsKey(config.num_threads,
+                              config.provider_config.provider,
+                              &config.provider_config);
+}
+
+bool IsOptimizedModelCacheSupported(const std::string &sess_opts_key) {
+  // See GetSessionOptionsKey() above. The first provider is the one used,
+  // e.g., cuda for the decoder of a trt model.
+  const std::string kProvider = "provider=\"";
+  auto pos = sess_opts_key.find(kProvider);
+  return pos != std::string::npos &&
+         sess_opts_key.compare(pos + kProvider.size(), 4, "cpu\"") == 0;
+}
+
 Ort::SessionOptions GetSessionOptions(const OfflineLMConfig &config) {
   return GetSessionOptionsImpl(config.lm_num_threads, config.lm_provider);
 }
@@ -6,6 +6,7 @@
 #define SHERPA_ONNX_CSRC_SESSION_H_
 
 #include <string>
+#include <vector>
 
 #include "onnxruntime_cxx_api.h"  // NOLINT
 #include "sherpa-onnx/csrc/offline-lm-config.h"
@@ -14,6 +15,19 @@
 
 namespace sherpa_onnx {
 
+// Options for the threads of onnxruntime. They apply to all sessions
+// created afterwards, so set them before creating models. See also
+// ThreadSchedulingConfig in thread-scheduling.h
+//
+// @param intra_op_cpus  If not empty, intra-op worker thread i is pinned to
+//                       intra_op_cpus[i % intra_op_cpus.size()]. The thread
+//                       that calls Run() is not pinned by onnxruntime.
+// @param allow_spinning  false to let idle worker threads sleep instead of
+//                        busy-waiting for work, which frees the CPUs for
+//                        other threads at the cost of a slower wakeup.
+void SetOrtThreadOptions(const std::vector<int32_t> &intra_op_cpus,
+                         bool allow_spinning);
+
 Ort::SessionOptions GetSessionOptionsImpl(
     int32_t num_threads, const std::string &provider_str,
     const ProviderConfig *provider_config = nullptr);
@@ -34,6 +48,26 @@ Ort::SessionOptions GetSessionOptions(const T &config) {
   return GetSessionOptionsImpl(config.num_threads, config.provider);
 }
 
+// Return a string that identifies the options returned by
+// GetSessionOptionsImpl() with the same arguments. Models that are loaded
+// with equal keys can share a session, see session-registry.h
+std::string GetSessionOptionsKey(
+    int32_t num_threads, const std::string &provider_str,
+    const ProviderConfig *provider_config = nullptr);
+
+// Key of GetSessionOptions(config, model_type)
+std::string GetSessionOptionsKey(const OnlineModelConfig &config,
+                                 const std::string &model_type);
+
+// Return true if sessions with options of this key can be saved in the
+// optimized model cache, see SetOptimizedModelCacheDir()
+bool IsOptimizedModelCacheSupported(const std::string &sess_opts_key);
+
+template <typename T>
+std::string GetSessionOptionsKey(const T &config) {
+  return GetSessionOptionsKey(config.num_threads, config.provider);
+}
+
 }  // namespace sherpa_onnx
 
 #endif  // SHERPA_ONNX_CSRC_SESSION_H_
@@ -17,6 +17,7 @@
 #include "sherpa-onnx/csrc/display.h"
 #include "sherpa-onnx/csrc/online-recognizer.h"
 #include "sherpa-onnx/csrc/parse-options.h"
+#include "sherpa-onnx/csrc/thread-scheduling.h"
 
 bool stop = false;
 
@@ -64,11 +65,19 @@ and if you want to select card 3 and device 0 on that card, please use:
   plughw:3,0
 
 as the device_name.
+
+--capture-cpus, --capture-priority, --decode-cpus and --decode-priority pin
+the capture and decode threads to CPUs and give them SCHED_FIFO realtime
+priorities, e.g., --capture-cpus=0 --capture-priority=80 --decode-cpus=1-3.
+--ort-cpus pins the worker threads of onnxruntime, one per CPU in turn, and
+--ort-allow-spinning=false lets them sleep when idle.
 )usage";
   sherpa_onnx::ParseOptions po(kUsageMessage);
   sherpa_onnx::OnlineRecognizerConfig config;
+  sherpa_onnx::ThreadSchedulingConfig scheduling_config;
 
   config.Register(&po);
+  scheduling_config.Register(&po);
 
   int32_t buffer_size = 1365;
   int32_t period_size = 170;
@@ -92,6 +101,13 @@ as the device_name.
     fprintf(stderr, "Errors in config!\n");
     return -1;
   }
+
+  fprintf(stderr, "%s\n", scheduling_config.ToString().c_str());
+
+  if (!scheduling_config.Validate()) {
+    fprintf(stderr, "Errors in thread scheduling config!\n");
+    return -1;
+  }
   
   // 限制参数在有效范围内
   buffer_size = std::max(buffer_size, 1365);
@@ -102,6 +118,9 @@ as the device_name.
   fprintf(stderr, "Using period size: %d\n", period_size);
   fprintf(stderr, "Using chunk size: %d\n", chunk_size);
 
+  // Before the sessions are created
+  sherpa_onnx::ConfigureOrtThreads(scheduling_config);
+
   sherpa_onnx::OnlineRecognizer recognizer(config);
 
   int32_t expected_sample_rate = config.feat_config.sampling_rate;
@@ -137,6 +156,10 @@ as the device_name.
 
   // 处理线程
   std::thread processing_thread([&]() {
+    sherpa_onnx::ConfigureCurrentThread(scheduling_config.decode_cpus,
+                                        scheduling_config.decode_priority,
+                                        "decode");
+
     while (!stop) {
       std::vector<float> local_buffer;
       
@@ -199,6 +222,9 @@ as the device_name.
   });
 
   // 主线程负责采集音频
+  sherpa_onnx::ConfigureCurrentThread(scheduling_config.capture_cpus,
+                                      scheduling_config.capture_priority,
+                                      "capture");
   while (!stop) {
     const std::vector<float> &samples = alsa.Read(chunk_size);
     
@@ -4,97 +4,60 @@
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <sys/stat.h>
-#include <sys/types.h>
 
 #include <algorithm>
-#include <cstdint>
-#include <mutex>
-#include <thread>
 #include <atomic>
-#include <condition_variable>
-#include <fstream>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "sherpa-onnx/csrc/alsa.h"
 #include "sherpa-onnx/csrc/display.h"
+#include "sherpa-onnx/csrc/file-utils.h"
+#include "sherpa-onnx/csrc/file-watcher.h"
+#include "sherpa-onnx/csrc/keyword-event-sink.h"
 #include "sherpa-onnx/csrc/keyword-spotter.h"
+#include "sherpa-onnx/csrc/latency-stats.h"
 #include "sherpa-onnx/csrc/parse-options.h"
+#include "sherpa-onnx/csrc/session-registry.h"
+#include "sherpa-onnx/csrc/speech-gate.h"
+#include "sherpa-onnx/csrc/spsc-ring-buffer.h"
+#include "sherpa-onnx/csrc/thread-scheduling.h"
 
 std::atomic<bool> stop(false);
+std::atomic<bool> dump_latency_stats(false);
 
 static void Handler(int sig) {
   stop = true;
   fprintf(stderr, "\nCaught Ctrl + C. Exiting...\n");
 }
 
-void LogKeyword(const std::string &keyword) {
-  const std::string dir_path = "/tmp/open-xiaoai";
-  const std::string file_path = "/tmp/open-xiaoai/kws.log";
-  
-  // 检查目录是否存在，不存在则创建
-  struct stat st;
-  if (::stat(dir_path.c_str(), &st) == -1) {
-    ::mkdir(dir_path.c_str(), 0755);
-  }
-  
-  // 获取当前时间戳（毫秒）
-  auto now = std::chrono::system_clock::now();
-  auto duration = now.time_since_epoch();
-  auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
-  
-  // 创建日志内容
-  std::string log_content = std::to_string(millis) + "@" + keyword;
-  
-  // 读取文件行数
-  int line_count = 0;
-  std::ifstream read_file(file_path); 
-  if (read_file.is_open()) {
-    std::string line;
-    while (std::getline(read_file, line)) {
-      line_count++;
-    }
-    read_file.close();
-  }
-  
-  // 如果少于 10 行则追加，否则清空重写
-  std::ios_base::openmode mode = std::ios::out;
-  if (line_count >= 10) {
-    // 清空文件重新开始
-    mode |= std::ios::trunc;
-  } else {
-    // 追加模式
-    mode |= std::ios::app;
-  }
-  
-  // 写入文件（写入时锁定文件）
-  std::ofstream file;
-  int fd = open(file_path.c_str(), O_WRONLY | O_CREAT, 0644);
-  if (fd != -1) {
-    // 获取文件锁
-    struct flock fl;
-    fl.l_type = F_WRLCK;
-    fl.l_whence = SEEK_SET;
-    fl.l_start = 0;
-    fl.l_len = 0;
-    
-    if (fcntl(fd, F_SETLK, &fl) != -1) {
-      file.open(file_path, mode);
-      if (file.is_open()) {
-        file << log_content << std::endl;
-        file.flush(); 
-        file.close();
-      }
-      
-      // 释放文件锁
-      fl.l_type = F_UNLCK;
-      fcntl(fd, F_SETLK, &fl);
-    }
-    close(fd);
+static void DumpLatencyStatsHandler(int sig) { dump_latency_stats = true; }
+
+static void DumpLatencyStats(
+    const sherpa_onnx::KeywordSpotterLatencyStats &stats,
+    const std::string &filename) {
+  fprintf(stderr, "%s", stats.ToString().c_str());
+
+  if (!filename.empty() && !stats.WriteToFile(filename)) {
+    fprintf(stderr, "Failed to write latency stats to %s\n",
+            filename.c_str());
   }
 }
 
+static int64_t NowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
 int main(int32_t argc, char *argv[]) {
   signal(SIGINT, Handler);
+  signal(SIGUSR1, DumpLatencyStatsHandler);
 
   const char *kUsageMessage = R"usage(
 Usage:
@@ -109,6 +72,14 @@ Usage:
     --chunk-size=1024 \
     --buffer-size=1365 \
     --period-size=170 \
+    --ring-size=16000 \
+    --watch-keywords-file=true \
+    --event-sinks=ring-log:/tmp/open-xiaoai/kws.log,stdout \
+    --trace-latency=true \
+    --latency-stats-file=/tmp/open-xiaoai/kws-latency.txt \
+    --num-channels=1 \
+    --speech-gate=energy \
+    --optimized-model-cache-dir=/data/kws-cache \
     device_name
 
 Please refer to
@@ -132,22 +103,104 @@ and if you want to select card 3 and device 0 on that card, please use:
   plughw:3,0
 
 as the device_name.
+
+--event-sinks is a comma-separated list of destinations for detected
+keywords. Supported are ring-log:/path (the last 10 detections as
+"time_ms@keyword" lines), socket:/path (json datagrams to a Unix-domain
+socket), fifo:/path (json lines) and stdout (json lines).
+
+If --trace-latency is true, per-stage latency histograms are collected:
+capture wait, queue, feature extraction, encoder, search, sink and end to
+end, i.e., from capturing the last sample of a keyword to reporting it.
+Send SIGUSR1 to print them and write them to --latency-stats-file. They
+are also printed and written on exit.
+
+If --num-channels is larger than 1, that many channels are captured, e.g.,
+from a microphone array, and each channel in --channels is decoded by its
+own stream. The streams are decoded together in one batch. With
+--channel-fusion=max, a keyword detected on several channels at the same
+time is reported once, from the channel with the highest score, and all
+streams are reset. With --channel-fusion=none, each channel reports its own
+detections. The "source" field of an event is the channel it comes from.
+
+If --watch-keywords-file is true, the keywords file is reloaded whenever it
+is changed, without restarting the program or reloading the models.
+
+With --speech-gate=energy or --speech-gate=silero, the encoder runs only
+while speech is found in the first decoded channel, plus
+--speech-gate-hangover seconds after it. Features are still computed in
+silence, and the last --speech-gate-preroll seconds of them are decoded
+when speech starts, so that the start of a keyword is not lost. The encoder
+restarts from its initial states at that point. --speech-gate=silero also
+needs --silero-vad-model=/path/to/silero_vad.onnx. The fraction of encoder
+runs that are skipped is printed on exit.
+
+If --optimized-model-cache-dir is not empty, models are saved there after
+graph optimization on the first start, and later starts load them from
+there without optimizing them again. The directory must exist.
+
+--capture-cpus, --capture-priority, --decode-cpus and --decode-priority pin
+the capture and decode threads to CPUs and give them SCHED_FIFO realtime
+priorities, e.g., --capture-cpus=0 --capture-priority=80 --decode-cpus=1-3.
+--ort-cpus pins the worker threads of onnxruntime, one per CPU in turn, and
+--ort-allow-spinning=false lets them sleep when idle.
 )usage";
   sherpa_onnx::ParseOptions po(kUsageMessage);
   sherpa_onnx::KeywordSpotterConfig config;
+  sherpa_onnx::SpeechGateConfig gate_config;
+  sherpa_onnx::ThreadSchedulingConfig scheduling_config;
 
   config.Register(&po);
+  gate_config.Register(&po);
+  scheduling_config.Register(&po);
   
   int32_t buffer_size = 1365;
   int32_t period_size = 170;
   int32_t chunk_size = 1024;
+  int32_t ring_size = 16000;
+  bool watch_keywords_file = false;
+  std::string event_sinks = "ring-log:/tmp/open-xiaoai/kws.log";
+  bool trace_latency = false;
+  std::string latency_stats_file;
+  int32_t num_channels = 1;
+  std::string channels;
+  std::string channel_fusion = "max";
+  std::string optimized_model_cache_dir;
   
   po.Register("buffer-size", &buffer_size, "ALSA buffer size in frames. Default: 1365");
   po.Register("period-size", &period_size, "ALSA period size in frames. Default: 170");
   po.Register("chunk-size", &chunk_size, "Number of samples to process in each chunk. Default: 1024");
+  po.Register("ring-size", &ring_size,
+              "Number of samples buffered between the capture thread and the "
+              "decoding thread. Rounded up to a power of two. Default: 16000");
+  po.Register("watch-keywords-file", &watch_keywords_file,
+              "true to reload --keywords-file when it is changed");
+  po.Register("event-sinks", &event_sinks,
+              "Comma-separated destinations for detected keywords. See the "
+              "usage above. Default: ring-log:/tmp/open-xiaoai/kws.log");
+  po.Register("trace-latency", &trace_latency,
+              "true to collect per-stage latency histograms");
+  po.Register("latency-stats-file", &latency_stats_file,
+              "If not empty, latency histograms are written to this file on "
+              "SIGUSR1 and on exit");
+  po.Register("num-channels", &num_channels,
+              "Number of channels to capture. Default: 1");
+  po.Register("channels", &channels,
+              "Comma-separated indexes of the channels to decode, starting "
+              "from 0. Empty to decode all channels");
+  po.Register("channel-fusion", &channel_fusion,
+              "How detections of multiple channels are combined: max or "
+              "none. Default: max");
+  po.Register("optimized-model-cache-dir", &optimized_model_cache_dir,
+              "If not empty, an existing directory where optimized models "
+              "are cached to speed up later starts");
 
   po.Read(argc, argv);
 
+  // Streams are fed and decoded only by the processing thread. Audio is
+  // handed over through rings, so feature extraction needs no locking.
+  config.feat_config.single_threaded = true;
+
   fprintf(stderr, "%s\n", config.ToString().c_str());
 
   if (!config.Validate()) {
@@ -155,6 +208,22 @@ as the device_name.
     return -1;
   }
 
+  if (gate_config.type != "none") {
+    fprintf(stderr, "%s\n", gate_config.ToString().c_str());
+  }
+
+  if (!gate_config.Validate()) {
+    fprintf(stderr, "Errors in speech gate config!\n");
+    return -1;
+  }
+
+  fprintf(stderr, "%s\n", scheduling_config.ToString().c_str());
+
+  if (!scheduling_config.Validate()) {
+    fprintf(stderr, "Errors in thread scheduling config!\n");
+    return -1;
+  }
+
   // 限制参数在有效范围内
   buffer_size = std::max(buffer_size, 1365);
   period_size = std::max(period_size, 170);
@@ -164,12 +233,115 @@ as the device_name.
   fprintf(stderr, "Using period size: %d\n", period_size);
   fprintf(stderr, "Using chunk size: %d\n", chunk_size);
 
+  if (num_channels < 1) {
+    fprintf(stderr, "Invalid number of channels: %d\n", num_channels);
+    return -1;
+  }
+
+  if (channel_fusion != "max" && channel_fusion != "none") {
+    fprintf(stderr, "Invalid channel fusion: %s\n", channel_fusion.c_str());
+    return -1;
+  }
+  bool fuse_channels = channel_fusion == "max";
+
+  // Channels decoded by the keyword spotter
+  std::vector<int32_t> selected_channels;
+  {
+    std::istringstream is(channels);
+    std::string c;
+    while (std::getline(is, c, ',')) {
+      if (c.empty()) continue;
+
+      int32_t i = atoi(c.c_str());
+      if (i < 0 || i >= num_channels) {
+        fprintf(stderr, "Invalid channel %s. Number of channels: %d\n",
+                c.c_str(), num_channels);
+        return -1;
+      }
+      selected_channels.push_back(i);
+    }
+
+    if (selected_channels.empty()) {
+      for (int32_t i = 0; i != num_channels; ++i) {
+        selected_channels.push_back(i);
+      }
+    }
+  }
+  int32_t num_streams = selected_channels.size();
+
+  std::vector<std::unique_ptr<sherpa_onnx::KeywordEventSink>> sinks;
+  {
+    std::istringstream is(event_sinks);
+    std::string spec;
+    while (std::getline(is, spec, ',')) {
+      if (spec.empty()) continue;
+
+      auto sink = sherpa_onnx::CreateKeywordEventSink(spec);
+      if (!sink) {
+        fprintf(stderr, "Invalid event sink: %s\n", spec.c_str());
+        return -1;
+      }
+      sinks.push_back(std::move(sink));
+    }
+  }
+
+  sherpa_onnx::KeywordSpotterLatencyStats latency_stats;
+  sherpa_onnx::SampleClock sample_clock;
+
+  // Events are written by a background thread, so I/O never blocks decoding
+  sherpa_onnx::KeywordEventDispatcher dispatcher(
+      std::move(sinks), 64, trace_latency ? &latency_stats.sink : nullptr);
+
+  if (!optimized_model_cache_dir.empty() &&
+      !sherpa_onnx::SetOptimizedModelCacheDir(optimized_model_cache_dir)) {
+    return -1;
+  }
+
+  // Before the sessions are created
+  sherpa_onnx::ConfigureOrtThreads(scheduling_config);
+
   sherpa_onnx::KeywordSpotter spotter(config);
+  if (trace_latency) {
+    spotter.SetLatencyStats(&latency_stats);
+  }
+
+  // Keywords are re-encoded in the watcher thread. The decoding thread
+  // switches to them before decoding its next chunk.
+  std::unique_ptr<sherpa_onnx::FileWatcher> keywords_watcher;
+  if (watch_keywords_file && config.keywords_buf.empty()) {
+    keywords_watcher = std::make_unique<sherpa_onnx::FileWatcher>(
+        config.keywords_file, [&spotter](const std::string &filename) {
+          if (!sherpa_onnx::FileExists(filename)) {
+            return;
+          }
+
+          auto buf = sherpa_onnx::ReadFile(filename);
+          if (spotter.ReloadKeywords(std::string(buf.begin(), buf.end()))) {
+            fprintf(stderr, "Reloaded keywords from %s\n", filename.c_str());
+          } else {
+            fprintf(stderr, "Failed to reload keywords from %s\n",
+                    filename.c_str());
+          }
+        });
+    fprintf(stderr, "Watching keywords file: %s\n",
+            config.keywords_file.c_str());
+  }
 
   int32_t expected_sample_rate = config.feat_config.sampling_rate;
 
+  sherpa_onnx::SpeechGate gate(gate_config, expected_sample_rate);
+
+  // Feature frames kept as pre-roll while the gate is closed
+  int32_t num_preroll_frames = static_cast<int32_t>(
+      gate_config.preroll * 1000 / config.feat_config.frame_shift_ms);
+
+  // Written by the processing thread and read after it exits
+  int64_t num_encoder_runs = 0;
+  int64_t num_skipped_encoder_runs = 0;
+
   std::string device_name = po.GetArg(1);
-  sherpa_onnx::Alsa alsa(device_name.c_str(), period_size, buffer_size);
+  sherpa_onnx::Alsa alsa(device_name.c_str(), period_size, buffer_size,
+                         num_channels);
   fprintf(stderr, "Use recording device: %s\n", device_name.c_str());
 
   if (alsa.GetExpectedSampleRate() != expected_sample_rate) {
@@ -180,61 +352,257 @@ as the device_name.
 
   std::string last_text;
 
-  auto stream = spotter.CreateStream();
+  std::vector<std::unique_ptr<sherpa_onnx::OnlineStream>> streams;
+  for (int32_t i = 0; i != num_streams; ++i) {
+    streams.push_back(spotter.CreateStream());
+  }
 
   sherpa_onnx::Display display;
 
   int32_t keyword_index = 0;
-  
-  // 双缓冲实现
-  std::vector<float> buffer1, buffer2;
-  std::vector<float> *writing_buffer = &buffer1;
-  std::vector<float> *processing_buffer = &buffer2;
-  std::mutex buffer_mutex;
-  std::condition_variable buffer_cv;
-  bool buffer_ready = false;
-  bool started = false;
-  
+
+  // The capture thread only pushes into the ring, so it is never blocked by
+  // decoding. If the decoder falls behind for longer than the ring can hold,
+  // the newest samples are dropped and counted.
+  //
+  // There is one ring per decoded channel. All of them are pushed the same
+  // number of samples at the same time.
+  std::vector<std::unique_ptr<sherpa_onnx::SpscRingBuffer>> rings;
+  for (int32_t i = 0; i != num_streams; ++i) {
+    rings.push_back(std::make_unique<sherpa_onnx::SpscRingBuffer>(
+        std::max(ring_size, 2 * chunk_size)));
+  }
+  fprintf(stderr, "Using ring size: %d\n", rings[0]->Capacity());
+
+  // The rings of the channels fall out of step if one of them drops
+  // samples or runs short. The decoding thread then asks the capture thread
+  // to stop pushing (kResyncRequested), waits until it has
+  // (kResyncPaused), empties all rings and lets capture go on (kNoResync),
+  // so that the rings start again from the same sample.
+  constexpr int32_t kNoResync = 0;
+  constexpr int32_t kResyncRequested = 1;
+  constexpr int32_t kResyncPaused = 2;
+  std::atomic<int32_t> resync(kNoResync);
+
+  // The capture thread pushes kResyncPaused into it once it has paused, so
+  // that the decoding thread can block until then
+  sherpa_onnx::BasicSpscRingBuffer<int32_t> resync_paused(1);
+
+  // Feature frame f ends before sample f * frame_shift_samples + frame_end,
+  // as in FirstSampleOfFrame() of kaldi-native-fbank. It maps keywords to
+  // the captured audio.
+  int32_t frame_shift_samples = static_cast<int32_t>(
+      expected_sample_rate * config.feat_config.frame_shift_ms / 1000);
+  int32_t frame_length_samples = static_cast<int32_t>(
+      expected_sample_rate * config.feat_config.frame_length_ms / 1000);
+  int32_t frame_end = frame_length_samples;
+  if (!config.feat_config.snip_edges) {
+    frame_end += frame_shift_samples / 2 - frame_length_samples / 2;
+  }
+
   // 处理线程
   std::thread processing_thread([&]() {
-    while (!stop) {
-      std::vector<float> local_buffer;
-      
-      {
-        std::unique_lock<std::mutex> lock(buffer_mutex);
-        buffer_cv.wait(lock, [&]{ return buffer_ready || stop; });
-        
-        if (stop) break;
-        
-        // 交换指针，避免复制
-        local_buffer.swap(*processing_buffer);
-        buffer_ready = false;
+    sherpa_onnx::ConfigureCurrentThread(scheduling_config.decode_cpus,
+                                        scheduling_config.decode_priority,
+                                        "decode");
+
+    std::vector<std::vector<float>> samples(num_streams,
+                                            std::vector<float>(chunk_size));
+    std::vector<sherpa_onnx::OnlineStream *> ready;
+    std::vector<sherpa_onnx::KeywordResult> results(num_streams);
+    bool started = false;
+    int64_t last_dropped = 0;
+    std::vector<int64_t> last_dropped_per_ring(num_streams, 0);
+
+    // Number of samples given to each stream so far
+    int64_t num_samples = 0;
+
+    // Number of samples popped from the first ring but not given to the
+    // streams, i.e., skipped while resyncing. The sample_clock counts the
+    // samples of the first ring, which are num_samples + num_discarded.
+    int64_t num_discarded = 0;
+    std::chrono::steady_clock::time_point captured;
+
+    auto report = [&](int32_t s, const sherpa_onnx::KeywordResult &r) {
+      // Frames count from the start of the stream. The last one is where
+      // the last token of the keyword is decoded. Its last sample is mapped
+      // to the first ring with the samples discarded so far, which is off
+      // only if the keyword spans a resync.
+      if (trace_latency && !r.frames.empty()) {
+        int64_t end_sample =
+            r.frames.back() * frame_shift_samples + frame_end - 1;
+        if (sample_clock.Lookup(end_sample + num_discarded, &captured)) {
+          latency_stats.end_to_end.AddSince(captured);
+        }
+      }
+
+      display.Print(keyword_index, r.AsJsonString() + "\n");
+
+      sherpa_onnx::KeywordEvent event;
+      event.time_ms = NowMs();
+      event.result = r;
+      if (num_channels > 1) {
+        event.source = "channel " + std::to_string(selected_channels[s]);
+      }
+
+      if (!dispatcher.Post(std::move(event))) {
+        fprintf(stderr, "Event queue is full. Dropped %s\n",
+                r.keyword.c_str());
+      }
+
+      fflush(stderr);
+      keyword_index++;
+    };
+
+    while (true) {
+      if (dump_latency_stats.exchange(false)) {
+        DumpLatencyStats(latency_stats, latency_stats_file);
+      }
+
+      int32_t n = rings[0]->WaitPop(samples[0].data(), chunk_size, 100);
+      if (n == 0) {
+        if (rings[0]->IsClosed()) break;
+        continue;
+      }
+
+      // The other rings are pushed together with the first one, so their
+      // samples are usually already there. If one of them runs short or
+      // any ring has dropped samples, they no longer hold the same samples.
+      bool in_step = true;
+      for (int32_t i = 1; i != num_streams; ++i) {
+        if (rings[i]->WaitPop(samples[i].data(), n, 100) != n) {
+          in_step = false;
+        }
+      }
+
+      int64_t dropped = 0;
+      for (int32_t i = 0; i != num_streams; ++i) {
+        int64_t d = rings[i]->NumDropped();
+        if (num_streams > 1 && d != last_dropped_per_ring[i]) {
+          in_step = false;
+        }
+        last_dropped_per_ring[i] = d;
+        dropped += d;
+      }
+
+      if (dropped != last_dropped) {
+        fprintf(stderr, "❌ dropped %lld samples (total %lld) in %d ring(s)\n",
+                static_cast<long long>(dropped - last_dropped),  // NOLINT
+                static_cast<long long>(dropped), num_streams);   // NOLINT
+        last_dropped = dropped;
+      }
+
+      if (!in_step) {
+        fprintf(stderr,
+                "Channels are out of step. Skip the chunk and resync.\n");
+        int64_t discarded = n;
+
+        // Block until capture has paused. It is closed on exit.
+        resync = kResyncRequested;
+        int32_t paused = 0;
+        if (!resync_paused.WaitPopItem(&paused)) {
+          break;
+        }
+
+        // Capture is paused, so all rings can be emptied
+        for (int32_t i = 0; i != num_streams; ++i) {
+          int32_t k = 0;
+          while ((k = rings[i]->Pop(samples[i].data(), chunk_size)) > 0) {
+            if (i == 0) {
+              discarded += k;
+            }
+          }
+          last_dropped_per_ring[i] = rings[i]->NumDropped();
+        }
+
+        num_discarded += discarded;
+        fprintf(stderr, "Discarded %lld samples (total %lld) to resync\n",
+                static_cast<long long>(discarded),       // NOLINT
+                static_cast<long long>(num_discarded));  // NOLINT
+        last_dropped = 0;
+        for (auto d : last_dropped_per_ring) {
+          last_dropped += d;
+        }
+
+        resync = kNoResync;
+        continue;
+      }
+
+      num_samples += n;
+
+      if (trace_latency &&
+          sample_clock.Lookup(num_samples + num_discarded - 1, &captured)) {
+        latency_stats.queue.AddSince(captured);
+      }
+
+      if (!started) {
+        started = true;
+        sherpa_onnx::KeywordEvent event;
+        event.time_ms = NowMs();
+        event.result.keyword = "__STARTED__";
+        dispatcher.Post(std::move(event));
+      }
+
+      auto feature_start = std::chrono::steady_clock::now();
+      for (int32_t i = 0; i != num_streams; ++i) {
+        streams[i]->AcceptWaveform(expected_sample_rate, samples[i].data(), n);
+      }
+      if (trace_latency) {
+        latency_stats.feature.AddSince(feature_start);
+      }
+
+      // All channels hear the same speaker, so the first one decides
+      bool open = gate.AcceptWaveform(samples[0].data(), n);
+      if (!open) {
+        // The streams are skipped together, like they are decoded together.
+        // Once the gate opens, they are decoded from the pre-roll with the
+        // initial encoder states.
+        int32_t skipped = 0;
+        for (auto &s : streams) {
+          skipped = std::max(
+              skipped, spotter.SkipFrames(s.get(), num_preroll_frames));
+        }
+        num_skipped_encoder_runs += skipped;
+        continue;
       }
-      
-      if (!local_buffer.empty()) {
-        
-        if(!started){
-          started = true;
-          LogKeyword("__STARTED__");
+
+      while (true) {
+        ready.clear();
+        for (auto &s : streams) {
+          if (spotter.IsReady(s.get())) {
+            ready.push_back(s.get());
+          }
+        }
+
+        if (ready.empty()) {
+          break;
         }
 
-        fprintf(stderr, "🔥 Processing buffer size: %d\n", local_buffer.size());
-        
-        stream->AcceptWaveform(expected_sample_rate, local_buffer.data(), local_buffer.size());
-        
-        while (spotter.IsReady(stream.get())) {
-          spotter.DecodeStream(stream.get());
-          
-          const auto r = spotter.GetResult(stream.get());
-          if (!r.keyword.empty()) {
-            display.Print(keyword_index, r.AsJsonString()+"\n");
-
-            LogKeyword(r.keyword);
-
-            fflush(stderr);
-            keyword_index++;
-            
-            spotter.Reset(stream.get());
+        // Streams of all channels run through the encoder in one batch
+        spotter.DecodeStreams(ready.data(), ready.size());
+        ++num_encoder_runs;
+
+        int32_t best = -1;
+        for (int32_t i = 0; i != num_streams; ++i) {
+          results[i] = spotter.GetResult(streams[i].get());
+          if (results[i].keyword.empty()) {
+            continue;
+          }
+
+          if (!fuse_channels) {
+            report(i, results[i]);
+            spotter.Reset(streams[i].get());
+          } else if (best == -1 || results[i].score > results[best].score) {
+            best = i;
+          }
+        }
+
+        if (best != -1) {
+          report(best, results[best]);
+
+          // Otherwise, other channels would report the same keyword later
+          for (auto &s : streams) {
+            spotter.Reset(s.get());
           }
         }
       }
@@ -242,33 +610,87 @@ as the device_name.
   });
 
   // 主线程负责采集音频
+  sherpa_onnx::ConfigureCurrentThread(scheduling_config.capture_cpus,
+                                      scheduling_config.capture_priority,
+                                      "capture");
+  int64_t num_pushed = 0;
+  std::vector<float> capture_buf;
   while (!stop) {
-    const std::vector<float> &samples = alsa.Read(chunk_size);
-    
-    writing_buffer->insert(writing_buffer->end(), samples.begin(), samples.end());
-    
-    if (writing_buffer->size() >= chunk_size) {
-      std::unique_lock<std::mutex> lock(buffer_mutex);
-      if (!buffer_ready) {
-        // 交换缓冲区
-        std::swap(writing_buffer, processing_buffer);
-        buffer_ready = true;
-        lock.unlock();
-        buffer_cv.notify_one();
-      }
+    if (num_channels == 1) {
+      // Converted and resampled straight into capture_buf
+      capture_buf.resize(alsa.MaxReadSize(period_size));
+      int32_t n = alsa.Read(period_size, capture_buf.data());
+      num_pushed += rings[0]->Push(capture_buf.data(), n);
     } else {
-      struct timespec ts = {0, 1 * 1000000};  // 1毫秒
-      nanosleep(&ts, nullptr);
+      const auto &samples = alsa.ReadChannels(period_size);
+
+      int32_t expected = kResyncRequested;
+      if (resync.load() != kNoResync) {
+        // Keep reading so that ALSA does not overrun, but push nothing
+        // until the decoding thread has emptied the rings
+        if (resync.compare_exchange_strong(expected, kResyncPaused)) {
+          resync_paused.PushItem(int32_t{kResyncPaused});
+        }
+        continue;
+      }
+
+      // The decoding thread counts the samples of the first ring
+      for (int32_t i = 0; i != num_streams; ++i) {
+        const auto &c = samples[selected_channels[i]];
+        int32_t pushed = rings[i]->Push(c.data(), c.size());
+        if (i == 0) {
+          num_pushed += pushed;
+        }
+      }
+    }
+
+    if (trace_latency) {
+      // Stamp the samples accepted by the ring, so that indexes match the
+      // ones seen by the decoding thread even if samples are dropped.
+      latency_stats.capture_wait.Add(alsa.LastWaitMs());
+      sample_clock.Stamp(num_pushed, alsa.LastReadTime());
     }
   }
-  
+
   // 等待处理线程结束
-  {
-    std::lock_guard<std::mutex> lock(buffer_mutex);
-    buffer_ready = true;
+  for (auto &r : rings) {
+    r->Close();
   }
-  buffer_cv.notify_one();
+  resync_paused.Close();
   processing_thread.join();
 
+  if (keywords_watcher) {
+    keywords_watcher->Stop();
+  }
+
+  dispatcher.Stop();
+
+  if (trace_latency) {
+    DumpLatencyStats(latency_stats, latency_stats_file);
+  }
+
+  int64_t num_hits = 0;
+  int64_t num_misses = 0;
+  for (auto &s : streams) {
+    const auto &cache = s->GetDecoderOutCache();
+    num_hits += cache.NumHits();
+    num_misses += cache.NumMisses();
+  }
+  fprintf(stderr, "Decoder cache: %lld hits, %lld misses, hit rate: %.2f%%\n",
+          static_cast<long long>(num_hits),    // NOLINT
+          static_cast<long long>(num_misses),  // NOLINT
+          num_hits + num_misses
+              ? 100.0 * num_hits / (num_hits + num_misses)
+              : 0.0);
+
+  if (gate_config.type != "none") {
+    int64_t total = num_encoder_runs + num_skipped_encoder_runs;
+    fprintf(stderr,
+            "Speech gate: skipped %lld of %lld encoder runs (%.2f%%)\n",
+            static_cast<long long>(num_skipped_encoder_runs),  // NOLINT
+            static_cast<long long>(total),                     // NOLINT
+            total ? 100.0 * num_skipped_encoder_runs / total : 0.0);
+  }
+
   return 0;
 }
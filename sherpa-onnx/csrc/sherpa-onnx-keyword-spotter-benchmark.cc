@@ -0,0 +1,410 @@
+// sherpa-onnx/csrc/sherpa-onnx-keyword-spotter-benchmark.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include <stdio.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "sherpa-onnx/csrc/keyword-spotter.h"
+#include "sherpa-onnx/csrc/latency-stats.h"
+#include "sherpa-onnx/csrc/online-stream.h"
+#include "sherpa-onnx/csrc/parse-options.h"
+#include "sherpa-onnx/csrc/text-utils.h"
+#include "sherpa-onnx/csrc/wave-reader.h"
+
+struct ManifestEntry {
+  std::string filename;
+
+  // Keywords expected in the file. Empty for negative samples.
+  std::vector<std::string> keywords;
+};
+
+static bool ReadManifest(const std::string &filename,
+                         std::vector<ManifestEntry> *entries) {
+  std::ifstream is(filename);
+  if (!is) {
+    fprintf(stderr, "Failed to open '%s'\n", filename.c_str());
+    return false;
+  }
+
+  std::string line;
+  while (std::getline(is, line)) {
+    std::istringstream iss(line);
+    ManifestEntry e;
+    if (!(iss >> e.filename) || e.filename[0] == '#') {
+      continue;
+    }
+
+    std::string keyword;
+    while (iss >> keyword) {
+      e.keywords.push_back(keyword);
+    }
+
+    entries->push_back(std::move(e));
+  }
+
+  return true;
+}
+
+// Peak resident set size of this process in MB, or -1 if unknown
+static float PeakRssMb() {
+#ifndef _WIN32
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024.0f / 1024.0f;  // in bytes
+#else
+    return usage.ru_maxrss / 1024.0f;  // in KB
+#endif
+  }
+#endif
+  return -1;
+}
+
+// Results of running the keyword spotter over the corpus
+struct CorpusResult {
+  double duration = 0;  // in seconds
+
+  // Duration of the audio given to the keyword spotter, i.e., including
+  // the tail padding, in seconds
+  double processed_duration = 0;
+
+  double elapsed_seconds = 0;  // excluding reading wave files
+  int64_t num_expected = 0;
+  int64_t num_missed = 0;
+  int64_t num_false_accepts = 0;
+
+  // detections[i] contains the sorted keywords detected in the i-th file
+  std::vector<std::vector<std::string>> detections;
+
+  float Rtf() const { return elapsed_seconds / processed_duration; }
+
+  float MissRate() const {
+    return num_expected ? static_cast<float>(num_missed) / num_expected : 0;
+  }
+
+  float Hours() const { return duration / 3600; }
+
+  float FalseAcceptsPerHour() const {
+    float hours = Hours();
+    return hours > 0 ? num_false_accepts / hours : 0;
+  }
+};
+
+static bool RunCorpus(const sherpa_onnx::KeywordSpotterConfig &config,
+                      const std::vector<ManifestEntry> &entries,
+                      int32_t chunk_ms, int32_t tail_padding_ms, bool verbose,
+                      CorpusResult *result) {
+  sherpa_onnx::KeywordSpotter keyword_spotter(config);
+
+  sherpa_onnx::KeywordSpotterLatencyStats stats;
+  keyword_spotter.SetLatencyStats(&stats);
+
+  sherpa_onnx::LatencyHistogram chunk_latency("chunk");
+
+  for (const auto &e : entries) {
+    int32_t sampling_rate = -1;
+    bool is_ok = false;
+    std::vector<float> samples =
+        sherpa_onnx::ReadWave(e.filename, &sampling_rate, &is_ok);
+
+    if (!is_ok) {
+      fprintf(stderr, "Failed to read '%s'\n", e.filename.c_str());
+      return false;
+    }
+
+    result->duration += samples.size() / static_cast<double>(sampling_rate);
+
+    // The padding is decoded like the rest, so it counts towards the RTF,
+    // but not towards false accepts per hour
+    int64_t num_padding =
+        static_cast<int64_t>(sampling_rate) * tail_padding_ms / 1000;
+    samples.resize(samples.size() + num_padding);
+    result->processed_duration +=
+        samples.size() / static_cast<double>(sampling_rate);
+
+    int32_t chunk_size =
+        std::max(1, static_cast<int32_t>(
+                        static_cast<int64_t>(sampling_rate) * chunk_ms / 1000));
+
+    std::vector<sherpa_onnx::KeywordResult> detections;
+
+    const auto begin = std::chrono::steady_clock::now();
+
+    auto s = keyword_spotter.CreateStream();
+    for (size_t start = 0; start < samples.size(); start += chunk_size) {
+      int32_t n =
+          static_cast<int32_t>(std::min<size_t>(chunk_size,
+                                                samples.size() - start));
+
+      const auto chunk_begin = std::chrono::steady_clock::now();
+
+      s->AcceptWaveform(sampling_rate, samples.data() + start, n);
+      if (start + n == samples.size()) {
+        s->InputFinished();
+      }
+
+      while (keyword_spotter.IsReady(s.get())) {
+        keyword_spotter.DecodeStream(s.get());
+
+        auto r = keyword_spotter.GetResult(s.get());
+        if (!r.keyword.empty()) {
+          detections.push_back(std::move(r));
+          keyword_spotter.Reset(s.get());
+        }
+      }
+
+      chunk_latency.AddSince(chunk_begin);
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    result->elapsed_seconds +=
+        std::chrono::duration<double>(end - begin).count();
+
+    // Match detections against the expected keywords. Each detection can
+    // match only one expected occurrence.
+    std::vector<std::string> expected = e.keywords;
+    int32_t false_accepts = 0;
+    for (const auto &r : detections) {
+      auto it = std::find(expected.begin(), expected.end(), r.keyword);
+      if (it != expected.end()) {
+        expected.erase(it);
+      } else {
+        ++false_accepts;
+      }
+    }
+
+    result->num_expected += e.keywords.size();
+    result->num_missed += expected.size();
+    result->num_false_accepts += false_accepts;
+
+    if (verbose) {
+      std::ostringstream os;
+      os << e.filename << "\n";
+      for (const auto &r : detections) {
+        os << "  " << r.AsJsonString() << "\n";
+      }
+      for (const auto &k : expected) {
+        os << "  missed: " << k << "\n";
+      }
+      if (false_accepts) {
+        os << "  false accepts: " << false_accepts << "\n";
+      }
+      fprintf(stderr, "%s", os.str().c_str());
+    }
+
+    std::vector<std::string> keywords;
+    for (const auto &r : detections) {
+      keywords.push_back(r.keyword);
+    }
+    std::sort(keywords.begin(), keywords.end());
+    result->detections.push_back(std::move(keywords));
+  }
+
+  const CorpusResult &r = *result;
+
+  fprintf(stderr, "\nNumber of files: %d\n",
+          static_cast<int32_t>(entries.size()));
+  fprintf(stderr, "Audio duration: %.3f s (%.3f s with tail padding)\n",
+          r.duration, r.processed_duration);
+  fprintf(stderr, "Elapsed seconds: %.3f s\n", r.elapsed_seconds);
+  fprintf(stderr, "Real time factor (RTF): %.3f / %.3f = %.3f\n",
+          r.elapsed_seconds, r.processed_duration, r.Rtf());
+  fprintf(stderr, "%s\n", chunk_latency.ToString().c_str());
+  fprintf(stderr, "%s\n", stats.encoder.ToString().c_str());
+  fprintf(stderr, "%s\n", stats.search.ToString().c_str());
+  fprintf(stderr, "Peak RSS: %.2f MB\n", PeakRssMb());
+  fprintf(stderr, "Miss rate: %lld / %lld = %.4f\n",
+          static_cast<long long>(r.num_missed),    // NOLINT
+          static_cast<long long>(r.num_expected),  // NOLINT
+          r.MissRate());
+  fprintf(stderr, "False accepts per hour: %lld / %.4f = %.3f\n",
+          static_cast<long long>(r.num_false_accepts),  // NOLINT
+          r.Hours(), r.FalseAcceptsPerHour());
+
+  return true;
+}
+
+int main(int32_t argc, char *argv[]) {
+  const char *kUsageMessage = R"usage(
+Benchmark and evaluate keyword spotting on a labeled corpus of wave files.
+
+Files are streamed through the keyword spotter chunk by chunk, as fast as
+possible, in the same way as sherpa-onnx-keyword-spotter-alsa does with live
+audio.
+
+Usage:
+
+  ./bin/sherpa-onnx-keyword-spotter-benchmark \
+    --tokens=/path/to/tokens.txt \
+    --encoder=/path/to/encoder.onnx \
+    --decoder=/path/to/decoder.onnx \
+    --joiner=/path/to/joiner.onnx \
+    --provider=cpu \
+    --num-threads=1 \
+    --keywords-file=keywords.txt \
+    --keywords-threshold=0.25 \
+    --num-trailing-blanks=1 \
+    --chunk-ms=100 \
+    /path/to/manifest.txt
+
+Each line of the manifest contains a wave file followed by the keywords it
+contains, separated by spaces, e.g.,
+
+  /path/to/positive.wav 小爱同学
+  /path/to/two-keywords.wav 小爱同学 天猫精灵
+  /path/to/negative.wav
+
+A keyword is the keyword field of the result, i.e., the text after @ in the
+keywords file if present, so it must not contain spaces. Lines starting
+with # are ignored.
+
+It reports:
+
+  - Real time factor (RTF), i.e., processing time / duration of the audio
+    processed. Both include the --tail-padding-ms of silence appended to
+    each file, since it is decoded like the rest. Reading wave files is not
+    included.
+  - Latency percentiles of processing a chunk, i.e., AcceptWaveform() plus
+    decoding all frames that are ready, and of the encoder and search.
+  - Peak resident set size (RSS).
+  - Miss rate, i.e., expected keywords not detected / expected keywords.
+  - False accepts per hour, i.e., detections not listed in the manifest
+    per hour of audio.
+
+To check a quantized model before shipping it, pass --precisions, e.g.,
+--precisions=fp32,int8. The corpus is run once with the model files of each
+precision, see --model-precision, and it also reports the drift of the
+others from the first one: the files whose detected keywords differ, and
+the change of the miss rate, false accepts and RTF. With --max-drift, it
+fails if too many files differ.
+)usage";
+
+  sherpa_onnx::ParseOptions po(kUsageMessage);
+  sherpa_onnx::KeywordSpotterConfig config;
+
+  int32_t chunk_ms = 100;
+  int32_t tail_padding_ms = 800;
+  bool verbose = false;
+  std::string precisions;
+  float max_drift = -1;
+
+  config.Register(&po);
+  po.Register("chunk-ms", &chunk_ms,
+              "Milliseconds of audio given to the keyword spotter at a time");
+  po.Register("tail-padding-ms", &tail_padding_ms,
+              "Milliseconds of silence appended to each file");
+  po.Register("verbose", &verbose, "true to print the results of each file");
+  po.Register("precisions", &precisions,
+              "Comma separated model precisions, e.g., fp32,int8, to run the "
+              "corpus with in turn. It overrides --model-precision");
+  po.Register("max-drift", &max_drift,
+              "With --precisions, fail if the fraction of files whose "
+              "detected keywords differ from those of the first precision "
+              "is larger than this. Negative to not check it");
+
+  po.Read(argc, argv);
+
+  // Everything runs in one thread
+  config.feat_config.single_threaded = true;
+
+  if (po.NumArgs() != 1) {
+    po.PrintUsage();
+    exit(EXIT_FAILURE);
+  }
+
+  std::vector<std::string> precision_list;
+  sherpa_onnx::SplitStringToVector(precisions, ",", true, &precision_list);
+  if (precision_list.empty()) {
+    precision_list.push_back(config.model_config.precision);
+  }
+
+  std::vector<sherpa_onnx::KeywordSpotterConfig> configs;
+  for (const auto &precision : precision_list) {
+    configs.push_back(config);
+    configs.back().model_config.precision = precision;
+
+    fprintf(stderr, "%s\n", configs.back().ToString().c_str());
+
+    if (!configs.back().Validate()) {
+      fprintf(stderr, "Errors in config!\n");
+      return -1;
+    }
+  }
+
+  if (chunk_ms <= 0) {
+    fprintf(stderr, "--chunk-ms should be positive. Given: %d\n", chunk_ms);
+    return -1;
+  }
+
+  std::vector<ManifestEntry> entries;
+  if (!ReadManifest(po.GetArg(1), &entries)) {
+    return -1;
+  }
+
+  if (entries.empty()) {
+    fprintf(stderr, "No wave files in '%s'\n", po.GetArg(1).c_str());
+    return -1;
+  }
+
+  std::vector<CorpusResult> results(configs.size());
+  for (size_t i = 0; i != configs.size(); ++i) {
+    if (configs.size() > 1) {
+      fprintf(stderr, "\nPrecision: %s\n", precision_list[i].c_str());
+    }
+
+    if (!RunCorpus(configs[i], entries, chunk_ms, tail_padding_ms, verbose,
+                   &results[i])) {
+      return -1;
+    }
+  }
+
+  bool ok = true;
+  const CorpusResult &ref = results[0];
+  for (size_t i = 1; i != results.size(); ++i) {
+    const CorpusResult &r = results[i];
+
+    int32_t num_differ = 0;
+    for (size_t k = 0; k != entries.size(); ++k) {
+      if (r.detections[k] != ref.detections[k]) {
+        ++num_differ;
+        if (verbose) {
+          fprintf(stderr, "%s: detections differ between %s and %s\n",
+                  entries[k].filename.c_str(), precision_list[0].c_str(),
+                  precision_list[i].c_str());
+        }
+      }
+    }
+
+    float drift = static_cast<float>(num_differ) / entries.size();
+
+    fprintf(stderr, "\nDrift of %s from %s\n", precision_list[i].c_str(),
+            precision_list[0].c_str());
+    fprintf(stderr, "Files with different detections: %d / %d = %.4f\n",
+            num_differ, static_cast<int32_t>(entries.size()), drift);
+    fprintf(stderr, "Miss rate: %.4f -> %.4f (%+.4f)\n", ref.MissRate(),
+            r.MissRate(), r.MissRate() - ref.MissRate());
+    fprintf(stderr, "False accepts per hour: %.3f -> %.3f (%+.3f)\n",
+            ref.FalseAcceptsPerHour(), r.FalseAcceptsPerHour(),
+            r.FalseAcceptsPerHour() - ref.FalseAcceptsPerHour());
+    fprintf(stderr, "RTF: %.3f -> %.3f (%.2fx speed)\n", ref.Rtf(), r.Rtf(),
+            ref.Rtf() / r.Rtf());
+
+    if (max_drift >= 0 && drift > max_drift) {
+      fprintf(stderr, "Drift %.4f is larger than --max-drift=%.4f\n", drift,
+              max_drift);
+      ok = false;
+    }
+  }
+
+  return ok ? 0 : -1;
+}
@@ -0,0 +1,313 @@
+// sherpa-onnx/csrc/sherpa-onnx-keyword-spotter-server.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "sherpa-onnx/csrc/alsa.h"
+#include "sherpa-onnx/csrc/keyword-event-sink.h"
+#include "sherpa-onnx/csrc/keyword-spotter-scheduler.h"
+#include "sherpa-onnx/csrc/keyword-spotter.h"
+#include "sherpa-onnx/csrc/parse-options.h"
+
+std::atomic<bool> stop(false);
+
+static void Handler(int sig) {
+  stop = true;
+  fprintf(stderr, "\nCaught Ctrl + C. Exiting...\n");
+}
+
+static int64_t NowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+// Capture from an ALSA device until stop is set
+static void CaptureAlsa(sherpa_onnx::Alsa *alsa, int32_t period_size,
+                        sherpa_onnx::KeywordSpotterScheduler *scheduler,
+                        int32_t source) {
+  std::vector<float> samples;
+  while (!stop) {
+    samples.resize(alsa->MaxReadSize(period_size));
+    int32_t n = alsa->Read(period_size, samples.data());
+    scheduler->AcceptWaveform(source, samples.data(), n);
+  }
+}
+
+// Receive 16-bit little-endian mono PCM datagrams until stop is set
+static void ReceiveUdp(int32_t fd,
+                       sherpa_onnx::KeywordSpotterScheduler *scheduler,
+                       int32_t source) {
+  std::vector<uint8_t> buf(65536);
+  std::vector<float> samples;
+
+  while (!stop) {
+    ssize_t n = recv(fd, buf.data(), buf.size(), 0);
+    if (n <= 0) {
+      // Timeout, so that stop is checked
+      continue;
+    }
+
+    // Assemble the samples from bytes, so that it does not depend on the
+    // byte order of the host
+    int32_t num_samples = static_cast<int32_t>(n / 2);
+    samples.resize(num_samples);
+    for (int32_t i = 0; i != num_samples; ++i) {
+      auto s = static_cast<int16_t>(buf[2 * i] | (buf[2 * i + 1] << 8));
+      samples[i] = s / 32768.0f;
+    }
+
+    scheduler->AcceptWaveform(source, samples.data(), num_samples);
+  }
+
+  close(fd);
+}
+
+// @return Return -1 on error
+static int32_t OpenUdp(int32_t port) {
+  int32_t fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd == -1) {
+    fprintf(stderr, "Failed to create a socket: %s\n", strerror(errno));
+    return -1;
+  }
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+
+  if (bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) ==
+      -1) {
+    fprintf(stderr, "Failed to bind to UDP port %d: %s\n", port,
+            strerror(errno));
+    close(fd);
+    return -1;
+  }
+
+  struct timeval timeout;
+  timeout.tv_sec = 0;
+  timeout.tv_usec = 100 * 1000;
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  return fd;
+}
+
+int main(int32_t argc, char *argv[]) {
+  signal(SIGINT, Handler);
+  signal(SIGTERM, Handler);
+
+  const char *kUsageMessage = R"usage(
+Keyword spotting on many audio sources in one process.
+
+Streams of all sources are decoded by one keyword spotter. Streams that are
+ready are decoded together in batches of up to --max-batch-size, so the
+encoder runs once per batch. A stream waits at most --max-latency-ms for
+other streams to join its batch.
+
+Usage:
+
+  ./bin/sherpa-onnx-keyword-spotter-server \
+    --tokens=/path/to/tokens.txt \
+    --encoder=/path/to/encoder.onnx \
+    --decoder=/path/to/decoder.onnx \
+    --joiner=/path/to/joiner.onnx \
+    --provider=cpu \
+    --num-threads=2 \
+    --keywords-file=keywords.txt \
+    --max-batch-size=8 \
+    --max-latency-ms=40 \
+    --event-sinks=stdout \
+    alsa:plughw:0,0 alsa:plughw:1,0 udp:9000 udp:9001
+
+Each positional argument is an audio source:
+
+  alsa:device   Capture from an ALSA device. See
+                sherpa-onnx-keyword-spotter-alsa for how to find the
+                device name.
+  udp:port      Receive datagrams of 16-bit little-endian mono PCM at the
+                sample rate of the model on the given UDP port, e.g., from a
+                satellite speaker. Each port is one source.
+
+Detections are written to --event-sinks. The "source" field of each event
+is the argument of its source. See sherpa-onnx-keyword-spotter-alsa for the
+supported sinks.
+)usage";
+
+  sherpa_onnx::ParseOptions po(kUsageMessage);
+  sherpa_onnx::KeywordSpotterConfig config;
+  sherpa_onnx::KeywordSpotterSchedulerConfig scheduler_config;
+
+  config.Register(&po);
+  scheduler_config.Register(&po);
+
+  int32_t buffer_size = 1365;
+  int32_t period_size = 170;
+  std::string event_sinks = "stdout";
+
+  po.Register("buffer-size", &buffer_size,
+              "ALSA buffer size in frames. Default: 1365");
+  po.Register("period-size", &period_size,
+              "ALSA period size in frames. Default: 170");
+  po.Register("event-sinks", &event_sinks,
+              "Comma-separated destinations for detected keywords. "
+              "Default: stdout");
+
+  po.Read(argc, argv);
+
+  // Streams are fed and decoded only by the scheduler thread. Audio is
+  // handed over through rings, so feature extraction needs no locking.
+  config.feat_config.single_threaded = true;
+
+  if (po.NumArgs() < 1) {
+    fprintf(stderr, "Please provide at least one audio source\n");
+    po.PrintUsage();
+    exit(EXIT_FAILURE);
+  }
+
+  scheduler_config.sample_rate = config.feat_config.sampling_rate;
+
+  fprintf(stderr, "%s\n", config.ToString().c_str());
+  fprintf(stderr, "%s\n", scheduler_config.ToString().c_str());
+
+  if (!config.Validate() || !scheduler_config.Validate()) {
+    fprintf(stderr, "Errors in config!\n");
+    return -1;
+  }
+
+  std::vector<std::unique_ptr<sherpa_onnx::KeywordEventSink>> sinks;
+  {
+    std::istringstream is(event_sinks);
+    std::string spec;
+    while (std::getline(is, spec, ',')) {
+      if (spec.empty()) continue;
+
+      auto sink = sherpa_onnx::CreateKeywordEventSink(spec);
+      if (!sink) {
+        fprintf(stderr, "Invalid event sink: %s\n", spec.c_str());
+        return -1;
+      }
+      sinks.push_back(std::move(sink));
+    }
+  }
+
+  sherpa_onnx::KeywordEventDispatcher dispatcher(std::move(sinks));
+
+  sherpa_onnx::KeywordSpotter spotter(config);
+
+  // Filled before the scheduler starts
+  std::vector<std::string> source_names;
+
+  sherpa_onnx::KeywordSpotterScheduler scheduler(
+      &spotter, scheduler_config,
+      [&](int32_t source, const sherpa_onnx::KeywordResult &r) {
+        sherpa_onnx::KeywordEvent event;
+        event.time_ms = NowMs();
+        event.result = r;
+        event.source = source_names[source];
+
+        fprintf(stderr, "%s\n", event.AsJsonString().c_str());
+
+        if (!dispatcher.Post(std::move(event))) {
+          fprintf(stderr, "Event queue is full. Dropped %s\n",
+                  r.keyword.c_str());
+        }
+      });
+
+  // Open all sources before starting any thread, so that errors in the
+  // arguments are reported early.
+  std::vector<std::unique_ptr<sherpa_onnx::Alsa>> alsa_devices;
+  std::vector<int32_t> alsa_sources;
+  std::vector<int32_t> udp_fds;
+  std::vector<int32_t> udp_sources;
+
+  for (int32_t i = 1; i <= po.NumArgs(); ++i) {
+    std::string arg = po.GetArg(i);
+
+    if (arg.compare(0, 5, "alsa:") == 0) {
+      std::string device_name = arg.substr(5);
+      auto alsa = std::make_unique<sherpa_onnx::Alsa>(
+          device_name.c_str(), period_size, buffer_size);
+
+      if (alsa->GetExpectedSampleRate() != scheduler_config.sample_rate) {
+        fprintf(stderr, "%s: sample rate: %d != %d\n", arg.c_str(),
+                alsa->GetExpectedSampleRate(), scheduler_config.sample_rate);
+        return -1;
+      }
+
+      alsa_devices.push_back(std::move(alsa));
+      alsa_sources.push_back(scheduler.AddSource(arg));
+    } else if (arg.compare(0, 4, "udp:") == 0) {
+      int32_t fd = OpenUdp(atoi(arg.c_str() + 4));
+      if (fd == -1) {
+        return -1;
+      }
+
+      udp_fds.push_back(fd);
+      udp_sources.push_back(scheduler.AddSource(arg));
+    } else {
+      fprintf(stderr, "Invalid audio source: %s\n", arg.c_str());
+      po.PrintUsage();
+      return -1;
+    }
+
+    source_names.push_back(arg);
+    fprintf(stderr, "Source %d: %s\n", scheduler.NumSources() - 1,
+            arg.c_str());
+  }
+
+  scheduler.Start();
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i != alsa_devices.size(); ++i) {
+    threads.emplace_back(CaptureAlsa, alsa_devices[i].get(), period_size,
+                         &scheduler, alsa_sources[i]);
+  }
+
+  for (size_t i = 0; i != udp_fds.size(); ++i) {
+    threads.emplace_back(ReceiveUdp, udp_fds[i], &scheduler, udp_sources[i]);
+  }
+
+  fprintf(stderr, "Started! Please speak\n");
+
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  scheduler.Stop();
+  dispatcher.Stop();
+
+  int64_t num_batches = scheduler.NumBatches();
+  fprintf(stderr, "Batches: %lld, average batch size: %.2f\n",
+          static_cast<long long>(num_batches),  // NOLINT
+          num_batches ? static_cast<float>(scheduler.NumDecodedStreams()) /
+                            num_batches
+                      : 0);
+  fprintf(stderr, "%s\n", scheduler.ScheduleDelay().ToString().c_str());
+
+  for (int32_t i = 0; i != scheduler.NumSources(); ++i) {
+    fprintf(stderr, "%s: dropped %lld samples\n",
+            scheduler.SourceName(i).c_str(),
+            static_cast<long long>(scheduler.NumDropped(i)));  // NOLINT
+  }
+
+  return 0;
+}
@@ -20,6 +20,7 @@
 #include "sherpa-onnx/csrc/file-utils.h"
 #include "sherpa-onnx/csrc/macros.h"
 #include "sherpa-onnx/csrc/onnx-utils.h"
+#include "sherpa-onnx/csrc/session-registry.h"
 #include "sherpa-onnx/csrc/session.h"
 
 namespace sherpa_onnx {
@@ -28,12 +29,14 @@ class SileroVadModel::Impl {
  public:
   explicit Impl(const VadModelConfig &config)
       : config_(config),
-        env_(ORT_LOGGING_LEVEL_ERROR),
         sess_opts_(GetSessionOptions(config)),
         allocator_{},
         sample_rate_(config.sample_rate) {
-    auto buf = ReadFile(config.silero_vad.model);
-    Init(buf.data(), buf.size());
+    // Shared with other VADs that use the same model, e.g., one per
+    // channel. Each VAD keeps its own states.
+    sess_ = GetSharedSession(config.silero_vad.model, sess_opts_,
+                             GetSessionOptionsKey(config));
+    Init();
 
     if (sample_rate_ != 16000) {
       SHERPA_ONNX_LOGE("Expected sample rate 16000. Given: %d",
@@ -50,12 +53,15 @@ class SileroVadModel::Impl {
   template <typename Manager>
   Impl(Manager *mgr, const VadModelConfig &config)
       : config_(config),
-        env_(ORT_LOGGING_LEVEL_ERROR),
         sess_opts_(GetSessionOptions(config)),
         allocator_{},
         sample_rate_(config.sample_rate) {
-    auto buf = ReadFile(mgr, config.silero_vad.model);
-    Init(buf.data(), buf.size());
+    {
+      auto buf = ReadFile(mgr, config.silero_vad.model);
+      sess_ = std::make_shared<Ort::Session>(GetOrtEnv(), buf.data(),
+                                             buf.size(), sess_opts_);
+    }
+    Init();
 
     if (sample_rate_ != 16000) {
       SHERPA_ONNX_LOGE("Expected sample rate 16000. Given: %d",
@@ -173,10 +179,7 @@ class SileroVadModel::Impl {
   }
 
  private:
-  void Init(void *model_data, size_t model_data_length) {
-    sess_ = std::make_unique<Ort::Session>(env_, model_data, model_data_length,
-                                           sess_opts_);
-
+  void Init() {
     GetInputNames(sess_.get(), &input_names_, &input_names_ptr_);
     GetOutputNames(sess_.get(), &output_names_, &output_names_ptr_);
 
@@ -411,11 +414,10 @@ class SileroVadModel::Impl {
  private:
   VadModelConfig config_;
 
-  Ort::Env env_;
   Ort::SessionOptions sess_opts_;
   Ort::AllocatorWithDefaultOptions allocator_;
 
-  std::unique_ptr<Ort::Session> sess_;
+  std::shared_ptr<Ort::Session> sess_;
 
   std::vector<std::string> input_names_;
   std::vector<const char *> input_names_ptr_;
@@ -0,0 +1,157 @@
+// sherpa-onnx/csrc/simd-fbank-test.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/simd-fbank.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "kaldi-native-fbank/csrc/online-feature.h"
+#include "sherpa-onnx/csrc/features.h"
+
+namespace sherpa_onnx {
+
+TEST(RealFftPlan, SameAsDft) {
+  for (int32_t n : {8, 16, 64, 512}) {
+    RealFftPlan plan(n);
+
+    std::mt19937 gen(n);
+    std::uniform_real_distribution<float> dist(-1, 1);
+    std::vector<float> in(n);
+    for (auto &x : in) {
+      x = dist(gen);
+    }
+
+    std::vector<float> out(n / 2 + 1);
+    plan.PowerSpectrum(in.data(), out.data());
+
+    for (int32_t k = 0; k <= n / 2; ++k) {
+      double re = 0;
+      double im = 0;
+      for (int32_t t = 0; t != n; ++t) {
+        double theta = 2 * M_PI * k * t / n;
+        re += in[t] * cos(theta);
+        im -= in[t] * sin(theta);
+      }
+      double expected = re * re + im * im;
+      EXPECT_NEAR(out[k], expected, 1e-4 * (1 + expected))
+          << "n " << n << ", bin " << k;
+    }
+  }
+}
+
+static knf::FbankOptions GetOptions(bool snip_edges) {
+  knf::FbankOptions opts;
+  opts.frame_opts.dither = 0;
+  opts.frame_opts.snip_edges = snip_edges;
+  opts.mel_opts.num_bins = 80;
+  opts.mel_opts.high_freq = -400;
+  return opts;
+}
+
+// Feed the same waveform in chunks of random sizes to both extractors
+static void CheckSameAsOnlineFbank(const knf::FbankOptions &opts) {
+  knf::OnlineFbank expected_fbank(opts);
+  SimdFbank fbank(opts);
+
+  std::mt19937 gen(opts.frame_opts.snip_edges);
+  std::normal_distribution<float> dist(0, 3000);
+  std::uniform_int_distribution<int32_t> chunk_dist(0, 1000);
+
+  // 2 seconds. The first 0.1 second is silence to check the log floor.
+  std::vector<float> samples(32000 + 123);
+  for (size_t i = 1600; i < samples.size(); ++i) {
+    samples[i] = dist(gen);
+  }
+
+  int32_t frame = 0;
+  auto check = [&]() {
+    ASSERT_EQ(fbank.NumFramesReady(), expected_fbank.NumFramesReady());
+
+    for (; frame < fbank.NumFramesReady(); ++frame) {
+      const float *expected = expected_fbank.GetFrame(frame);
+      const float *f = fbank.GetFrame(frame);
+      for (int32_t i = 0; i != fbank.Dim(); ++i) {
+        EXPECT_NEAR(f[i], expected[i], 2e-3) << "frame " << frame;
+      }
+
+      // Keep a few frames, as the online recognizer does
+      if (frame % 7 == 6) {
+        expected_fbank.Pop(5);
+        fbank.Pop(5);
+      }
+    }
+  };
+
+  size_t start = 0;
+  while (start < samples.size()) {
+    int32_t n = std::min<int32_t>(chunk_dist(gen), samples.size() - start);
+    expected_fbank.AcceptWaveform(16000, samples.data() + start, n);
+    fbank.AcceptWaveform(16000, samples.data() + start, n);
+    start += n;
+
+    check();
+  }
+
+  expected_fbank.InputFinished();
+  fbank.InputFinished();
+  check();
+
+  EXPECT_TRUE(fbank.IsLastFrame(fbank.NumFramesReady() - 1));
+}
+
+TEST(SimdFbank, SameAsOnlineFbank) {
+  CheckSameAsOnlineFbank(GetOptions(false));
+  CheckSameAsOnlineFbank(GetOptions(true));
+}
+
+TEST(SimdFbank, Hamming) {
+  auto opts = GetOptions(false);
+  opts.frame_opts.window_type = "hamming";
+  CheckSameAsOnlineFbank(opts);
+}
+
+TEST(SimdFbank, Unsupported) {
+  std::string reason;
+  auto opts = GetOptions(false);
+  EXPECT_TRUE(SimdFbank::IsSupported(opts, &reason));
+
+  opts.frame_opts.dither = 1;
+  EXPECT_FALSE(SimdFbank::IsSupported(opts, &reason));
+  EXPECT_FALSE(reason.empty());
+}
+
+TEST(SimdFbank, FeatureExtractor) {
+  FeatureExtractorConfig config;
+  FeatureExtractor expected_extractor(config);
+
+  config.fbank_backend = "simd";
+  FeatureExtractor extractor(config);
+
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> dist(-0.5, 0.5);
+  std::vector<float> samples(16000);
+  for (auto &x : samples) {
+    x = dist(gen);
+  }
+
+  expected_extractor.AcceptWaveform(16000, samples.data(), samples.size());
+  extractor.AcceptWaveform(16000, samples.data(), samples.size());
+
+  int32_t n = extractor.NumFramesReady();
+  ASSERT_EQ(n, expected_extractor.NumFramesReady());
+
+  auto expected = expected_extractor.GetFrames(0, n);
+  auto features = extractor.GetFrames(0, n);
+  ASSERT_EQ(features.size(), expected.size());
+  for (size_t i = 0; i != features.size(); ++i) {
+    EXPECT_NEAR(features[i], expected[i], 2e-3) << i;
+  }
+}
+
+}  // namespace sherpa_onnx
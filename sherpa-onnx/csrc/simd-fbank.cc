@@ -0,0 +1,712 @@
+// sherpa-onnx/csrc/simd-fbank.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/simd-fbank.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "sherpa-onnx/csrc/macros.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SHERPA_ONNX_SIMD_FBANK_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SHERPA_ONNX_SIMD_FBANK_SSE2 1
+#endif
+
+#ifndef M_PI
+#define M_PI 3.1415926535897932384626433832795
+#endif
+
+namespace sherpa_onnx {
+
+namespace {
+
+// Constants for the polynomial approximation of log() from Cephes.
+// See also http://gruntthepeon.free.fr/ssemath/
+constexpr float kLogSqrtHalf = 0.707106781186547524f;
+constexpr float kLogP0 = 7.0376836292e-2f;
+constexpr float kLogP1 = -1.1514610310e-1f;
+constexpr float kLogP2 = 1.1676998740e-1f;
+constexpr float kLogP3 = -1.2420140846e-1f;
+constexpr float kLogP4 = 1.4249322787e-1f;
+constexpr float kLogP5 = -1.6668057665e-1f;
+constexpr float kLogP6 = 2.0000714765e-1f;
+constexpr float kLogP7 = -2.4999993993e-1f;
+constexpr float kLogP8 = 3.3333331174e-1f;
+constexpr float kLogQ1 = -2.12194440e-4f;
+constexpr float kLogQ2 = 0.693359375f;
+
+int32_t RoundUpToPowerOfTwo(int32_t n) {
+  int32_t p = 1;
+  while (p < n) {
+    p <<= 1;
+  }
+  return p;
+}
+
+int32_t WindowSize(const knf::FrameExtractionOptions &opts) {
+  return static_cast<int32_t>(opts.samp_freq * 0.001f * opts.frame_length_ms);
+}
+
+int32_t WindowShift(const knf::FrameExtractionOptions &opts) {
+  return static_cast<int32_t>(opts.samp_freq * 0.001f * opts.frame_shift_ms);
+}
+
+// The same as knf::MelScale()
+float MelScale(float freq) { return 1127.0f * logf(1.0f + freq / 700.0f); }
+
+// The same as knf::FeatureWindowFunction
+std::vector<float> GetWindow(const knf::FrameExtractionOptions &opts) {
+  int32_t frame_length = WindowSize(opts);
+  std::vector<float> window(frame_length);
+
+  double a = 2 * M_PI / (frame_length - 1);
+  for (int32_t i = 0; i < frame_length; ++i) {
+    double i_fl = static_cast<double>(i);
+    if (opts.window_type == "hanning") {
+      window[i] = 0.5 - 0.5 * cos(a * i_fl);
+    } else if (opts.window_type == "sine") {
+      window[i] = sin(0.5 * a * i_fl);
+    } else if (opts.window_type == "hamming") {
+      window[i] = 0.54 - 0.46 * cos(a * i_fl);
+    } else if (opts.window_type == "povey") {
+      window[i] = pow(0.5 - 0.5 * cos(a * i_fl), 0.85);
+    } else if (opts.window_type == "rectangular") {
+      window[i] = 1.0;
+    } else if (opts.window_type == "blackman") {
+      window[i] = opts.blackman_coeff - 0.5 * cos(a * i_fl) +
+                  (0.5 - opts.blackman_coeff) * cos(2 * a * i_fl);
+    }
+  }
+
+  return window;
+}
+
+#if SHERPA_ONNX_SIMD_FBANK_NEON
+
+inline float HorizontalSum(float32x4_t v) {
+  float32x2_t s = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+  return vget_lane_f32(vpadd_f32(s, s), 0);
+}
+
+// x must be positive and normal
+inline float32x4_t Log(float32x4_t x) {
+  int32x4_t e = vsubq_s32(vshrq_n_s32(vreinterpretq_s32_f32(x), 23),
+                          vdupq_n_s32(0x7f));
+  x = vreinterpretq_f32_s32(
+      vorrq_s32(vandq_s32(vreinterpretq_s32_f32(x), vdupq_n_s32(~0x7f800000)),
+                vreinterpretq_s32_f32(vdupq_n_f32(0.5f))));
+  float32x4_t fe = vaddq_f32(vcvtq_f32_s32(e), vdupq_n_f32(1));
+
+  uint32x4_t mask = vcltq_f32(x, vdupq_n_f32(kLogSqrtHalf));
+  float32x4_t tmp =
+      vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(x), mask));
+  x = vsubq_f32(x, vdupq_n_f32(1));
+  fe = vsubq_f32(fe, vreinterpretq_f32_u32(vandq_u32(
+                         vreinterpretq_u32_f32(vdupq_n_f32(1)), mask)));
+  x = vaddq_f32(x, tmp);
+
+  float32x4_t z = vmulq_f32(x, x);
+  float32x4_t y = vdupq_n_f32(kLogP0);
+  y = vmlaq_f32(vdupq_n_f32(kLogP1), y, x);
+  y = vmlaq_f32(vdupq_n_f32(kLogP2), y, x);
+  y = vmlaq_f32(vdupq_n_f32(kLogP3), y, x);
+  y = vmlaq_f32(vdupq_n_f32(kLogP4), y, x);
+  y = vmlaq_f32(vdupq_n_f32(kLogP5), y, x);
+  y = vmlaq_f32(vdupq_n_f32(kLogP6), y, x);
+  y = vmlaq_f32(vdupq_n_f32(kLogP7), y, x);
+  y = vmlaq_f32(vdupq_n_f32(kLogP8), y, x);
+  y = vmulq_f32(vmulq_f32(y, x), z);
+
+  y = vmlaq_f32(y, fe, vdupq_n_f32(kLogQ1));
+  y = vmlsq_f32(y, z, vdupq_n_f32(0.5f));
+  x = vaddq_f32(x, y);
+  return vmlaq_f32(x, fe, vdupq_n_f32(kLogQ2));
+}
+
+#elif SHERPA_ONNX_SIMD_FBANK_SSE2
+
+inline float HorizontalSum(__m128 v) {
+  v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+  v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+  return _mm_cvtss_f32(v);
+}
+
+// x must be positive and normal
+inline __m128 Log(__m128 x) {
+  __m128i e = _mm_sub_epi32(_mm_srli_epi32(_mm_castps_si128(x), 23),
+                            _mm_set1_epi32(0x7f));
+  x = _mm_and_ps(x, _mm_castsi128_ps(_mm_set1_epi32(~0x7f800000)));
+  x = _mm_or_ps(x, _mm_set1_ps(0.5f));
+  __m128 fe = _mm_add_ps(_mm_cvtepi32_ps(e), _mm_set1_ps(1));
+
+  __m128 mask = _mm_cmplt_ps(x, _mm_set1_ps(kLogSqrtHalf));
+  __m128 tmp = _mm_and_ps(x, mask);
+  x = _mm_sub_ps(x, _mm_set1_ps(1));
+  fe = _mm_sub_ps(fe, _mm_and_ps(_mm_set1_ps(1), mask));
+  x = _mm_add_ps(x, tmp);
+
+  __m128 z = _mm_mul_ps(x, x);
+  __m128 y = _mm_set1_ps(kLogP0);
+  y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kLogP1));
+  y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kLogP2));
+  y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kLogP3));
+  y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kLogP4));
+  y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kLogP5));
+  y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kLogP6));
+  y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kLogP7));
+  y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kLogP8));
+  y = _mm_mul_ps(_mm_mul_ps(y, x), z);
+
+  y = _mm_add_ps(y, _mm_mul_ps(fe, _mm_set1_ps(kLogQ1)));
+  y = _mm_sub_ps(y, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+  x = _mm_add_ps(x, y);
+  return _mm_add_ps(x, _mm_mul_ps(fe, _mm_set1_ps(kLogQ2)));
+}
+
+#endif
+
+// n must be a multiple of 4
+inline float DotProduct(const float *a, const float *b, int32_t n) {
+#if SHERPA_ONNX_SIMD_FBANK_NEON
+  float32x4_t acc = vdupq_n_f32(0);
+  for (int32_t i = 0; i != n; i += 4) {
+    acc = vmlaq_f32(acc, vld1q_f32(a + i), vld1q_f32(b + i));
+  }
+  return HorizontalSum(acc);
+#elif SHERPA_ONNX_SIMD_FBANK_SSE2
+  __m128 acc = _mm_setzero_ps();
+  for (int32_t i = 0; i != n; i += 4) {
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+  }
+  return HorizontalSum(acc);
+#else
+  float sum = 0;
+  for (int32_t i = 0; i != n; ++i) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+#endif
+}
+
+// x[i] = log(max(x[i], floor)). floor must be positive.
+void LogWithFloor(float *x, int32_t n, float floor) {
+  int32_t i = 0;
+#if SHERPA_ONNX_SIMD_FBANK_NEON
+  float32x4_t f = vdupq_n_f32(floor);
+  for (; i + 4 <= n; i += 4) {
+    vst1q_f32(x + i, Log(vmaxq_f32(vld1q_f32(x + i), f)));
+  }
+#elif SHERPA_ONNX_SIMD_FBANK_SSE2
+  __m128 f = _mm_set1_ps(floor);
+  for (; i + 4 <= n; i += 4) {
+    _mm_storeu_ps(x + i, Log(_mm_max_ps(_mm_loadu_ps(x + i), f)));
+  }
+#endif
+  for (; i < n; ++i) {
+    x[i] = std::log(std::max(x[i], floor));
+  }
+}
+
+}  // namespace
+
+RealFftPlan::RealFftPlan(int32_t n) : n_(n), half_(n / 2) {
+  if (n < 8 || (n & (n - 1)) != 0) {
+    SHERPA_ONNX_LOGE("FFT size must be a power of two and at least 8. Given: %d",
+                     n);
+    exit(-1);
+  }
+
+  int32_t num_bits = 0;
+  while ((1 << num_bits) < half_) {
+    ++num_bits;
+  }
+
+  bit_reverse_.resize(half_);
+  for (int32_t i = 0; i != half_; ++i) {
+    int32_t r = 0;
+    for (int32_t b = 0; b != num_bits; ++b) {
+      r |= ((i >> b) & 1) << (num_bits - 1 - b);
+    }
+    bit_reverse_[i] = r;
+  }
+
+  twiddle_re_.resize(half_ - 1);
+  twiddle_im_.resize(half_ - 1);
+  for (int32_t h = 1; h < half_; h *= 2) {
+    for (int32_t j = 0; j != h; ++j) {
+      double theta = -M_PI * j / h;
+      twiddle_re_[h - 1 + j] = cos(theta);
+      twiddle_im_[h - 1 + j] = sin(theta);
+    }
+  }
+
+  post_re_.resize(half_);
+  post_im_.resize(half_);
+  for (int32_t k = 0; k != half_; ++k) {
+    double theta = -2 * M_PI * k / n_;
+    post_re_[k] = cos(theta);
+    post_im_[k] = sin(theta);
+  }
+
+  re_.resize(half_);
+  im_.resize(half_);
+}
+
+void RealFftPlan::PowerSpectrum(const float *in, float *out) {
+  float *re = re_.data();
+  float *im = im_.data();
+
+  // z[k] = in[2k] + i * in[2k + 1], in bit-reversed order
+  for (int32_t k = 0; k != half_; ++k) {
+    int32_t r = bit_reverse_[k];
+    re[r] = in[2 * k];
+    im[r] = in[2 * k + 1];
+  }
+
+  // The first stage has only the twiddle factor 1
+  for (int32_t k = 0; k < half_; k += 2) {
+    float ar = re[k], ai = im[k];
+    float br = re[k + 1], bi = im[k + 1];
+    re[k] = ar + br;
+    im[k] = ai + bi;
+    re[k + 1] = ar - br;
+    im[k + 1] = ai - bi;
+  }
+
+  for (int32_t h = 2; h < half_; h *= 2) {
+    const float *wr = twiddle_re_.data() + h - 1;
+    const float *wi = twiddle_im_.data() + h - 1;
+
+    for (int32_t k = 0; k < half_; k += 2 * h) {
+      float *ar = re + k;
+      float *ai = im + k;
+      float *br = re + k + h;
+      float *bi = im + k + h;
+
+      int32_t j = 0;
+#if SHERPA_ONNX_SIMD_FBANK_NEON
+      for (; j + 4 <= h; j += 4) {
+        float32x4_t vwr = vld1q_f32(wr + j);
+        float32x4_t vwi = vld1q_f32(wi + j);
+        float32x4_t vbr = vld1q_f32(br + j);
+        float32x4_t vbi = vld1q_f32(bi + j);
+        float32x4_t tr = vmlsq_f32(vmulq_f32(vwr, vbr), vwi, vbi);
+        float32x4_t ti = vmlaq_f32(vmulq_f32(vwr, vbi), vwi, vbr);
+        float32x4_t var = vld1q_f32(ar + j);
+        float32x4_t vai = vld1q_f32(ai + j);
+        vst1q_f32(br + j, vsubq_f32(var, tr));
+        vst1q_f32(bi + j, vsubq_f32(vai, ti));
+        vst1q_f32(ar + j, vaddq_f32(var, tr));
+        vst1q_f32(ai + j, vaddq_f32(vai, ti));
+      }
+#elif SHERPA_ONNX_SIMD_FBANK_SSE2
+      for (; j + 4 <= h; j += 4) {
+        __m128 vwr = _mm_loadu_ps(wr + j);
+        __m128 vwi = _mm_loadu_ps(wi + j);
+        __m128 vbr = _mm_loadu_ps(br + j);
+        __m128 vbi = _mm_loadu_ps(bi + j);
+        __m128 tr = _mm_sub_ps(_mm_mul_ps(vwr, vbr), _mm_mul_ps(vwi, vbi));
+        __m128 ti = _mm_add_ps(_mm_mul_ps(vwr, vbi), _mm_mul_ps(vwi, vbr));
+        __m128 var = _mm_loadu_ps(ar + j);
+        __m128 vai = _mm_loadu_ps(ai + j);
+        _mm_storeu_ps(br + j, _mm_sub_ps(var, tr));
+        _mm_storeu_ps(bi + j, _mm_sub_ps(vai, ti));
+        _mm_storeu_ps(ar + j, _mm_add_ps(var, tr));
+        _mm_storeu_ps(ai + j, _mm_add_ps(vai, ti));
+      }
+#endif
+      for (; j < h; ++j) {
+        float tr = wr[j] * br[j] - wi[j] * bi[j];
+        float ti = wr[j] * bi[j] + wi[j] * br[j];
+        br[j] = ar[j] - tr;
+        bi[j] = ai[j] - ti;
+        ar[j] += tr;
+        ai[j] += ti;
+      }
+    }
+  }
+
+  // Split Z into the spectrum X of the real signal:
+  //   X[k] = (Z[k] + conj(Z[m - k])) / 2
+  //          - i / 2 * exp(-2 pi i k / n) * (Z[k] - conj(Z[m - k]))
+  // where m = n / 2.
+  out[0] = (re[0] + im[0]) * (re[0] + im[0]);
+  out[half_] = (re[0] - im[0]) * (re[0] - im[0]);
+
+  for (int32_t k = 1; k != half_; ++k) {
+    float zr = re[k], zi = im[k];
+    float cr = re[half_ - k], ci = -im[half_ - k];
+
+    float er = 0.5f * (zr + cr), ei = 0.5f * (zi + ci);
+
+    // -i / 2 * (Z[k] - conj(Z[m - k]))
+    float or_ = 0.5f * (zi - ci), oi = -0.5f * (zr - cr);
+
+    float xr = er + post_re_[k] * or_ - post_im_[k] * oi;
+    float xi = ei + post_re_[k] * oi + post_im_[k] * or_;
+
+    out[k] = xr * xr + xi * xi;
+  }
+}
+
+bool SimdFbank::IsSupported(const knf::FbankOptions &opts,
+                            std::string *reason) {
+  const auto &frame_opts = opts.frame_opts;
+  const auto &mel_opts = opts.mel_opts;
+
+  if (frame_opts.dither != 0) {
+    *reason = "dither is not supported";
+    return false;
+  }
+
+  if (!frame_opts.round_to_power_of_two) {
+    *reason = "round_to_power_of_two must be true";
+    return false;
+  }
+
+  if (opts.use_energy) {
+    *reason = "use_energy is not supported";
+    return false;
+  }
+
+  if (mel_opts.is_librosa) {
+    *reason = "is_librosa is not supported";
+    return false;
+  }
+
+  if (mel_opts.num_bins < 3) {
+    *reason = "num_bins must be at least 3";
+    return false;
+  }
+
+  const auto &w = frame_opts.window_type;
+  if (w != "hanning" && w != "sine" && w != "hamming" && w != "povey" &&
+      w != "rectangular" && w != "blackman") {
+    *reason = "unknown window type " + w;
+    return false;
+  }
+
+  if (WindowSize(frame_opts) < 2 || WindowShift(frame_opts) < 1) {
+    *reason = "invalid frame length or frame shift";
+    return false;
+  }
+
+  return true;
+}
+
+SimdFbank::SimdFbank(const knf::FbankOptions &opts)
+    : opts_(opts),
+      frame_length_(WindowSize(opts.frame_opts)),
+      frame_shift_(WindowShift(opts.frame_opts)),
+      num_bins_(opts.mel_opts.num_bins),
+      window_(GetWindow(opts.frame_opts)),
+      fft_(RoundUpToPowerOfTwo(std::max(WindowSize(opts.frame_opts), 8))) {
+  std::string reason;
+  if (!IsSupported(opts, &reason)) {
+    SHERPA_ONNX_LOGE("Unsupported fbank options: %s", reason.c_str());
+    exit(-1);
+  }
+
+  // The same as knf::MelBanks for the options we support
+  int32_t padded_length = fft_.Size();
+  int32_t num_fft_bins = padded_length / 2;
+  float sample_freq = opts.frame_opts.samp_freq;
+  float nyquist = 0.5f * sample_freq;
+
+  float low_freq = opts.mel_opts.low_freq;
+  float high_freq = opts.mel_opts.high_freq > 0.0f
+                        ? opts.mel_opts.high_freq
+                        : nyquist + opts.mel_opts.high_freq;
+
+  if (low_freq < 0.0f || low_freq >= nyquist || high_freq <= 0.0f ||
+      high_freq > nyquist || high_freq <= low_freq) {
+    SHERPA_ONNX_LOGE("Bad values in options: low-freq %f and high-freq %f vs. "
+                     "nyquist %f",
+                     low_freq, high_freq, nyquist);
+    exit(-1);
+  }
+
+  float fft_bin_width = sample_freq / padded_length;
+  float mel_low_freq = MelScale(low_freq);
+  float mel_high_freq = MelScale(high_freq);
+  float mel_freq_delta = (mel_high_freq - mel_low_freq) / (num_bins_ + 1);
+
+  std::vector<std::vector<float>> rows(num_bins_);
+  mel_offset_.resize(num_bins_);
+
+  for (int32_t bin = 0; bin < num_bins_; ++bin) {
+    float left_mel = mel_low_freq + bin * mel_freq_delta,
+          center_mel = mel_low_freq + (bin + 1) * mel_freq_delta,
+          right_mel = mel_low_freq + (bin + 2) * mel_freq_delta;
+
+    int32_t first_index = -1;
+    for (int32_t i = 0; i < num_fft_bins; ++i) {
+      float freq = fft_bin_width * i;
+      float mel = MelScale(freq);
+      if (mel > left_mel && mel < right_mel) {
+        float weight;
+        if (mel <= center_mel)
+          weight = (mel - left_mel) / (center_mel - left_mel);
+        else
+          weight = (right_mel - mel) / (right_mel - center_mel);
+
+        if (first_index == -1) {
+          first_index = i;
+        }
+        rows[bin].resize(i + 1 - first_index);
+        rows[bin][i - first_index] = weight;
+      }
+    }
+
+    if (first_index == -1) {
+      SHERPA_ONNX_LOGE("You may have set num_mel_bins too large.");
+      exit(-1);
+    }
+
+    if (opts.mel_opts.htk_mode && bin == 0 && mel_low_freq != 0.0f) {
+      rows[bin][0] = 0.0f;
+    }
+
+    mel_offset_[bin] = first_index;
+    mel_size_ = std::max<int32_t>(mel_size_, rows[bin].size());
+  }
+
+  mel_size_ = (mel_size_ + 3) / 4 * 4;
+  mel_weights_.resize(num_bins_ * mel_size_);
+  for (int32_t bin = 0; bin < num_bins_; ++bin) {
+    std::copy(rows[bin].begin(), rows[bin].end(),
+              mel_weights_.begin() + bin * mel_size_);
+  }
+
+  frame_.resize(padded_length);
+
+  // Padded rows may read past the last bin. The extra bins are zeros.
+  power_.resize(num_fft_bins + 1 + mel_size_);
+}
+
+void SimdFbank::AcceptWaveform(float sampling_rate, const float *waveform,
+                               int32_t n) {
+  if (input_finished_) {
+    SHERPA_ONNX_LOGE("AcceptWaveform called after InputFinished() was called.");
+    exit(-1);
+  }
+
+  if (sampling_rate != opts_.frame_opts.samp_freq) {
+    SHERPA_ONNX_LOGE(
+        "Sampling rate mismatch. Expected: %f, given: %f. Please resample it",
+        opts_.frame_opts.samp_freq, sampling_rate);
+    exit(-1);
+  }
+
+  if (n == 0) {
+    return;
+  }
+
+  waveform_.insert(waveform_.end(), waveform, waveform + n);
+
+  ComputeFeatures();
+}
+
+void SimdFbank::InputFinished() {
+  input_finished_ = true;
+  ComputeFeatures();
+}
+
+const float *SimdFbank::GetFrame(int32_t frame) const {
+  if (frame < first_frame_ || frame >= num_frames_) {
+    SHERPA_ONNX_LOGE("Frame %d is not available. Available: [%d, %d)", frame,
+                     first_frame_, num_frames_);
+    exit(-1);
+  }
+
+  return features_.data() +
+         static_cast<int64_t>(frame - storage_frame_) * num_bins_;
+}
+
+void SimdFbank::Pop(int32_t n) {
+  first_frame_ = std::min(first_frame_ + n, num_frames_);
+
+  int32_t num_popped = first_frame_ - storage_frame_;
+  int32_t num_kept = num_frames_ - first_frame_;
+  if (num_popped > num_kept) {
+    std::copy(features_.begin() + static_cast<int64_t>(num_popped) * num_bins_,
+              features_.end(), features_.begin());
+    features_.resize(static_cast<int64_t>(num_kept) * num_bins_);
+    storage_frame_ = first_frame_;
+  }
+}
+
+int64_t SimdFbank::FirstSampleOfFrame(int32_t frame) const {
+  if (opts_.frame_opts.snip_edges) {
+    return static_cast<int64_t>(frame) * frame_shift_;
+  }
+
+  int64_t midpoint_of_frame =
+      static_cast<int64_t>(frame_shift_) * frame + frame_shift_ / 2;
+  return midpoint_of_frame - frame_length_ / 2;
+}
+
+int32_t SimdFbank::NumFrames(int64_t num_samples, bool flush) const {
+  if (opts_.frame_opts.snip_edges) {
+    if (num_samples < frame_length_) {
+      return 0;
+    }
+    return 1 + static_cast<int32_t>((num_samples - frame_length_) /
+                                    frame_shift_);
+  }
+
+  int32_t num_frames =
+      static_cast<int32_t>((num_samples + frame_shift_ / 2) / frame_shift_);
+  if (flush) {
+    return num_frames;
+  }
+
+  int64_t end_sample_of_last_frame =
+      FirstSampleOfFrame(num_frames - 1) + frame_length_;
+  while (num_frames > 0 && end_sample_of_last_frame > num_samples) {
+    --num_frames;
+    end_sample_of_last_frame -= frame_shift_;
+  }
+  return num_frames;
+}
+
+void SimdFbank::ComputeFeatures() {
+  int64_t num_samples_total =
+      waveform_offset_ + static_cast<int64_t>(waveform_.size());
+  int32_t num_frames_new = NumFrames(num_samples_total, input_finished_);
+
+  if (num_frames_new > num_frames_) {
+    // All new frames are written to the end of the storage in one pass
+    int64_t start = static_cast<int64_t>(num_frames_ - storage_frame_) *
+                    num_bins_;
+    features_.resize(static_cast<int64_t>(num_frames_new - storage_frame_) *
+                     num_bins_);
+
+    for (int32_t f = num_frames_; f < num_frames_new; ++f) {
+      ComputeFrame(f, features_.data() + start);
+      start += num_bins_;
+    }
+
+    num_frames_ = num_frames_new;
+  }
+
+  // Discard samples that are not needed by later frames
+  int64_t first_sample_of_next_frame = FirstSampleOfFrame(num_frames_new);
+  int64_t samples_to_discard = first_sample_of_next_frame - waveform_offset_;
+  if (samples_to_discard > 0) {
+    int64_t n = static_cast<int64_t>(waveform_.size());
+    if (samples_to_discard >= n) {
+      waveform_offset_ += n;
+      waveform_.clear();
+    } else {
+      std::copy(waveform_.begin() + samples_to_discard, waveform_.end(),
+                waveform_.begin());
+      waveform_.resize(n - samples_to_discard);
+      waveform_offset_ += samples_to_discard;
+    }
+  }
+}
+
+void SimdFbank::ComputeFrame(int32_t frame, float *feature) {
+  float *p = frame_.data();
+  int32_t n = frame_length_;
+
+  // Extract the window. Samples outside of the waveform are reflected.
+  int64_t wave_start = FirstSampleOfFrame(frame) - waveform_offset_;
+  int32_t wave_dim = static_cast<int32_t>(waveform_.size());
+  if (wave_start >= 0 && wave_start + n <= wave_dim) {
+    std::copy(waveform_.begin() + wave_start,
+              waveform_.begin() + wave_start + n, p);
+  } else {
+    for (int32_t s = 0; s < n; ++s) {
+      int64_t s_in_wave = s + wave_start;
+      while (s_in_wave < 0 || s_in_wave >= wave_dim) {
+        if (s_in_wave < 0) {
+          s_in_wave = -s_in_wave - 1;
+        } else {
+          s_in_wave = 2 * wave_dim - 1 - s_in_wave;
+        }
+      }
+      p[s] = waveform_[s_in_wave];
+    }
+  }
+
+  const auto &frame_opts = opts_.frame_opts;
+
+  if (frame_opts.remove_dc_offset) {
+    float sum = 0;
+    for (int32_t i = 0; i < n; ++i) {
+      sum += p[i];
+    }
+    float mean = sum / n;
+    for (int32_t i = 0; i < n; ++i) {
+      p[i] -= mean;
+    }
+  }
+
+  // Pre-emphasis and the window. Going backwards, p[i - 1] is still the
+  // original sample.
+  float c = frame_opts.preemph_coeff;
+  const float *w = window_.data();
+  if (c != 0) {
+    int32_t i = n - 1;
+#if SHERPA_ONNX_SIMD_FBANK_NEON
+    float32x4_t vc = vdupq_n_f32(c);
+    for (; i - 3 >= 1; i -= 4) {
+      float32x4_t x = vld1q_f32(p + i - 3);
+      float32x4_t prev = vld1q_f32(p + i - 4);
+      vst1q_f32(p + i - 3, vmulq_f32(vmlsq_f32(x, vc, prev),
+                                     vld1q_f32(w + i - 3)));
+    }
+#elif SHERPA_ONNX_SIMD_FBANK_SSE2
+    __m128 vc = _mm_set1_ps(c);
+    for (; i - 3 >= 1; i -= 4) {
+      __m128 x = _mm_loadu_ps(p + i - 3);
+      __m128 prev = _mm_loadu_ps(p + i - 4);
+      _mm_storeu_ps(p + i - 3,
+                    _mm_mul_ps(_mm_sub_ps(x, _mm_mul_ps(vc, prev)),
+                               _mm_loadu_ps(w + i - 3)));
+    }
+#endif
+    for (; i >= 1; --i) {
+      p[i] = (p[i] - c * p[i - 1]) * w[i];
+    }
+    p[0] = (p[0] - c * p[0]) * w[0];
+  } else {
+    for (int32_t i = 0; i < n; ++i) {
+      p[i] *= w[i];
+    }
+  }
+
+  std::fill(p + n, p + fft_.Size(), 0);
+
+  fft_.PowerSpectrum(p, power_.data());
+
+  if (!opts_.use_power) {
+    int32_t num_fft_bins = fft_.Size() / 2 + 1;
+    for (int32_t i = 0; i < num_fft_bins; ++i) {
+      power_[i] = std::sqrt(power_[i]);
+    }
+  }
+
+  const float *weights = mel_weights_.data();
+  for (int32_t bin = 0; bin < num_bins_; ++bin) {
+    feature[bin] = DotProduct(weights + bin * mel_size_,
+                              power_.data() + mel_offset_[bin], mel_size_);
+  }
+
+  if (opts_.use_log_fbank) {
+    LogWithFloor(feature, num_bins_, std::numeric_limits<float>::epsilon());
+  }
+}
+
+}  // namespace sherpa_onnx
@@ -0,0 +1,153 @@
+// sherpa-onnx/csrc/simd-fbank.h
+//
+// Copyright (c)  2025  Xiaomi Corporation
+#ifndef SHERPA_ONNX_CSRC_SIMD_FBANK_H_
+#define SHERPA_ONNX_CSRC_SIMD_FBANK_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "kaldi-native-fbank/csrc/online-feature.h"
+
+namespace sherpa_onnx {
+
+/** A real FFT of a fixed power-of-two size.
+ *
+ * The twiddle factors and the bit-reversal permutation are computed once in
+ * the constructor. The FFT runs as a complex FFT of half the size on split
+ * real/imaginary arrays, so the butterflies of all but the first two stages
+ * are vectorized.
+ */
+class RealFftPlan {
+ public:
+  // @param n Size of the FFT. It must be a power of two and at least 8.
+  explicit RealFftPlan(int32_t n);
+
+  int32_t Size() const { return n_; }
+
+  /** Compute the power spectrum of a real signal.
+   *
+   * @param in  Pointer to an array of Size() floats.
+   * @param out Pointer to an array of Size() / 2 + 1 floats. out[k] is
+   *            |X[k]|^2, where X is the unnormalized DFT of in.
+   */
+  void PowerSpectrum(const float *in, float *out);
+
+ private:
+  int32_t n_;
+  int32_t half_;  // n_ / 2, size of the complex FFT
+
+  std::vector<int32_t> bit_reverse_;
+
+  // Twiddle factors of the complex FFT, stage after stage. The stage with
+  // half-size h uses h contiguous entries starting at h - 1.
+  std::vector<float> twiddle_re_;
+  std::vector<float> twiddle_im_;
+
+  // exp(-2 pi i k / n) for k in [0, half_), to split the complex FFT into
+  // the spectrum of the real signal
+  std::vector<float> post_re_;
+  std::vector<float> post_im_;
+
+  // Scratch buffers
+  std::vector<float> re_;
+  std::vector<float> im_;
+};
+
+/** An online fbank feature extractor that computes the same features as
+ * knf::OnlineFbank, up to floating-point rounding, but faster.
+ *
+ * It has the same interface as knf::OnlineFbank, so FeatureExtractor uses
+ * either of them. Compared with knf::OnlineFbank:
+ *
+ *  - The window, DC removal and pre-emphasis are fused into vectorized
+ *    loops over a precomputed window.
+ *  - The FFT uses a RealFftPlan for the padded frame length.
+ *  - The mel filter bank is stored as one sparse row per bin, padded to a
+ *    multiple of 4 taps, and applied with vectorized dot products.
+ *  - The log is a vectorized polynomial approximation.
+ *  - All frames that become available in one AcceptWaveform() call are
+ *    computed in one pass into contiguous storage.
+ *
+ * Only the options used by our models are supported. See IsSupported().
+ */
+class SimdFbank {
+ public:
+  explicit SimdFbank(const knf::FbankOptions &opts);
+
+  /** Return true if opts is supported. Otherwise, *reason says why.
+   *
+   * Dither, energy, librosa-style mel banks, MFCC and frame lengths that
+   * are not rounded to a power of two are not supported.
+   */
+  static bool IsSupported(const knf::FbankOptions &opts, std::string *reason);
+
+  int32_t Dim() const { return num_bins_; }
+
+  void AcceptWaveform(float sampling_rate, const float *waveform, int32_t n);
+
+  void InputFinished();
+
+  int32_t NumFramesReady() const { return num_frames_; }
+
+  bool IsLastFrame(int32_t frame) const {
+    return input_finished_ && frame == num_frames_ - 1;
+  }
+
+  // The frame must not have been popped
+  const float *GetFrame(int32_t frame) const;
+
+  // Discard the n oldest frames that have not been popped
+  void Pop(int32_t n);
+
+ private:
+  void ComputeFeatures();
+
+  void ComputeFrame(int32_t frame, float *feature);
+
+  int64_t FirstSampleOfFrame(int32_t frame) const;
+
+  int32_t NumFrames(int64_t num_samples, bool flush) const;
+
+ private:
+  knf::FbankOptions opts_;
+
+  int32_t frame_length_;
+  int32_t frame_shift_;
+  int32_t num_bins_;
+
+  std::vector<float> window_;
+
+  RealFftPlan fft_;
+
+  // Row i of the mel filter bank covers power spectrum bins
+  // [mel_offset_[i], mel_offset_[i] + mel_size_) with the weights
+  // mel_weights_[i * mel_size_ ...]. Rows are padded with zeros to the
+  // same size, a multiple of 4.
+  std::vector<int32_t> mel_offset_;
+  std::vector<float> mel_weights_;
+  int32_t mel_size_ = 0;
+
+  // Samples from waveform_offset_ on that are still needed
+  std::vector<float> waveform_;
+  int64_t waveform_offset_ = 0;
+
+  // Features of frames [storage_frame_, num_frames_), one row per frame.
+  // Frames before first_frame_ have been popped. They are removed from
+  // the storage once they outnumber the frames that are kept.
+  std::vector<float> features_;
+  int32_t storage_frame_ = 0;
+  int32_t first_frame_ = 0;
+  int32_t num_frames_ = 0;
+
+  bool input_finished_ = false;
+
+  // Scratch buffers for one frame
+  std::vector<float> frame_;
+  std::vector<float> power_;
+};
+
+}  // namespace sherpa_onnx
+
+#endif  // SHERPA_ONNX_CSRC_SIMD_FBANK_H_
@@ -0,0 +1,107 @@
+// sherpa-onnx/csrc/speech-gate-test.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/speech-gate.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace sherpa_onnx {
+
+// Background noise at about -50 dBFS
+static std::vector<float> Noise(int32_t n, std::mt19937 *gen) {
+  std::normal_distribution<float> dist(0, 0.003);
+  std::vector<float> samples(n);
+  for (auto &x : samples) {
+    x = dist(*gen);
+  }
+  return samples;
+}
+
+// A 300 Hz tone at about -13 dBFS
+static std::vector<float> Tone(int32_t n) {
+  std::vector<float> samples(n);
+  for (int32_t i = 0; i != n; ++i) {
+    samples[i] = 0.3 * std::sin(2 * M_PI * 300 * i / 16000);
+  }
+  return samples;
+}
+
+// Feed samples in chunks of an odd size. Return the number of samples
+// after which the gate is open.
+static int32_t Feed(SpeechGate *gate, const std::vector<float> &samples) {
+  int32_t num_open = 0;
+  for (size_t i = 0; i < samples.size(); i += 170) {
+    int32_t n = std::min<int32_t>(170, samples.size() - i);
+    if (gate->AcceptWaveform(samples.data() + i, n)) {
+      num_open += n;
+    }
+  }
+  return num_open;
+}
+
+TEST(SpeechGate, None) {
+  SpeechGateConfig config;
+  SpeechGate gate(config, 16000);
+
+  std::vector<float> silence(1600);
+  EXPECT_TRUE(gate.AcceptWaveform(silence.data(), silence.size()));
+  EXPECT_TRUE(gate.IsOpen());
+}
+
+TEST(SpeechGate, Energy) {
+  SpeechGateConfig config;
+  config.type = "energy";
+  config.hangover = 0.5;
+  ASSERT_TRUE(config.Validate());
+
+  SpeechGate gate(config, 16000);
+  std::mt19937 gen(0);
+
+  // 3 seconds of noise
+  EXPECT_EQ(Feed(&gate, Noise(48000, &gen)), 0);
+  EXPECT_FALSE(gate.IsOpen());
+
+  // It opens within 20 ms of a tone
+  int32_t n = Feed(&gate, Tone(16000));
+  EXPECT_GE(n, 16000 - 320);
+  EXPECT_TRUE(gate.IsOpen());
+
+  // It stays open for the hangover and then closes
+  auto noise = Noise(16000, &gen);
+  EXPECT_TRUE(gate.AcceptWaveform(noise.data(), 4000));
+  EXPECT_FALSE(gate.AcceptWaveform(noise.data() + 4000, 12000));
+
+  // A second tone opens it again
+  EXPECT_GT(Feed(&gate, Tone(8000)), 0);
+}
+
+TEST(SpeechGate, EnergyDigitalSilence) {
+  SpeechGateConfig config;
+  config.type = "energy";
+  SpeechGate gate(config, 16000);
+
+  // The noise floor must not drop to 0, otherwise any sound would be speech
+  std::vector<float> silence(16000);
+  EXPECT_EQ(Feed(&gate, silence), 0);
+
+  std::vector<float> click(160, 1e-4);
+  EXPECT_FALSE(gate.AcceptWaveform(click.data(), click.size()));
+}
+
+TEST(SpeechGate, InvalidConfig) {
+  SpeechGateConfig config;
+  config.type = "loudness";
+  EXPECT_FALSE(config.Validate());
+
+  config.type = "silero";
+  config.vad.silero_vad.model = "";
+  EXPECT_FALSE(config.Validate());
+}
+
+}  // namespace sherpa_onnx
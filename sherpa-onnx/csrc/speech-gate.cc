@@ -0,0 +1,182 @@
+// sherpa-onnx/csrc/speech-gate.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/speech-gate.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <string>
+
+#include "sherpa-onnx/csrc/macros.h"
+#include "sherpa-onnx/csrc/vad-model.h"
+
+namespace sherpa_onnx {
+
+// Frames quieter than this, about -60 dBFS, are never speech, so that the
+// gate stays closed in a silent room whatever the noise floor is.
+static constexpr float kMinSpeechEnergy = 1e-6f;
+
+// The noise floor follows a quieter frame quickly and a louder one slowly,
+// at about 1 dB per second with 10 ms frames, so that speech does not
+// raise it.
+static constexpr float kNoiseFloorDecay = 0.9f;
+static constexpr float kNoiseFloorRise = 1.0023f;
+
+void SpeechGateConfig::Register(ParseOptions *po) {
+  vad.Register(po);
+
+  po->Register("speech-gate", &type,
+               "Skip the encoder while there is no speech. Possible values: "
+               "none, energy, silero. silero requires --silero-vad-model");
+
+  po->Register("speech-gate-energy-threshold", &energy_threshold,
+               "In dB. For --speech-gate=energy, audio that is this much "
+               "louder than the noise floor is speech");
+
+  po->Register("speech-gate-hangover", &hangover,
+               "In seconds. The gate stays open for this long after the "
+               "last speech");
+
+  po->Register("speech-gate-preroll", &preroll,
+               "In seconds. Audio from before the gate opens that is still "
+               "decoded, so that the start of a keyword is not lost");
+}
+
+bool SpeechGateConfig::Validate() const {
+  if (type != "none" && type != "energy" && type != "silero") {
+    SHERPA_ONNX_LOGE(
+        "Unsupported --speech-gate: '%s'. Supported values: none, energy, "
+        "silero",
+        type.c_str());
+    return false;
+  }
+
+  if (hangover < 0) {
+    SHERPA_ONNX_LOGE("--speech-gate-hangover should be >= 0. Given: %f",
+                     hangover);
+    return false;
+  }
+
+  if (preroll < 0) {
+    SHERPA_ONNX_LOGE("--speech-gate-preroll should be >= 0. Given: %f",
+                     preroll);
+    return false;
+  }
+
+  if (type == "silero") {
+    return vad.Validate();
+  }
+
+  return true;
+}
+
+std::string SpeechGateConfig::ToString() const {
+  std::ostringstream os;
+
+  os << "SpeechGateConfig(";
+  os << "type=\"" << type << "\", ";
+  os << "energy_threshold=" << energy_threshold << ", ";
+  os << "hangover=" << hangover << ", ";
+  os << "preroll=" << preroll << ", ";
+  os << "vad=" << vad.ToString() << ")";
+
+  return os.str();
+}
+
+SpeechGate::SpeechGate(const SpeechGateConfig &config, int32_t sample_rate)
+    : config_(config) {
+  if (config_.type == "silero") {
+    if (config_.vad.sample_rate != sample_rate) {
+      SHERPA_ONNX_LOGE("The VAD expects sample rate %d. Given: %d",
+                       config_.vad.sample_rate, sample_rate);
+      exit(-1);
+    }
+
+    vad_ = VadModel::Create(config_.vad);
+    frame_size_ = vad_->WindowSize();
+  } else {
+    // 10 ms
+    frame_size_ = std::max(sample_rate / 100, 1);
+  }
+
+  buffer_.reserve(frame_size_);
+  hangover_samples_ = static_cast<int64_t>(config_.hangover * sample_rate);
+}
+
+SpeechGate::~SpeechGate() = default;
+
+bool SpeechGate::AcceptWaveform(const float *samples, int32_t n) {
+  if (config_.type == "none") {
+    return true;
+  }
+
+  if (!buffer_.empty()) {
+    int32_t m = std::min<int32_t>(frame_size_ - buffer_.size(), n);
+    buffer_.insert(buffer_.end(), samples, samples + m);
+    samples += m;
+    n -= m;
+
+    if (static_cast<int32_t>(buffer_.size()) < frame_size_) {
+      return IsOpen();
+    }
+
+    ProcessFrame(buffer_.data(), frame_size_);
+    buffer_.clear();
+  }
+
+  for (; n >= frame_size_; samples += frame_size_, n -= frame_size_) {
+    ProcessFrame(samples, frame_size_);
+  }
+
+  buffer_.insert(buffer_.end(), samples, samples + n);
+
+  return IsOpen();
+}
+
+bool SpeechGate::IsOpen() const {
+  return config_.type == "none" || remaining_samples_ > 0;
+}
+
+void SpeechGate::ProcessFrame(const float *samples, int32_t n) {
+  bool speech =
+      vad_ ? vad_->IsSpeech(samples, n) : IsEnergySpeech(samples, n);
+
+  if (speech) {
+    // Also count the next frame, so that the gate is open after a speech
+    // frame even if the hangover is 0
+    remaining_samples_ = hangover_samples_ + n;
+  } else {
+    remaining_samples_ = std::max<int64_t>(remaining_samples_ - n, 0);
+  }
+}
+
+bool SpeechGate::IsEnergySpeech(const float *samples, int32_t n) {
+  float energy = 0;
+  for (int32_t i = 0; i != n; ++i) {
+    energy += samples[i] * samples[i];
+  }
+  energy /= n;
+
+  if (noise_floor_ < 0) {
+    noise_floor_ = std::max(energy, kMinSpeechEnergy);
+  }
+
+  float ratio = std::pow(10.0f, config_.energy_threshold / 10);
+  bool speech = energy > kMinSpeechEnergy && energy > noise_floor_ * ratio;
+
+  if (energy < noise_floor_) {
+    noise_floor_ = kNoiseFloorDecay * noise_floor_ +
+                   (1 - kNoiseFloorDecay) * energy;
+  } else {
+    noise_floor_ = std::min(noise_floor_ * kNoiseFloorRise, energy);
+  }
+
+  // Keep it away from 0 after digital silence
+  noise_floor_ = std::max(noise_floor_, kMinSpeechEnergy * 1e-3f);
+
+  return speech;
+}
+
+}  // namespace sherpa_onnx
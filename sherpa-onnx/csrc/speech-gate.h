@@ -0,0 +1,91 @@
+// sherpa-onnx/csrc/speech-gate.h
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#ifndef SHERPA_ONNX_CSRC_SPEECH_GATE_H_
+#define SHERPA_ONNX_CSRC_SPEECH_GATE_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "sherpa-onnx/csrc/parse-options.h"
+#include "sherpa-onnx/csrc/vad-model-config.h"
+
+namespace sherpa_onnx {
+
+class VadModel;
+
+struct SpeechGateConfig {
+  // Possible values:
+  // - none: the gate is always open
+  // - energy: a 10 ms frame is speech if its energy is energy_threshold dB
+  //   above the tracked noise floor
+  // - silero: a window is speech if the silero VAD model in vad says so
+  std::string type = "none";
+
+  // in dB, for type energy
+  float energy_threshold = 12.0f;
+
+  // in seconds. The gate stays open for this long after the last speech.
+  float hangover = 1.0f;
+
+  // in seconds. Not used by SpeechGate itself. Users of the gate keep
+  // this much audio from before the gate opens, so that the onset of
+  // speech, which the detector needs some time to notice, is not lost.
+  float preroll = 0.8f;
+
+  // for type silero
+  VadModelConfig vad;
+
+  SpeechGateConfig() = default;
+
+  void Register(ParseOptions *po);
+  bool Validate() const;
+
+  std::string ToString() const;
+};
+
+/** Decide from the audio whether the expensive stages after it, e.g., the
+ * encoder of a keyword spotter, should run.
+ */
+class SpeechGate {
+ public:
+  SpeechGate(const SpeechGateConfig &config, int32_t sample_rate);
+  ~SpeechGate();
+
+  /**
+   * @param samples Pointer to a 1-D array of size n. It must be normalized
+   *                to the range [-1, 1].
+   * @param n Number of entries in samples. It can be of any size.
+   *
+   * @return Return IsOpen() after processing the samples.
+   */
+  bool AcceptWaveform(const float *samples, int32_t n);
+
+  // Return true if speech was found in the last config.hangover seconds,
+  // or if the type of the gate is none.
+  bool IsOpen() const;
+
+ private:
+  // Process a frame of n samples
+  void ProcessFrame(const float *samples, int32_t n);
+
+  bool IsEnergySpeech(const float *samples, int32_t n);
+
+ private:
+  SpeechGateConfig config_;
+  std::unique_ptr<VadModel> vad_;
+
+  int32_t frame_size_ = 0;
+  std::vector<float> buffer_;  // samples of an incomplete frame
+
+  int64_t hangover_samples_ = 0;
+  int64_t remaining_samples_ = 0;  // before the gate closes
+
+  float noise_floor_ = -1;  // negative means not initialized
+};
+
+}  // namespace sherpa_onnx
+
+#endif  // SHERPA_ONNX_CSRC_SPEECH_GATE_H_
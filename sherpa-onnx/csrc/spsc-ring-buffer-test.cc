@@ -0,0 +1,198 @@
+// sherpa-onnx/csrc/spsc-ring-buffer-test.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/spsc-ring-buffer.h"
+
+#include <algorithm>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace sherpa_onnx {
+
+TEST(SpscRingBuffer, Capacity) {
+  SpscRingBuffer buffer(5);
+  EXPECT_EQ(buffer.Capacity(), 8);
+  EXPECT_EQ(buffer.Size(), 0);
+
+  SpscRingBuffer buffer2(16);
+  EXPECT_EQ(buffer2.Capacity(), 16);
+}
+
+TEST(SpscRingBuffer, PushAndPop) {
+  SpscRingBuffer buffer(4);
+
+  std::vector<float> a = {0, 1, 2};
+  EXPECT_EQ(buffer.Push(a.data(), a.size()), 3);
+  EXPECT_EQ(buffer.Size(), 3);
+
+  std::vector<float> c(4);
+  EXPECT_EQ(buffer.Pop(c.data(), 2), 2);
+  EXPECT_EQ(c[0], 0);
+  EXPECT_EQ(c[1], 1);
+  EXPECT_EQ(buffer.Size(), 1);
+
+  // wrap around
+  a = {10, 20, 30};
+  EXPECT_EQ(buffer.Push(a.data(), a.size()), 3);
+  EXPECT_EQ(buffer.Size(), 4);
+
+  EXPECT_EQ(buffer.Pop(c.data(), 10), 4);
+  EXPECT_EQ(c[0], 2);
+  EXPECT_EQ(c[1], 10);
+  EXPECT_EQ(c[2], 20);
+  EXPECT_EQ(c[3], 30);
+
+  EXPECT_EQ(buffer.Size(), 0);
+  EXPECT_EQ(buffer.Pop(c.data(), 1), 0);
+  EXPECT_EQ(buffer.NumDropped(), 0);
+}
+
+TEST(SpscRingBuffer, Overflow) {
+  SpscRingBuffer buffer(4);
+
+  std::vector<float> a = {0, 1, 2, 3, 4, 5};
+  EXPECT_EQ(buffer.Push(a.data(), a.size()), 4);
+  EXPECT_EQ(buffer.NumDropped(), 2);
+
+  EXPECT_EQ(buffer.Push(a.data(), 1), 0);
+  EXPECT_EQ(buffer.NumDropped(), 3);
+
+  // The oldest samples are kept
+  std::vector<float> c(4);
+  EXPECT_EQ(buffer.Pop(c.data(), 4), 4);
+  EXPECT_EQ(c[0], 0);
+  EXPECT_EQ(c[3], 3);
+}
+
+TEST(SpscRingBuffer, WaitPopTimeout) {
+  SpscRingBuffer buffer(8);
+
+  std::vector<float> a = {1, 2};
+  buffer.Push(a.data(), a.size());
+
+  std::vector<float> c(4);
+  EXPECT_EQ(buffer.WaitPop(c.data(), 4, 10), 2);
+  EXPECT_EQ(c[0], 1);
+  EXPECT_EQ(c[1], 2);
+
+  EXPECT_EQ(buffer.WaitPop(c.data(), 4, 0), 0);
+}
+
+TEST(SpscRingBuffer, Close) {
+  SpscRingBuffer buffer(8);
+
+  std::thread t([&buffer]() { buffer.Close(); });
+
+  std::vector<float> c(4);
+  EXPECT_EQ(buffer.WaitPop(c.data(), 4), 0);
+  EXPECT_TRUE(buffer.IsClosed());
+
+  t.join();
+}
+
+TEST(SpscRingBuffer, ProducerConsumer) {
+  SpscRingBuffer buffer(64);
+
+  const int32_t kTotal = 100000;
+  const int32_t kChunk = 7;
+
+  std::thread producer([&buffer, kTotal, kChunk]() {
+    std::vector<float> a(kChunk);
+    int32_t i = 0;
+    while (i < kTotal) {
+      int32_t n = std::min(kChunk, kTotal - i);
+      for (int32_t k = 0; k != n; ++k) {
+        a[k] = i + k;
+      }
+
+      int32_t written = 0;
+      while (written < n) {
+        // Retry instead of dropping so that the order can be checked
+        int32_t available = buffer.Capacity() - buffer.Size();
+        int32_t m = std::min(n - written, available);
+        written += buffer.Push(a.data() + written, m);
+      }
+      i += n;
+    }
+  });
+
+  std::vector<float> c(16);
+  int32_t expected = 0;
+  while (expected < kTotal) {
+    int32_t n = buffer.WaitPop(c.data(), 16, 100);
+    for (int32_t k = 0; k != n; ++k) {
+      ASSERT_EQ(c[k], expected);
+      ++expected;
+    }
+  }
+
+  producer.join();
+  EXPECT_EQ(buffer.NumDropped(), 0);
+}
+
+TEST(SpscRingBuffer, PushAndPopObjects) {
+  BasicSpscRingBuffer<std::string> buffer(3);
+  EXPECT_EQ(buffer.Capacity(), 4);
+
+  for (int32_t i = 0; i != 4; ++i) {
+    EXPECT_TRUE(buffer.PushItem(std::to_string(i)));
+  }
+
+  std::string s = "full";
+  EXPECT_FALSE(buffer.PushItem(std::move(s)));
+  EXPECT_EQ(s, "full");
+  EXPECT_EQ(buffer.NumDropped(), 1);
+
+  std::string out;
+  for (int32_t i = 0; i != 4; ++i) {
+    EXPECT_TRUE(buffer.PopItem(&out));
+    EXPECT_EQ(out, std::to_string(i));
+  }
+
+  EXPECT_FALSE(buffer.PopItem(&out));
+  EXPECT_EQ(buffer.Size(), 0);
+}
+
+TEST(SpscRingBuffer, WaitPopObjectAfterClose) {
+  BasicSpscRingBuffer<std::string> buffer(4);
+  buffer.PushItem(std::string("a"));
+  buffer.Close();
+
+  // Objects pushed before Close() are still returned
+  std::string out;
+  EXPECT_TRUE(buffer.WaitPopItem(&out));
+  EXPECT_EQ(out, "a");
+  EXPECT_FALSE(buffer.WaitPopItem(&out));
+}
+
+TEST(SpscRingBuffer, ProducerConsumerObjects) {
+  BasicSpscRingBuffer<std::string> buffer(8);
+  const int32_t kTotal = 100000;
+
+  std::thread producer([&buffer, kTotal]() {
+    for (int32_t i = 0; i != kTotal; ++i) {
+      // Retry instead of dropping so that the order can be checked
+      std::string s = std::to_string(i);
+      while (!buffer.PushItem(std::move(s))) {
+        std::this_thread::yield();
+      }
+    }
+    buffer.Close();
+  });
+
+  std::string out;
+  int32_t expected = 0;
+  while (buffer.WaitPopItem(&out)) {
+    ASSERT_EQ(out, std::to_string(expected));
+    ++expected;
+  }
+
+  producer.join();
+  EXPECT_EQ(expected, kTotal);
+}
+
+}  // namespace sherpa_onnx
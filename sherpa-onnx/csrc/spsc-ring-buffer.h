@@ -0,0 +1,274 @@
+// sherpa-onnx/csrc/spsc-ring-buffer.h
+//
+// Copyright (c)  2025  Xiaomi Corporation
+#ifndef SHERPA_ONNX_CSRC_SPSC_RING_BUFFER_H_
+#define SHERPA_ONNX_CSRC_SPSC_RING_BUFFER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "sherpa-onnx/csrc/macros.h"
+
+namespace sherpa_onnx {
+
+// A single-producer/single-consumer ring of elements of type T.
+//
+// Exactly one thread may push and exactly one (other) thread may pop. The
+// data path is lock-free; the mutex and condition variable are only touched
+// when the consumer is blocked in WaitPop() or WaitPopItem().
+//
+// Unlike CircularBuffer, this buffer never grows. If the consumer falls
+// behind, elements that do not fit are dropped and counted, so that the
+// producer (e.g., an audio capture thread) is never blocked.
+//
+// Audio samples use SpscRingBuffer, i.e., T is float, and are copied in and
+// out in blocks with Push() and Pop(). Objects such as events with strings
+// are moved in and out one at a time with PushItem() and PopItem().
+//
+// All slots are allocated in the constructor.
+template <typename T>
+class BasicSpscRingBuffer {
+ public:
+  // @param capacity Number of elements the buffer can hold. It is rounded up
+  //                 to the next power of two.
+  explicit BasicSpscRingBuffer(int32_t capacity) {
+    if (capacity <= 0 || capacity > (1 << 30)) {
+      SHERPA_ONNX_LOGE("Please specify a capacity in (0, 2^30]. Given: %d\n",
+                       capacity);
+      exit(-1);
+    }
+
+    uint32_t n = 1;
+    while (n < static_cast<uint32_t>(capacity)) {
+      n <<= 1;
+    }
+
+    buffer_.resize(n);
+    mask_ = n - 1;
+  }
+
+  BasicSpscRingBuffer(const BasicSpscRingBuffer &) = delete;
+  BasicSpscRingBuffer &operator=(const BasicSpscRingBuffer &) = delete;
+
+  // Called only by the producer.
+  //
+  // @param p Pointer to the start address of the array
+  // @param n Number of elements in the array
+  // @return Return the number of elements written. If it is less than n,
+  //         the remaining elements are dropped and added to NumDropped().
+  int32_t Push(const T *p, int32_t n) {
+    if (n <= 0) {
+      return 0;
+    }
+
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    uint32_t head = head_.load(std::memory_order_acquire);
+
+    int32_t capacity = Capacity();
+    int32_t available = capacity - static_cast<int32_t>(tail - head);
+    int32_t k = std::min(n, available);
+
+    if (k < n) {
+      num_dropped_.fetch_add(n - k, std::memory_order_relaxed);
+    }
+
+    if (k > 0) {
+      uint32_t start = tail & mask_;
+      int32_t part1_size =
+          std::min(k, capacity - static_cast<int32_t>(start));
+
+      std::copy(p, p + part1_size, buffer_.begin() + start);
+      std::copy(p + part1_size, p + k, buffer_.begin());
+
+      Publish(tail + k);
+    }
+
+    return k;
+  }
+
+  // Called only by the producer.
+  //
+  // @return Return false if the buffer is full. The item is dropped and
+  //         added to NumDropped(); it is left unchanged.
+  bool PushItem(T &&item) {
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    uint32_t head = head_.load(std::memory_order_acquire);
+
+    if (static_cast<int32_t>(tail - head) == Capacity()) {
+      num_dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    buffer_[tail & mask_] = std::move(item);
+    Publish(tail + 1);
+
+    return true;
+  }
+
+  // Called only by the consumer. It does not block.
+  //
+  // @param p Pointer to an array that can hold at least n elements.
+  // @param n Maximum number of elements to pop.
+  // @return Return the number of elements copied to p.
+  int32_t Pop(T *p, int32_t n) {
+    if (n <= 0) {
+      return 0;
+    }
+
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    uint32_t tail = tail_.load(std::memory_order_acquire);
+
+    int32_t k = std::min(n, static_cast<int32_t>(tail - head));
+    if (k == 0) {
+      return 0;
+    }
+
+    int32_t capacity = Capacity();
+    uint32_t start = head & mask_;
+    int32_t part1_size = std::min(k, capacity - static_cast<int32_t>(start));
+
+    std::copy(buffer_.begin() + start, buffer_.begin() + start + part1_size,
+              p);
+    std::copy(buffer_.begin(), buffer_.begin() + (k - part1_size),
+              p + part1_size);
+
+    head_.store(head + k, std::memory_order_release);
+
+    return k;
+  }
+
+  // Called only by the consumer. It does not block.
+  //
+  // @return Return false if the buffer is empty.
+  bool PopItem(T *item) {
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    uint32_t tail = tail_.load(std::memory_order_acquire);
+    if (head == tail) {
+      return false;
+    }
+
+    *item = std::move(buffer_[head & mask_]);
+    head_.store(head + 1, std::memory_order_release);
+
+    return true;
+  }
+
+  // Called only by the consumer. Block until n elements are available,
+  // the timeout expires or Close() is called, then pop at most n elements.
+  //
+  // @param p Pointer to an array that can hold at least n elements.
+  // @param n Number of elements to wait for.
+  // @param timeout_ms A negative value means to wait forever.
+  // @return Return the number of elements copied to p. It is less than n
+  //         only on timeout or after Close().
+  int32_t WaitPop(T *p, int32_t n, int32_t timeout_ms = -1) {
+    if (n > Capacity()) {
+      SHERPA_ONNX_LOGE("Cannot wait for %d elements. Capacity: %d", n,
+                       Capacity());
+      n = Capacity();
+    }
+
+    Wait(n, timeout_ms);
+
+    return Pop(p, n);
+  }
+
+  // Called only by the consumer. Block until an element is available, the
+  // timeout expires or Close() is called, then pop it.
+  //
+  // @param timeout_ms A negative value means to wait forever.
+  // @return Return false if there is no element on timeout or after
+  //         Close(). Elements pushed before Close() are still returned.
+  bool WaitPopItem(T *item, int32_t timeout_ms = -1) {
+    Wait(1, timeout_ms);
+
+    return PopItem(item);
+  }
+
+  // Wake up a blocked consumer. Later calls to WaitPop() and WaitPopItem()
+  // return immediately.
+  void Close() {
+    closed_.store(true);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    cv_.notify_one();
+  }
+
+  bool IsClosed() const { return closed_.load(); }
+
+  // Number of elements that can be popped. It is a snapshot if called from
+  // a thread other than the consumer.
+  int32_t Size() const {
+    uint32_t head = head_.load();
+    uint32_t tail = tail_.load();
+    return static_cast<int32_t>(tail - head);
+  }
+
+  int32_t Capacity() const { return static_cast<int32_t>(buffer_.size()); }
+
+  // Total number of elements dropped by Push() or PushItem() because the
+  // buffer was full.
+  int64_t NumDropped() const { return num_dropped_.load(); }
+
+ private:
+  // Make the elements before tail visible to the consumer and wake it up if
+  // it is blocked in WaitPop() or WaitPopItem().
+  void Publish(uint32_t tail) {
+    // seq_cst pairs with the store to waiting_ in Wait() so that either
+    // the consumer sees the new tail or we see that it is waiting.
+    tail_.store(tail);
+
+    if (waiting_.load()) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      cv_.notify_one();
+    }
+  }
+
+  void Wait(int32_t n, int32_t timeout_ms) {
+    if (Size() >= n || IsClosed() || timeout_ms == 0) {
+      return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    waiting_.store(true);
+
+    auto ready = [this, n]() { return Size() >= n || IsClosed(); };
+
+    if (timeout_ms < 0) {
+      cv_.wait(lock, ready);
+    } else {
+      cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms), ready);
+    }
+
+    waiting_.store(false);
+  }
+
+ private:
+  std::vector<T> buffer_;
+  uint32_t mask_ = 0;
+
+  // Written only by the consumer
+  alignas(64) std::atomic<uint32_t> head_{0};
+
+  // Written only by the producer
+  alignas(64) std::atomic<uint32_t> tail_{0};
+  std::atomic<int64_t> num_dropped_{0};
+
+  std::atomic<bool> closed_{false};
+  std::atomic<bool> waiting_{false};
+  std::mutex mutex_;
+  std::condition_variable cv_;
+};
+
+using SpscRingBuffer = BasicSpscRingBuffer<float>;
+
+}  // namespace sherpa_onnx
+
+#endif  // SHERPA_ONNX_CSRC_SPSC_RING_BUFFER_H_
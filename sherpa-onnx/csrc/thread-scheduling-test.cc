@@ -0,0 +1,60 @@
+// sherpa-onnx/csrc/thread-scheduling-test.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/thread-scheduling.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace sherpa_onnx {
+
+TEST(ThreadScheduling, ParseCpuList) {
+  std::vector<int32_t> cpus;
+  EXPECT_TRUE(ParseCpuList("", &cpus));
+  EXPECT_TRUE(cpus.empty());
+
+  EXPECT_TRUE(ParseCpuList("2", &cpus));
+  EXPECT_EQ(cpus, (std::vector<int32_t>{2}));
+
+  EXPECT_TRUE(ParseCpuList("0,2-4,7", &cpus));
+  EXPECT_EQ(cpus, (std::vector<int32_t>{0, 2, 3, 4, 7}));
+
+  for (const char *s : {"a", "1,", ",1", "1-", "3-1", "-1", "1-2x", "5000"}) {
+    EXPECT_FALSE(ParseCpuList(s, &cpus)) << s;
+  }
+}
+
+TEST(ThreadScheduling, Validate) {
+  ThreadSchedulingConfig config;
+  EXPECT_TRUE(config.Validate());
+
+  config.capture_cpus = "0";
+  config.capture_priority = 80;
+  config.decode_cpus = "1-3";
+  config.ort_cpus = "2,3";
+  EXPECT_TRUE(config.Validate());
+
+  config.decode_priority = 100;
+  EXPECT_FALSE(config.Validate());
+
+  config.decode_priority = 0;
+  config.ort_cpus = "2;3";
+  EXPECT_FALSE(config.Validate());
+}
+
+TEST(ThreadScheduling, ConfigureCurrentThread) {
+  // Nothing to change
+  EXPECT_TRUE(ConfigureCurrentThread("", 0, "test"));
+
+  EXPECT_FALSE(ConfigureCurrentThread("x", 0, "test"));
+
+#if defined(__linux__)
+  // Every thread can pin itself to a CPU it may run on. CPU 0 is used
+  // since it is usually allowed.
+  EXPECT_TRUE(ConfigureCurrentThread("0", 0, "test"));
+#endif
+}
+
+}  // namespace sherpa_onnx
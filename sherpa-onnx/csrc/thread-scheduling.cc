@@ -0,0 +1,203 @@
+// sherpa-onnx/csrc/thread-scheduling.cc
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/thread-scheduling.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "sherpa-onnx/csrc/macros.h"
+#include "sherpa-onnx/csrc/session.h"
+
+namespace sherpa_onnx {
+
+void ThreadSchedulingConfig::Register(ParseOptions *po) {
+  po->Register("capture-cpus", &capture_cpus,
+               "CPUs of the capture thread, e.g., 0 or 1-3 or 1,3. Empty to "
+               "use all CPUs");
+
+  po->Register("capture-priority", &capture_priority,
+               "SCHED_FIFO priority in [1, 99] of the capture thread. 0 to "
+               "use the default scheduling. Needs root or CAP_SYS_NICE");
+
+  po->Register("decode-cpus", &decode_cpus,
+               "CPUs of the decode thread. Empty to use all CPUs");
+
+  po->Register("decode-priority", &decode_priority,
+               "SCHED_FIFO priority in [1, 99] of the decode thread. 0 to "
+               "use the default scheduling");
+
+  po->Register("ort-cpus", &ort_cpus,
+               "CPUs of the intra-op threads of onnxruntime, one per thread "
+               "in turn. Empty to not pin them");
+
+  po->Register("ort-allow-spinning", &ort_allow_spinning,
+               "false to let idle onnxruntime threads sleep instead of "
+               "spinning");
+}
+
+bool ThreadSchedulingConfig::Validate() const {
+  std::vector<int32_t> cpus;
+  if (!ParseCpuList(capture_cpus, &cpus)) {
+    SHERPA_ONNX_LOGE("Invalid --capture-cpus: '%s'", capture_cpus.c_str());
+    return false;
+  }
+
+  if (!ParseCpuList(decode_cpus, &cpus)) {
+    SHERPA_ONNX_LOGE("Invalid --decode-cpus: '%s'", decode_cpus.c_str());
+    return false;
+  }
+
+  if (!ParseCpuList(ort_cpus, &cpus)) {
+    SHERPA_ONNX_LOGE("Invalid --ort-cpus: '%s'", ort_cpus.c_str());
+    return false;
+  }
+
+  if (capture_priority < 0 || capture_priority > 99) {
+    SHERPA_ONNX_LOGE("--capture-priority should be in [0, 99]. Given: %d",
+                     capture_priority);
+    return false;
+  }
+
+  if (decode_priority < 0 || decode_priority > 99) {
+    SHERPA_ONNX_LOGE("--decode-priority should be in [0, 99]. Given: %d",
+                     decode_priority);
+    return false;
+  }
+
+  return true;
+}
+
+std::string ThreadSchedulingConfig::ToString() const {
+  std::ostringstream os;
+
+  os << "ThreadSchedulingConfig(";
+  os << "capture_cpus=\"" << capture_cpus << "\", ";
+  os << "capture_priority=" << capture_priority << ", ";
+  os << "decode_cpus=\"" << decode_cpus << "\", ";
+  os << "decode_priority=" << decode_priority << ", ";
+  os << "ort_cpus=\"" << ort_cpus << "\", ";
+  os << "ort_allow_spinning=" << (ort_allow_spinning ? "True" : "False")
+     << ")";
+
+  return os.str();
+}
+
+bool ParseCpuList(const std::string &s, std::vector<int32_t> *cpus) {
+  cpus->clear();
+
+  // std::getline() below does not see an empty range at the end
+  if (!s.empty() && s.back() == ',') {
+    return false;
+  }
+
+  std::istringstream is(s);
+  std::string range;
+  while (std::getline(is, range, ',')) {
+    if (range.empty()) {
+      return false;
+    }
+
+    const char *p = range.c_str();
+    char *end = nullptr;
+    int64_t first = strtol(p, &end, 10);
+    int64_t last = first;
+    if (end == p) {
+      return false;
+    }
+
+    if (*end == '-') {
+      p = end + 1;
+      last = strtol(p, &end, 10);
+      if (end == p) {
+        return false;
+      }
+    }
+
+    if (*end != '\0' || first < 0 || last < first || last >= 1024) {
+      return false;
+    }
+
+    for (int64_t c = first; c <= last; ++c) {
+      cpus->push_back(static_cast<int32_t>(c));
+    }
+  }
+
+  return true;
+}
+
+bool ConfigureCurrentThread(const std::string &cpus, int32_t priority,
+                            const char *name) {
+  std::vector<int32_t> cpu_list;
+  if (!ParseCpuList(cpus, &cpu_list)) {
+    SHERPA_ONNX_LOGE("Invalid CPU list of the %s thread: '%s'", name,
+                     cpus.c_str());
+    return false;
+  }
+
+  if (cpu_list.empty() && priority == 0) {
+    return true;
+  }
+
+#if defined(__linux__)
+  bool ok = true;
+
+  if (!cpu_list.empty()) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (auto c : cpu_list) {
+      CPU_SET(c, &set);
+    }
+
+    int ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (ret != 0) {
+      SHERPA_ONNX_LOGE("Failed to pin the %s thread to CPUs %s: %s", name,
+                       cpus.c_str(), strerror(ret));
+      ok = false;
+    }
+  }
+
+  if (priority > 0) {
+    sched_param param{};
+    param.sched_priority = priority;
+
+    int ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (ret != 0) {
+      SHERPA_ONNX_LOGE("Failed to set SCHED_FIFO priority %d of the %s "
+                       "thread: %s",
+                       priority, name, strerror(ret));
+      ok = false;
+    }
+  }
+
+  return ok;
+#else
+  SHERPA_ONNX_LOGE(
+      "CPU affinity and realtime priority of the %s thread are supported "
+      "only on Linux",
+      name);
+  return false;
+#endif
+}
+
+void ConfigureOrtThreads(const ThreadSchedulingConfig &config) {
+  std::vector<int32_t> cpus;
+  if (!ParseCpuList(config.ort_cpus, &cpus)) {
+    SHERPA_ONNX_LOGE("Invalid CPU list of onnxruntime threads: '%s'",
+                     config.ort_cpus.c_str());
+    cpus.clear();
+  }
+
+  SetOrtThreadOptions(cpus, config.ort_allow_spinning);
+}
+
+}  // namespace sherpa_onnx
@@ -0,0 +1,72 @@
+// sherpa-onnx/csrc/thread-scheduling.h
+//
+// Copyright (c)  2025  Xiaomi Corporation
+
+#ifndef SHERPA_ONNX_CSRC_THREAD_SCHEDULING_H_
+#define SHERPA_ONNX_CSRC_THREAD_SCHEDULING_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "sherpa-onnx/csrc/parse-options.h"
+
+namespace sherpa_onnx {
+
+// CPU affinity and scheduling of the threads of a streaming app: the
+// capture thread that reads the microphone, the decode thread that runs
+// the models, and the worker threads of onnxruntime.
+//
+// CPU lists are like "0", "1-3" or "1,3". An empty list leaves a thread on
+// all CPUs. Only Linux is supported.
+struct ThreadSchedulingConfig {
+  std::string capture_cpus;
+
+  // SCHED_FIFO priority in [1, 99]. 0 keeps the default scheduling.
+  // Realtime priorities need root or CAP_SYS_NICE.
+  int32_t capture_priority = 0;
+
+  std::string decode_cpus;
+  int32_t decode_priority = 0;
+
+  // Intra-op worker threads of onnxruntime are pinned to these CPUs, one
+  // CPU per thread, in turn. The decode thread runs the first share of the
+  // work itself.
+  std::string ort_cpus;
+
+  // false to let idle onnxruntime threads sleep instead of spinning
+  bool ort_allow_spinning = true;
+
+  ThreadSchedulingConfig() = default;
+
+  void Register(ParseOptions *po);
+  bool Validate() const;
+
+  std::string ToString() const;
+};
+
+/** Parse a CPU list, e.g., "0,2-3" gives {0, 2, 3}.
+ *
+ * @return Return false if s is malformed.
+ */
+bool ParseCpuList(const std::string &s, std::vector<int32_t> *cpus);
+
+/** Pin the calling thread to the given CPUs and set its realtime priority.
+ *
+ * @param cpus  A CPU list. Empty to keep the current affinity.
+ * @param priority  SCHED_FIFO priority. 0 to keep the current scheduling.
+ * @param name  Name of the thread, for error messages.
+ *
+ * @return Return false if any of them cannot be set. The thread keeps
+ *         running with what could be set.
+ */
+bool ConfigureCurrentThread(const std::string &cpus, int32_t priority,
+                            const char *name);
+
+// Apply ort_cpus and ort_allow_spinning to sessions created afterwards.
+// Call it before creating models.
+void ConfigureOrtThreads(const ThreadSchedulingConfig &config);
+
+}  // namespace sherpa_onnx
+
+#endif  // SHERPA_ONNX_CSRC_THREAD_SCHEDULING_H_
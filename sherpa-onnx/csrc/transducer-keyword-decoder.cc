@@ -5,11 +5,12 @@
 #include "sherpa-onnx/csrc/transducer-keyword-decoder.h"
 
 #include <algorithm>
+#include <array>
 #include <cmath>
-#include <cstring>
 #include <utility>
 #include <vector>
 
+#include "sherpa-onnx/csrc/log-softmax-topk.h"
 #include "sherpa-onnx/csrc/log.h"
 #include "sherpa-onnx/csrc/onnx-utils.h"
 
@@ -27,6 +28,100 @@ TransducerKeywordResult TransducerKeywordDecoder::GetEmptyResult() const {
   return r;
 }
 
+Ort::Value TransducerKeywordDecoder::RunDecoderWithCache(
+    const std::vector<ArenaHypothesis> &hyps,
+    const std::vector<int32_t> &hyps_row_splits, OnlineStream **ss,
+    int32_t batch_size, DecodeWorkspace *workspace) {
+  int32_t context_size = model_->ContextSize();
+  int32_t num_hyps = static_cast<int32_t>(hyps.size());
+
+  const auto &arena = workspace->arena;
+  auto &contexts = workspace->contexts;
+  auto &cache_index = workspace->cache_index;
+  auto &misses = workspace->misses;
+
+  contexts.resize(num_hyps * context_size);
+  for (int32_t i = 0; i != num_hyps; ++i) {
+    arena.LastTokens(hyps[i], context_size,
+                     contexts.data() + i * context_size);
+  }
+
+  // Look up the decoder output of each hyp in the cache of its stream.
+  // Contexts not seen before are added to the cache and collected in
+  // `misses` so that the decoder network runs only once for each of them.
+  cache_index.resize(num_hyps);
+  misses.clear();
+
+  for (int32_t b = 0; b != batch_size; ++b) {
+    DecoderOutCache &cache = ss[b]->GetDecoderOutCache();
+    int32_t start = hyps_row_splits[b];
+    int32_t end = hyps_row_splits[b + 1];
+    cache.MakeRoom(end - start);
+
+    for (int32_t i = start; i != end; ++i) {
+      const int64_t *context = contexts.data() + i * context_size;
+      bool found = false;
+      cache_index[i] = cache.FindOrAdd(context, context_size, &found);
+      if (!found) {
+        misses.push_back(i);
+      }
+    }
+  }
+
+  if (!misses.empty()) {
+    int32_t num_misses = static_cast<int32_t>(misses.size());
+
+    std::array<int64_t, 2> shape{num_misses, context_size};
+    Ort::Value decoder_input = Ort::Value::CreateTensor<int64_t>(
+        model_->Allocator(), shape.data(), shape.size());
+    int64_t *p = decoder_input.GetTensorMutableData<int64_t>();
+
+    for (auto i : misses) {
+      const int64_t *context = contexts.data() + i * context_size;
+      std::copy(context, context + context_size, p);
+      p += context_size;
+    }
+
+    Ort::Value out = model_->RunDecoder(std::move(decoder_input));
+    int32_t dim = out.GetTensorTypeAndShapeInfo().GetElementCount() /
+                  num_misses;
+    const float *p_out = out.GetTensorData<float>();
+
+    int32_t b = 0;
+    for (auto i : misses) {
+      while (i >= hyps_row_splits[b + 1]) {
+        ++b;
+      }
+
+      DecoderOutCache &cache = ss[b]->GetDecoderOutCache();
+      cache.SetDim(dim);
+      std::copy(p_out, p_out + dim, cache.Data(cache_index[i]));
+      p_out += dim;
+    }
+  }
+
+  int32_t dim = ss[0]->GetDecoderOutCache().Dim();
+
+  std::array<int64_t, 2> shape{num_hyps, dim};
+  Ort::Value decoder_out = Ort::Value::CreateTensor<float>(
+      model_->Allocator(), shape.data(), shape.size());
+  float *p = decoder_out.GetTensorMutableData<float>();
+
+  for (int32_t b = 0; b != batch_size; ++b) {
+    const DecoderOutCache &cache = ss[b]->GetDecoderOutCache();
+    int32_t start = hyps_row_splits[b];
+    int32_t end = hyps_row_splits[b + 1];
+
+    for (int32_t i = start; i != end; ++i) {
+      const float *src = cache.Data(cache_index[i]);
+      std::copy(src, src + dim, p);
+      p += dim;
+    }
+  }
+
+  return decoder_out;
+}
+
 void TransducerKeywordDecoder::Decode(
     Ort::Value encoder_out, OnlineStream **ss,
     std::vector<TransducerKeywordResult> *result) {
@@ -49,29 +144,43 @@ void TransducerKeywordDecoder::Decode(
   std::vector<int64_t> blanks(context_size, -1);
   blanks.back() = 0;  // blank_id is hardcoded to 0
 
-  std::vector<Hypotheses> cur;
-  for (auto &r : *result) {
-    cur.push_back(std::move(r.hyps));
+  // Decode() may run on several threads at once, e.g., for
+  // KeywordSpotter::DecodeStreams() from different threads, so each thread
+  // has its own workspace.
+  static thread_local DecodeWorkspace workspace;
+  auto &arena = workspace.arena;
+  auto &prev = workspace.prev;
+  auto &beams = workspace.beams;
+
+  // Tokens are appended to the arena as hyps are extended, so a new hyp
+  // costs one token instead of a copy of all of its vectors.
+  arena.Clear();
+  ArenaHypothesis blank_hyp = arena.Import({blanks, 0});
+
+  beams.resize(batch_size, ArenaHypotheses(&arena));
+  for (int32_t b = 0; b != batch_size; ++b) {
+    beams[b].Clear();
+    for (const auto &h : (*result)[b].hyps) {
+      beams[b].Add(arena.Import(h.second));
+    }
   }
-  std::vector<Hypothesis> prev;
+
+  std::vector<int32_t> hyps_row_splits(batch_size + 1);
 
   for (int32_t t = 0; t != num_frames; ++t) {
     // Due to merging paths with identical token sequences,
     // not all utterances have "num_active_paths" paths.
-    auto hyps_row_splits = GetHypsRowSplits(cur);
-    int32_t num_hyps =
-        hyps_row_splits.back();  // total num hyps for all utterance
     prev.clear();
-    for (auto &hyps : cur) {
-      for (auto &h : hyps) {
-        prev.push_back(std::move(h.second));
-      }
+    for (int32_t b = 0; b != batch_size; ++b) {
+      prev.insert(prev.end(), beams[b].begin(), beams[b].end());
+      hyps_row_splits[b + 1] = static_cast<int32_t>(prev.size());
+      beams[b].Clear();
     }
-    cur.clear();
-    cur.reserve(batch_size);
+    int32_t num_hyps =
+        hyps_row_splits.back();  // total num hyps for all utterance
 
-    Ort::Value decoder_input = model_->BuildDecoderInput(prev);
-    Ort::Value decoder_out = model_->RunDecoder(std::move(decoder_input));
+    Ort::Value decoder_out = RunDecoderWithCache(prev, hyps_row_splits, ss,
+                                                 batch_size, &workspace);
 
     Ort::Value cur_encoder_out =
         GetEncoderOutFrame(model_->Allocator(), &encoder_out, t);
@@ -80,104 +189,117 @@ void TransducerKeywordDecoder::Decode(
     Ort::Value logit =
         model_->RunJoiner(std::move(cur_encoder_out), View(&decoder_out));
 
-    float *p_logit = logit.GetTensorMutableData<float>();
-    LogSoftmax(p_logit, vocab_size, num_hyps);
+    // add log_prob of each hypothesis to the log_softmax output
+    // before taking top_k
+    auto &offsets = workspace.offsets;
+    offsets.resize(num_hyps);
+    for (int32_t i = 0; i != num_hyps; ++i) {
+      offsets[i] = prev[i].log_prob;
+    }
 
     // The acoustic logprobs for current frame
-    std::vector<float> logprobs(vocab_size * num_hyps);
-    std::memcpy(logprobs.data(), p_logit,
-                sizeof(float) * vocab_size * num_hyps);
+    auto &logprobs_buf = workspace.logprobs;
+    logprobs_buf.resize(vocab_size * num_hyps);
 
-    // now p_logit contains log_softmax output, we rename it to p_logprob
-    // to match what it actually contains
-    float *p_logprob = p_logit;
+    float *p_logprob = logit.GetTensorMutableData<float>();
+    LogSoftmaxWithOffset(p_logprob, vocab_size, num_hyps, offsets.data(),
+                         logprobs_buf.data());
+    const float *logprobs = logprobs_buf.data();
 
-    // add log_prob of each hypothesis to p_logprob before taking top_k
-    for (int32_t i = 0; i != num_hyps; ++i) {
-      float log_prob = prev[i].log_prob;
-      for (int32_t k = 0; k != vocab_size; ++k, ++p_logprob) {
-        *p_logprob += log_prob;
-      }
-    }
-    p_logprob = p_logit;  // we changed p_logprob in the above for loop
+    auto &topk = workspace.topk;
+    topk.resize(max_active_paths_);
 
     for (int32_t b = 0; b != batch_size; ++b) {
-      int32_t frame_offset = (*result)[b].frame_offset;
+      // Timestamps in hyps count from hyps_frame_offset
+      int32_t frame_offset = static_cast<int32_t>(
+          (*result)[b].frame_offset - (*result)[b].hyps_frame_offset);
       int32_t start = hyps_row_splits[b];
       int32_t end = hyps_row_splits[b + 1];
-      auto topk =
-          TopkIndex(p_logprob, vocab_size * (end - start), max_active_paths_);
+      int32_t num_topk = TopkIndex(p_logprob, vocab_size * (end - start),
+                                   max_active_paths_, topk.data());
 
-      Hypotheses hyps;
-      for (auto k : topk) {
+      ArenaHypotheses &hyps = beams[b];
+      for (int32_t i = 0; i != num_topk; ++i) {
+        int32_t k = topk[i];
         int32_t hyp_index = k / vocab_size + start;
         int32_t new_token = k % vocab_size;
 
-        Hypothesis new_hyp = prev[hyp_index];
+        ArenaHypothesis new_hyp = prev[hyp_index];
         float context_score = 0;
-        auto context_state = new_hyp.context_state;
 
         // blank is hardcoded to 0
         // also, it treats unk as blank
         if (new_token != 0 && new_token != unk_id_) {
-          new_hyp.ys.push_back(new_token);
-          new_hyp.timestamps.push_back(t + frame_offset);
-          new_hyp.ys_probs.push_back(
-              exp(logprobs[hyp_index * vocab_size + new_token]));
-
-          new_hyp.num_trailing_blanks = 0;
           auto context_res = ss[b]->GetContextGraph()->ForwardOneStep(
-              context_state, new_token);
+              new_hyp.context_state, new_token);
           context_score = std::get<0>(context_res);
-          new_hyp.context_state = std::get<1>(context_res);
+          const ContextState *context_state = std::get<1>(context_res);
+
           // Start matching from the start state, forget the decoder history.
-          if (new_hyp.context_state->token == -1) {
-            new_hyp.ys = blanks;
-            new_hyp.timestamps.clear();
-            new_hyp.ys_probs.clear();
+          if (context_state->token == -1) {
+            new_hyp = blank_hyp;
+          } else {
+            new_hyp = arena.Extend(
+                new_hyp, new_token, t + frame_offset,
+                exp(logprobs[hyp_index * vocab_size + new_token]),
+                context_score);
           }
+
+          new_hyp.context_state = context_state;
+          new_hyp.num_trailing_blanks = 0;
         } else {
           ++new_hyp.num_trailing_blanks;
         }
         new_hyp.log_prob = p_logprob[k] + context_score;
-        hyps.Add(std::move(new_hyp));
-      }  // for (auto k : topk)
+        hyps.Add(new_hyp);
+      }  // for (int32_t i = 0; i != num_topk; ++i)
 
-      auto best_hyp = hyps.GetMostProbable(false);
+      const auto &best = hyps[hyps.MostProbable(false)];
 
-      auto status = ss[b]->GetContextGraph()->IsMatched(best_hyp.context_state);
+      auto status = ss[b]->GetContextGraph()->IsMatched(best.context_state);
       bool matched = std::get<0>(status);
       const ContextState *matched_state = std::get<1>(status);
 
-      if (matched) {
+      if (matched && best.num_trailing_blanks > num_trailing_blanks_) {
+        // Tokens are materialized only for a candidate keyword
+        auto best_hyp = arena.Export(best, false);
+
         float ys_prob = 0.0;
         for (int32_t i = 0; i < matched_state->level; ++i) {
           ys_prob += best_hyp.ys_probs[i];
         }
         ys_prob /= matched_state->level;
-        if (best_hyp.num_trailing_blanks > num_trailing_blanks_ &&
-            ys_prob >= matched_state->ac_threshold) {
+        if (ys_prob >= matched_state->ac_threshold) {
           auto &r = (*result)[b];
           r.tokens = {best_hyp.ys.end() - matched_state->level,
                       best_hyp.ys.end()};
-          r.timestamps = {best_hyp.timestamps.end() - matched_state->level,
-                          best_hyp.timestamps.end()};
-          r.keyword = matched_state->phrase;
+          r.timestamps.assign(best_hyp.timestamps.end() - matched_state->level,
+                              best_hyp.timestamps.end());
+          for (auto &t : r.timestamps) {
+            t += r.hyps_frame_offset;
+          }
+          r.keyword = ss[b]->GetContextGraph()->Phrase(matched_state);
+          r.score = ys_prob;
 
-          hyps = Hypotheses({{blanks, 0, ss[b]->GetContextGraph()->Root()}});
+          ArenaHypothesis root_hyp = blank_hyp;
+          root_hyp.context_state = ss[b]->GetContextGraph()->Root();
+          hyps.Clear();
+          hyps.Add(root_hyp);
         }
       }
-      cur.push_back(std::move(hyps));
       p_logprob += (end - start) * vocab_size;
     }  // for (int32_t b = 0; b != batch_size; ++b)
   }
 
   for (int32_t b = 0; b != batch_size; ++b) {
-    auto &hyps = cur[b];
-    auto best_hyp = hyps.GetMostProbable(false);
+    const auto &hyps = beams[b];
     auto &r = (*result)[b];
-    r.hyps = std::move(hyps);
-    r.num_trailing_blanks = best_hyp.num_trailing_blanks;
+
+    r.hyps.Clear();
+    for (const auto &h : hyps) {
+      r.hyps.Add(arena.Export(h, false));
+    }
+    r.num_trailing_blanks = hyps[hyps.MostProbable(false)].num_trailing_blanks;
     r.frame_offset += num_frames;
   }
 }
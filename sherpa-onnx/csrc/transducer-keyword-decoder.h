@@ -9,14 +9,21 @@
 #include <utility>
 #include <vector>
 
+#include "sherpa-onnx/csrc/hypothesis-arena.h"
 #include "sherpa-onnx/csrc/online-stream.h"
 #include "sherpa-onnx/csrc/online-transducer-model.h"
 
 namespace sherpa_onnx {
 
 struct TransducerKeywordResult {
-  /// Number of frames after subsampling we have decoded so far
-  int32_t frame_offset = 0;
+  /// Number of frames after subsampling we have decoded so far, counting
+  /// from the start of the stream
+  int64_t frame_offset = 0;
+
+  /// Value of frame_offset when hyps were last started from scratch, e.g.,
+  /// by a reset. Timestamps in hyps count from it, so that they stay within
+  /// int32_t however long the stream runs.
+  int64_t hyps_frame_offset = 0;
 
   /// The decoded token IDs for keywords
   std::vector<int64_t> tokens;
@@ -24,11 +31,15 @@ struct TransducerKeywordResult {
   /// The triggered keyword
   std::string keyword;
 
+  /// Average probability of the tokens of the triggered keyword
+  float score = 0;
+
   /// number of trailing blank frames decoded so far
   int32_t num_trailing_blanks = 0;
 
-  /// timestamps[i] contains the output frame index where tokens[i] is decoded.
-  std::vector<int32_t> timestamps;
+  /// timestamps[i] contains the output frame index, counting from the start
+  /// of the stream, where tokens[i] is decoded.
+  std::vector<int64_t> timestamps;
 
   // used only in modified beam_search
   Hypotheses hyps;
@@ -49,6 +60,39 @@ class TransducerKeywordDecoder {
   void Decode(Ort::Value encoder_out, OnlineStream **ss,
               std::vector<TransducerKeywordResult> *result);
 
+ private:
+  // Buffers of Decode() that are reused across frames and calls
+  struct DecodeWorkspace {
+    // Tokens of all hypotheses in Decode(). It is cleared at the start of
+    // each call.
+    HypothesisArena arena;
+
+    // Hypotheses of the previous frame for all streams
+    std::vector<ArenaHypothesis> prev;
+
+    // Hypotheses of the current frame, one beam per stream
+    std::vector<ArenaHypotheses> beams;
+
+    // Scratch buffers for RunDecoderWithCache()
+    std::vector<int64_t> contexts;
+    std::vector<int32_t> cache_index;
+    std::vector<int32_t> misses;
+
+    // Scratch buffers for the log-softmax and top-k of each frame in
+    // Decode()
+    std::vector<float> offsets;
+    std::vector<float> logprobs;
+    std::vector<int32_t> topk;
+  };
+
+  // Return the decoder output for hyps, a tensor of shape
+  // (hyps.size(), decoder_dim). The decoder network is run only for
+  // contexts that are not in the DecoderOutCache of their stream.
+  Ort::Value RunDecoderWithCache(const std::vector<ArenaHypothesis> &hyps,
+                                 const std::vector<int32_t> &hyps_row_splits,
+                                 OnlineStream **ss, int32_t batch_size,
+                                 DecodeWorkspace *workspace);
+
  private:
   OnlineTransducerModel *model_;  // Not owned
 